@@ -14,6 +14,23 @@
 /*--------------------------------------------------------------------------------*/
 extern const char * JTEST_CYCLE_STRF;
 
+#if defined ARM_MATH_HOST
+extern const char * JTEST_CYCLE_HOST_STRF;
+
+/*--------------------------------------------------------------------------------*/
+/* Host Timer Functions (platform/Linux) */
+/*--------------------------------------------------------------------------------*/
+uint64_t jtest_host_cycles(void);
+uint64_t jtest_host_ns(void);
+void jtest_host_repeat(void);
+void jtest_host_repeat_end(uint64_t * cycles, uint64_t * ns);
+#elif defined JTEST_DWT
+/*--------------------------------------------------------------------------------*/
+/* DWT Timing (platform/STM32F411) */
+/*--------------------------------------------------------------------------------*/
+extern uint32_t jtest_dwt_overhead;
+#endif
+
 /*--------------------------------------------------------------------------------*/
 /* Macros and Defines */
 /*--------------------------------------------------------------------------------*/
@@ -43,6 +60,75 @@ extern const char * JTEST_CYCLE_STRF;
                          __jtest_cycle_end_count));     \
     } while (0)
 */
+#if defined ARM_MATH_HOST
+/**
+ *  Host build: count TSC cycles (nanoseconds where there is no TSC) and
+ *  wall-clock nanoseconds of the call. Most functions under test change
+ *  their state or output, so the call is first repeated in forked copies
+ *  of the process, each from the same state (jtest_host_repeat(), which
+ *  returns once in every copy and then in the test itself). The least
+ *  cycles and time of the copies are reported, with the test's own call,
+ *  whose results are checked, as "First".
+ */
+#define JTEST_COUNT_CYCLES(fn_call)                     \
+    do                                                  \
+    {                                                   \
+        uint64_t __jtest_ns_start;                      \
+        uint64_t __jtest_cycle_start;                   \
+        uint64_t __jtest_cycle_count;                   \
+        uint64_t __jtest_ns_count;                      \
+        uint64_t __jtest_cycle_first;                   \
+        uint64_t __jtest_ns_first;                      \
+                                                        \
+        jtest_host_repeat();                            \
+        __jtest_ns_start = jtest_host_ns();             \
+        __jtest_cycle_start = jtest_host_cycles();      \
+                                                        \
+        fn_call;                                        \
+                                                        \
+        __jtest_cycle_count =                           \
+            jtest_host_cycles() - __jtest_cycle_start;  \
+        __jtest_ns_count =                              \
+            jtest_host_ns() - __jtest_ns_start;         \
+        __jtest_cycle_first = __jtest_cycle_count;      \
+        __jtest_ns_first = __jtest_ns_count;            \
+        jtest_host_repeat_end(&__jtest_cycle_count,     \
+                              &__jtest_ns_count);       \
+                                                        \
+        JTEST_DUMP_STRF(JTEST_CYCLE_HOST_STRF,          \
+                        __jtest_cycle_first,            \
+                        __jtest_ns_first,               \
+                        __jtest_cycle_count,            \
+                        __jtest_ns_count);              \
+    } while (0)
+#elif defined JTEST_DWT
+/**
+ *  Target benchmark build: count core cycles with DWT->CYCCNT at the
+ *  application's clock and flash wait states. Interrupts are masked for the
+ *  call so USB traffic does not land in the count, and the cost of reading
+ *  the counter is taken off.
+ */
+#define JTEST_COUNT_CYCLES(fn_call)                     \
+    do                                                  \
+    {                                                   \
+        uint32_t __jtest_primask = __get_PRIMASK();     \
+        uint32_t __jtest_cycle_start;                   \
+        uint32_t __jtest_cycle_count;                   \
+                                                        \
+        __disable_irq();                                \
+        __jtest_cycle_start = DWT->CYCCNT;              \
+                                                        \
+        fn_call;                                        \
+                                                        \
+        __jtest_cycle_count =                           \
+            DWT->CYCCNT - __jtest_cycle_start -         \
+            jtest_dwt_overhead;                         \
+        __set_PRIMASK(__jtest_primask);                 \
+                                                        \
+        JTEST_DUMP_STRF(JTEST_CYCLE_STRF,               \
+                        __jtest_cycle_count);           \
+    } while (0)
+#else
 #define JTEST_COUNT_CYCLES(fn_call)                     \
     do                                                  \
     {                                                   \
@@ -61,5 +147,6 @@ extern const char * JTEST_CYCLE_STRF;
                         (JTEST_SYSTICK_INITIAL_VALUE -  \
                          __jtest_cycle_end_count));     \
     } while (0)
+#endif /* ARM_MATH_HOST, JTEST_DWT */
 
 #endif /* _JTEST_CYCLE_H_ */
@@ -6,7 +6,14 @@
 /*--------------------------------------------------------------------------------*/
 
 /* Get access to the SysTick structure. */
-#if   defined ARMCM0
+#if   defined ARM_MATH_HOST
+  /* Host build: no SysTick, jtest_cycle.h times calls with the platform
+   * layer in platform/Linux. */
+#elif defined JTEST_DWT
+  /* STM32F411 benchmark image: the application's device header, calls are
+   * timed with the DWT cycle counter (platform/STM32F411). */
+  #include "stm32f4xx.h"
+#elif defined ARMCM0
   #include "ARMCM0.h"
 #elif defined ARMCM0P
   #include "ARMCM0plus.h"
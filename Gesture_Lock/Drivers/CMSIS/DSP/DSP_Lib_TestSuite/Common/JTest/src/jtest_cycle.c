@@ -7,3 +7,8 @@
 
 /* const char * JTEST_CYCLE_STRF = "Running: %s\nCycles: %" PRIu32 "\n"; */
 const char * JTEST_CYCLE_STRF = "Cycles: %" PRIu32 "\n"; /* function name + parameter string skipped */
+
+#if defined ARM_MATH_HOST
+const char * JTEST_CYCLE_HOST_STRF = "First: %" PRIu64 " cycles %" PRIu64 " ns\n"
+                                     "Cycles: %" PRIu64 "\nTime: %" PRIu64 " ns\n";
+#endif
@@ -22,12 +22,14 @@ void jtest_dump_str_segments(void)
             memmove_idx = 0;
             while (memmove_idx < (seg_cnt - seg_idx -1) )
             {
+                /* Shift the rest of the buffer, not past its end */
                 memmove(
                     JTEST_FW.str_buffer+
                     (memmove_idx* JTEST_STR_MAX_OUTPUT_SIZE),
                     JTEST_FW.str_buffer+
                     ((memmove_idx+1)*JTEST_STR_MAX_OUTPUT_SIZE),
-                    JTEST_BUF_SIZE);
+                    JTEST_BUF_SIZE -
+                    ((memmove_idx+1)*JTEST_STR_MAX_OUTPUT_SIZE));
                 ++memmove_idx;
             }
         }
@@ -0,0 +1,643 @@
+/*----------------------------------------------------------------------------
+ * Name:    jtest_linux.c
+ * Purpose: Linux platform layer of the JTest framework (ARM_MATH_HOST)
+ * Note(s): Replaces the Keil debugger. The action triggers of
+ *          jtest_trigger_action.c are implemented here and read the dump
+ *          stream the debugger script would read: group and test names,
+ *          parameter lines, "Cycles:"/"Time:" lines and the results. From
+ *          it a JSON report is written, one object per test with a run per
+ *          timed call. Build with the Makefile next to this file.
+ *
+ *          A timed call changes the state and output the test checks, so
+ *          it cannot simply be run again. jtest_host_repeat() forks copies
+ *          of the process that each make the call once from the same state,
+ *          its page faults taken before the count and its caches warmed by
+ *          the copies before it. A run reports the least cycles and time of
+ *          the copies, and the test's own call as first_cycles and first_ns.
+ *
+ *          Environment:
+ *            JTEST_JSON     report file, default jtest_report.json
+ *            JTEST_VERBOSE  1: echo the raw dump stream to stdout
+ *            JTEST_REPEAT   forked calls per timed call, default 5, 0: only
+ *                           the test's own call
+ *----------------------------------------------------------------------------*/
+
+#include "jtest_fw.h"
+#include "arm_math.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+#endif
+
+/*--------------------------------------------------------------------------------*/
+/* Macros and Defines */
+/*--------------------------------------------------------------------------------*/
+#define JTEST_HOST_LINE_MAX     (2 * JTEST_BUF_SIZE)
+#define JTEST_HOST_NAME_MAX     96
+#define JTEST_HOST_GROUP_DEPTH  8
+#define JTEST_HOST_PARAM_MAX    8
+#define JTEST_HOST_REPEAT       5
+#define JTEST_HOST_MAP_MAX      64
+#define JTEST_HOST_PAGE         4096
+
+/*--------------------------------------------------------------------------------*/
+/* Type Definitions */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  The line expected after a "... Name:" header.
+ */
+typedef enum
+{
+    JTEST_HOST_EXPECT_NONE = 0,
+    JTEST_HOST_EXPECT_GROUP,
+    JTEST_HOST_EXPECT_TEST,
+    JTEST_HOST_EXPECT_FUT
+} JTEST_HOST_EXPECT_t;
+
+/**
+ *  A "Key: value" line printed by a test before it times a call.
+ */
+typedef struct
+{
+    char key[JTEST_HOST_NAME_MAX];
+    char value[JTEST_HOST_NAME_MAX];
+} JTEST_HOST_PARAM_t;
+
+typedef struct
+{
+    FILE * json;
+    int verbose;
+
+    char line[JTEST_HOST_LINE_MAX];     /* dump stream, until a newline */
+    uint32_t line_len;
+    JTEST_HOST_EXPECT_t expect;
+
+    char group[JTEST_HOST_GROUP_DEPTH][JTEST_HOST_NAME_MAX];
+    int32_t depth;
+
+    int in_test;
+    int test_open;                      /* object written to the report */
+    int test_count;
+    int run_count;
+    int run_open;                       /* waiting for the "Time:" line */
+    int passed;
+    int first_set;                      /* "First:" line of the run read */
+    uint64_t first_cycles;
+    uint64_t first_ns;
+
+    int repeat;                         /* JTEST_REPEAT */
+    int child_fd;                       /* in a forked copy, its result pipe */
+    int best_count;
+    uint64_t best_cycles;
+    uint64_t best_ns;
+    uintptr_t map[JTEST_HOST_MAP_MAX][3];   /* start, end, writable */
+    uint32_t map_count;
+    char test[JTEST_HOST_NAME_MAX];
+    char fut[JTEST_HOST_NAME_MAX];
+    JTEST_HOST_PARAM_t param[JTEST_HOST_PARAM_MAX];
+    uint32_t param_count;
+} JTEST_HOST_t;
+
+/*--------------------------------------------------------------------------------*/
+/* Module Variables */
+/*--------------------------------------------------------------------------------*/
+static JTEST_HOST_t jtest_host = { .child_fd = -1 };
+
+/*--------------------------------------------------------------------------------*/
+/* Timers */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Monotonic time in nanoseconds.
+ */
+uint64_t jtest_host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000U + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ *  Time stamp counter on x86, nanoseconds elsewhere.
+ */
+uint64_t jtest_host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return jtest_host_ns();
+#endif
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Repeated Calls */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Note the mappings of the process that can be read, the writable ones
+ *  (data, bss, heap, stack) marked. The kernel's [vvar] and [vsyscall]
+ *  pages are left out, they do not all read.
+ */
+static void jtest_host_maps(void)
+{
+    FILE * f = fopen("/proc/self/maps", "r");
+    char line[256];
+    char perm[8];
+    unsigned long start;
+    unsigned long end;
+
+    jtest_host.map_count = 0;
+    if (f == NULL)
+    {
+        return;
+    }
+    while (jtest_host.map_count < JTEST_HOST_MAP_MAX && fgets(line, sizeof(line), f))
+    {
+        if (sscanf(line, "%lx-%lx %7s", &start, &end, perm) == 3 && perm[0] == 'r' &&
+            strstr(line, "[v") == NULL)
+        {
+            jtest_host.map[jtest_host.map_count][0] = start;
+            jtest_host.map[jtest_host.map_count][1] = end;
+            jtest_host.map[jtest_host.map_count][2] = perm[1] == 'w';
+            jtest_host.map_count++;
+        }
+    }
+    fclose(f);
+}
+
+/**
+ *  Read every page and write every writable one, so that the page faults
+ *  after a fork, copy on write and the code pages that fork does not map
+ *  into the copy, are taken here and not in the timed call.
+ */
+static void jtest_host_touch(void)
+{
+    uint32_t i;
+    uintptr_t p;
+
+    for (i = 0; i < jtest_host.map_count; i++)
+    {
+        for (p = jtest_host.map[i][0]; p < jtest_host.map[i][1]; p += JTEST_HOST_PAGE)
+        {
+            if (jtest_host.map[i][2])
+            {
+                *(volatile char *) p = *(volatile char *) p;
+            }
+            else
+            {
+                (void) *(volatile char *) p;
+            }
+        }
+    }
+}
+
+/**
+ *  Fork JTEST_REPEAT copies of the process one after the other. Each
+ *  returns from here, makes the timed call from the state the test is in
+ *  now and ends in jtest_host_repeat_end(). Then it returns in the test.
+ */
+void jtest_host_repeat(void)
+{
+    int fd[2];
+    int i;
+    pid_t pid;
+    uint64_t result[2];
+
+    jtest_host.best_count = 0;
+    if (jtest_host.repeat > 0)
+    {
+        jtest_host_maps();
+    }
+    for (i = 0; i < jtest_host.repeat; i++)
+    {
+        if (pipe(fd) != 0)
+        {
+            break;
+        }
+        pid = fork();
+        if (pid == 0)
+        {
+            close(fd[0]);
+            jtest_host.child_fd = fd[1];
+            jtest_host_touch();
+            return;
+        }
+        close(fd[1]);
+        if (pid > 0 && read(fd[0], result, sizeof(result)) == sizeof(result))
+        {
+            if (jtest_host.best_count == 0 || result[0] < jtest_host.best_cycles)
+            {
+                jtest_host.best_cycles = result[0];
+            }
+            if (jtest_host.best_count == 0 || result[1] < jtest_host.best_ns)
+            {
+                jtest_host.best_ns = result[1];
+            }
+            jtest_host.best_count++;
+        }
+        close(fd[0]);
+        if (pid < 0)
+        {
+            break;
+        }
+        waitpid(pid, NULL, 0);
+    }
+    if (i > 0)
+    {
+        jtest_host_touch();             /* the fork left the test's pages copy on write too */
+    }
+}
+
+/**
+ *  In a forked copy, send its count and exit. In the test, replace the
+ *  count of its own call with the least cycles and time of the copies, if
+ *  any finished.
+ */
+void jtest_host_repeat_end(uint64_t * cycles, uint64_t * ns)
+{
+    uint64_t result[2];
+    ssize_t n;
+
+    if (jtest_host.child_fd >= 0)
+    {
+        result[0] = *cycles;
+        result[1] = *ns;
+        n = write(jtest_host.child_fd, result, sizeof(result));
+        _exit(n == sizeof(result) ? 0 : 1);
+    }
+    if (jtest_host.best_count > 0)
+    {
+        *cycles = jtest_host.best_cycles;
+        *ns = jtest_host.best_ns;
+    }
+}
+
+/*--------------------------------------------------------------------------------*/
+/* JSON Report */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Write s as a JSON string.
+ */
+static void jtest_host_json_str(const char * s)
+{
+    fputc('"', jtest_host.json);
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+        {
+            fputc('\\', jtest_host.json);
+            fputc(*s, jtest_host.json);
+        }
+        else if ((unsigned char) *s < 0x20)
+        {
+            fprintf(jtest_host.json, "\\u%04x", (unsigned char) *s);
+        }
+        else
+        {
+            fputc(*s, jtest_host.json);
+        }
+    }
+    fputc('"', jtest_host.json);
+}
+
+/**
+ *  Group path, "all_tests/filtering_tests/...".
+ */
+static void jtest_host_json_group(void)
+{
+    char path[JTEST_HOST_GROUP_DEPTH * JTEST_HOST_NAME_MAX] = "";
+    int32_t i;
+
+    for (i = 0; i < jtest_host.depth && i < JTEST_HOST_GROUP_DEPTH; i++)
+    {
+        if (i > 0)
+        {
+            strcat(path, "/");
+        }
+        strcat(path, jtest_host.group[i]);
+    }
+    jtest_host_json_str(path);
+}
+
+static void jtest_host_open(void)
+{
+    const char * path = getenv("JTEST_JSON");
+    const char * verbose = getenv("JTEST_VERBOSE");
+    const char * repeat = getenv("JTEST_REPEAT");
+
+    if (jtest_host.json)
+    {
+        return;
+    }
+    if (path == NULL)
+    {
+        path = "jtest_report.json";
+    }
+    jtest_host.json = fopen(path, "w");
+    if (jtest_host.json == NULL)
+    {
+        perror(path);
+        exit(2);
+    }
+    jtest_host.verbose = (verbose != NULL) && (verbose[0] == '1');
+    jtest_host.repeat = repeat ? atoi(repeat) : JTEST_HOST_REPEAT;
+
+    fprintf(jtest_host.json, "{\n  \"platform\": ");
+#if defined(__x86_64__)
+    jtest_host_json_str("linux-x86_64");
+#elif defined(__i386__)
+    jtest_host_json_str("linux-x86");
+#elif defined(__aarch64__)
+    jtest_host_json_str("linux-aarch64");
+#else
+    jtest_host_json_str("linux");
+#endif
+    fprintf(jtest_host.json, ",\n  \"simd\": ");
+    jtest_host_json_str(arm_host_simd_get() == ARM_HOST_SIMD_AVX2 ? "avx2" :
+                        arm_host_simd_get() == ARM_HOST_SIMD_SSE ? "sse" : "none");
+#if defined(__x86_64__) || defined(__i386__)
+    fprintf(jtest_host.json, ",\n  \"cycles\": \"tsc\"");
+#else
+    fprintf(jtest_host.json, ",\n  \"cycles\": \"ns\"");
+#endif
+    fprintf(jtest_host.json, ",\n  \"repeat\": %d", jtest_host.repeat);
+    fprintf(jtest_host.json, ",\n  \"tests\": [");
+}
+
+/**
+ *  Write the test object up to its runs, once the function under test is
+ *  known.
+ */
+static void jtest_host_test_begin(void)
+{
+    fprintf(jtest_host.json, "%s\n    {\"group\": ", jtest_host.test_count ? "," : "");
+    jtest_host_json_group();
+    fprintf(jtest_host.json, ", \"test\": ");
+    jtest_host_json_str(jtest_host.test);
+    fprintf(jtest_host.json, ", \"fut\": ");
+    jtest_host_json_str(jtest_host.fut);
+    fprintf(jtest_host.json, ",\n     \"runs\": [");
+    jtest_host.test_open = 1;
+    jtest_host.test_count++;
+    jtest_host.run_count = 0;
+}
+
+static void jtest_host_run_begin(const char * cycles)
+{
+    uint32_t i;
+
+    if (!jtest_host.test_open)
+    {
+        jtest_host_test_begin();
+    }
+    fprintf(jtest_host.json, "%s\n      {\"params\": {", jtest_host.run_count ? "," : "");
+    for (i = 0; i < jtest_host.param_count; i++)
+    {
+        fprintf(jtest_host.json, "%s", i ? ", " : "");
+        jtest_host_json_str(jtest_host.param[i].key);
+        fprintf(jtest_host.json, ": ");
+        jtest_host_json_str(jtest_host.param[i].value);
+    }
+    fprintf(jtest_host.json, "}, \"cycles\": %" PRIu64, (uint64_t) strtoull(cycles, NULL, 10));
+    jtest_host.run_open = 1;
+    jtest_host.run_count++;
+}
+
+static void jtest_host_run_end(const char * ns)
+{
+    fprintf(jtest_host.json, ", \"ns\": %" PRIu64, (uint64_t) strtoull(ns, NULL, 10));
+    if (jtest_host.first_set)
+    {
+        fprintf(jtest_host.json, ", \"first_cycles\": %" PRIu64 ", \"first_ns\": %" PRIu64,
+                jtest_host.first_cycles, jtest_host.first_ns);
+    }
+    fprintf(jtest_host.json, "}");
+    jtest_host.run_open = 0;
+    jtest_host.first_set = 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Dump Stream */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Copy a name, cut to JTEST_HOST_NAME_MAX - 1 characters.
+ */
+static void jtest_host_name(char * dst, const char * src)
+{
+    size_t len = strlen(src);
+
+    if (len >= JTEST_HOST_NAME_MAX)
+    {
+        len = JTEST_HOST_NAME_MAX - 1;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+/**
+ *  Remember a "Key: value" parameter, a repeated key updates its value.
+ */
+static void jtest_host_param(const char * key, const char * value)
+{
+    uint32_t i;
+
+    for (i = 0; i < jtest_host.param_count; i++)
+    {
+        if (strcmp(jtest_host.param[i].key, key) == 0)
+        {
+            break;
+        }
+    }
+    if (i == JTEST_HOST_PARAM_MAX)
+    {
+        return;
+    }
+    if (i == jtest_host.param_count)
+    {
+        jtest_host_name(jtest_host.param[i].key, key);
+        jtest_host.param_count++;
+    }
+    jtest_host_name(jtest_host.param[i].value, value);
+}
+
+/**
+ *  One line of the dump stream, without its newline.
+ */
+static void jtest_host_line(char * s)
+{
+    char * value;
+    JTEST_HOST_EXPECT_t expect = jtest_host.expect;
+
+    jtest_host.expect = JTEST_HOST_EXPECT_NONE;
+
+    switch (expect)
+    {
+    case JTEST_HOST_EXPECT_GROUP:
+        if (jtest_host.depth > 0 && jtest_host.depth <= JTEST_HOST_GROUP_DEPTH)
+        {
+            jtest_host_name(jtest_host.group[jtest_host.depth - 1], s);
+        }
+        return;
+    case JTEST_HOST_EXPECT_TEST:
+        jtest_host_name(jtest_host.test, s);
+        return;
+    case JTEST_HOST_EXPECT_FUT:
+        jtest_host_name(jtest_host.fut, s);
+        jtest_host_test_begin();
+        return;
+    default:
+        break;
+    }
+
+    if (strcmp(s, "Group Name:") == 0)
+    {
+        jtest_host.expect = JTEST_HOST_EXPECT_GROUP;
+    }
+    else if (strcmp(s, "Test Name:") == 0)
+    {
+        jtest_host.expect = JTEST_HOST_EXPECT_TEST;
+    }
+    else if (strcmp(s, "Function Under Test:") == 0)
+    {
+        jtest_host.expect = JTEST_HOST_EXPECT_FUT;
+    }
+    else if (!jtest_host.in_test)
+    {
+        /* group summaries, nothing to record */
+    }
+    else if (strcmp(s, "Test Passed") == 0)
+    {
+        jtest_host.passed = 1;
+    }
+    else if (strncmp(s, "First: ", 7) == 0)
+    {
+        jtest_host.first_set = sscanf(s + 7, "%" SCNu64 " cycles %" SCNu64,
+                                      &jtest_host.first_cycles, &jtest_host.first_ns) == 2;
+    }
+    else if (strncmp(s, "Cycles: ", 8) == 0)
+    {
+        jtest_host_run_begin(s + 8);
+    }
+    else if (strncmp(s, "Time: ", 6) == 0 && jtest_host.run_open)
+    {
+        jtest_host_run_end(s + 6);
+    }
+    else if ((value = strstr(s, ": ")) != NULL)
+    {
+        *value = '\0';
+        jtest_host_param(s, value + 2);
+    }
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Action Triggers */
+/*--------------------------------------------------------------------------------*/
+
+void test_start(void)
+{
+    JTEST_FW.test_start++;
+    jtest_host_open();
+    jtest_host.in_test = 1;
+    jtest_host.test_open = 0;
+    jtest_host.run_open = 0;
+    jtest_host.passed = 0;
+    jtest_host.param_count = 0;
+    jtest_host.test[0] = '\0';
+    jtest_host.fut[0] = '\0';
+}
+
+void test_end(void)
+{
+    const char * result = jtest_host.passed ? "pass" : "fail";
+
+    JTEST_FW.test_end++;
+    if (!jtest_host.test_open)
+    {
+        jtest_host_test_begin();
+    }
+    if (jtest_host.run_open)
+    {
+        jtest_host_run_end("0");
+    }
+    fprintf(jtest_host.json, "%s],\n     \"result\": \"%s\"}",
+            jtest_host.run_count ? "\n     " : "", result);
+    printf("%s  %s\n", jtest_host.passed ? "PASS" : "FAIL", jtest_host.test);
+    jtest_host.in_test = 0;
+}
+
+void group_start(void)
+{
+    JTEST_FW.group_start++;
+    jtest_host_open();
+    if (jtest_host.depth < JTEST_HOST_GROUP_DEPTH)
+    {
+        jtest_host.group[jtest_host.depth][0] = '\0';
+    }
+    jtest_host.depth++;
+}
+
+void group_end(void)
+{
+    JTEST_FW.group_end++;
+    if (jtest_host.depth > 0)
+    {
+        jtest_host.depth--;
+    }
+}
+
+/**
+ *  Called once per segment of at most JTEST_STR_MAX_OUTPUT_SIZE characters,
+ *  the same chunks the debugger reads.
+ */
+void dump_str(void)
+{
+    const char * s = JTEST_FW.str_buffer;
+    uint32_t n = 0;
+
+    JTEST_FW.dump_str++;
+    if (jtest_host.verbose)
+    {
+        printf("%.*s", (int) JTEST_STR_MAX_OUTPUT_SIZE, s);
+    }
+    for (; n < JTEST_STR_MAX_OUTPUT_SIZE && s[n] != '\0'; n++)
+    {
+        if (s[n] == '\n')
+        {
+            jtest_host.line[jtest_host.line_len] = '\0';
+            jtest_host_line(jtest_host.line);
+            jtest_host.line_len = 0;
+        }
+        else if (jtest_host.line_len < JTEST_HOST_LINE_MAX - 1)
+        {
+            jtest_host.line[jtest_host.line_len++] = s[n];
+        }
+    }
+}
+
+void dump_data(void)
+{
+    JTEST_FW.dump_data++;
+}
+
+/**
+ *  Close the report and exit, non zero if a test failed.
+ */
+void exit_fw(void)
+{
+    JTEST_FW.exit_fw++;
+    jtest_host_open();
+    fprintf(jtest_host.json,
+            "\n  ],\n  \"passed\": %" PRIu32 ",\n  \"failed\": %" PRIu32 "\n}\n",
+            JTEST_FW.passed, JTEST_FW.failed);
+    fclose(jtest_host.json);
+    printf("Passed: %" PRIu32 "  Failed: %" PRIu32 "\n", JTEST_FW.passed, JTEST_FW.failed);
+    exit(JTEST_FW.failed ? 1 : 0);
+}
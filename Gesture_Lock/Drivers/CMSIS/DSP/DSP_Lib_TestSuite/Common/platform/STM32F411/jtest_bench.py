@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+"""Capture and compare JTest benchmark runs.
+
+  jtest_bench.py run PORT [-g GROUP ...] [-o run.json] [-t run.txt]
+      Start a run on the Gesture_Lock_Bench image over USB CDC (CmdBench,
+      see Inc/cmd.h and Inc/bench.h) and write the JSON report.
+  jtest_bench.py parse run.txt [-o run.json]
+      Build the report from a saved dump stream.
+  jtest_bench.py diff old.json new.json [--threshold PCT]
+      Compare the cycles of two reports, per test and run. Reports of the
+      Linux port (platform/Linux) have the same layout.
+
+The report is the one jtest_linux.c writes: a list of tests with their
+group path, function under test and one run per timed call, each with the
+parameter lines printed before it and its cycle count. Needs pyserial for
+"run".
+"""
+
+import argparse
+import json
+import sys
+import time
+
+CMD_BENCH = 0xBE
+CMD_BENCH_END = 0xBF
+CMD_OK = 0
+GROUPS = ["basic_math_tests", "complex_math_tests", "fast_math_tests",
+          "filtering_tests", "statistics_tests", "support_tests"]  # JTEST_BENCH_GROUP_TABLE
+
+
+# ----------------------------------------------------------------------------
+# Framing, as in Src/cmd.c
+# ----------------------------------------------------------------------------
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_at, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+        else:
+            out.append(b)
+            code += 1
+            if code == 0xFF:
+                out[code_at] = code
+                code_at, code = len(out), 1
+                out.append(0)
+    out[code_at] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    r = 0
+    while r < len(data):
+        code = data[r]
+        r += 1
+        if code == 0 or r + code - 1 > len(data):
+            return None
+        out += data[r:r + code - 1]
+        r += code - 1
+        if code != 0xFF and r < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def frame(cmd, seq, payload=b""):
+    raw = bytes([cmd, seq]) + payload
+    crc = crc16(raw)
+    return b"\x00" + cobs_encode(raw + bytes([crc >> 8, crc & 0xFF])) + b"\x00"
+
+
+def read_frames(port, timeout):
+    """Yield (cmd, seq, payload) of good frames, text between frames is skipped."""
+    buf = bytearray()
+    last = time.time()
+    while True:
+        chunk = port.read(4096)
+        if chunk:
+            last = time.time()
+            buf += chunk
+        elif time.time() - last > timeout:
+            raise TimeoutError("no data for %d s" % timeout)
+        while b"\x00" in buf:
+            end = buf.index(0)
+            enc = bytes(buf[:end])
+            del buf[:end + 1]
+            if not enc:
+                continue
+            raw = cobs_decode(enc)
+            if raw is None or len(raw) < 4:
+                continue
+            if crc16(raw[:-2]) != (raw[-2] << 8 | raw[-1]):
+                continue
+            yield raw[0], raw[1], raw[2:-2]
+
+
+# ----------------------------------------------------------------------------
+# Dump stream to report, as in platform/Linux/jtest_linux.c
+# ----------------------------------------------------------------------------
+
+def parse_stream(text):
+    tests = []
+    groups = []
+    expect = None
+    test = None
+    params = {}
+    for line in text.split("\n"):
+        if expect == "group":
+            groups[-1] = line
+            expect = None
+            continue
+        if expect == "test":
+            test = {"group": "/".join(groups), "test": line, "fut": "", "runs": [],
+                    "result": "fail"}
+            params = {}
+            tests.append(test)
+            expect = None
+            continue
+        if expect == "fut":
+            test["fut"] = line
+            expect = None
+            continue
+        if line == "Group Name:":
+            groups.append("")
+            expect = "group"
+        elif line == "Test Name:":
+            expect = "test"
+        elif line == "Function Under Test:":
+            expect = "fut"
+        elif line.startswith("Tests Run:"):
+            # summary printed once a group has returned
+            if groups:
+                groups.pop()
+            test = None
+        elif test is None:
+            pass
+        elif line == "Test Passed":
+            test["result"] = "pass"
+        elif line == "Test Failed":
+            test["result"] = "fail"
+        elif line.startswith("Cycles: "):
+            test["runs"].append({"params": dict(params), "cycles": int(line[8:])})
+        elif line.startswith("Time: ") and test["runs"]:
+            test["runs"][-1]["ns"] = int(line[6:].split()[0])
+        elif ": " in line:
+            key, value = line.split(": ", 1)
+            params[key] = value
+    return tests
+
+
+def report(tests, **info):
+    rep = dict(info)
+    rep["tests"] = tests
+    rep["passed"] = sum(t["result"] == "pass" for t in tests)
+    rep["failed"] = sum(t["result"] != "pass" for t in tests)
+    return rep
+
+
+def u32(b, i):
+    return int.from_bytes(b[i:i + 4], "big")
+
+
+# ----------------------------------------------------------------------------
+# Commands
+# ----------------------------------------------------------------------------
+
+def cmd_run(args):
+    import serial
+
+    mask = 0
+    for g in args.group or GROUPS:
+        if g not in GROUPS:
+            sys.exit("unknown group %s, one of %s" % (g, ", ".join(GROUPS)))
+        mask |= 1 << GROUPS.index(g)
+    seq = 0x5A
+    text = []
+    info = {"platform": "stm32f411", "cycles": "dwt"}
+    with serial.Serial(args.port, timeout=0.1) as port:
+        port.reset_input_buffer()
+        port.write(frame(CMD_BENCH, seq, mask.to_bytes(4, "big")))
+        for cmd, fseq, data in read_frames(port, args.timeout):
+            if cmd == CMD_BENCH and fseq == seq:
+                if data[0] != CMD_OK:
+                    sys.exit("CmdBench refused, status %d" % data[0])
+                info["clock_hz"] = u32(data, 2)
+                info["flash_acr"] = "0x%08X" % u32(data, 6)
+                info["latency"] = u32(data, 6) & 0xF
+                info["dwt_overhead"] = u32(data, 10)
+            elif cmd == CMD_BENCH:
+                text.append(data.decode("ascii", "replace"))
+                if args.verbose:
+                    sys.stdout.write(text[-1])
+            elif cmd == CMD_BENCH_END:
+                info["chunks"] = u32(data, 8)
+                info["dropped"] = u32(data, 12)
+                info["run_ms"] = u32(data, 16)
+                break
+    text = "".join(text)
+    if args.text:
+        with open(args.text, "w") as f:
+            f.write(text)
+    tests = parse_stream(text)
+    if "clock_hz" in info:
+        for t in tests:
+            for r in t["runs"]:
+                r["ns"] = r["cycles"] * 1000000000 // info["clock_hz"]
+    rep = report(tests, **info)
+    write_report(rep, args.output)
+    if info.get("dropped"):
+        print("warning: %d chunks dropped, the report is incomplete" % info["dropped"])
+    return 1 if rep["failed"] else 0
+
+
+def cmd_parse(args):
+    with open(args.text) as f:
+        rep = report(parse_stream(f.read()), platform="stm32f411", cycles="dwt")
+    write_report(rep, args.output)
+    return 1 if rep["failed"] else 0
+
+
+def write_report(rep, path):
+    with open(path, "w") as f:
+        json.dump(rep, f, indent=1)
+    print("%s: %d tests, passed %d, failed %d" %
+          (path, len(rep["tests"]), rep["passed"], rep["failed"]))
+
+
+def runs_by_key(rep):
+    """(group, test, n) -> run, n counts runs of one test in order."""
+    out = {}
+    for t in rep["tests"]:
+        for n, r in enumerate(t["runs"]):
+            out[(t["group"], t["test"], n)] = (t, r)
+    return out
+
+
+def cmd_diff(args):
+    with open(args.old) as f:
+        old = json.load(f)
+    with open(args.new) as f:
+        new = json.load(f)
+    a = runs_by_key(old)
+    b = runs_by_key(new)
+    worse = better = 0
+    for key in sorted(set(a) & set(b)):
+        t, ra = a[key]
+        rb = b[key][1]
+        if ra["cycles"] == 0:
+            continue
+        pct = 100.0 * (rb["cycles"] - ra["cycles"]) / ra["cycles"]
+        if abs(pct) < args.threshold:
+            continue
+        if pct > 0:
+            worse += 1
+        else:
+            better += 1
+        p = " ".join("%s=%s" % kv for kv in sorted(ra["params"].items()))
+        print("%-28s %-40s %10d -> %10d  %+7.1f%%" %
+              (t["fut"], p[:40], ra["cycles"], rb["cycles"], pct))
+    only = len(set(a) ^ set(b))
+    print("runs compared %d, slower %d, faster %d (threshold %.1f%%), unmatched %d" %
+          (len(set(a) & set(b)), worse, better, args.threshold, only))
+    for t in new["tests"]:
+        if t["result"] != "pass":
+            print("FAIL  %s" % t["test"])
+    return 1 if worse or new.get("failed") else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("run", help="run the benchmark image")
+    p.add_argument("port")
+    p.add_argument("-g", "--group", action="append", help="group to run, default all")
+    p.add_argument("-o", "--output", default="bench_report.json")
+    p.add_argument("-t", "--text", help="also save the dump stream")
+    p.add_argument("--timeout", type=float, default=10)
+    p.add_argument("-v", "--verbose", action="store_true")
+    p = sub.add_parser("parse", help="report from a saved dump stream")
+    p.add_argument("text")
+    p.add_argument("-o", "--output", default="bench_report.json")
+    p = sub.add_parser("diff", help="compare two reports")
+    p.add_argument("old")
+    p.add_argument("new")
+    p.add_argument("--threshold", type=float, default=2.0, help="percent, default 2")
+    args = ap.parse_args()
+    return {"run": cmd_run, "parse": cmd_parse, "diff": cmd_diff}[args.cmd](args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,152 @@
+/*----------------------------------------------------------------------------
+ * Name:    jtest_f411.c
+ * Purpose: STM32F411 benchmark platform layer of the JTest framework (JTEST_DWT)
+ * Note(s): Built into the Gesture_Lock_Bench target next to the application
+ *          HAL, so kernels are timed at the clock and flash wait states the
+ *          gesture pipeline runs at. Replaces jtest_trigger_action.c: the
+ *          dump stream the Keil debugger script would read is handed to the
+ *          application with jtest_bench_write(), which sends it over USB
+ *          CDC. The groups are chosen at build time by
+ *          JTEST_BENCH_GROUP_TABLE and per run by a mask.
+ *----------------------------------------------------------------------------*/
+
+#include "jtest.h"
+#include "jtest_f411.h"
+#include "basic_math_test_group.h"
+#include "complex_math_test_group.h"
+#include "fast_math_test_group.h"
+#include "filtering_test_group.h"
+#include "statistics_test_group.h"
+#include "support_test_group.h"
+
+/*--------------------------------------------------------------------------------*/
+/* Macros and Defines */
+/*--------------------------------------------------------------------------------*/
+#define JTEST_BENCH_GROUP_NAME(group_fn) #group_fn,
+
+#define JTEST_BENCH_GROUP_CALL(group_fn)                        \
+    if (jtest_bench_mask & (1UL << JTEST_BENCH_##group_fn))     \
+    {                                                           \
+        JTEST_GROUP_CALL(group_fn);                             \
+    }
+
+/*--------------------------------------------------------------------------------*/
+/* Define Module Variables */
+/*--------------------------------------------------------------------------------*/
+uint32_t jtest_dwt_overhead;
+
+const char * const jtest_bench_group_name[JTEST_BENCH_GROUP_NUM] =
+{
+    JTEST_BENCH_GROUP_TABLE(JTEST_BENCH_GROUP_NAME)
+};
+
+static uint32_t jtest_bench_mask;
+
+/*--------------------------------------------------------------------------------*/
+/* DWT Timing */
+/*--------------------------------------------------------------------------------*/
+
+void jtest_dwt_init(void)
+{
+    uint32_t start;
+    uint32_t count;
+    uint32_t i;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /* Smallest count of an empty call, the same two reads as
+     * JTEST_COUNT_CYCLES */
+    jtest_dwt_overhead = 0xFFFFFFFFU;
+    for (i = 0; i < 16; i++)
+    {
+        __disable_irq();
+        start = DWT->CYCCNT;
+        count = DWT->CYCCNT - start;
+        __enable_irq();
+        if (count < jtest_dwt_overhead)
+        {
+            jtest_dwt_overhead = count;
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Benchmark Groups */
+/*--------------------------------------------------------------------------------*/
+
+JTEST_DEFINE_GROUP(bench_tests)
+{
+    JTEST_BENCH_GROUP_TABLE(JTEST_BENCH_GROUP_CALL)
+}
+
+uint32_t jtest_bench_run(uint32_t mask)
+{
+    JTEST_INIT();
+    JTEST_PF_RESET_PASSED(&JTEST_FW);
+    JTEST_PF_RESET_FAILED(&JTEST_FW);
+    JTEST_SET_CURRENT_GROUP(NULL);
+
+    jtest_bench_mask = mask;
+    JTEST_GROUP_CALL(bench_tests);
+    JTEST_ACT_EXIT_FW();
+
+    return JTEST_FW.failed;
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Action Triggers */
+/*--------------------------------------------------------------------------------*/
+
+void test_start(void)
+{
+    JTEST_FW.test_start++;
+}
+
+void test_end(void)
+{
+    JTEST_FW.test_end++;
+}
+
+void group_start(void)
+{
+    JTEST_FW.group_start++;
+}
+
+void group_end(void)
+{
+    JTEST_FW.group_end++;
+}
+
+/**
+ *  Called once per segment of at most JTEST_STR_MAX_OUTPUT_SIZE characters,
+ *  the same chunks the debugger reads.
+ */
+void dump_str(void)
+{
+    const char * s = JTEST_FW.str_buffer;
+    uint32_t n = 0;
+
+    JTEST_FW.dump_str++;
+    while (n < JTEST_STR_MAX_OUTPUT_SIZE && s[n] != '\0')
+    {
+        n++;
+    }
+    if (n > 0)
+    {
+        jtest_bench_write(s, n);
+    }
+}
+
+void dump_data(void)
+{
+    JTEST_FW.dump_data++;
+}
+
+/**
+ *  The caller of jtest_bench_run() reports the totals.
+ */
+void exit_fw(void)
+{
+    JTEST_FW.exit_fw++;
+}
@@ -0,0 +1,67 @@
+#ifndef _JTEST_F411_H_
+#define _JTEST_F411_H_
+
+/*--------------------------------------------------------------------------------*/
+/* Includes */
+/*--------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*--------------------------------------------------------------------------------*/
+/* Macros and Defines */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Test groups linked into the benchmark image, in run order. The bit of a
+ *  group in the run mask is its position here. transform_tests needs about
+ *  200 KB of buffers and does not fit the F411, matrix_tests,
+ *  controller_tests and intrinsics_tests are left out to save flash. A
+ *  group added here needs its sources in the Gesture_Lock_Bench target.
+ */
+#define JTEST_BENCH_GROUP_TABLE(X)              \
+    X(basic_math_tests)                         \
+    X(complex_math_tests)                       \
+    X(fast_math_tests)                          \
+    X(filtering_tests)                          \
+    X(statistics_tests)                         \
+    X(support_tests)
+
+#define JTEST_BENCH_GROUP_ID(group_fn) JTEST_BENCH_##group_fn,
+
+/*--------------------------------------------------------------------------------*/
+/* Type Definitions */
+/*--------------------------------------------------------------------------------*/
+
+typedef enum
+{
+    JTEST_BENCH_GROUP_TABLE(JTEST_BENCH_GROUP_ID)
+    JTEST_BENCH_GROUP_NUM
+} JTEST_BENCH_GROUP_t;
+
+/*--------------------------------------------------------------------------------*/
+/* Declare Module Variables */
+/*--------------------------------------------------------------------------------*/
+extern const char * const jtest_bench_group_name[JTEST_BENCH_GROUP_NUM];
+
+/*--------------------------------------------------------------------------------*/
+/* Function Prototypes */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Run the groups whose bits are set in mask. The dump stream goes to
+ *  jtest_bench_write(). Returns the number of failed tests.
+ */
+uint32_t jtest_bench_run(uint32_t mask);
+
+/**
+ *  Enable the DWT cycle counter and measure the cost of reading it.
+ */
+void jtest_dwt_init(void);
+
+/**
+ *  Provided by the application: send len characters of the dump stream. It
+ *  may wait for room, it is never called with interrupts masked.
+ */
+void jtest_bench_write(const char * str, uint32_t len);
+
+#endif /* _JTEST_F411_H_ */
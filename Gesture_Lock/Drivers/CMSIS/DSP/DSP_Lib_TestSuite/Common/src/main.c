@@ -10,8 +10,10 @@ asm(" .global __ARM_use_no_argv\n");
 
 void debug_init(void)
 {
+#if !defined(ARM_MATH_HOST)
     uint32_t * SHCSR_ptr = (uint32_t *) 0xE000ED24; /* System Handler Control and State Register */
     *SHCSR_ptr |= 0x70000;             /* Enable  UsageFault, BusFault, and MemManage fault*/
+#endif
 }
 
 int main(void)
@@ -22,6 +24,6 @@ int main(void)
 
     JTEST_GROUP_CALL(all_tests); /* Run all tests. */
 
-    JTEST_ACT_EXIT_FW();        /* Exit test framework.  */
+    JTEST_ACT_EXIT_FW();        /* Exit test framework. The host build exits here. */
     while (1);                   /* Never return. */
 }
@@ -0,0 +1,75 @@
+/******************************************************************************
+ * @file     arm_host_simd.h
+ * @brief    SSE / AVX2 backends of the floating-point kernels for the host
+ *           build of the CMSIS DSP Library (ARM_MATH_HOST)
+ ******************************************************************************/
+/*
+ * Included by arm_math.h when ARM_MATH_HOST is defined. On an x86 host
+ * built with GCC or Clang, each kernel listed below checks its pointer on
+ * entry and, when it is set, hands the whole call to the vector version.
+ * The public signatures do not change and the scalar Cortex-M4 path stays
+ * the fallback, so a build for another host, or with ARM_MATH_HOST_NO_SIMD,
+ * is the plain portable library.
+ *
+ * The pointers are filled once at load time from CPUID: AVX2 with FMA if
+ * the CPU and OS support it, else SSE2. The environment variable
+ * ARM_HOST_SIMD=none|sse|avx2 overrides the choice, arm_host_simd_select()
+ * changes it at run time (not thread safe, call it between kernels).
+ *
+ * Results agree with the scalar path within rounding: the vector kernels
+ * sum in a different order, the AVX2 ones use fused multiply-add. The
+ * biquad keeps the scalar operation order per stage and is bit exact.
+ */
+
+#ifndef _ARM_HOST_SIMD_H
+#define _ARM_HOST_SIMD_H
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__) && !defined (ARM_MATH_HOST_NO_SIMD)
+  #define ARM_MATH_HOST_X86
+#endif
+
+#ifdef   __cplusplus
+extern "C"
+{
+#endif
+
+typedef enum
+{
+  ARM_HOST_SIMD_NONE = 0,     /**< scalar Cortex-M4 paths */
+  ARM_HOST_SIMD_SSE  = 1,     /**< SSE2 */
+  ARM_HOST_SIMD_AVX2 = 2      /**< AVX2 and FMA */
+} arm_host_simd_level;
+
+#if defined (ARM_MATH_HOST_X86)
+
+/* NULL: the kernel runs its scalar code */
+extern void (*arm_host_dot_prod_f32)(float32_t * pSrcA, float32_t * pSrcB, uint32_t blockSize, float32_t * result);
+extern void (*arm_host_mean_f32)(float32_t * pSrc, uint32_t blockSize, float32_t * pResult);
+extern void (*arm_host_var_f32)(float32_t * pSrc, uint32_t blockSize, float32_t * pResult);
+extern void (*arm_host_rms_f32)(float32_t * pSrc, uint32_t blockSize, float32_t * pResult);
+extern void (*arm_host_fir_f32)(const arm_fir_instance_f32 * S, float32_t * pSrc, float32_t * pDst, uint32_t blockSize);
+extern void (*arm_host_fir_decimate_f32)(const arm_fir_decimate_instance_f32 * S, float32_t * pSrc, float32_t * pDst, uint32_t blockSize);
+extern void (*arm_host_biquad_cascade_df2T_f32)(const arm_biquad_cascade_df2T_instance_f32 * S, float32_t * pSrc, float32_t * pDst, uint32_t blockSize);
+extern void (*arm_host_stage_rfft_f32)(arm_rfft_fast_instance_f32 * S, float32_t * p, float32_t * pOut);
+extern void (*arm_host_merge_rfft_f32)(arm_rfft_fast_instance_f32 * S, float32_t * p, float32_t * pOut);
+
+#endif /* ARM_MATH_HOST_X86 */
+
+/**
+ * @brief  Select the backend of the host kernels.
+ * @param[in] level  wanted arm_host_simd_level, lowered to what the CPU supports.
+ * @return level in use.
+ */
+arm_host_simd_level arm_host_simd_select(arm_host_simd_level level);
+
+/**
+ * @brief  Backend in use.
+ * @return arm_host_simd_level.
+ */
+arm_host_simd_level arm_host_simd_get(void);
+
+#ifdef   __cplusplus
+}
+#endif
+
+#endif /* _ARM_HOST_SIMD_H */
@@ -0,0 +1,282 @@
+/******************************************************************************
+ * @file     arm_math_host.h
+ * @brief    Cortex-M4 intrinsics in portable C for a host build of the
+ *           CMSIS DSP Library (ARM_MATH_HOST)
+ ******************************************************************************/
+/*
+ * Included by arm_math.h in place of core_cm4.h when ARM_MATH_HOST is
+ * defined. ARM_MATH_DSP stays defined, so the kernels take the same
+ * Cortex-M4 paths as the firmware. Every intrinsic gives the result of the
+ * instruction bit for bit: wrap-around where the instruction wraps,
+ * saturation where it saturates. The Q flag is not modelled, no kernel
+ * reads it.
+ *
+ * Arithmetic is done on unsigned or 64 bit values so that no step relies
+ * on signed overflow or on shifting negative values left.
+ */
+
+#ifndef _ARM_MATH_HOST_H
+#define _ARM_MATH_HOST_H
+
+#include <stdint.h>
+
+#ifndef   __STATIC_INLINE
+  #define __STATIC_INLINE             static inline
+#endif
+#ifndef   __STATIC_FORCEINLINE
+  #define __STATIC_FORCEINLINE        __attribute__((always_inline)) static inline
+#endif
+#ifndef   __INLINE
+  #define __INLINE                    inline
+#endif
+#ifndef   __ASM
+  #define __ASM                       __asm
+#endif
+
+/* the kernels read q7/q15 buffers through int32_t pointers (__SIMD32),
+   which the ARM compilers allow; GCC needs strict aliasing off for it.
+   Other compilers: build the library with -fno-strict-aliasing. */
+#if defined (__GNUC__) && !defined (__clang__)
+  #pragma GCC optimize ("no-strict-aliasing")
+#endif
+
+#define __FPU_PRESENT                 0U
+#define __FPU_USED                    0U
+#define __DSP_PRESENT                 1U
+
+/* halfword and byte lanes, sign extended */
+#define __HOST_LO16(x)  ((int32_t)(int16_t)(uint16_t)(x))
+#define __HOST_HI16(x)  ((int32_t)(int16_t)(uint16_t)((uint32_t)(x) >> 16))
+#define __HOST_B(x, n)  ((int32_t)(int8_t)(uint8_t)((uint32_t)(x) >> (8 * (n))))
+
+__STATIC_FORCEINLINE int32_t __SSAT(int32_t val, uint32_t sat)
+{
+  if ((sat >= 1U) && (sat <= 32U))
+  {
+    const int32_t max = (int32_t)((1U << (sat - 1U)) - 1U);
+    const int32_t min = -1 - max;
+    if (val > max)
+    {
+      return max;
+    }
+    else if (val < min)
+    {
+      return min;
+    }
+  }
+  return val;
+}
+
+__STATIC_FORCEINLINE uint32_t __USAT(int32_t val, uint32_t sat)
+{
+  if (sat <= 31U)
+  {
+    const uint32_t max = ((1U << sat) - 1U);
+    if (val > (int32_t)max)
+    {
+      return max;
+    }
+    else if (val < 0)
+    {
+      return 0U;
+    }
+  }
+  return (uint32_t)val;
+}
+
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value)
+{
+  return (value == 0U) ? 32U : (uint8_t)__builtin_clz(value);
+}
+
+__STATIC_FORCEINLINE uint32_t __ROR(uint32_t op1, uint32_t op2)
+{
+  op2 %= 32U;
+  return (op2 == 0U) ? op1 : ((op1 >> op2) | (op1 << (32U - op2)));
+}
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value)
+{
+  return __builtin_bswap32(value);
+}
+
+__STATIC_FORCEINLINE int32_t __QADD(int32_t op1, int32_t op2)
+{
+  int64_t r = (int64_t)op1 + op2;
+  return (r > INT32_MAX) ? INT32_MAX : (r < INT32_MIN) ? INT32_MIN : (int32_t)r;
+}
+
+__STATIC_FORCEINLINE int32_t __QSUB(int32_t op1, int32_t op2)
+{
+  int64_t r = (int64_t)op1 - op2;
+  return (r > INT32_MAX) ? INT32_MAX : (r < INT32_MIN) ? INT32_MIN : (int32_t)r;
+}
+
+__STATIC_FORCEINLINE uint32_t __QADD8(uint32_t op1, uint32_t op2)
+{
+  uint32_t r = 0U;
+  int n;
+  for (n = 0; n < 4; n++)
+  {
+    r |= ((uint32_t)__SSAT(__HOST_B(op1, n) + __HOST_B(op2, n), 8U) & 0xFFU) << (8 * n);
+  }
+  return r;
+}
+
+__STATIC_FORCEINLINE uint32_t __QSUB8(uint32_t op1, uint32_t op2)
+{
+  uint32_t r = 0U;
+  int n;
+  for (n = 0; n < 4; n++)
+  {
+    r |= ((uint32_t)__SSAT(__HOST_B(op1, n) - __HOST_B(op2, n), 8U) & 0xFFU) << (8 * n);
+  }
+  return r;
+}
+
+/* pack two halfword results, bottom first */
+#define __HOST_PACK16(lo, hi)  ((((uint32_t)(lo)) & 0xFFFFU) | (((uint32_t)(hi)) << 16))
+
+__STATIC_FORCEINLINE uint32_t __QADD16(uint32_t op1, uint32_t op2)
+{
+  return __HOST_PACK16(__SSAT(__HOST_LO16(op1) + __HOST_LO16(op2), 16U),
+                       __SSAT(__HOST_HI16(op1) + __HOST_HI16(op2), 16U));
+}
+
+__STATIC_FORCEINLINE uint32_t __QSUB16(uint32_t op1, uint32_t op2)
+{
+  return __HOST_PACK16(__SSAT(__HOST_LO16(op1) - __HOST_LO16(op2), 16U),
+                       __SSAT(__HOST_HI16(op1) - __HOST_HI16(op2), 16U));
+}
+
+__STATIC_FORCEINLINE uint32_t __SHADD16(uint32_t op1, uint32_t op2)
+{
+  return __HOST_PACK16((__HOST_LO16(op1) + __HOST_LO16(op2)) >> 1,
+                       (__HOST_HI16(op1) + __HOST_HI16(op2)) >> 1);
+}
+
+__STATIC_FORCEINLINE uint32_t __SHSUB16(uint32_t op1, uint32_t op2)
+{
+  return __HOST_PACK16((__HOST_LO16(op1) - __HOST_LO16(op2)) >> 1,
+                       (__HOST_HI16(op1) - __HOST_HI16(op2)) >> 1);
+}
+
+__STATIC_FORCEINLINE uint32_t __QASX(uint32_t op1, uint32_t op2)
+{
+  return __HOST_PACK16(__SSAT(__HOST_LO16(op1) - __HOST_HI16(op2), 16U),
+                       __SSAT(__HOST_HI16(op1) + __HOST_LO16(op2), 16U));
+}
+
+__STATIC_FORCEINLINE uint32_t __SHASX(uint32_t op1, uint32_t op2)
+{
+  return __HOST_PACK16((__HOST_LO16(op1) - __HOST_HI16(op2)) >> 1,
+                       (__HOST_HI16(op1) + __HOST_LO16(op2)) >> 1);
+}
+
+__STATIC_FORCEINLINE uint32_t __QSAX(uint32_t op1, uint32_t op2)
+{
+  return __HOST_PACK16(__SSAT(__HOST_LO16(op1) + __HOST_HI16(op2), 16U),
+                       __SSAT(__HOST_HI16(op1) - __HOST_LO16(op2), 16U));
+}
+
+__STATIC_FORCEINLINE uint32_t __SHSAX(uint32_t op1, uint32_t op2)
+{
+  return __HOST_PACK16((__HOST_LO16(op1) + __HOST_HI16(op2)) >> 1,
+                       (__HOST_HI16(op1) - __HOST_LO16(op2)) >> 1);
+}
+
+/* dual 16x16 multiplies, sums wrap modulo 2^32 like the instruction */
+__STATIC_FORCEINLINE uint32_t __SMUAD(uint32_t op1, uint32_t op2)
+{
+  return (uint32_t)(__HOST_LO16(op1) * __HOST_LO16(op2)) +
+         (uint32_t)(__HOST_HI16(op1) * __HOST_HI16(op2));
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUADX(uint32_t op1, uint32_t op2)
+{
+  return (uint32_t)(__HOST_LO16(op1) * __HOST_HI16(op2)) +
+         (uint32_t)(__HOST_HI16(op1) * __HOST_LO16(op2));
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUSD(uint32_t op1, uint32_t op2)
+{
+  return (uint32_t)(__HOST_LO16(op1) * __HOST_LO16(op2)) -
+         (uint32_t)(__HOST_HI16(op1) * __HOST_HI16(op2));
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUSDX(uint32_t op1, uint32_t op2)
+{
+  return (uint32_t)(__HOST_LO16(op1) * __HOST_HI16(op2)) -
+         (uint32_t)(__HOST_HI16(op1) * __HOST_LO16(op2));
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLAD(uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  return __SMUAD(op1, op2) + op3;
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLADX(uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  return __SMUADX(op1, op2) + op3;
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLSD(uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  return __SMUSD(op1, op2) + op3;
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLSDX(uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  return __SMUSDX(op1, op2) + op3;
+}
+
+/* 64 bit accumulators wrap modulo 2^64 */
+__STATIC_FORCEINLINE uint64_t __SMLALD(uint32_t op1, uint32_t op2, uint64_t acc)
+{
+  return acc + (uint64_t)(int64_t)(__HOST_LO16(op1) * __HOST_LO16(op2)) +
+               (uint64_t)(int64_t)(__HOST_HI16(op1) * __HOST_HI16(op2));
+}
+
+__STATIC_FORCEINLINE uint64_t __SMLALDX(uint32_t op1, uint32_t op2, uint64_t acc)
+{
+  return acc + (uint64_t)(int64_t)(__HOST_LO16(op1) * __HOST_HI16(op2)) +
+               (uint64_t)(int64_t)(__HOST_HI16(op1) * __HOST_LO16(op2));
+}
+
+__STATIC_FORCEINLINE uint64_t __SMLSLD(uint32_t op1, uint32_t op2, uint64_t acc)
+{
+  return acc + (uint64_t)(int64_t)(__HOST_LO16(op1) * __HOST_LO16(op2)) -
+               (uint64_t)(int64_t)(__HOST_HI16(op1) * __HOST_HI16(op2));
+}
+
+__STATIC_FORCEINLINE uint64_t __SMLSLDX(uint32_t op1, uint32_t op2, uint64_t acc)
+{
+  return acc + (uint64_t)(int64_t)(__HOST_LO16(op1) * __HOST_HI16(op2)) -
+               (uint64_t)(int64_t)(__HOST_HI16(op1) * __HOST_LO16(op2));
+}
+
+/* top word of op3:0 + op1*op2, truncated */
+__STATIC_FORCEINLINE int32_t __SMMLA(int32_t op1, int32_t op2, int32_t op3)
+{
+  return (int32_t)((((uint64_t)(uint32_t)op3 << 32) + (uint64_t)((int64_t)op1 * op2)) >> 32);
+}
+
+__STATIC_FORCEINLINE uint32_t __SXTB16(uint32_t op1)
+{
+  return __HOST_PACK16(__HOST_B(op1, 0), __HOST_B(op1, 2));
+}
+
+__STATIC_FORCEINLINE uint32_t __SXTAB16(uint32_t op1, uint32_t op2)
+{
+  return __HOST_PACK16(__HOST_LO16(op1) + __HOST_B(op2, 0),
+                       __HOST_HI16(op1) + __HOST_B(op2, 2));
+}
+
+/* ARG3 is a constant shift, 0 for PKHTB keeps the top of ARG1 and the
+   bottom of ARG2 unshifted, as in cmsis_gcc.h */
+#define __PKHBT(ARG1, ARG2, ARG3) \
+  ((int32_t)((((uint32_t)(ARG1)) & 0x0000FFFFU) | ((((uint32_t)(ARG2)) << (ARG3)) & 0xFFFF0000U)))
+#define __PKHTB(ARG1, ARG2, ARG3) \
+  ((int32_t)((((uint32_t)(ARG1)) & 0xFFFF0000U) | (((uint32_t)((int32_t)(ARG2) >> (ARG3))) & 0x0000FFFFU)))
+
+#endif /* _ARM_MATH_HOST_H */
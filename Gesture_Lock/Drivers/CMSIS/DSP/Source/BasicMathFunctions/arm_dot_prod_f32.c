@@ -69,6 +69,14 @@ void arm_dot_prod_f32(
   float32_t sum = 0.0f;                          /* Temporary result storage */
   uint32_t blkCnt;                               /* loop counter */
 
+#if defined (ARM_MATH_HOST_X86)
+  /* SSE / AVX2 version on a PC, see arm_host_simd.h */
+  if (arm_host_dot_prod_f32 != NULL)
+  {
+    arm_host_dot_prod_f32(pSrcA, pSrcB, blockSize, result);
+    return;
+  }
+#endif
 
 #if defined (ARM_MATH_DSP)
 
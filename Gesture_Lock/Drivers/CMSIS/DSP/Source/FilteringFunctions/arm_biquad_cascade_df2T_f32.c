@@ -156,6 +156,16 @@ uint32_t blockSize)
    float32_t d1, d2;                              /*  state variables           */
    uint32_t sample, stage = S->numStages;         /*  loop counters             */
 
+#if defined (ARM_MATH_HOST_X86)
+   /* stages in parallel on a PC, see arm_host_simd.h; a single stage has
+      nothing to run beside it */
+   if ((arm_host_biquad_cascade_df2T_f32 != NULL) && (S->numStages > 1U))
+   {
+      arm_host_biquad_cascade_df2T_f32(S, pSrc, pDst, blockSize);
+      return;
+   }
+#endif
+
 #if defined(ARM_MATH_CM7)
 
    float32_t Xn2, Xn3, Xn4, Xn5, Xn6, Xn7, Xn8;   /*  Input State variables     */
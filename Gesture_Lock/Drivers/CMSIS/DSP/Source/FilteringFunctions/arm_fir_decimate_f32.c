@@ -141,6 +141,15 @@ void arm_fir_decimate_f32(
   uint32_t numTaps = S->numTaps;                 /* Number of filter coefficients in the filter */
   uint32_t i, tapCnt, blkCnt, outBlockSize = blockSize / S->M;  /* Loop counters */
 
+#if defined (ARM_MATH_HOST_X86)
+  /* SSE / AVX2 version on a PC, see arm_host_simd.h */
+  if (arm_host_fir_decimate_f32 != NULL)
+  {
+    arm_host_fir_decimate_f32(S, pSrc, pDst, blockSize);
+    return;
+  }
+#endif
+
 #if defined (ARM_MATH_DSP)
 
   uint32_t blkCntN4;
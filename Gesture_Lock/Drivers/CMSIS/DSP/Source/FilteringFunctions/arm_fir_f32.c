@@ -566,6 +566,15 @@ uint32_t blockSize)
    uint32_t i, tapCnt, blkCnt;                    /* Loop counters */
    float32_t p0,p1,p2,p3,p4,p5,p6,p7;             /* Temporary product values */
 
+#if defined (ARM_MATH_HOST_X86)
+   /* SSE / AVX2 version on a PC, see arm_host_simd.h */
+   if (arm_host_fir_f32 != NULL)
+   {
+      arm_host_fir_f32(S, pSrc, pDst, blockSize);
+      return;
+   }
+#endif
+
    /* S->pState points to state array which contains previous frame (numTaps - 1) samples */
    /* pStateCurnt points to the location where the new input data should be written */
    pStateCurnt = &(S->pState[(numTaps - 1U)]);
@@ -0,0 +1,828 @@
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS DSP Library
+ * Title:        arm_host_simd.c
+ * Description:  SSE2 and AVX2/FMA versions of the floating-point FIR,
+ *               FIR decimator, DF2T biquad, dot product, mean, variance,
+ *               RMS and real FFT split stages for the host build
+ *               (ARM_MATH_HOST), selected at load time from CPUID.
+ *
+ * Target Processor: host, x86 / x86-64
+ * -------------------------------------------------------------------- */
+/*
+ * Copyright (C) 2010-2017 ARM Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "arm_math.h"
+
+#if defined (ARM_MATH_HOST)
+
+static arm_host_simd_level arm_host_level = ARM_HOST_SIMD_NONE;
+
+#if defined (ARM_MATH_HOST_X86)
+
+#include <immintrin.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* each function is compiled for its instruction set, the library itself
+   is built without -msse / -mavx flags */
+#define ARM_HOST_SSE    __attribute__((target("sse2")))
+#define ARM_HOST_AVX2   __attribute__((target("avx2,fma")))
+
+void (*arm_host_dot_prod_f32)(float32_t * pSrcA, float32_t * pSrcB, uint32_t blockSize, float32_t * result);
+void (*arm_host_mean_f32)(float32_t * pSrc, uint32_t blockSize, float32_t * pResult);
+void (*arm_host_var_f32)(float32_t * pSrc, uint32_t blockSize, float32_t * pResult);
+void (*arm_host_rms_f32)(float32_t * pSrc, uint32_t blockSize, float32_t * pResult);
+void (*arm_host_fir_f32)(const arm_fir_instance_f32 * S, float32_t * pSrc, float32_t * pDst, uint32_t blockSize);
+void (*arm_host_fir_decimate_f32)(const arm_fir_decimate_instance_f32 * S, float32_t * pSrc, float32_t * pDst, uint32_t blockSize);
+void (*arm_host_biquad_cascade_df2T_f32)(const arm_biquad_cascade_df2T_instance_f32 * S, float32_t * pSrc, float32_t * pDst, uint32_t blockSize);
+void (*arm_host_stage_rfft_f32)(arm_rfft_fast_instance_f32 * S, float32_t * p, float32_t * pOut);
+void (*arm_host_merge_rfft_f32)(arm_rfft_fast_instance_f32 * S, float32_t * p, float32_t * pOut);
+
+/* ----------------------------------------------------------------------
+ * SSE2
+ * -------------------------------------------------------------------- */
+
+ARM_HOST_SSE static inline float32_t arm_host_hsum_sse(__m128 v)
+{
+  v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+  return _mm_cvtss_f32(v);
+}
+
+/* sum of a[i] * b[i] */
+ARM_HOST_SSE static float32_t arm_host_dot_sse(const float32_t * a, const float32_t * b, uint32_t n)
+{
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  float32_t sum;
+  uint32_t i = 0U;
+
+  for (; i + 8U <= n; i += 8U)
+  {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i     ), _mm_loadu_ps(b + i     )));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4U), _mm_loadu_ps(b + i + 4U)));
+  }
+  sum = arm_host_hsum_sse(_mm_add_ps(acc0, acc1));
+  for (; i < n; i++)
+  {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+ARM_HOST_SSE static float32_t arm_host_sum_sse(const float32_t * a, uint32_t n)
+{
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  float32_t sum;
+  uint32_t i = 0U;
+
+  for (; i + 8U <= n; i += 8U)
+  {
+    acc0 = _mm_add_ps(acc0, _mm_loadu_ps(a + i     ));
+    acc1 = _mm_add_ps(acc1, _mm_loadu_ps(a + i + 4U));
+  }
+  sum = arm_host_hsum_sse(_mm_add_ps(acc0, acc1));
+  for (; i < n; i++)
+  {
+    sum += a[i];
+  }
+  return sum;
+}
+
+/* sum of (a[i] - m)^2 */
+ARM_HOST_SSE static float32_t arm_host_sumsq_sse(const float32_t * a, uint32_t n, float32_t m)
+{
+  const __m128 vm = _mm_set1_ps(m);
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  __m128 v0, v1;
+  float32_t sum, v;
+  uint32_t i = 0U;
+
+  for (; i + 8U <= n; i += 8U)
+  {
+    v0 = _mm_sub_ps(_mm_loadu_ps(a + i     ), vm);
+    v1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4U), vm);
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(v0, v0));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(v1, v1));
+  }
+  sum = arm_host_hsum_sse(_mm_add_ps(acc0, acc1));
+  for (; i < n; i++)
+  {
+    v = a[i] - m;
+    sum += v * v;
+  }
+  return sum;
+}
+
+ARM_HOST_SSE static void arm_dot_prod_f32_sse(
+  float32_t * pSrcA,
+  float32_t * pSrcB,
+  uint32_t blockSize,
+  float32_t * result)
+{
+  *result = arm_host_dot_sse(pSrcA, pSrcB, blockSize);
+}
+
+ARM_HOST_SSE static void arm_mean_f32_sse(
+  float32_t * pSrc,
+  uint32_t blockSize,
+  float32_t * pResult)
+{
+  *pResult = arm_host_sum_sse(pSrc, blockSize) / (float32_t) blockSize;
+}
+
+ARM_HOST_SSE static void arm_var_f32_sse(
+  float32_t * pSrc,
+  uint32_t blockSize,
+  float32_t * pResult)
+{
+  float32_t fMean;
+
+  if (blockSize <= 1U)
+  {
+    *pResult = 0;
+    return;
+  }
+  fMean = arm_host_sum_sse(pSrc, blockSize) / (float32_t) blockSize;
+  *pResult = arm_host_sumsq_sse(pSrc, blockSize, fMean) / ((float32_t) blockSize - 1.0f);
+}
+
+ARM_HOST_SSE static void arm_rms_f32_sse(
+  float32_t * pSrc,
+  uint32_t blockSize,
+  float32_t * pResult)
+{
+  arm_sqrt_f32(arm_host_sumsq_sse(pSrc, blockSize, 0.0f) / (float32_t) blockSize, pResult);
+}
+
+/* 16 outputs at a time, each coefficient broadcast against the state */
+ARM_HOST_SSE static void arm_fir_f32_sse(
+  const arm_fir_instance_f32 * S,
+  float32_t * pSrc,
+  float32_t * pDst,
+  uint32_t blockSize)
+{
+  float32_t *pState = S->pState;
+  const float32_t *pCoeffs = S->pCoeffs;
+  const float32_t *px;
+  uint32_t numTaps = S->numTaps;
+  uint32_t n = 0U, i;
+  __m128 acc0, acc1, acc2, acc3, c;
+  float32_t acc;
+
+  memcpy(pState + (numTaps - 1U), pSrc, blockSize * sizeof(float32_t));
+
+  for (; n + 16U <= blockSize; n += 16U)
+  {
+    px = pState + n;
+    acc0 = acc1 = acc2 = acc3 = _mm_setzero_ps();
+    for (i = 0U; i < numTaps; i++)
+    {
+      c = _mm_set1_ps(pCoeffs[i]);
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(c, _mm_loadu_ps(px + i      )));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(c, _mm_loadu_ps(px + i +  4U)));
+      acc2 = _mm_add_ps(acc2, _mm_mul_ps(c, _mm_loadu_ps(px + i +  8U)));
+      acc3 = _mm_add_ps(acc3, _mm_mul_ps(c, _mm_loadu_ps(px + i + 12U)));
+    }
+    _mm_storeu_ps(pDst + n      , acc0);
+    _mm_storeu_ps(pDst + n +  4U, acc1);
+    _mm_storeu_ps(pDst + n +  8U, acc2);
+    _mm_storeu_ps(pDst + n + 12U, acc3);
+  }
+  for (; n + 4U <= blockSize; n += 4U)
+  {
+    px = pState + n;
+    acc0 = _mm_setzero_ps();
+    for (i = 0U; i < numTaps; i++)
+    {
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_set1_ps(pCoeffs[i]), _mm_loadu_ps(px + i)));
+    }
+    _mm_storeu_ps(pDst + n, acc0);
+  }
+  for (; n < blockSize; n++)
+  {
+    px = pState + n;
+    acc = 0.0f;
+    for (i = 0U; i < numTaps; i++)
+    {
+      acc += pCoeffs[i] * px[i];
+    }
+    pDst[n] = acc;
+  }
+
+  memmove(pState, pState + blockSize, (numTaps - 1U) * sizeof(float32_t));
+}
+
+ARM_HOST_SSE static void arm_fir_decimate_f32_sse(
+  const arm_fir_decimate_instance_f32 * S,
+  float32_t * pSrc,
+  float32_t * pDst,
+  uint32_t blockSize)
+{
+  float32_t *pState = S->pState;
+  uint32_t numTaps = S->numTaps;
+  uint32_t M = S->M;
+  uint32_t outBlockSize = blockSize / M;
+  uint32_t n;
+
+  memcpy(pState + (numTaps - 1U), pSrc, outBlockSize * M * sizeof(float32_t));
+
+  for (n = 0U; n < outBlockSize; n++)
+  {
+    pDst[n] = arm_host_dot_sse(S->pCoeffs, pState + n * M, numTaps);
+  }
+
+  memmove(pState, pState + outBlockSize * M, (numTaps - 1U) * sizeof(float32_t));
+}
+
+/*
+ * The cascade as a wavefront: lane s holds stage s of a group of four and
+ * at step t runs its sample t - s, fed by the output lane s - 1 gave at
+ * step t - 1. Each stage does the same multiplies and adds in the same
+ * order as the scalar code, so the output is identical. Lanes outside
+ * their sample range at the head and tail of the block keep their state.
+ */
+ARM_HOST_SSE static void arm_biquad_cascade_df2T_f32_sse(
+  const arm_biquad_cascade_df2T_instance_f32 * S,
+  float32_t * pSrc,
+  float32_t * pDst,
+  uint32_t blockSize)
+{
+  float32_t *pIn = pSrc;
+  float32_t *pState = S->pState;
+  const float32_t *pCoeffs = S->pCoeffs;
+  const __m128i lane = _mm_set_epi32(3, 2, 1, 0);
+  __m128 b0, b1, b2, a1, a2, d1, d2, x, y, n1, n2, hold;
+  float32_t cf[5][4], st[2][4], out[4];
+  uint32_t stage, lanes, steps, s, k, t;
+
+  for (stage = 0U; stage < S->numStages; stage += lanes)
+  {
+    lanes = S->numStages - stage;
+    if (lanes > 4U)
+    {
+      lanes = 4U;
+    }
+
+    /* unused lanes get zero coefficients, their state is not written back */
+    for (s = 0U; s < 4U; s++)
+    {
+      for (k = 0U; k < 5U; k++)
+      {
+        cf[k][s] = (s < lanes) ? pCoeffs[5U * (stage + s) + k] : 0.0f;
+      }
+      st[0][s] = (s < lanes) ? pState[2U * (stage + s)     ] : 0.0f;
+      st[1][s] = (s < lanes) ? pState[2U * (stage + s) + 1U] : 0.0f;
+    }
+    b0 = _mm_loadu_ps(cf[0]);
+    b1 = _mm_loadu_ps(cf[1]);
+    b2 = _mm_loadu_ps(cf[2]);
+    a1 = _mm_loadu_ps(cf[3]);
+    a2 = _mm_loadu_ps(cf[4]);
+    d1 = _mm_loadu_ps(st[0]);
+    d2 = _mm_loadu_ps(st[1]);
+    y = _mm_setzero_ps();
+
+    steps = blockSize + lanes - 1U;
+    for (t = 0U; t < steps; t++)
+    {
+      x = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4));
+      if (t < blockSize)
+      {
+        x = _mm_move_ss(x, _mm_set_ss(pIn[t]));
+      }
+
+      /* y = b0 * x + d1, d1 = b1 * x + a1 * y + d2, d2 = b2 * x + a2 * y */
+      y  = _mm_add_ps(_mm_mul_ps(b0, x), d1);
+      n1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), d2);
+      n2 = _mm_add_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+
+      if ((t + 1U < lanes) || (t >= blockSize))
+      {
+        hold = _mm_castsi128_ps(_mm_or_si128(
+                 _mm_cmpgt_epi32(lane, _mm_set1_epi32((int32_t) t)),
+                 _mm_cmpgt_epi32(_mm_set1_epi32((int32_t) (t - blockSize + 1U)), lane)));
+        d1 = _mm_or_ps(_mm_and_ps(hold, d1), _mm_andnot_ps(hold, n1));
+        d2 = _mm_or_ps(_mm_and_ps(hold, d2), _mm_andnot_ps(hold, n2));
+      }
+      else
+      {
+        d1 = n1;
+        d2 = n2;
+      }
+
+      if (t + 1U >= lanes)
+      {
+        _mm_storeu_ps(out, y);
+        pDst[t + 1U - lanes] = out[lanes - 1U];
+      }
+    }
+
+    _mm_storeu_ps(st[0], d1);
+    _mm_storeu_ps(st[1], d2);
+    for (s = 0U; s < lanes; s++)
+    {
+      pState[2U * (stage + s)     ] = st[0][s];
+      pState[2U * (stage + s) + 1U] = st[1][s];
+    }
+
+    /* the output of this group is the input of the next */
+    pIn = pDst;
+  }
+}
+
+/*
+ * One or two bins of the real FFT split. a holds bins k (and k + 1),
+ * b the mirrored bins N - k (and N - k - 1), w their twiddles, all as
+ * re, im pairs.
+ */
+ARM_HOST_SSE static inline __m128 arm_host_stage_bins_sse(__m128 a, __m128 b, __m128 w)
+{
+  const __m128 neg_re = _mm_castsi128_ps(_mm_set_epi32(0, (int32_t) 0x80000000, 0, (int32_t) 0x80000000));
+  const __m128 neg_im = _mm_castsi128_ps(_mm_set_epi32((int32_t) 0x80000000, 0, (int32_t) 0x80000000, 0));
+  __m128 u, d, p, q;
+
+  /* u = (xAR + xBR, xAI - xBI), d = (xBR - xAR, xBI + xAI) */
+  u = _mm_add_ps(a, _mm_xor_ps(b, neg_im));
+  d = _mm_add_ps(b, _mm_xor_ps(a, neg_re));
+  /* p = (twR * t1a, twR * t1b), q = (twI * t1b, twI * t1a) */
+  p = _mm_mul_ps(d, _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0)));
+  q = _mm_mul_ps(_mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1)));
+  /* (xAR + xBR + p0 + p3, xAI - xBI + p1 - p2) / 2 */
+  return _mm_mul_ps(_mm_set1_ps(0.5f), _mm_add_ps(u, _mm_add_ps(q, _mm_xor_ps(p, neg_im))));
+}
+
+ARM_HOST_SSE static inline __m128 arm_host_merge_bins_sse(__m128 a, __m128 b, __m128 w)
+{
+  const __m128 neg_re = _mm_castsi128_ps(_mm_set_epi32(0, (int32_t) 0x80000000, 0, (int32_t) 0x80000000));
+  const __m128 neg_im = _mm_castsi128_ps(_mm_set_epi32((int32_t) 0x80000000, 0, (int32_t) 0x80000000, 0));
+  __m128 u, d, p, q;
+
+  /* u = (xAR + xBR, xAI - xBI), d = (xAR - xBR, xAI + xBI) */
+  u = _mm_add_ps(a, _mm_xor_ps(b, neg_im));
+  d = _mm_add_ps(a, _mm_xor_ps(b, neg_re));
+  /* p = (r, u), q = (s, t) */
+  p = _mm_mul_ps(d, _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0)));
+  q = _mm_mul_ps(_mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1)));
+  /* (xAR + xBR - r - s, xAI - xBI + t - u) / 2 */
+  return _mm_mul_ps(_mm_set1_ps(0.5f), _mm_add_ps(_mm_sub_ps(u, p), _mm_xor_ps(q, neg_re)));
+}
+
+ARM_HOST_SSE static void arm_stage_rfft_f32_sse(
+  arm_rfft_fast_instance_f32 * S,
+  float32_t * p,
+  float32_t * pOut)
+{
+  const float32_t *pCoeff = S->pTwiddleRFFT + 2;
+  const float32_t *pA = p + 2;
+  const float32_t *pB;
+  uint32_t k = (S->Sint).fftLen - 1U;
+  __m128 b;
+
+  /* first and last sample of the frequency domain packed together */
+  pOut[0] = 0.5f * ((p[0] + p[0]) + (p[1] + p[1]));
+  pOut[1] = 0.5f * ((p[0] + p[0]) - (p[1] + p[1]));
+  pOut += 2;
+  pB = p + 2U * k;
+
+  for (; k >= 2U; k -= 2U)
+  {
+    b = _mm_loadu_ps(pB - 2);
+    b = _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2));
+    _mm_storeu_ps(pOut, arm_host_stage_bins_sse(_mm_loadu_ps(pA), b, _mm_loadu_ps(pCoeff)));
+    pA += 4;
+    pB -= 4;
+    pCoeff += 4;
+    pOut += 4;
+  }
+  if (k > 0U)
+  {
+    b = arm_host_stage_bins_sse(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) pA),
+                                _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) pB),
+                                _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) pCoeff));
+    _mm_storel_pi((__m64 *) pOut, b);
+  }
+}
+
+ARM_HOST_SSE static void arm_merge_rfft_f32_sse(
+  arm_rfft_fast_instance_f32 * S,
+  float32_t * p,
+  float32_t * pOut)
+{
+  const float32_t *pCoeff = S->pTwiddleRFFT + 2;
+  const float32_t *pA = p + 2;
+  const float32_t *pB;
+  uint32_t k = (S->Sint).fftLen - 1U;
+  __m128 b;
+
+  pOut[0] = 0.5f * (p[0] + p[1]);
+  pOut[1] = 0.5f * (p[0] - p[1]);
+  pOut += 2;
+  pB = p + 2U * k;
+
+  for (; k >= 2U; k -= 2U)
+  {
+    b = _mm_loadu_ps(pB - 2);
+    b = _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2));
+    _mm_storeu_ps(pOut, arm_host_merge_bins_sse(_mm_loadu_ps(pA), b, _mm_loadu_ps(pCoeff)));
+    pA += 4;
+    pB -= 4;
+    pCoeff += 4;
+    pOut += 4;
+  }
+  if (k > 0U)
+  {
+    b = arm_host_merge_bins_sse(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) pA),
+                                _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) pB),
+                                _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) pCoeff));
+    _mm_storel_pi((__m64 *) pOut, b);
+  }
+}
+
+/* ----------------------------------------------------------------------
+ * AVX2 + FMA
+ * -------------------------------------------------------------------- */
+
+ARM_HOST_AVX2 static inline float32_t arm_host_hsum_avx2(__m256 v)
+{
+  __m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+  h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+  return _mm_cvtss_f32(h);
+}
+
+ARM_HOST_AVX2 static float32_t arm_host_dot_avx2(const float32_t * a, const float32_t * b, uint32_t n)
+{
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  float32_t sum;
+  uint32_t i = 0U;
+
+  for (; i + 32U <= n; i += 32U)
+  {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i      ), _mm256_loadu_ps(b + i      ), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i +  8U), _mm256_loadu_ps(b + i +  8U), acc1);
+    acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16U), _mm256_loadu_ps(b + i + 16U), acc2);
+    acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24U), _mm256_loadu_ps(b + i + 24U), acc3);
+  }
+  for (; i + 8U <= n; i += 8U)
+  {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+  }
+  sum = arm_host_hsum_avx2(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+  for (; i < n; i++)
+  {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+ARM_HOST_AVX2 static float32_t arm_host_sum_avx2(const float32_t * a, uint32_t n)
+{
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  float32_t sum;
+  uint32_t i = 0U;
+
+  for (; i + 32U <= n; i += 32U)
+  {
+    acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(a + i      ));
+    acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(a + i +  8U));
+    acc2 = _mm256_add_ps(acc2, _mm256_loadu_ps(a + i + 16U));
+    acc3 = _mm256_add_ps(acc3, _mm256_loadu_ps(a + i + 24U));
+  }
+  for (; i + 8U <= n; i += 8U)
+  {
+    acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(a + i));
+  }
+  sum = arm_host_hsum_avx2(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+  for (; i < n; i++)
+  {
+    sum += a[i];
+  }
+  return sum;
+}
+
+ARM_HOST_AVX2 static float32_t arm_host_sumsq_avx2(const float32_t * a, uint32_t n, float32_t m)
+{
+  const __m256 vm = _mm256_set1_ps(m);
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps();
+  __m256 acc3 = _mm256_setzero_ps();
+  __m256 v0, v1, v2, v3;
+  float32_t sum, v;
+  uint32_t i = 0U;
+
+  for (; i + 32U <= n; i += 32U)
+  {
+    v0 = _mm256_sub_ps(_mm256_loadu_ps(a + i      ), vm);
+    v1 = _mm256_sub_ps(_mm256_loadu_ps(a + i +  8U), vm);
+    v2 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 16U), vm);
+    v3 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 24U), vm);
+    acc0 = _mm256_fmadd_ps(v0, v0, acc0);
+    acc1 = _mm256_fmadd_ps(v1, v1, acc1);
+    acc2 = _mm256_fmadd_ps(v2, v2, acc2);
+    acc3 = _mm256_fmadd_ps(v3, v3, acc3);
+  }
+  for (; i + 8U <= n; i += 8U)
+  {
+    v0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), vm);
+    acc0 = _mm256_fmadd_ps(v0, v0, acc0);
+  }
+  sum = arm_host_hsum_avx2(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+  for (; i < n; i++)
+  {
+    v = a[i] - m;
+    sum += v * v;
+  }
+  return sum;
+}
+
+ARM_HOST_AVX2 static void arm_dot_prod_f32_avx2(
+  float32_t * pSrcA,
+  float32_t * pSrcB,
+  uint32_t blockSize,
+  float32_t * result)
+{
+  *result = arm_host_dot_avx2(pSrcA, pSrcB, blockSize);
+}
+
+ARM_HOST_AVX2 static void arm_mean_f32_avx2(
+  float32_t * pSrc,
+  uint32_t blockSize,
+  float32_t * pResult)
+{
+  *pResult = arm_host_sum_avx2(pSrc, blockSize) / (float32_t) blockSize;
+}
+
+ARM_HOST_AVX2 static void arm_var_f32_avx2(
+  float32_t * pSrc,
+  uint32_t blockSize,
+  float32_t * pResult)
+{
+  float32_t fMean;
+
+  if (blockSize <= 1U)
+  {
+    *pResult = 0;
+    return;
+  }
+  fMean = arm_host_sum_avx2(pSrc, blockSize) / (float32_t) blockSize;
+  *pResult = arm_host_sumsq_avx2(pSrc, blockSize, fMean) / ((float32_t) blockSize - 1.0f);
+}
+
+ARM_HOST_AVX2 static void arm_rms_f32_avx2(
+  float32_t * pSrc,
+  uint32_t blockSize,
+  float32_t * pResult)
+{
+  arm_sqrt_f32(arm_host_sumsq_avx2(pSrc, blockSize, 0.0f) / (float32_t) blockSize, pResult);
+}
+
+/* 32 outputs at a time */
+ARM_HOST_AVX2 static void arm_fir_f32_avx2(
+  const arm_fir_instance_f32 * S,
+  float32_t * pSrc,
+  float32_t * pDst,
+  uint32_t blockSize)
+{
+  float32_t *pState = S->pState;
+  const float32_t *pCoeffs = S->pCoeffs;
+  const float32_t *px;
+  uint32_t numTaps = S->numTaps;
+  uint32_t n = 0U, i;
+  __m256 acc0, acc1, acc2, acc3, c;
+  float32_t acc;
+
+  memcpy(pState + (numTaps - 1U), pSrc, blockSize * sizeof(float32_t));
+
+  for (; n + 32U <= blockSize; n += 32U)
+  {
+    px = pState + n;
+    acc0 = acc1 = acc2 = acc3 = _mm256_setzero_ps();
+    for (i = 0U; i < numTaps; i++)
+    {
+      c = _mm256_set1_ps(pCoeffs[i]);
+      acc0 = _mm256_fmadd_ps(c, _mm256_loadu_ps(px + i      ), acc0);
+      acc1 = _mm256_fmadd_ps(c, _mm256_loadu_ps(px + i +  8U), acc1);
+      acc2 = _mm256_fmadd_ps(c, _mm256_loadu_ps(px + i + 16U), acc2);
+      acc3 = _mm256_fmadd_ps(c, _mm256_loadu_ps(px + i + 24U), acc3);
+    }
+    _mm256_storeu_ps(pDst + n      , acc0);
+    _mm256_storeu_ps(pDst + n +  8U, acc1);
+    _mm256_storeu_ps(pDst + n + 16U, acc2);
+    _mm256_storeu_ps(pDst + n + 24U, acc3);
+  }
+  for (; n + 8U <= blockSize; n += 8U)
+  {
+    px = pState + n;
+    acc0 = _mm256_setzero_ps();
+    for (i = 0U; i < numTaps; i++)
+    {
+      acc0 = _mm256_fmadd_ps(_mm256_set1_ps(pCoeffs[i]), _mm256_loadu_ps(px + i), acc0);
+    }
+    _mm256_storeu_ps(pDst + n, acc0);
+  }
+  for (; n < blockSize; n++)
+  {
+    px = pState + n;
+    acc = 0.0f;
+    for (i = 0U; i < numTaps; i++)
+    {
+      acc += pCoeffs[i] * px[i];
+    }
+    pDst[n] = acc;
+  }
+
+  memmove(pState, pState + blockSize, (numTaps - 1U) * sizeof(float32_t));
+}
+
+/* four outputs share each load of the coefficients */
+ARM_HOST_AVX2 static void arm_fir_decimate_f32_avx2(
+  const arm_fir_decimate_instance_f32 * S,
+  float32_t * pSrc,
+  float32_t * pDst,
+  uint32_t blockSize)
+{
+  float32_t *pState = S->pState;
+  const float32_t *pCoeffs = S->pCoeffs;
+  const float32_t *px0, *px1, *px2, *px3;
+  uint32_t numTaps = S->numTaps;
+  uint32_t M = S->M;
+  uint32_t outBlockSize = blockSize / M;
+  uint32_t n = 0U, i;
+  __m256 acc0, acc1, acc2, acc3, c;
+  float32_t sum0, sum1, sum2, sum3;
+
+  memcpy(pState + (numTaps - 1U), pSrc, outBlockSize * M * sizeof(float32_t));
+
+  for (; n + 4U <= outBlockSize; n += 4U)
+  {
+    px0 = pState + n * M;
+    px1 = px0 + M;
+    px2 = px1 + M;
+    px3 = px2 + M;
+    acc0 = acc1 = acc2 = acc3 = _mm256_setzero_ps();
+    for (i = 0U; i + 8U <= numTaps; i += 8U)
+    {
+      c = _mm256_loadu_ps(pCoeffs + i);
+      acc0 = _mm256_fmadd_ps(c, _mm256_loadu_ps(px0 + i), acc0);
+      acc1 = _mm256_fmadd_ps(c, _mm256_loadu_ps(px1 + i), acc1);
+      acc2 = _mm256_fmadd_ps(c, _mm256_loadu_ps(px2 + i), acc2);
+      acc3 = _mm256_fmadd_ps(c, _mm256_loadu_ps(px3 + i), acc3);
+    }
+    sum0 = arm_host_hsum_avx2(acc0);
+    sum1 = arm_host_hsum_avx2(acc1);
+    sum2 = arm_host_hsum_avx2(acc2);
+    sum3 = arm_host_hsum_avx2(acc3);
+    for (; i < numTaps; i++)
+    {
+      sum0 += pCoeffs[i] * px0[i];
+      sum1 += pCoeffs[i] * px1[i];
+      sum2 += pCoeffs[i] * px2[i];
+      sum3 += pCoeffs[i] * px3[i];
+    }
+    pDst[n     ] = sum0;
+    pDst[n + 1U] = sum1;
+    pDst[n + 2U] = sum2;
+    pDst[n + 3U] = sum3;
+  }
+  for (; n < outBlockSize; n++)
+  {
+    pDst[n] = arm_host_dot_avx2(pCoeffs, pState + n * M, numTaps);
+  }
+
+  memmove(pState, pState + outBlockSize * M, (numTaps - 1U) * sizeof(float32_t));
+}
+
+/* ----------------------------------------------------------------------
+ * Selection
+ * -------------------------------------------------------------------- */
+
+static arm_host_simd_level arm_host_simd_cpu(void)
+{
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+  {
+    return ARM_HOST_SIMD_AVX2;
+  }
+  if (__builtin_cpu_supports("sse2"))
+  {
+    return ARM_HOST_SIMD_SSE;
+  }
+  return ARM_HOST_SIMD_NONE;
+}
+
+arm_host_simd_level arm_host_simd_select(arm_host_simd_level level)
+{
+  arm_host_simd_level cpu = arm_host_simd_cpu();
+
+  if (level > cpu)
+  {
+    level = cpu;
+  }
+
+  switch (level)
+  {
+  case ARM_HOST_SIMD_AVX2:
+    arm_host_dot_prod_f32 = arm_dot_prod_f32_avx2;
+    arm_host_mean_f32 = arm_mean_f32_avx2;
+    arm_host_var_f32 = arm_var_f32_avx2;
+    arm_host_rms_f32 = arm_rms_f32_avx2;
+    arm_host_fir_f32 = arm_fir_f32_avx2;
+    arm_host_fir_decimate_f32 = arm_fir_decimate_f32_avx2;
+    /* the biquad wavefront and the FFT split gain nothing from 8 lanes */
+    arm_host_biquad_cascade_df2T_f32 = arm_biquad_cascade_df2T_f32_sse;
+    arm_host_stage_rfft_f32 = arm_stage_rfft_f32_sse;
+    arm_host_merge_rfft_f32 = arm_merge_rfft_f32_sse;
+    break;
+
+  case ARM_HOST_SIMD_SSE:
+    arm_host_dot_prod_f32 = arm_dot_prod_f32_sse;
+    arm_host_mean_f32 = arm_mean_f32_sse;
+    arm_host_var_f32 = arm_var_f32_sse;
+    arm_host_rms_f32 = arm_rms_f32_sse;
+    arm_host_fir_f32 = arm_fir_f32_sse;
+    arm_host_fir_decimate_f32 = arm_fir_decimate_f32_sse;
+    arm_host_biquad_cascade_df2T_f32 = arm_biquad_cascade_df2T_f32_sse;
+    arm_host_stage_rfft_f32 = arm_stage_rfft_f32_sse;
+    arm_host_merge_rfft_f32 = arm_merge_rfft_f32_sse;
+    break;
+
+  default:
+    arm_host_dot_prod_f32 = NULL;
+    arm_host_mean_f32 = NULL;
+    arm_host_var_f32 = NULL;
+    arm_host_rms_f32 = NULL;
+    arm_host_fir_f32 = NULL;
+    arm_host_fir_decimate_f32 = NULL;
+    arm_host_biquad_cascade_df2T_f32 = NULL;
+    arm_host_stage_rfft_f32 = NULL;
+    arm_host_merge_rfft_f32 = NULL;
+    break;
+  }
+
+  arm_host_level = level;
+  return level;
+}
+
+/* runs before main: best level of the CPU, or ARM_HOST_SIMD from the
+   environment */
+__attribute__((constructor)) static void arm_host_simd_init(void)
+{
+  const char *env = getenv("ARM_HOST_SIMD");
+  arm_host_simd_level level = ARM_HOST_SIMD_AVX2;
+
+  if (env != NULL)
+  {
+    if (strcmp(env, "none") == 0)
+    {
+      level = ARM_HOST_SIMD_NONE;
+    }
+    else if (strcmp(env, "sse") == 0)
+    {
+      level = ARM_HOST_SIMD_SSE;
+    }
+  }
+  arm_host_simd_select(level);
+}
+
+#else
+
+/* not an x86 host: the scalar paths only */
+arm_host_simd_level arm_host_simd_select(arm_host_simd_level level)
+{
+  (void) level;
+  return arm_host_level;
+}
+
+#endif /* ARM_MATH_HOST_X86 */
+
+arm_host_simd_level arm_host_simd_get(void)
+{
+  return arm_host_level;
+}
+
+#endif /* ARM_MATH_HOST */
@@ -67,6 +67,15 @@ void arm_mean_f32(
   float32_t sum = 0.0f;                          /* Temporary result storage */
   uint32_t blkCnt;                               /* loop counter */
 
+#if defined (ARM_MATH_HOST_X86)
+  /* SSE / AVX2 version on a PC, see arm_host_simd.h */
+  if (arm_host_mean_f32 != NULL)
+  {
+    arm_host_mean_f32(pSrc, blockSize, pResult);
+    return;
+  }
+#endif
+
 #if defined (ARM_MATH_DSP)
   /* Run the below code for Cortex-M4 and Cortex-M3 */
 
@@ -76,6 +76,15 @@ void arm_var_f32(
     float32_t in1, in2, in3, in4;
     #endif
 
+    #if defined(ARM_MATH_HOST_X86)
+    /* SSE / AVX2 version on a PC, see arm_host_simd.h */
+    if (arm_host_var_f32 != NULL)
+    {
+        arm_host_var_f32(pSrc, blockSize, pResult);
+        return;
+    }
+    #endif
+
     if (blockSize <= 1U)
     {
         *pResult = 0;
@@ -0,0 +1,93 @@
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS DSP Library
+ * Title:        arm_bitreversal2.c
+ * Description:  arm_bitreversal_32 and arm_bitreversal_16 in C for the
+ *               host build (ARM_MATH_HOST), where arm_bitreversal2.S
+ *               cannot be assembled. Same table walk as the assembly.
+ *
+ * Target Processor: host
+ * -------------------------------------------------------------------- */
+/*
+ * Copyright (C) 2010-2017 ARM Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "arm_math.h"
+
+#if defined (ARM_MATH_HOST)
+
+/*
+* @brief  In-place 32 bit complex bit reversal, the table holds pairs of
+*         byte offsets of the entries to swap.
+* @param[in, out] *pSrc         points to the in-place buffer.
+* @param[in]      bitRevLen     length of the table.
+* @param[in]      *pBitRevTab   points to the bit reversal table.
+* @return none.
+*/
+void arm_bitreversal_32(
+  uint32_t * pSrc,
+  const uint16_t bitRevLen,
+  const uint16_t * pBitRevTab)
+{
+  uint32_t i, a, b, tmp;
+
+  for (i = 0U; i + 1U < bitRevLen; i += 2U)
+  {
+    a = pBitRevTab[i    ] >> 2U;
+    b = pBitRevTab[i + 1] >> 2U;
+
+    tmp = pSrc[a];
+    pSrc[a] = pSrc[b];
+    pSrc[b] = tmp;
+
+    tmp = pSrc[a + 1U];
+    pSrc[a + 1U] = pSrc[b + 1U];
+    pSrc[b + 1U] = tmp;
+  }
+}
+
+/*
+* @brief  In-place 16 bit complex bit reversal, the table offsets are
+*         those of the 32 bit version.
+* @param[in, out] *pSrc         points to the in-place buffer.
+* @param[in]      bitRevLen     length of the table.
+* @param[in]      *pBitRevTab   points to the bit reversal table.
+* @return none.
+*/
+void arm_bitreversal_16(
+  uint16_t * pSrc,
+  const uint16_t bitRevLen,
+  const uint16_t * pBitRevTab)
+{
+  uint32_t i, a, b;
+  uint16_t tmp;
+
+  for (i = 0U; i + 1U < bitRevLen; i += 2U)
+  {
+    a = pBitRevTab[i    ] >> 2U;
+    b = pBitRevTab[i + 1] >> 2U;
+
+    tmp = pSrc[a];
+    pSrc[a] = pSrc[b];
+    pSrc[b] = tmp;
+
+    tmp = pSrc[a + 1U];
+    pSrc[a + 1U] = pSrc[b + 1U];
+    pSrc[b + 1U] = tmp;
+  }
+}
+
+#endif /* defined (ARM_MATH_HOST) */
@@ -41,6 +41,15 @@ void stage_rfft_f32(
    float32_t t1a, t1b;				         /* temporary variables              */
    float32_t p0, p1, p2, p3;				   /* temporary variables              */
 
+#if defined (ARM_MATH_HOST_X86)
+   /* SSE version on a PC, see arm_host_simd.h */
+   if (arm_host_stage_rfft_f32 != NULL)
+   {
+      arm_host_stage_rfft_f32(S, p, pOut);
+      return;
+   }
+#endif
+
 
    k = (S->Sint).fftLen - 1;
 
@@ -126,6 +135,15 @@ float32_t * p, float32_t * pOut)
    float32_t xAR, xAI, xBR, xBI;			/* temporary variables              */
    float32_t t1a, t1b, r, s, t, u;			/* temporary variables              */
 
+#if defined (ARM_MATH_HOST_X86)
+   /* SSE version on a PC, see arm_host_simd.h */
+   if (arm_host_merge_rfft_f32 != NULL)
+   {
+      arm_host_merge_rfft_f32(S, p, pOut);
+      return;
+   }
+#endif
+
    k = (S->Sint).fftLen - 1;
 
    xAR = pA[0];
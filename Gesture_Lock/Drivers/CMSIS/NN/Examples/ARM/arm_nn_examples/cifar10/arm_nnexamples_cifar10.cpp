@@ -55,8 +55,10 @@
  * of 3 convolution layers interspersed by ReLU activation and max pooling layers, followed by a 
  * fully-connected layer at the end. The input to the network is a 32x32 pixel color image, which will 
  * be classified into one of the 10 output classes. 
- * This example model implementation needs 32.3 KB to store weights, 40 KB for activations and 
- * 3.1 KB for storing the \c im2col data.
+ * This example model implementation needs 32.3 KB to store weights and 35.3 KB for the
+ * activations and \c im2col data, which share one arena planned by Scripts/nn_arena.py.
+ * One array per buffer would take 56.5 KB, and an activation buffer plus a separate
+ * \c im2col buffer 43.1 KB.
  *
  * \image html CIFAR10_CNN.gif "Neural Network model definition"
  *
@@ -67,8 +69,8 @@
  * \li \c ip1_wt, ip1_bias point to fully-connected layer weights and biases
  * \li \c input_data points to the input image data
  * \li \c output_data points to the classification output
- * \li \c col_buffer is a buffer to store the \c im2col output
- * \li \c scratch_buffer is used to store the activation data (intermediate layer outputs)
+ * \li \c arena holds the activation data and the \c im2col and fully-connected buffers,
+ * at the offsets of arm_nnexamples_cifar10_arena.h
  *
  * \par CMSIS DSP Software Library Functions Used:
  * \par
@@ -91,6 +93,7 @@
 #include "arm_math.h"
 #include "arm_nnexamples_cifar10_parameter.h"
 #include "arm_nnexamples_cifar10_weights.h"
+#include "arm_nnexamples_cifar10_arena.h"
 
 #include "arm_nnfunctions.h"
 #include "arm_nnexamples_cifar10_inputs.h"
@@ -118,12 +121,10 @@ static q7_t ip1_bias[IP1_OUT] = IP1_BIAS;
 
 /* Here the image_data should be the raw uint8 type RGB image in [RGB, RGB, RGB ... RGB] format */
 uint8_t   image_data[CONV1_IM_CH * CONV1_IM_DIM * CONV1_IM_DIM] = IMG_DATA;
-q7_t      output_data[IP1_OUT];
 
-//vector buffer: max(im2col buffer,average pool buffer, fully connected buffer)
-q7_t      col_buffer[2 * 5 * 5 * 32 * 2];
-
-q7_t      scratch_buffer[32 * 32 * 10 * 4];
+// activations and kernel buffers, placed by Scripts/nn_arena.py from
+// arm_nnexamples_cifar10_graph.json; q31_t for the 4-byte alignment
+q31_t     arena[(CIFAR10_ARENA_SIZE + 3) / 4];
 
 int main()
 {
@@ -134,56 +135,62 @@ int main()
   printf("start execution\n");
   /* start the execution */
 
-  q7_t     *img_buffer1 = scratch_buffer;
-  q7_t     *img_buffer2 = img_buffer1 + 32 * 32 * 32;
+  q7_t     *data = (q7_t *) arena + CIFAR10_DATA_OFFSET;
+  q7_t     *conv1 = (q7_t *) arena + CIFAR10_CONV1_OFFSET;
+  q7_t     *pool1 = (q7_t *) arena + CIFAR10_POOL1_OFFSET;
+  q7_t     *conv2 = (q7_t *) arena + CIFAR10_CONV2_OFFSET;
+  q7_t     *pool2 = (q7_t *) arena + CIFAR10_POOL2_OFFSET;
+  q7_t     *conv3 = (q7_t *) arena + CIFAR10_CONV3_OFFSET;
+  q7_t     *pool3 = (q7_t *) arena + CIFAR10_POOL3_OFFSET;
+  q7_t     *output_data = (q7_t *) arena + CIFAR10_IP1_OFFSET;
 
   /* input pre-processing */
   int mean_data[3] = INPUT_MEAN_SHIFT;
   unsigned int scale_data[3] = INPUT_RIGHT_SHIFT;
   for (int i=0;i<32*32*3; i+=3) {
-    img_buffer2[i] =   (q7_t)__SSAT( ((((int)image_data[i]   - mean_data[0])<<7) + (0x1<<(scale_data[0]-1)))
+    data[i] =   (q7_t)__SSAT( ((((int)image_data[i]   - mean_data[0])<<7) + (0x1<<(scale_data[0]-1)))
                              >> scale_data[0], 8);
-    img_buffer2[i+1] = (q7_t)__SSAT( ((((int)image_data[i+1] - mean_data[1])<<7) + (0x1<<(scale_data[1]-1)))
+    data[i+1] = (q7_t)__SSAT( ((((int)image_data[i+1] - mean_data[1])<<7) + (0x1<<(scale_data[1]-1)))
                              >> scale_data[1], 8);
-    img_buffer2[i+2] = (q7_t)__SSAT( ((((int)image_data[i+2] - mean_data[2])<<7) + (0x1<<(scale_data[2]-1)))
+    data[i+2] = (q7_t)__SSAT( ((((int)image_data[i+2] - mean_data[2])<<7) + (0x1<<(scale_data[2]-1)))
                              >> scale_data[2], 8);
   }
   
-  // conv1 img_buffer2 -> img_buffer1
-  arm_convolve_HWC_q7_RGB(img_buffer2, CONV1_IM_DIM, CONV1_IM_CH, conv1_wt, CONV1_OUT_CH, CONV1_KER_DIM, CONV1_PADDING,
-                          CONV1_STRIDE, conv1_bias, CONV1_BIAS_LSHIFT, CONV1_OUT_RSHIFT, img_buffer1, CONV1_OUT_DIM,
-                          (q15_t *) col_buffer, NULL);
+  // conv1 data -> conv1
+  arm_convolve_HWC_q7_RGB(data, CONV1_IM_DIM, CONV1_IM_CH, conv1_wt, CONV1_OUT_CH, CONV1_KER_DIM, CONV1_PADDING,
+                          CONV1_STRIDE, conv1_bias, CONV1_BIAS_LSHIFT, CONV1_OUT_RSHIFT, conv1, CONV1_OUT_DIM,
+                          (q15_t *) ((q7_t *) arena + CIFAR10_CONV1_BUF_OFFSET), NULL);
 
-  arm_relu_q7(img_buffer1, CONV1_OUT_DIM * CONV1_OUT_DIM * CONV1_OUT_CH);
+  arm_relu_q7(conv1, CONV1_OUT_DIM * CONV1_OUT_DIM * CONV1_OUT_CH);
 
-  // pool1 img_buffer1 -> img_buffer2
-  arm_maxpool_q7_HWC(img_buffer1, CONV1_OUT_DIM, CONV1_OUT_CH, POOL1_KER_DIM,
-                     POOL1_PADDING, POOL1_STRIDE, POOL1_OUT_DIM, NULL, img_buffer2);
+  // pool1 conv1 -> pool1, written over conv1
+  arm_maxpool_q7_HWC(conv1, CONV1_OUT_DIM, CONV1_OUT_CH, POOL1_KER_DIM,
+                     POOL1_PADDING, POOL1_STRIDE, POOL1_OUT_DIM, NULL, pool1);
 
-  // conv2 img_buffer2 -> img_buffer1
-  arm_convolve_HWC_q7_fast(img_buffer2, CONV2_IM_DIM, CONV2_IM_CH, conv2_wt, CONV2_OUT_CH, CONV2_KER_DIM,
-                           CONV2_PADDING, CONV2_STRIDE, conv2_bias, CONV2_BIAS_LSHIFT, CONV2_OUT_RSHIFT, img_buffer1,
-                           CONV2_OUT_DIM, (q15_t *) col_buffer, NULL);
+  // conv2 pool1 -> conv2
+  arm_convolve_HWC_q7_fast(pool1, CONV2_IM_DIM, CONV2_IM_CH, conv2_wt, CONV2_OUT_CH, CONV2_KER_DIM,
+                           CONV2_PADDING, CONV2_STRIDE, conv2_bias, CONV2_BIAS_LSHIFT, CONV2_OUT_RSHIFT, conv2,
+                           CONV2_OUT_DIM, (q15_t *) ((q7_t *) arena + CIFAR10_CONV2_BUF_OFFSET), NULL);
 
-  arm_relu_q7(img_buffer1, CONV2_OUT_DIM * CONV2_OUT_DIM * CONV2_OUT_CH);
+  arm_relu_q7(conv2, CONV2_OUT_DIM * CONV2_OUT_DIM * CONV2_OUT_CH);
 
-  // pool2 img_buffer1 -> img_buffer2
-  arm_maxpool_q7_HWC(img_buffer1, CONV2_OUT_DIM, CONV2_OUT_CH, POOL2_KER_DIM,
-                     POOL2_PADDING, POOL2_STRIDE, POOL2_OUT_DIM, col_buffer, img_buffer2);
+  // pool2 conv2 -> pool2, written over conv2
+  arm_maxpool_q7_HWC(conv2, CONV2_OUT_DIM, CONV2_OUT_CH, POOL2_KER_DIM,
+                     POOL2_PADDING, POOL2_STRIDE, POOL2_OUT_DIM, NULL, pool2);
 
-// conv3 img_buffer2 -> img_buffer1
-  arm_convolve_HWC_q7_fast(img_buffer2, CONV3_IM_DIM, CONV3_IM_CH, conv3_wt, CONV3_OUT_CH, CONV3_KER_DIM,
-                           CONV3_PADDING, CONV3_STRIDE, conv3_bias, CONV3_BIAS_LSHIFT, CONV3_OUT_RSHIFT, img_buffer1,
-                           CONV3_OUT_DIM, (q15_t *) col_buffer, NULL);
+  // conv3 pool2 -> conv3
+  arm_convolve_HWC_q7_fast(pool2, CONV3_IM_DIM, CONV3_IM_CH, conv3_wt, CONV3_OUT_CH, CONV3_KER_DIM,
+                           CONV3_PADDING, CONV3_STRIDE, conv3_bias, CONV3_BIAS_LSHIFT, CONV3_OUT_RSHIFT, conv3,
+                           CONV3_OUT_DIM, (q15_t *) ((q7_t *) arena + CIFAR10_CONV3_BUF_OFFSET), NULL);
 
-  arm_relu_q7(img_buffer1, CONV3_OUT_DIM * CONV3_OUT_DIM * CONV3_OUT_CH);
+  arm_relu_q7(conv3, CONV3_OUT_DIM * CONV3_OUT_DIM * CONV3_OUT_CH);
 
-  // pool3 img_buffer-> img_buffer2
-  arm_maxpool_q7_HWC(img_buffer1, CONV3_OUT_DIM, CONV3_OUT_CH, POOL3_KER_DIM,
-                     POOL3_PADDING, POOL3_STRIDE, POOL3_OUT_DIM, col_buffer, img_buffer2);
+  // pool3 conv3 -> pool3, written over conv3
+  arm_maxpool_q7_HWC(conv3, CONV3_OUT_DIM, CONV3_OUT_CH, POOL3_KER_DIM,
+                     POOL3_PADDING, POOL3_STRIDE, POOL3_OUT_DIM, NULL, pool3);
 
-  arm_fully_connected_q7_opt(img_buffer2, ip1_wt, IP1_DIM, IP1_OUT, IP1_BIAS_LSHIFT, IP1_OUT_RSHIFT, ip1_bias,
-                             output_data, (q15_t *) img_buffer1);
+  arm_fully_connected_q7_opt(pool3, ip1_wt, IP1_DIM, IP1_OUT, IP1_BIAS_LSHIFT, IP1_OUT_RSHIFT, ip1_bias,
+                             output_data, (q15_t *) ((q7_t *) arena + CIFAR10_IP1_BUF_OFFSET));
 
   arm_softmax_q7(output_data, 10, output_data);
 
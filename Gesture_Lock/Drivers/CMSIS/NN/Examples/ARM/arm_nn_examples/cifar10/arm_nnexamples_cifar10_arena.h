@@ -0,0 +1,27 @@
+/* Generated by nn_arena.py from arm_nnexamples_cifar10_graph.json, do not edit.
+ *
+ * One arena of CIFAR10_ARENA_SIZE bytes holds the activations and kernel
+ * buffers of cifar10. Offsets are in bytes from the start of the arena,
+ * which must be 4-byte aligned. Buffers not live at the same layer
+ * share space, so a buffer is only valid between its first and last layer.
+ */
+
+#ifndef _CIFAR10_ARENA_H_
+#define _CIFAR10_ARENA_H_
+
+#define CIFAR10_ARENA_SIZE         36144
+
+#define CIFAR10_DATA_OFFSET        32768  /*  3073 bytes, layers 0..0, q7 32x32x3 */
+#define CIFAR10_CONV1_OFFSET       0      /* 32768 bytes, layers 0..2, q7 32x32x32 */
+#define CIFAR10_CONV1_BUF_OFFSET   35844  /*   300 bytes, layers 0..0, scratch of conv1 */
+#define CIFAR10_POOL1_OFFSET       0      /*  8192 bytes, layers 2..3, q7 16x16x32, over conv1 */
+#define CIFAR10_CONV2_OFFSET       8192   /*  4096 bytes, layers 3..5, q7 16x16x16 */
+#define CIFAR10_CONV2_BUF_OFFSET   12288  /*  3200 bytes, layers 3..3, scratch of conv2 */
+#define CIFAR10_POOL2_OFFSET       8192   /*  1024 bytes, layers 5..6, q7 8x8x16, over conv2 */
+#define CIFAR10_CONV3_OFFSET       0      /*  2048 bytes, layers 6..8, q7 8x8x32 */
+#define CIFAR10_CONV3_BUF_OFFSET   2048   /*  1600 bytes, layers 6..6, scratch of conv3 */
+#define CIFAR10_POOL3_OFFSET       0      /*   512 bytes, layers 8..9, q7 4x4x32, over conv3 */
+#define CIFAR10_IP1_OFFSET         1536   /*    10 bytes, layers 9..10, q7 10 */
+#define CIFAR10_IP1_BUF_OFFSET     512    /*  1024 bytes, layers 9..9, scratch of ip1 */
+
+#endif /* _CIFAR10_ARENA_H_ */
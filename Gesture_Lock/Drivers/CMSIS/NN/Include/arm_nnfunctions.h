@@ -43,6 +43,7 @@
    * - Fully-connected Layer Functions
    * - Neural Network Pooling Functions
    * - Softmax Functions
+   * - Recurrent Cell Functions
    * - Neural Network Support Functions
    *
    * The library has separate functions for operating on different weight and activation data
@@ -119,6 +120,10 @@ extern    "C"
  * Each iteration, only a few column (i.e., patches) are generated and 
  * computed with GEMM kernels similar to CMSIS-DSP arm_mat_mult functions.
  *
+ * The 1-D causal kernels take time as the only spatial dimension for
+ * sensor sequences, their streaming versions compute one output sample
+ * per new input sample.
+ *
  */
 
   /**
@@ -265,6 +270,7 @@ extern    "C"
    * some contraints:
    *   ch_im_in is multiple of 4
    *   ch_im_out is multiple of 2
+   *   padding is at most dim_im_out
    */
 
     arm_status arm_convolve_HWC_q7_fast(const q7_t * Im_in,
@@ -312,6 +318,7 @@ extern    "C"
    * some contraints:
    *   ch_im_in is multiple of 4
    *   ch_im_out is multiple of 2
+   *   padding_x is at most dim_im_out_x, padding_y at most dim_im_out_y
    */
 
     arm_status arm_convolve_HWC_q7_fast_nonsquare(const q7_t * Im_in,
@@ -629,6 +636,156 @@ extern    "C"
                                                              q15_t * bufferA,
                                                              q7_t * bufferB);
 
+  /**
+   * @brief Q7 1-D causal dilated convolution function
+   * @param[in]       Im_in       pointer to input tensor
+   * @param[in]       dim_im_in   input tensor length, also the output length
+   * @param[in]       ch_im_in    number of input tensor channels
+   * @param[in]       wt          pointer to kernel weights
+   * @param[in]       ch_im_out   number of filters, i.e., output tensor channels
+   * @param[in]       dim_kernel  filter kernel size
+   * @param[in]       dilation    distance between kernel taps, 1 for a plain convolution
+   * @param[in]       bias        pointer to bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for output
+   * @param[in,out]   Im_out      pointer to output tensor
+   * @param[in,out]   bufferA     pointer to buffer space for input 
+   * @param[in,out]   bufferB     pointer to buffer space for output
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * Channel-last tensors, output sample t is computed from input samples
+   * t - (dim_kernel - 1) * dilation to t, those before the start are 0.
+   */
+
+    arm_status arm_convolve_1D_causal_q7(const q7_t * Im_in,
+                                         const uint16_t dim_im_in,
+                                         const uint16_t ch_im_in,
+                                         const q7_t * wt,
+                                         const uint16_t ch_im_out,
+                                         const uint16_t dim_kernel,
+                                         const uint16_t dilation,
+                                         const q7_t * bias,
+                                         const uint16_t bias_shift,
+                                         const uint16_t out_shift,
+                                         q7_t * Im_out,
+                                         q15_t * bufferA,
+                                         q7_t * bufferB);
+
+  /**
+   * @brief Q15 1-D causal dilated convolution function
+   * @param[in]       Im_in       pointer to input tensor
+   * @param[in]       dim_im_in   input tensor length, also the output length
+   * @param[in]       ch_im_in    number of input tensor channels
+   * @param[in]       wt          pointer to kernel weights
+   * @param[in]       ch_im_out   number of filters, i.e., output tensor channels
+   * @param[in]       dim_kernel  filter kernel size
+   * @param[in]       dilation    distance between kernel taps, 1 for a plain convolution
+   * @param[in]       bias        pointer to bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for output
+   * @param[in,out]   Im_out      pointer to output tensor
+   * @param[in,out]   bufferA     pointer to buffer space for input 
+   * @param[in,out]   bufferB     pointer to buffer space for output
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * Channel-last tensors, output sample t is computed from input samples
+   * t - (dim_kernel - 1) * dilation to t, those before the start are 0.
+   */
+
+    arm_status arm_convolve_1D_causal_q15(const q15_t * Im_in,
+                                          const uint16_t dim_im_in,
+                                          const uint16_t ch_im_in,
+                                          const q15_t * wt,
+                                          const uint16_t ch_im_out,
+                                          const uint16_t dim_kernel,
+                                          const uint16_t dilation,
+                                          const q15_t * bias,
+                                          const uint16_t bias_shift,
+                                          const uint16_t out_shift,
+                                          q15_t * Im_out,
+                                          q15_t * bufferA,
+                                          q7_t * bufferB);
+
+  /**
+   * @brief Q7 streaming 1-D causal dilated convolution function
+   * @param[in]       sample      pointer to the newest input sample, ch_im_in values
+   * @param[in]       ch_im_in    number of input tensor channels
+   * @param[in]       wt          pointer to kernel weights
+   * @param[in]       ch_im_out   number of filters, i.e., output tensor channels
+   * @param[in]       dim_kernel  filter kernel size
+   * @param[in]       dilation    distance between kernel taps, 1 for a plain convolution
+   * @param[in]       bias        pointer to bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for output
+   * @param[in,out]   ring        pointer to the past input samples
+   * @param[in,out]   head        slot of ring the next sample goes to
+   * @param[in,out]   out         pointer to the output sample, ch_im_out values
+   * @param[in,out]   bufferA     pointer to buffer space for input 
+   * @param[in,out]   bufferB     pointer to buffer space for output
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * One output sample of arm_convolve_1D_causal_q7 per input sample. ring
+   * holds ((dim_kernel-1)*dilation+1)*ch_im_in values and starts cleared
+   * with *head 0.
+   */
+
+    arm_status arm_convolve_1D_stream_q7(const q7_t * sample,
+                                         const uint16_t ch_im_in,
+                                         const q7_t * wt,
+                                         const uint16_t ch_im_out,
+                                         const uint16_t dim_kernel,
+                                         const uint16_t dilation,
+                                         const q7_t * bias,
+                                         const uint16_t bias_shift,
+                                         const uint16_t out_shift,
+                                         q7_t * ring,
+                                         uint16_t * head,
+                                         q7_t * out,
+                                         q15_t * bufferA,
+                                         q7_t * bufferB);
+
+  /**
+   * @brief Q15 streaming 1-D causal dilated convolution function
+   * @param[in]       sample      pointer to the newest input sample, ch_im_in values
+   * @param[in]       ch_im_in    number of input tensor channels
+   * @param[in]       wt          pointer to kernel weights
+   * @param[in]       ch_im_out   number of filters, i.e., output tensor channels
+   * @param[in]       dim_kernel  filter kernel size
+   * @param[in]       dilation    distance between kernel taps, 1 for a plain convolution
+   * @param[in]       bias        pointer to bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for output
+   * @param[in,out]   ring        pointer to the past input samples
+   * @param[in,out]   head        slot of ring the next sample goes to
+   * @param[in,out]   out         pointer to the output sample, ch_im_out values
+   * @param[in,out]   bufferA     pointer to buffer space for input 
+   * @param[in,out]   bufferB     pointer to buffer space for output
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * One output sample of arm_convolve_1D_causal_q15 per input sample. ring
+   * holds ((dim_kernel-1)*dilation+1)*ch_im_in values and starts cleared
+   * with *head 0.
+   */
+
+    arm_status arm_convolve_1D_stream_q15(const q15_t * sample,
+                                          const uint16_t ch_im_in,
+                                          const q15_t * wt,
+                                          const uint16_t ch_im_out,
+                                          const uint16_t dim_kernel,
+                                          const uint16_t dilation,
+                                          const q15_t * bias,
+                                          const uint16_t bias_shift,
+                                          const uint16_t out_shift,
+                                          q15_t * ring,
+                                          uint16_t * head,
+                                          q15_t * out,
+                                          q15_t * bufferA,
+                                          q7_t * bufferB);
+
 
 /**
  * @defgroup FC Fully-connected Layer Functions
@@ -1003,6 +1160,139 @@ extern    "C"
 
     void      arm_softmax_q15(const q15_t * vec_in, const uint16_t dim_vec, q15_t * p_out);
 
+/**
+ * @defgroup RNN Recurrent Cell Functions
+ *
+ * Single time step of GRU and LSTM cells with q7 weights and q15
+ * activations, for running a recurrent layer one sample at a time. The
+ * state lives in the caller's buffer between steps.
+ *
+ */
+
+  /**
+   * @brief Mixed Q15-Q7 gated recurrent unit step function
+   * @param[in]       input       pointer to the input sample, dim_input values
+   * @param[in]       dim_input   length of the input sample
+   * @param[in]       dim_hidden  length of the hidden state
+   * @param[in]       wt_gates    pointer to update and reset gate weights
+   * @param[in]       bias_gates  pointer to update and reset gate bias
+   * @param[in]       wt_hidden   pointer to candidate state weights
+   * @param[in]       bias_hidden pointer to candidate state bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for the gate inputs
+   * @param[in]       int_width   integer bits of the gate inputs, at most 3
+   * @param[in,out]   buffer      pointer to the state and buffer space
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * buffer size: 4*dim_hidden+dim_input, the hidden state is at
+   * buffer + dim_hidden + dim_input
+   */
+
+    arm_status arm_gru_step_q7_q15(const q15_t * input,
+                                   const uint16_t dim_input,
+                                   const uint16_t dim_hidden,
+                                   const q7_t * wt_gates,
+                                   const q7_t * bias_gates,
+                                   const q7_t * wt_hidden,
+                                   const q7_t * bias_hidden,
+                                   const uint16_t bias_shift,
+                                   const uint16_t out_shift,
+                                   const uint16_t int_width,
+                                   q15_t * buffer);
+
+  /**
+   * @brief Mixed Q15-Q7 opt gated recurrent unit step function
+   * @param[in]       input       pointer to the input sample, dim_input values
+   * @param[in]       dim_input   length of the input sample
+   * @param[in]       dim_hidden  length of the hidden state
+   * @param[in]       wt_gates    pointer to update and reset gate weights
+   * @param[in]       bias_gates  pointer to update and reset gate bias
+   * @param[in]       wt_hidden   pointer to candidate state weights
+   * @param[in]       bias_hidden pointer to candidate state bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for the gate inputs
+   * @param[in]       int_width   integer bits of the gate inputs, at most 3
+   * @param[in,out]   buffer      pointer to the state and buffer space
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * buffer size: 4*dim_hidden+dim_input, weights in the interleaved
+   * order of arm_fully_connected_mat_q7_vec_q15_opt
+   */
+
+    arm_status arm_gru_step_q7_q15_opt(const q15_t * input,
+                                       const uint16_t dim_input,
+                                       const uint16_t dim_hidden,
+                                       const q7_t * wt_gates,
+                                       const q7_t * bias_gates,
+                                       const q7_t * wt_hidden,
+                                       const q7_t * bias_hidden,
+                                       const uint16_t bias_shift,
+                                       const uint16_t out_shift,
+                                       const uint16_t int_width,
+                                       q15_t * buffer);
+
+  /**
+   * @brief Mixed Q15-Q7 long short-term memory step function
+   * @param[in]       input       pointer to the input sample, dim_input values
+   * @param[in]       dim_input   length of the input sample
+   * @param[in]       dim_hidden  length of the hidden and cell state
+   * @param[in]       wt          pointer to gate weights
+   * @param[in]       bias        pointer to gate bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for the gate inputs
+   * @param[in]       int_width   integer bits of the gate inputs, at most 3
+   * @param[in]       cell_int_width integer bits of the cell state, at most 3
+   * @param[in,out]   buffer      pointer to the state and buffer space
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * buffer size: 6*dim_hidden+dim_input, the hidden state is at
+   * buffer + dim_input and the cell state follows it
+   */
+
+    arm_status arm_lstm_step_q7_q15(const q15_t * input,
+                                    const uint16_t dim_input,
+                                    const uint16_t dim_hidden,
+                                    const q7_t * wt,
+                                    const q7_t * bias,
+                                    const uint16_t bias_shift,
+                                    const uint16_t out_shift,
+                                    const uint16_t int_width,
+                                    const uint16_t cell_int_width,
+                                    q15_t * buffer);
+
+  /**
+   * @brief Mixed Q15-Q7 opt long short-term memory step function
+   * @param[in]       input       pointer to the input sample, dim_input values
+   * @param[in]       dim_input   length of the input sample
+   * @param[in]       dim_hidden  length of the hidden and cell state
+   * @param[in]       wt          pointer to gate weights
+   * @param[in]       bias        pointer to gate bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for the gate inputs
+   * @param[in]       int_width   integer bits of the gate inputs, at most 3
+   * @param[in]       cell_int_width integer bits of the cell state, at most 3
+   * @param[in,out]   buffer      pointer to the state and buffer space
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * buffer size: 6*dim_hidden+dim_input, weights in the interleaved
+   * order of arm_fully_connected_mat_q7_vec_q15_opt
+   */
+
+    arm_status arm_lstm_step_q7_q15_opt(const q15_t * input,
+                                        const uint16_t dim_input,
+                                        const uint16_t dim_hidden,
+                                        const q7_t * wt,
+                                        const q7_t * bias,
+                                        const uint16_t bias_shift,
+                                        const uint16_t out_shift,
+                                        const uint16_t int_width,
+                                        const uint16_t cell_int_width,
+                                        q15_t * buffer);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,1792 @@
+/*----------------------------------------------------------------------------
+ * Name:    nn_bench.c
+ * Purpose: Host comparison and benchmark of the CMSIS-NN kernels (ARM_MATH_HOST)
+ * Note(s): Linux counterpart of arm_nnexamples_nn_test.cpp. Every kernel is
+ *          run against its Ref_Implementations version on random data, over
+ *          fixed shapes of the size a gesture classifier uses and over
+ *          random ones. Outputs must match bit for bit. Average pooling may
+ *          differ by 1, as nn_test allows. The optimized call is then timed
+ *          and ns per call and MAC/s are printed and written to a JSON
+ *          report. The host runs the Cortex-M4 code paths with the
+ *          intrinsics of arm_math_host.h, so the times rank kernels and
+ *          shapes against each other; device numbers come from the F411
+ *          benchmark image. Last, the gesture_imu network of
+ *          Scripts/gesture_imu_graph.json runs from the arena nn_arena.py
+ *          plans for it and must give what it gives from one array per
+ *          buffer. Build with the Makefile next to this file.
+ *
+ *          Environment:
+ *            NN_BENCH_JSON    report file, default nn_bench.json
+ *            NN_BENCH_SEED    random seed, default 1
+ *            NN_BENCH_SHAPES  random shapes per kernel family, default 16
+ *            NN_BENCH_MS      minimum timed span per call in ms, default
+ *                             20, 0 checks without timing
+ *----------------------------------------------------------------------------*/
+
+#include "arm_math.h"
+#include "arm_nnfunctions.h"
+#include "ref_functions.h"
+#include "gesture_imu_arena.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------------------*/
+/* Macros and Defines */
+/*--------------------------------------------------------------------------------*/
+#define NN_BENCH_SHAPE_STR  80
+
+/**
+ *  Time call, ns per call into ns. The call is repeated until the span
+ *  reaches NN_BENCH_MS. setup runs before every call and its own time is
+ *  taken off, it restores the input of the in place kernels.
+ */
+#define NN_BENCH_TIME(ns, setup, call)                                  \
+    do                                                                  \
+    {                                                                   \
+        uint64_t __nn_reps;                                             \
+        uint64_t __nn_i;                                                \
+        uint64_t __nn_t0;                                               \
+        uint64_t __nn_span = 0;                                         \
+        uint64_t __nn_setup = 0;                                        \
+                                                                        \
+        (ns) = 0;                                                       \
+        if (nn_bench.min_ns == 0)                                       \
+        {                                                               \
+            break;                                                      \
+        }                                                               \
+        for (__nn_reps = 1; ; __nn_reps *= 2)                           \
+        {                                                               \
+            __nn_t0 = nn_bench_ns();                                    \
+            for (__nn_i = 0; __nn_i < __nn_reps; __nn_i++)              \
+            {                                                           \
+                setup;                                                  \
+                call;                                                   \
+            }                                                           \
+            __nn_span = nn_bench_ns() - __nn_t0;                        \
+            if (__nn_span >= nn_bench.min_ns)                           \
+            {                                                           \
+                break;                                                  \
+            }                                                           \
+        }                                                               \
+        __nn_t0 = nn_bench_ns();                                        \
+        for (__nn_i = 0; __nn_i < __nn_reps; __nn_i++)                  \
+        {                                                               \
+            setup;                                                      \
+        }                                                               \
+        __nn_setup = nn_bench_ns() - __nn_t0;                           \
+        if (__nn_span > __nn_setup)                                     \
+        {                                                               \
+            (ns) = (double)(__nn_span - __nn_setup) / __nn_reps;        \
+        }                                                               \
+    } while (0)
+
+#define NN_BENCH_NOTHING    ((void)0)
+
+/*--------------------------------------------------------------------------------*/
+/* Type Definitions */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Layer shape. Square kernels use the x fields. Fully connected layers
+ *  use ch_in for the vector length and ch_out for the rows, softmax and
+ *  relu use ch_in for the length. 1-D causal convolutions use in_x for
+ *  the length, k_x and dilation. Recurrent cells use ch_in for the input
+ *  and ch_out for the hidden state length.
+ */
+typedef struct
+{
+    uint16_t in_x;
+    uint16_t in_y;
+    uint16_t ch_in;
+    uint16_t ch_out;
+    uint16_t k_x;
+    uint16_t k_y;
+    uint16_t pad_x;
+    uint16_t pad_y;
+    uint16_t stride_x;
+    uint16_t stride_y;
+    uint16_t out_x;
+    uint16_t out_y;
+    uint16_t bias_shift;
+    uint16_t out_shift;
+    uint16_t dilation;
+} NN_BENCH_SHAPE_t;
+
+typedef struct
+{
+    const char * kernel;
+    char shape[NN_BENCH_SHAPE_STR];
+    uint64_t macs;
+    double ns;
+    int match;
+} NN_BENCH_RUN_t;
+
+typedef struct
+{
+    uint64_t min_ns;
+    int shapes;
+    unsigned seed;
+    NN_BENCH_RUN_t * runs;
+    int run_num;
+    int run_max;
+    int failed;
+} NN_BENCH_t;
+
+typedef arm_status (*NN_CONV_Q7_FN_t)(const q7_t *, const uint16_t, const uint16_t, const q7_t *,
+                                      const uint16_t, const uint16_t, const uint16_t, const uint16_t,
+                                      const q7_t *, const uint16_t, const uint16_t, q7_t *,
+                                      const uint16_t, q15_t *, q7_t *);
+
+typedef arm_status (*NN_CONV_Q7_NS_FN_t)(const q7_t *, const uint16_t, const uint16_t, const uint16_t,
+                                         const q7_t *, const uint16_t, const uint16_t, const uint16_t,
+                                         const uint16_t, const uint16_t, const uint16_t, const uint16_t,
+                                         const q7_t *, const uint16_t, const uint16_t, q7_t *,
+                                         const uint16_t, const uint16_t, q15_t *, q7_t *);
+
+/**
+ *  Buffers of gesture_imu, in the order of gesture_imu_arena.h.
+ */
+typedef enum
+{
+    NN_ARENA_IMU = 0,
+    NN_ARENA_TC1,
+    NN_ARENA_TC1_BUF,
+    NN_ARENA_TC2,
+    NN_ARENA_TC2_BUF,
+    NN_ARENA_TC3,
+    NN_ARENA_TC3_BUF,
+    NN_ARENA_DOWN,
+    NN_ARENA_DOWN_BUF,
+    NN_ARENA_FC1,
+    NN_ARENA_FC1_BUF,
+    NN_ARENA_FC2,
+    NN_ARENA_FC2_BUF,
+    NN_ARENA_NUM
+} NN_ARENA_BUF_t;
+
+/**
+ *  Weights of the six weighted layers of gesture_imu: tc1, tc2, tc3, down,
+ *  fc1 and fc2.
+ */
+typedef struct
+{
+    q7_t * wt[6];
+    q7_t * bias[6];
+    uint16_t bias_shift[6];
+    uint16_t out_shift[6];
+} NN_BENCH_ARENA_NET_t;
+
+typedef arm_status (*NN_CONV_Q15_FN_t)(const q15_t *, const uint16_t, const uint16_t, const q15_t *,
+                                       const uint16_t, const uint16_t, const uint16_t, const uint16_t,
+                                       const q15_t *, const uint16_t, const uint16_t, q15_t *,
+                                       const uint16_t, q15_t *, q7_t *);
+
+/*--------------------------------------------------------------------------------*/
+/* Module Variables */
+/*--------------------------------------------------------------------------------*/
+static NN_BENCH_t nn_bench;
+
+/**
+ *  Fixed shapes, the layers of a small IMU gesture classifier: 1-D
+ *  convolutions over a window of samples (in_y 1), a 2-D feature map and
+ *  the dense head. They run before the random shapes.
+ */
+static const NN_BENCH_SHAPE_t nn_bench_conv_shapes[] =
+{
+    /* in_x in_y ch_in ch_out k_x k_y pad_x pad_y s_x s_y out_x out_y bias out */
+    { 16,  16,  16,  16,  5,  5,  2,  2,  1,  1,  16,  16,  1,  7 },  /* nn_test CONV */
+    { 32,  32,   3,  16,  5,  5,  2,  2,  1,  1,  32,  32,  0,  9 },
+    { 16,  16,  16,  32,  3,  3,  1,  1,  2,  2,   8,   8,  1,  8 },
+    { 64,   1,   8,  16,  5,  1,  2,  0,  1,  1,  64,   1,  1,  7 },
+    { 32,   1,  16,  32,  3,  1,  1,  0,  1,  1,  32,   1,  1,  8 },
+    { 32,   1,  32,  32,  1,  1,  0,  0,  1,  1,  32,   1,  0,  7 },
+    { 10,   8,   4,   4,  5,  3,  2,  1,  1,  1,  10,   8,  1,  7 },  /* nn_test RCONV */
+};
+
+/**
+ *  1-D causal convolutions over a window of 6-axis IMU samples, with the
+ *  dilations of a temporal convolution stack.
+ */
+static const NN_BENCH_SHAPE_t nn_bench_conv1d_shapes[] =
+{
+    /* in_x     ch_in ch_out k_x                                     bias out dilation */
+    { 128, 1,   6,  16,  5, 1, 0, 0, 1, 1, 128, 1,  1,  7,  1 },
+    { 128, 1,  16,  16,  3, 1, 0, 0, 1, 1, 128, 1,  1,  8,  2 },
+    { 128, 1,  16,  32,  3, 1, 0, 0, 1, 1, 128, 1,  1,  8,  4 },
+    {  64, 1,  32,  32,  3, 1, 0, 0, 1, 1,  64, 1,  1,  8,  8 },
+};
+
+static const NN_BENCH_SHAPE_t nn_bench_fc_shapes[] =
+{
+    { 0, 0, 127, 127, 0, 0, 0, 0, 0, 0, 0, 0, 1, 7 },     /* nn_test IP */
+    { 0, 0, 512,  64, 0, 0, 0, 0, 0, 0, 0, 0, 1, 9 },
+    { 0, 0, 256,  32, 0, 0, 0, 0, 0, 0, 0, 0, 1, 8 },
+    { 0, 0,  64,  10, 0, 0, 0, 0, 0, 0, 0, 0, 1, 7 },
+};
+
+static const NN_BENCH_SHAPE_t nn_bench_pool_shapes[] =
+{
+    { 32, 32,  8,  8,  3,  3,  0,  0,  2,  2,  16, 16,  0,  0 },     /* nn_test POOL */
+    { 16, 16, 32, 32,  2,  2,  0,  0,  2,  2,   8,  8,  0,  0 },
+};
+
+static const uint16_t nn_bench_vec_lens[] = { 10, 16, 127, 256 };
+
+/**
+ *  Offset in the arena and size of each gesture_imu buffer. The sizes are
+ *  what the kernels take, from arm_nnfunctions.h, not from the plan.
+ */
+static const struct
+{
+    int offset;
+    int size;
+} nn_bench_arena_buf[NN_ARENA_NUM] =
+{
+    { GESTURE_IMU_IMU_OFFSET, 64 * 6 },
+    { GESTURE_IMU_TC1_OFFSET, 64 * 16 },
+    { GESTURE_IMU_TC1_BUF_OFFSET, 2 * 6 * 5 * sizeof(q15_t) },
+    { GESTURE_IMU_TC2_OFFSET, 64 * 32 },
+    { GESTURE_IMU_TC2_BUF_OFFSET, 2 * 16 * 3 * sizeof(q15_t) },
+    { GESTURE_IMU_TC3_OFFSET, 64 * 32 },
+    { GESTURE_IMU_TC3_BUF_OFFSET, 2 * 32 * 3 * sizeof(q15_t) },
+    { GESTURE_IMU_DOWN_OFFSET, 16 * 32 },
+    { GESTURE_IMU_DOWN_BUF_OFFSET, 2 * 32 * 4 * sizeof(q15_t) },
+    { GESTURE_IMU_FC1_OFFSET, 64 },
+    { GESTURE_IMU_FC1_BUF_OFFSET, 16 * 32 * sizeof(q15_t) },
+    { GESTURE_IMU_FC2_OFFSET, 8 },
+    { GESTURE_IMU_FC2_BUF_OFFSET, 64 * sizeof(q15_t) },
+};
+
+/* weights and biases of tc1, tc2, tc3, down, fc1 and fc2 */
+static const int nn_bench_arena_wt[6] = { 16 * 5 * 6, 32 * 3 * 16, 32 * 3 * 32, 32 * 4 * 32, 64 * 512, 8 * 64 };
+static const int nn_bench_arena_bias[6] = { 16, 32, 32, 32, 64, 8 };
+
+/**
+ *  Recurrent cells over 6-axis IMU samples or a feature vector per step.
+ */
+static const NN_BENCH_SHAPE_t nn_bench_rnn_shapes[] =
+{
+    /*    ch_in ch_out                           bias out */
+    { 0, 0,  6,  32, 0, 0, 0, 0, 0, 0, 0, 0,  1,  12 },
+    { 0, 0,  6,  64, 0, 0, 0, 0, 0, 0, 0, 0,  1,  12 },
+    { 0, 0, 32,  32, 0, 0, 0, 0, 0, 0, 0, 0,  1,  13 },
+    { 0, 0, 16,  16, 0, 0, 0, 0, 0, 0, 0, 0,  0,  11 },
+};
+
+/**
+ *  Steps run on each shape, the states are compared after every step.
+ */
+#define NN_BENCH_RNN_STEPS  8
+
+/*--------------------------------------------------------------------------------*/
+/* Helpers */
+/*--------------------------------------------------------------------------------*/
+
+static uint64_t nn_bench_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static int nn_bench_rand(int lo, int hi)
+{
+    return lo + rand() % (hi - lo + 1);
+}
+
+static int nn_bench_pick(const int * set, int num)
+{
+    return set[rand() % num];
+}
+
+static void nn_bench_fill_q7(q7_t * p, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        p[i] = (q7_t) nn_bench_rand(-128, 127);
+    }
+}
+
+/**
+ *  Values in [-amp, amp). The q15 kernels accumulate in 32 bits like the
+ *  target, amp keeps the sums of the larger shapes from wrapping.
+ */
+static void nn_bench_fill_q15(q15_t * p, int n, int amp)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        p[i] = (q15_t) nn_bench_rand(-amp, amp - 1);
+    }
+}
+
+static void * nn_bench_alloc(size_t size)
+{
+    void * p = malloc(size ? size : 1);
+
+    if (p == NULL)
+    {
+        fprintf(stderr, "nn_bench: out of memory\n");
+        exit(2);
+    }
+    return p;
+}
+
+/**
+ *  Output dimension of a convolution or pooling window.
+ */
+static uint16_t nn_bench_out_dim(int in, int k, int pad, int stride)
+{
+    return (uint16_t) ((in + 2 * pad - k) / stride + 1);
+}
+
+/**
+ *  Print and record one run.
+ */
+static void nn_bench_run(const char * kernel, const char * shape, uint64_t macs,
+                        double ns, int match)
+{
+    NN_BENCH_RUN_t * r;
+
+    if (nn_bench.run_num == nn_bench.run_max)
+    {
+        nn_bench.run_max = nn_bench.run_max ? 2 * nn_bench.run_max : 256;
+        nn_bench.runs = realloc(nn_bench.runs, nn_bench.run_max * sizeof(NN_BENCH_RUN_t));
+        if (nn_bench.runs == NULL)
+        {
+            fprintf(stderr, "nn_bench: out of memory\n");
+            exit(2);
+        }
+    }
+    r = &nn_bench.runs[nn_bench.run_num++];
+    r->kernel = kernel;
+    snprintf(r->shape, sizeof(r->shape), "%s", shape);
+    r->macs = macs;
+    r->ns = ns;
+    r->match = match;
+
+    if (!match)
+    {
+        nn_bench.failed++;
+    }
+    printf("%-44s %-40s %-8s", kernel, shape, match ? "match" : "MISMATCH");
+    if (ns > 0)
+    {
+        printf(" %12.0f ns %10.1f MMAC/s", ns, macs * 1e3 / ns);
+    }
+    printf("\n");
+}
+
+/**
+ *  Compare outputs, print the first difference larger than tol.
+ */
+static int nn_bench_cmp_q7(const q7_t * ref, const q7_t * opt, int n, int tol)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        if (ref[i] - opt[i] > tol || opt[i] - ref[i] > tol)
+        {
+            printf("  output %d of %d: expected %d, actual %d\n", i, n, ref[i], opt[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int nn_bench_cmp_q15(const q15_t * ref, const q15_t * opt, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        if (ref[i] != opt[i])
+        {
+            printf("  output %d of %d: expected %d, actual %d\n", i, n, ref[i], opt[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void nn_bench_conv_str(char * s, const NN_BENCH_SHAPE_t * sh)
+{
+    snprintf(s, NN_BENCH_SHAPE_STR, "%dx%dx%d k%dx%d p%d,%d s%d,%d -> %dx%dx%d",
+             sh->in_x, sh->in_y, sh->ch_in, sh->k_x, sh->k_y, sh->pad_x, sh->pad_y,
+             sh->stride_x, sh->stride_y, sh->out_x, sh->out_y, sh->ch_out);
+}
+
+/**
+ *  Random convolution shape. square forces in_y = in_x and the same
+ *  kernel, padding and stride in y. ch_in comes from ch_set, ch_out from
+ *  ch_set too unless depthwise.
+ */
+static void nn_bench_rand_conv(NN_BENCH_SHAPE_t * sh, int square, int depthwise,
+                               const int * ch_set, int ch_num, int q15)
+{
+    memset(sh, 0, sizeof(*sh));
+    sh->in_x = nn_bench_rand(1, 24);
+    sh->k_x = nn_bench_rand(1, 5);
+    sh->pad_x = nn_bench_rand(0, sh->k_x / 2);
+    sh->stride_x = nn_bench_rand(1, 2);
+    if (sh->in_x + 2 * sh->pad_x < sh->k_x)
+    {
+        sh->in_x = sh->k_x;
+    }
+    if (square)
+    {
+        sh->in_y = sh->in_x;
+        sh->k_y = sh->k_x;
+        sh->pad_y = sh->pad_x;
+        sh->stride_y = sh->stride_x;
+    }
+    else if (rand() % 3 == 0)
+    {
+        /* 1-D over a window of samples */
+        sh->in_y = 1;
+        sh->k_y = 1;
+        sh->pad_y = 0;
+        sh->stride_y = 1;
+    }
+    else
+    {
+        sh->in_y = nn_bench_rand(1, 24);
+        sh->k_y = nn_bench_rand(1, 5);
+        sh->pad_y = nn_bench_rand(0, sh->k_y / 2);
+        sh->stride_y = nn_bench_rand(1, 2);
+        if (sh->in_y + 2 * sh->pad_y < sh->k_y)
+        {
+            sh->in_y = sh->k_y;
+        }
+    }
+    sh->ch_in = nn_bench_pick(ch_set, ch_num);
+    sh->ch_out = depthwise ? sh->ch_in : nn_bench_pick(ch_set, ch_num);
+    sh->out_x = nn_bench_out_dim(sh->in_x, sh->k_x, sh->pad_x, sh->stride_x);
+    sh->out_y = nn_bench_out_dim(sh->in_y, sh->k_y, sh->pad_y, sh->stride_y);
+    sh->bias_shift = q15 ? 0 : nn_bench_rand(0, 3);
+    sh->out_shift = q15 ? nn_bench_rand(10, 15) : nn_bench_rand(5, 9);
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Weight Reordering */
+/*--------------------------------------------------------------------------------*/
+
+/*
+ * The _opt fully connected kernels read the weights interleaved, four rows
+ * at a time, see the Ref_Implementations *_opt_ref.c loops. These build
+ * that layout from a row-major matrix. Rows past the last full group of
+ * four stay row-major.
+ */
+
+#define NN_W(r, c)  src[(r) * dim_vec + (c)]
+
+static void nn_bench_reorder_q7_opt(const q7_t * src, q7_t * dst, int dim_vec, int rows)
+{
+    int r, c, i;
+    q7_t * d = dst;
+
+    for (r = 0; r + 4 <= rows; r += 4)
+    {
+        for (c = 0; c + 4 <= dim_vec; c += 4)
+        {
+            /* inA1 inA3 inA2 inA4 are columns c, c+1, c+2, c+3 */
+            for (i = 0; i < 2; i++)
+            {
+                *d++ = NN_W(r + 0, c + i);  *d++ = NN_W(r + 1, c + i);
+                *d++ = NN_W(r + 0, c + i + 2);  *d++ = NN_W(r + 1, c + i + 2);
+                *d++ = NN_W(r + 2, c + i);  *d++ = NN_W(r + 3, c + i);
+                *d++ = NN_W(r + 2, c + i + 2);  *d++ = NN_W(r + 3, c + i + 2);
+            }
+        }
+        for (; c < dim_vec; c++)
+        {
+            for (i = 0; i < 4; i++)
+            {
+                *d++ = NN_W(r + i, c);
+            }
+        }
+    }
+    memcpy(d, &NN_W(r, 0), (rows - r) * dim_vec * sizeof(q7_t));
+}
+
+static void nn_bench_reorder_q15_opt(const q15_t * src, q15_t * dst, int dim_vec, int rows)
+{
+    int r, c, i;
+    q15_t * d = dst;
+
+    for (r = 0; r + 4 <= rows; r += 4)
+    {
+        for (c = 0; c + 2 <= dim_vec; c += 2)
+        {
+            for (i = 0; i < 4; i++)
+            {
+                *d++ = NN_W(r + i, c);
+                *d++ = NN_W(r + i, c + 1);
+            }
+        }
+        for (; c < dim_vec; c++)
+        {
+            for (i = 0; i < 4; i++)
+            {
+                *d++ = NN_W(r + i, c);
+            }
+        }
+    }
+    memcpy(d, &NN_W(r, 0), (rows - r) * dim_vec * sizeof(q15_t));
+}
+
+static void nn_bench_reorder_q7_q15_opt(const q7_t * src, q7_t * dst, int dim_vec, int rows)
+{
+    int r, c, i;
+    q7_t * d = dst;
+
+    for (r = 0; r + 4 <= rows; r += 4)
+    {
+        for (c = 0; c + 2 <= dim_vec; c += 2)
+        {
+            for (i = 0; i < 4; i += 2)
+            {
+                *d++ = NN_W(r + i, c);
+                *d++ = NN_W(r + i + 1, c);
+                *d++ = NN_W(r + i, c + 1);
+                *d++ = NN_W(r + i + 1, c + 1);
+            }
+        }
+        for (; c < dim_vec; c++)
+        {
+            for (i = 0; i < 4; i++)
+            {
+                *d++ = NN_W(r + i, c);
+            }
+        }
+    }
+    memcpy(d, &NN_W(r, 0), (rows - r) * dim_vec * sizeof(q7_t));
+}
+
+#undef NN_W
+
+
+/*--------------------------------------------------------------------------------*/
+/* Convolution */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  arm_convolve_HWC_q7_* and the depthwise kernel against their reference.
+ *  Square shapes run the square kernels, all shapes the nonsquare ones.
+ *  A kernel that returns ARM_MATH_SIZE_MISMATCH does not support the shape
+ *  and is skipped. The fast kernels run their top rows and left columns up
+ *  to the padding and must refuse a padding larger than the output, one
+ *  that runs such a shape counts as a mismatch.
+ */
+static void nn_bench_conv_q7(const NN_BENCH_SHAPE_t * sh, int depthwise)
+{
+    static const struct
+    {
+        const char * name;
+        NN_CONV_Q7_FN_t fn;
+        int depthwise;
+        int pad_max;            /* padding at most the output */
+    } sq[] =
+    {
+        { "arm_convolve_HWC_q7_basic", arm_convolve_HWC_q7_basic, 0, 0 },
+        { "arm_convolve_HWC_q7_fast", arm_convolve_HWC_q7_fast, 0, 1 },
+        { "arm_convolve_HWC_q7_RGB", arm_convolve_HWC_q7_RGB, 0, 0 },
+        { "arm_depthwise_separable_conv_HWC_q7", arm_depthwise_separable_conv_HWC_q7, 1, 0 },
+    };
+    static const struct
+    {
+        const char * name;
+        NN_CONV_Q7_NS_FN_t fn;
+        int depthwise;
+        int pad_max;            /* padding at most the output */
+    } ns[] =
+    {
+        { "arm_convolve_HWC_q7_basic_nonsquare", arm_convolve_HWC_q7_basic_nonsquare, 0, 0 },
+        { "arm_convolve_HWC_q7_fast_nonsquare", arm_convolve_HWC_q7_fast_nonsquare, 0, 1 },
+        { "arm_convolve_1x1_HWC_q7_fast_nonsquare", arm_convolve_1x1_HWC_q7_fast_nonsquare, 0, 1 },
+        { "arm_depthwise_separable_conv_HWC_q7_nonsquare", arm_depthwise_separable_conv_HWC_q7_nonsquare, 1, 0 },
+    };
+    int square = sh->in_x == sh->in_y && sh->k_x == sh->k_y && sh->pad_x == sh->pad_y
+                 && sh->stride_x == sh->stride_y;
+    int pad_ok = sh->pad_x <= sh->out_x && sh->pad_y <= sh->out_y;
+    /* room for what a fast kernel that misses the padding limit writes */
+    int n_opt = (sh->pad_x > sh->out_x ? sh->pad_x : sh->out_x) * (sh->pad_y > sh->out_y ? sh->pad_y : sh->out_y)
+                * sh->ch_out + sh->ch_out;
+    int n_in = sh->in_x * sh->in_y * sh->ch_in;
+    int n_k = sh->k_x * sh->k_y * (depthwise ? 1 : sh->ch_in);
+    int n_wt = n_k * sh->ch_out;
+    int n_out = sh->out_x * sh->out_y * sh->ch_out;
+    uint64_t macs = (uint64_t) n_out * n_k;
+    /* the RGB kernel loads the 3 channels of a pixel as one word */
+    q7_t * in = nn_bench_alloc(n_in + 1);
+    q7_t * wt = nn_bench_alloc(n_wt);
+    q7_t * bias = nn_bench_alloc(sh->ch_out);
+    q7_t * out_ref = nn_bench_alloc(n_out);
+    q7_t * out_opt = nn_bench_alloc(n_opt);
+    q15_t * buf = nn_bench_alloc(2 * sh->ch_in * sh->k_x * sh->k_y * sizeof(q15_t));
+    char str[NN_BENCH_SHAPE_STR];
+    unsigned i;
+
+    nn_bench_fill_q7(in, n_in);
+    nn_bench_fill_q7(wt, n_wt);
+    nn_bench_fill_q7(bias, sh->ch_out);
+    nn_bench_conv_str(str, sh);
+
+    if (depthwise)
+    {
+        arm_depthwise_separable_conv_HWC_q7_ref_nonsquare(in, sh->in_x, sh->in_y, sh->ch_in, wt, sh->ch_out,
+                                                          sh->k_x, sh->k_y, sh->pad_x, sh->pad_y,
+                                                          sh->stride_x, sh->stride_y, bias, sh->bias_shift,
+                                                          sh->out_shift, out_ref, sh->out_x, sh->out_y,
+                                                          buf, NULL);
+    }
+    else
+    {
+        arm_convolve_HWC_q7_ref_nonsquare(in, sh->in_x, sh->in_y, sh->ch_in, wt, sh->ch_out, sh->k_x,
+                                          sh->k_y, sh->pad_x, sh->pad_y, sh->stride_x, sh->stride_y, bias,
+                                          sh->bias_shift, sh->out_shift, out_ref, sh->out_x, sh->out_y,
+                                          buf, NULL);
+    }
+
+    for (i = 0; square && i < sizeof(sq) / sizeof(sq[0]); i++)
+    {
+        double t;
+        int match;
+        arm_status status;
+
+        if (sq[i].depthwise != depthwise)
+        {
+            continue;
+        }
+        memset(out_opt, 37, n_out);
+        status = sq[i].fn(in, sh->in_x, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->pad_x, sh->stride_x, bias,
+                          sh->bias_shift, sh->out_shift, out_opt, sh->out_x, buf, NULL);
+        if (sq[i].pad_max && !pad_ok && status != ARM_MATH_SIZE_MISMATCH)
+        {
+            nn_bench_run(sq[i].name, str, macs, 0, 0);
+            continue;
+        }
+        if (status == ARM_MATH_SIZE_MISMATCH)
+        {
+            continue;
+        }
+        match = nn_bench_cmp_q7(out_ref, out_opt, n_out, 0);
+        t = 0;
+        if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          sq[i].fn(in, sh->in_x, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->pad_x,
+                                   sh->stride_x, bias, sh->bias_shift, sh->out_shift, out_opt,
+                                   sh->out_x, buf, NULL));
+        }
+        nn_bench_run(sq[i].name, str, macs, t, match);
+    }
+
+    for (i = 0; i < sizeof(ns) / sizeof(ns[0]); i++)
+    {
+        double t;
+        int match;
+        arm_status status;
+
+        if (ns[i].depthwise != depthwise)
+        {
+            continue;
+        }
+        memset(out_opt, 37, n_out);
+        status = ns[i].fn(in, sh->in_x, sh->in_y, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->k_y, sh->pad_x,
+                          sh->pad_y, sh->stride_x, sh->stride_y, bias, sh->bias_shift, sh->out_shift,
+                          out_opt, sh->out_x, sh->out_y, buf, NULL);
+        if (ns[i].pad_max && !pad_ok && status != ARM_MATH_SIZE_MISMATCH)
+        {
+            nn_bench_run(ns[i].name, str, macs, 0, 0);
+            continue;
+        }
+        if (status == ARM_MATH_SIZE_MISMATCH)
+        {
+            continue;
+        }
+        match = nn_bench_cmp_q7(out_ref, out_opt, n_out, 0);
+        t = 0;
+        if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          ns[i].fn(in, sh->in_x, sh->in_y, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->k_y,
+                                   sh->pad_x, sh->pad_y, sh->stride_x, sh->stride_y, bias,
+                                   sh->bias_shift, sh->out_shift, out_opt, sh->out_x, sh->out_y,
+                                   buf, NULL));
+        }
+        nn_bench_run(ns[i].name, str, macs, t, match);
+    }
+
+    free(in);
+    free(wt);
+    free(bias);
+    free(out_ref);
+    free(out_opt);
+    free(buf);
+}
+
+/**
+ *  arm_convolve_HWC_q15_* against their reference. The fast kernels compute
+ *  two neighbouring outputs of a row at a time and write past bufferA when
+ *  the output width is odd, which their size check does not catch, so they
+ *  only run on even widths.
+ */
+static void nn_bench_conv_q15(const NN_BENCH_SHAPE_t * sh)
+{
+    static const struct
+    {
+        const char * name;
+        NN_CONV_Q15_FN_t fn;
+        int pairs;
+    } sq[] =
+    {
+        { "arm_convolve_HWC_q15_basic", arm_convolve_HWC_q15_basic, 0 },
+        { "arm_convolve_HWC_q15_fast", arm_convolve_HWC_q15_fast, 1 },
+    };
+    int square = sh->in_x == sh->in_y && sh->k_x == sh->k_y && sh->pad_x == sh->pad_y
+                 && sh->stride_x == sh->stride_y;
+    int n_in = sh->in_x * sh->in_y * sh->ch_in;
+    int n_k = sh->k_x * sh->k_y * sh->ch_in;
+    int n_wt = n_k * sh->ch_out;
+    int n_out = sh->out_x * sh->out_y * sh->ch_out;
+    uint64_t macs = (uint64_t) n_out * n_k;
+    q15_t * in = nn_bench_alloc(n_in * sizeof(q15_t));
+    q15_t * wt = nn_bench_alloc(n_wt * sizeof(q15_t));
+    q15_t * bias = nn_bench_alloc(sh->ch_out * sizeof(q15_t));
+    q15_t * out_ref = nn_bench_alloc(n_out * sizeof(q15_t));
+    q15_t * out_opt = nn_bench_alloc(n_out * sizeof(q15_t));
+    q15_t * buf = nn_bench_alloc(2 * n_k * sizeof(q15_t));
+    char str[NN_BENCH_SHAPE_STR];
+    double t;
+    int match;
+    unsigned i;
+
+    nn_bench_fill_q15(in, n_in, 1024);
+    nn_bench_fill_q15(wt, n_wt, 1024);
+    nn_bench_fill_q15(bias, sh->ch_out, 32768);
+    nn_bench_conv_str(str, sh);
+
+    arm_convolve_HWC_q15_nonsquare_ref(in, sh->in_x, sh->in_y, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->k_y,
+                                       sh->pad_x, sh->pad_y, sh->stride_x, sh->stride_y, bias,
+                                       sh->bias_shift, sh->out_shift, out_ref, sh->out_x, sh->out_y,
+                                       buf, NULL);
+
+    for (i = 0; square && i < sizeof(sq) / sizeof(sq[0]); i++)
+    {
+        if (sq[i].pairs && (sh->out_x & 1))
+        {
+            continue;
+        }
+        arm_fill_q15(0x5F5, out_opt, n_out);
+        if (sq[i].fn(in, sh->in_x, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->pad_x, sh->stride_x, bias,
+                     sh->bias_shift, sh->out_shift, out_opt, sh->out_x, buf, NULL) == ARM_MATH_SIZE_MISMATCH)
+        {
+            continue;
+        }
+        match = nn_bench_cmp_q15(out_ref, out_opt, n_out);
+        t = 0;
+        if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          sq[i].fn(in, sh->in_x, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->pad_x,
+                                   sh->stride_x, bias, sh->bias_shift, sh->out_shift, out_opt,
+                                   sh->out_x, buf, NULL));
+        }
+        nn_bench_run(sq[i].name, str, macs, t, match);
+    }
+
+    arm_fill_q15(0x5F5, out_opt, n_out);
+    if ((sh->out_x & 1) == 0
+        && arm_convolve_HWC_q15_fast_nonsquare(in, sh->in_x, sh->in_y, sh->ch_in, wt, sh->ch_out,
+                                               sh->k_x, sh->k_y, sh->pad_x, sh->pad_y, sh->stride_x,
+                                               sh->stride_y, bias, sh->bias_shift, sh->out_shift,
+                                               out_opt, sh->out_x, sh->out_y, buf,
+                                               NULL) != ARM_MATH_SIZE_MISMATCH)
+    {
+        match = nn_bench_cmp_q15(out_ref, out_opt, n_out);
+        t = 0;
+        if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          arm_convolve_HWC_q15_fast_nonsquare(in, sh->in_x, sh->in_y, sh->ch_in, wt,
+                                                              sh->ch_out, sh->k_x, sh->k_y, sh->pad_x,
+                                                              sh->pad_y, sh->stride_x, sh->stride_y, bias,
+                                                              sh->bias_shift, sh->out_shift, out_opt,
+                                                              sh->out_x, sh->out_y, buf, NULL));
+        }
+        nn_bench_run("arm_convolve_HWC_q15_fast_nonsquare", str, macs, t, match);
+    }
+
+    free(in);
+    free(wt);
+    free(bias);
+    free(out_ref);
+    free(out_opt);
+    free(buf);
+}
+
+/*--------------------------------------------------------------------------------*/
+/* 1-D Convolution */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  arm_convolve_1D_causal_* and arm_convolve_1D_stream_* against the causal
+ *  reference. The streaming kernel is fed one sample per call from a
+ *  cleared ring and must produce the same sequence, it is timed per sample
+ *  with the MACs of one output sample. For dilation 1 the q7 layer also
+ *  runs as a 1 x len image through the 2-D nonsquare kernels, padded by
+ *  k - 1 on both sides, whose first len outputs are the causal ones.
+ */
+static void nn_bench_conv1d(const NN_BENCH_SHAPE_t * sh, int q15)
+{
+    static const struct
+    {
+        const char * name;
+        NN_CONV_Q7_NS_FN_t fn;
+    } img[] =
+    {
+        { "arm_convolve_HWC_q7_basic_nonsquare", arm_convolve_HWC_q7_basic_nonsquare },
+        { "arm_convolve_HWC_q7_fast_nonsquare", arm_convolve_HWC_q7_fast_nonsquare },
+    };
+    int len = sh->in_x;
+    int n_win = sh->k_x * sh->ch_in;
+    int n_in = len * sh->ch_in;
+    int n_wt = n_win * sh->ch_out;
+    int n_out = len * sh->ch_out;
+    int n_img = (len + sh->k_x - 1) * sh->ch_out;
+    int n_ring = ((sh->k_x - 1) * sh->dilation + 1) * sh->ch_in;
+    int size = q15 ? sizeof(q15_t) : sizeof(q7_t);
+    uint64_t macs = (uint64_t) n_out * n_win;
+    void * in = nn_bench_alloc(n_in * size);
+    void * wt = nn_bench_alloc(n_wt * size);
+    void * bias = nn_bench_alloc(sh->ch_out * size);
+    void * out_ref = nn_bench_alloc(n_out * size);
+    void * out_opt = nn_bench_alloc(n_img * size);
+    void * ring = nn_bench_alloc(n_ring * size);
+    q15_t * buf = nn_bench_alloc(2 * n_win * sizeof(q15_t));
+    q7_t * win = nn_bench_alloc(n_win);
+    char str[NN_BENCH_SHAPE_STR];
+    uint16_t head;
+    double t;
+    int match;
+    int n;
+    unsigned i;
+
+    snprintf(str, sizeof(str), "len %d ch %d k%d d%d -> %d", len, sh->ch_in, sh->k_x, sh->dilation,
+             sh->ch_out);
+
+    if (q15)
+    {
+        q15_t * in15 = in;
+        q15_t * wt15 = wt;
+        q15_t * bias15 = bias;
+        q15_t * ref15 = out_ref;
+        q15_t * opt15 = out_opt;
+        q15_t * ring15 = ring;
+
+        nn_bench_fill_q15(in15, n_in, 1024);
+        nn_bench_fill_q15(wt15, n_wt, 1024);
+        nn_bench_fill_q15(bias15, sh->ch_out, 32768);
+        arm_convolve_1D_causal_q15_ref(in15, len, sh->ch_in, wt15, sh->ch_out, sh->k_x, sh->dilation,
+                                       bias15, sh->bias_shift, sh->out_shift, ref15);
+
+        arm_fill_q15(0x5F5, opt15, n_out);
+        arm_convolve_1D_causal_q15(in15, len, sh->ch_in, wt15, sh->ch_out, sh->k_x, sh->dilation, bias15,
+                                   sh->bias_shift, sh->out_shift, opt15, buf, NULL);
+        match = nn_bench_cmp_q15(ref15, opt15, n_out);
+        t = 0;
+        if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          arm_convolve_1D_causal_q15(in15, len, sh->ch_in, wt15, sh->ch_out, sh->k_x,
+                                                     sh->dilation, bias15, sh->bias_shift, sh->out_shift,
+                                                     opt15, buf, NULL));
+        }
+        nn_bench_run("arm_convolve_1D_causal_q15", str, macs, t, match);
+
+        arm_fill_q15(0x5F5, opt15, n_out);
+        memset(ring15, 0, n_ring * sizeof(q15_t));
+        head = 0;
+        for (n = 0; n < len; n++)
+        {
+            arm_convolve_1D_stream_q15(in15 + n * sh->ch_in, sh->ch_in, wt15, sh->ch_out, sh->k_x,
+                                       sh->dilation, bias15, sh->bias_shift, sh->out_shift, ring15, &head,
+                                       opt15 + n * sh->ch_out, buf, NULL);
+        }
+        match = nn_bench_cmp_q15(ref15, opt15, n_out);
+        t = 0;
+        if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          arm_convolve_1D_stream_q15(in15, sh->ch_in, wt15, sh->ch_out, sh->k_x,
+                                                     sh->dilation, bias15, sh->bias_shift, sh->out_shift,
+                                                     ring15, &head, opt15, buf, NULL));
+        }
+        nn_bench_run("arm_convolve_1D_stream_q15", str, macs / len, t, match);
+    }
+    else
+    {
+        nn_bench_fill_q7(in, n_in);
+        nn_bench_fill_q7(wt, n_wt);
+        nn_bench_fill_q7(bias, sh->ch_out);
+        arm_convolve_1D_causal_q7_ref(in, len, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->dilation, bias,
+                                      sh->bias_shift, sh->out_shift, out_ref);
+
+        memset(out_opt, 37, n_out);
+        arm_convolve_1D_causal_q7(in, len, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->dilation, bias,
+                                  sh->bias_shift, sh->out_shift, out_opt, buf, NULL);
+        match = nn_bench_cmp_q7(out_ref, out_opt, n_out, 0);
+        t = 0;
+        if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          arm_convolve_1D_causal_q7(in, len, sh->ch_in, wt, sh->ch_out, sh->k_x,
+                                                    sh->dilation, bias, sh->bias_shift, sh->out_shift,
+                                                    out_opt, buf, NULL));
+        }
+        nn_bench_run("arm_convolve_1D_causal_q7", str, macs, t, match);
+
+        memset(out_opt, 37, n_out);
+        memset(ring, 0, n_ring);
+        head = 0;
+        for (n = 0; n < len; n++)
+        {
+            arm_convolve_1D_stream_q7((q7_t *) in + n * sh->ch_in, sh->ch_in, wt, sh->ch_out, sh->k_x,
+                                      sh->dilation, bias, sh->bias_shift, sh->out_shift, ring, &head,
+                                      (q7_t *) out_opt + n * sh->ch_out, buf, win);
+        }
+        match = nn_bench_cmp_q7(out_ref, out_opt, n_out, 0);
+        t = 0;
+        if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          arm_convolve_1D_stream_q7(in, sh->ch_in, wt, sh->ch_out, sh->k_x, sh->dilation,
+                                                    bias, sh->bias_shift, sh->out_shift, ring, &head,
+                                                    out_opt, buf, win));
+        }
+        nn_bench_run("arm_convolve_1D_stream_q7", str, macs / len, t, match);
+
+        for (i = 0; sh->dilation == 1 && i < sizeof(img) / sizeof(img[0]); i++)
+        {
+            memset(out_opt, 37, n_img);
+            if (img[i].fn(in, len, 1, sh->ch_in, wt, sh->ch_out, sh->k_x, 1, sh->k_x - 1, 0, 1, 1, bias,
+                          sh->bias_shift, sh->out_shift, out_opt, len + sh->k_x - 1, 1, buf,
+                          NULL) == ARM_MATH_SIZE_MISMATCH)
+            {
+                continue;
+            }
+            match = nn_bench_cmp_q7(out_ref, out_opt, n_out, 0);
+            t = 0;
+            if (match)
+            {
+                NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                              img[i].fn(in, len, 1, sh->ch_in, wt, sh->ch_out, sh->k_x, 1, sh->k_x - 1, 0,
+                                        1, 1, bias, sh->bias_shift, sh->out_shift, out_opt,
+                                        len + sh->k_x - 1, 1, buf, NULL));
+            }
+            nn_bench_run(img[i].name, str, macs, t, match);
+        }
+    }
+
+    free(in);
+    free(wt);
+    free(bias);
+    free(out_ref);
+    free(out_opt);
+    free(ring);
+    free(buf);
+    free(win);
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Fully Connected */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  The three weight/vector formats, each plain and _opt with reordered
+ *  weights, against the row-major reference.
+ */
+static void nn_bench_fc(const NN_BENCH_SHAPE_t * sh)
+{
+    int dim_vec = sh->ch_in;
+    int rows = sh->ch_out;
+    uint64_t macs = (uint64_t) dim_vec * rows;
+    q7_t * vec_q7 = nn_bench_alloc(dim_vec);
+    q15_t * vec_q15 = nn_bench_alloc(dim_vec * sizeof(q15_t));
+    q7_t * wt_q7 = nn_bench_alloc(dim_vec * rows);
+    q7_t * wt_q7_opt = nn_bench_alloc(dim_vec * rows);
+    q15_t * wt_q15 = nn_bench_alloc(dim_vec * rows * sizeof(q15_t));
+    q15_t * wt_q15_opt = nn_bench_alloc(dim_vec * rows * sizeof(q15_t));
+    q7_t * bias_q7 = nn_bench_alloc(rows);
+    q15_t * bias_q15 = nn_bench_alloc(rows * sizeof(q15_t));
+    q7_t * out_ref_q7 = nn_bench_alloc(rows);
+    q7_t * out_opt_q7 = nn_bench_alloc(rows);
+    q15_t * out_ref_q15 = nn_bench_alloc(rows * sizeof(q15_t));
+    q15_t * out_opt_q15 = nn_bench_alloc(rows * sizeof(q15_t));
+    q15_t * buf = nn_bench_alloc(dim_vec * sizeof(q15_t));
+    uint16_t q15_shift = sh->out_shift + 7;
+    char str[NN_BENCH_SHAPE_STR];
+    double t;
+    int match;
+
+    nn_bench_fill_q7(vec_q7, dim_vec);
+    nn_bench_fill_q15(vec_q15, dim_vec, 1024);
+    nn_bench_fill_q7(wt_q7, dim_vec * rows);
+    nn_bench_fill_q15(wt_q15, dim_vec * rows, 1024);
+    nn_bench_fill_q7(bias_q7, rows);
+    nn_bench_fill_q15(bias_q15, rows, 32768);
+    nn_bench_reorder_q7_opt(wt_q7, wt_q7_opt, dim_vec, rows);
+    nn_bench_reorder_q15_opt(wt_q15, wt_q15_opt, dim_vec, rows);
+    snprintf(str, sizeof(str), "vec %d rows %d", dim_vec, rows);
+
+    /* q7 vector, q7 weights */
+    arm_fully_connected_q7_ref(vec_q7, wt_q7, dim_vec, rows, sh->bias_shift, sh->out_shift, bias_q7,
+                               out_ref_q7, buf);
+
+    memset(out_opt_q7, 37, rows);
+    arm_fully_connected_q7(vec_q7, wt_q7, dim_vec, rows, sh->bias_shift, sh->out_shift, bias_q7,
+                           out_opt_q7, buf);
+    match = nn_bench_cmp_q7(out_ref_q7, out_opt_q7, rows, 0);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                      arm_fully_connected_q7(vec_q7, wt_q7, dim_vec, rows, sh->bias_shift, sh->out_shift,
+                                             bias_q7, out_opt_q7, buf));
+    }
+    nn_bench_run("arm_fully_connected_q7", str, macs, t, match);
+
+    memset(out_opt_q7, 37, rows);
+    arm_fully_connected_q7_opt(vec_q7, wt_q7_opt, dim_vec, rows, sh->bias_shift, sh->out_shift, bias_q7,
+                               out_opt_q7, buf);
+    match = nn_bench_cmp_q7(out_ref_q7, out_opt_q7, rows, 0);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                      arm_fully_connected_q7_opt(vec_q7, wt_q7_opt, dim_vec, rows, sh->bias_shift,
+                                                 sh->out_shift, bias_q7, out_opt_q7, buf));
+    }
+    nn_bench_run("arm_fully_connected_q7_opt", str, macs, t, match);
+
+    /* q15 vector, q15 weights */
+    arm_fully_connected_q15_ref(vec_q15, wt_q15, dim_vec, rows, sh->bias_shift, q15_shift, bias_q15,
+                                out_ref_q15, NULL);
+
+    arm_fill_q15(0x5F5, out_opt_q15, rows);
+    arm_fully_connected_q15(vec_q15, wt_q15, dim_vec, rows, sh->bias_shift, q15_shift, bias_q15,
+                            out_opt_q15, NULL);
+    match = nn_bench_cmp_q15(out_ref_q15, out_opt_q15, rows);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                      arm_fully_connected_q15(vec_q15, wt_q15, dim_vec, rows, sh->bias_shift, q15_shift,
+                                              bias_q15, out_opt_q15, NULL));
+    }
+    nn_bench_run("arm_fully_connected_q15", str, macs, t, match);
+
+    arm_fill_q15(0x5F5, out_opt_q15, rows);
+    arm_fully_connected_q15_opt(vec_q15, wt_q15_opt, dim_vec, rows, sh->bias_shift, q15_shift, bias_q15,
+                                out_opt_q15, NULL);
+    match = nn_bench_cmp_q15(out_ref_q15, out_opt_q15, rows);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                      arm_fully_connected_q15_opt(vec_q15, wt_q15_opt, dim_vec, rows, sh->bias_shift,
+                                                  q15_shift, bias_q15, out_opt_q15, NULL));
+    }
+    nn_bench_run("arm_fully_connected_q15_opt", str, macs, t, match);
+
+    /* q15 vector, q7 weights */
+    nn_bench_reorder_q7_q15_opt(wt_q7, wt_q7_opt, dim_vec, rows);
+    arm_fully_connected_mat_q7_vec_q15_ref(vec_q15, wt_q7, dim_vec, rows, sh->bias_shift, sh->out_shift,
+                                           bias_q7, out_ref_q15, buf);
+
+    arm_fill_q15(0x5F5, out_opt_q15, rows);
+    arm_fully_connected_mat_q7_vec_q15(vec_q15, wt_q7, dim_vec, rows, sh->bias_shift, sh->out_shift,
+                                       bias_q7, out_opt_q15, buf);
+    match = nn_bench_cmp_q15(out_ref_q15, out_opt_q15, rows);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                      arm_fully_connected_mat_q7_vec_q15(vec_q15, wt_q7, dim_vec, rows, sh->bias_shift,
+                                                         sh->out_shift, bias_q7, out_opt_q15, buf));
+    }
+    nn_bench_run("arm_fully_connected_mat_q7_vec_q15", str, macs, t, match);
+
+    arm_fill_q15(0x5F5, out_opt_q15, rows);
+    arm_fully_connected_mat_q7_vec_q15_opt(vec_q15, wt_q7_opt, dim_vec, rows, sh->bias_shift,
+                                           sh->out_shift, bias_q7, out_opt_q15, buf);
+    match = nn_bench_cmp_q15(out_ref_q15, out_opt_q15, rows);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                      arm_fully_connected_mat_q7_vec_q15_opt(vec_q15, wt_q7_opt, dim_vec, rows,
+                                                             sh->bias_shift, sh->out_shift, bias_q7,
+                                                             out_opt_q15, buf));
+    }
+    nn_bench_run("arm_fully_connected_mat_q7_vec_q15_opt", str, macs, t, match);
+
+    free(vec_q7);
+    free(vec_q15);
+    free(wt_q7);
+    free(wt_q7_opt);
+    free(wt_q15);
+    free(wt_q15_opt);
+    free(bias_q7);
+    free(bias_q15);
+    free(out_ref_q7);
+    free(out_opt_q7);
+    free(out_ref_q15);
+    free(out_opt_q15);
+    free(buf);
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Pooling, Softmax, Relu */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Max and average pooling, one MAC per window element. Both kernels work
+ *  in place on the input, which is restored before every call.
+ */
+static void nn_bench_pool(const NN_BENCH_SHAPE_t * sh)
+{
+    int n_in = sh->in_x * sh->in_x * sh->ch_in;
+    int n_out = sh->out_x * sh->out_x * sh->ch_in;
+    uint64_t macs = (uint64_t) n_out * sh->k_x * sh->k_x;
+    q7_t * src = nn_bench_alloc(n_in);
+    q7_t * in = nn_bench_alloc(n_in);
+    q7_t * out_ref = nn_bench_alloc(n_out);
+    q7_t * out_opt = nn_bench_alloc(n_out);
+    q15_t * buf = nn_bench_alloc(2 * sh->out_x * sh->ch_in * sizeof(q15_t));
+    char str[NN_BENCH_SHAPE_STR];
+    double t;
+    int match;
+
+    nn_bench_fill_q7(src, n_in);
+    snprintf(str, sizeof(str), "%dx%dx%d k%d p%d s%d -> %dx%d", sh->in_x, sh->in_x, sh->ch_in,
+             sh->k_x, sh->pad_x, sh->stride_x, sh->out_x, sh->out_x);
+
+    memcpy(in, src, n_in);
+    arm_maxpool_q7_HWC_ref(in, sh->in_x, sh->ch_in, sh->k_x, sh->pad_x, sh->stride_x, sh->out_x,
+                           (q7_t *) buf, out_ref);
+    memcpy(in, src, n_in);
+    memset(out_opt, 37, n_out);
+    arm_maxpool_q7_HWC(in, sh->in_x, sh->ch_in, sh->k_x, sh->pad_x, sh->stride_x, sh->out_x,
+                       (q7_t *) buf, out_opt);
+    match = nn_bench_cmp_q7(out_ref, out_opt, n_out, 0);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, memcpy(in, src, n_in),
+                      arm_maxpool_q7_HWC(in, sh->in_x, sh->ch_in, sh->k_x, sh->pad_x, sh->stride_x,
+                                         sh->out_x, (q7_t *) buf, out_opt));
+    }
+    nn_bench_run("arm_maxpool_q7_HWC", str, macs, t, match);
+
+    memcpy(in, src, n_in);
+    arm_avepool_q7_HWC_ref(in, sh->in_x, sh->ch_in, sh->k_x, sh->pad_x, sh->stride_x, sh->out_x,
+                           (q7_t *) buf, out_ref);
+    memcpy(in, src, n_in);
+    memset(out_opt, 37, n_out);
+    arm_avepool_q7_HWC(in, sh->in_x, sh->ch_in, sh->k_x, sh->pad_x, sh->stride_x, sh->out_x,
+                       (q7_t *) buf, out_opt);
+    /* the reference truncates the mean, the kernel may round */
+    match = nn_bench_cmp_q7(out_ref, out_opt, n_out, 1);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, memcpy(in, src, n_in),
+                      arm_avepool_q7_HWC(in, sh->in_x, sh->ch_in, sh->k_x, sh->pad_x, sh->stride_x,
+                                         sh->out_x, (q7_t *) buf, out_opt));
+    }
+    nn_bench_run("arm_avepool_q7_HWC", str, macs, t, match);
+
+    free(src);
+    free(in);
+    free(out_ref);
+    free(out_opt);
+    free(buf);
+}
+
+/**
+ *  Softmax and relu of a vector of len elements, one MAC per element.
+ *  Softmax inputs are kept within a few steps of each other, the kernels
+ *  only resolve the top 8 (q7) or 16 (q15) steps below the maximum.
+ */
+static void nn_bench_vec(uint16_t len)
+{
+    q7_t * in_q7 = nn_bench_alloc(len);
+    q7_t * ref_q7 = nn_bench_alloc(len);
+    q7_t * opt_q7 = nn_bench_alloc(len);
+    q15_t * in_q15 = nn_bench_alloc(len * sizeof(q15_t));
+    q15_t * ref_q15 = nn_bench_alloc(len * sizeof(q15_t));
+    q15_t * opt_q15 = nn_bench_alloc(len * sizeof(q15_t));
+    char str[NN_BENCH_SHAPE_STR];
+    double t;
+    int match;
+    int i;
+
+    snprintf(str, sizeof(str), "len %d", len);
+
+    for (i = 0; i < len; i++)
+    {
+        in_q7[i] = (q7_t) nn_bench_rand(-16, 15);
+    }
+    nn_bench_fill_q15(in_q15, len, 32);
+
+    arm_softmax_q7_ref(in_q7, len, ref_q7);
+    memset(opt_q7, 37, len);
+    arm_softmax_q7(in_q7, len, opt_q7);
+    match = nn_bench_cmp_q7(ref_q7, opt_q7, len, 0);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, NN_BENCH_NOTHING, arm_softmax_q7(in_q7, len, opt_q7));
+    }
+    nn_bench_run("arm_softmax_q7", str, len, t, match);
+
+    arm_softmax_q15_ref(in_q15, len, ref_q15);
+    arm_fill_q15(0x5F5, opt_q15, len);
+    arm_softmax_q15(in_q15, len, opt_q15);
+    match = nn_bench_cmp_q15(ref_q15, opt_q15, len);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, NN_BENCH_NOTHING, arm_softmax_q15(in_q15, len, opt_q15));
+    }
+    nn_bench_run("arm_softmax_q15", str, len, t, match);
+
+    /* relu works in place */
+    nn_bench_fill_q7(in_q7, len);
+    nn_bench_fill_q15(in_q15, len, 32768);
+    memcpy(ref_q7, in_q7, len);
+    memcpy(opt_q7, in_q7, len);
+    arm_relu_q7_ref(ref_q7, len);
+    arm_relu_q7(opt_q7, len);
+    match = nn_bench_cmp_q7(ref_q7, opt_q7, len, 0);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, memcpy(opt_q7, in_q7, len), arm_relu_q7(opt_q7, len));
+    }
+    nn_bench_run("arm_relu_q7", str, len, t, match);
+
+    memcpy(ref_q15, in_q15, len * sizeof(q15_t));
+    memcpy(opt_q15, in_q15, len * sizeof(q15_t));
+    arm_relu_q15_ref(ref_q15, len);
+    arm_relu_q15(opt_q15, len);
+    match = nn_bench_cmp_q15(ref_q15, opt_q15, len);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, memcpy(opt_q15, in_q15, len * sizeof(q15_t)), arm_relu_q15(opt_q15, len));
+    }
+    nn_bench_run("arm_relu_q15", str, len, t, match);
+
+    free(in_q7);
+    free(ref_q7);
+    free(opt_q7);
+    free(in_q15);
+    free(ref_q15);
+    free(opt_q15);
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Recurrent Cells */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Sigmoid and tanh of every q15 input against libm, for each int_width.
+ *  The tables step by 1/16 and are interpolated, a few LSB of error is
+ *  expected. Counts one MAC per element.
+ */
+static void nn_bench_acti(void)
+{
+    static const char * const name[2] = { "sigmoid", "tanh" };
+    q15_t * in = nn_bench_alloc(65536 * sizeof(q15_t));
+    q15_t * out = nn_bench_alloc(65536 * sizeof(q15_t));
+    char str[NN_BENCH_SHAPE_STR];
+    int type;
+    int width;
+    int worst;
+    int i;
+    double t;
+
+    for (i = 0; i < 65536; i++)
+    {
+        in[i] = (q15_t) (i - 32768);
+    }
+    for (type = 0; type < 2; type++)
+    {
+        for (width = 0; width <= 3; width++)
+        {
+            memcpy(out, in, 65536 * sizeof(q15_t));
+            arm_nn_activations_direct_q15(out, 32768, width, type ? ARM_TANH : ARM_SIGMOID);
+            arm_nn_activations_direct_q15(out + 32768, 32768, width, type ? ARM_TANH : ARM_SIGMOID);
+            worst = 0;
+            for (i = 0; i < 65536; i++)
+            {
+                double x = ldexp(in[i], width - 15);
+                double y = type ? tanh(x) : 1.0 / (1.0 + exp(-x));
+                int err = abs(out[i] - (int) lround(ldexp(y, 15) > 32767 ? 32767 : ldexp(y, 15)));
+
+                if (err > worst)
+                {
+                    worst = err;
+                }
+            }
+            snprintf(str, sizeof(str), "%s int_width %d, max error %d", name[type], width, worst);
+            t = 0;
+            if (worst <= 16)
+            {
+                NN_BENCH_TIME(t, memcpy(out, in, 256 * sizeof(q15_t)),
+                              arm_nn_activations_direct_q15(out, 256, width, type ? ARM_TANH : ARM_SIGMOID));
+                t /= 256;
+            }
+            nn_bench_run("arm_nn_activations_direct_q15", str, 1, t, worst <= 16);
+        }
+    }
+
+    free(in);
+    free(out);
+}
+
+/**
+ *  GRU and LSTM steps, plain and _opt with reordered weights, against the
+ *  per-gate references over NN_BENCH_RNN_STEPS steps of random input. The
+ *  states are compared after every step, then one step is timed.
+ */
+static void nn_bench_rnn(const NN_BENCH_SHAPE_t * sh, int int_width, int cell_int_width)
+{
+    int in = sh->ch_in;
+    int hid = sh->ch_out;
+    int cols = in + hid;
+    uint64_t gru_macs = 3ull * hid * cols;
+    uint64_t lstm_macs = 4ull * hid * cols;
+    q15_t * x = nn_bench_alloc(NN_BENCH_RNN_STEPS * in * sizeof(q15_t));
+    q7_t * wt = nn_bench_alloc(4 * hid * cols);
+    q7_t * wt_opt = nn_bench_alloc(4 * hid * cols);
+    q7_t * wt_hidden = nn_bench_alloc(hid * cols);
+    q7_t * wt_hidden_opt = nn_bench_alloc(hid * cols);
+    q7_t * bias = nn_bench_alloc(4 * hid);
+    q15_t * buf_ref = nn_bench_alloc((6 * hid + in) * sizeof(q15_t));
+    q15_t * buf = nn_bench_alloc((6 * hid + in) * sizeof(q15_t));
+    char str[NN_BENCH_SHAPE_STR];
+    double t;
+    int match;
+    int opt;
+    int step;
+
+    nn_bench_fill_q15(x, NN_BENCH_RNN_STEPS * in, 16384);
+    nn_bench_fill_q7(wt, 4 * hid * cols);
+    nn_bench_fill_q7(wt_hidden, hid * cols);
+    nn_bench_fill_q7(bias, 4 * hid);
+    snprintf(str, sizeof(str), "in %d hidden %d int %d,%d shift %d", in, hid, int_width, cell_int_width,
+             sh->out_shift);
+
+    /* GRU, state at buf + hid + in */
+    nn_bench_reorder_q7_q15_opt(wt, wt_opt, cols, 2 * hid);
+    nn_bench_reorder_q7_q15_opt(wt_hidden, wt_hidden_opt, cols, hid);
+    for (opt = 0; opt < 2; opt++)
+    {
+        memset(buf_ref, 0, (4 * hid + in) * sizeof(q15_t));
+        memset(buf, 0, (4 * hid + in) * sizeof(q15_t));
+        match = 1;
+        for (step = 0; step < NN_BENCH_RNN_STEPS && match; step++)
+        {
+            arm_gru_step_q7_q15_ref(x + step * in, in, hid, wt, bias, wt_hidden, bias + 2 * hid,
+                                    sh->bias_shift, sh->out_shift, int_width, buf_ref);
+            if (opt)
+            {
+                arm_gru_step_q7_q15_opt(x + step * in, in, hid, wt_opt, bias, wt_hidden_opt, bias + 2 * hid,
+                                        sh->bias_shift, sh->out_shift, int_width, buf);
+            } else
+            {
+                arm_gru_step_q7_q15(x + step * in, in, hid, wt, bias, wt_hidden, bias + 2 * hid,
+                                    sh->bias_shift, sh->out_shift, int_width, buf);
+            }
+            match = nn_bench_cmp_q15(buf_ref + hid + in, buf + hid + in, hid);
+        }
+        t = 0;
+        if (match && opt)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          arm_gru_step_q7_q15_opt(x, in, hid, wt_opt, bias, wt_hidden_opt, bias + 2 * hid,
+                                                  sh->bias_shift, sh->out_shift, int_width, buf));
+        } else if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          arm_gru_step_q7_q15(x, in, hid, wt, bias, wt_hidden, bias + 2 * hid,
+                                              sh->bias_shift, sh->out_shift, int_width, buf));
+        }
+        nn_bench_run(opt ? "arm_gru_step_q7_q15_opt" : "arm_gru_step_q7_q15", str, gru_macs, t, match);
+    }
+
+    /* LSTM, h and c at buf + in */
+    nn_bench_reorder_q7_q15_opt(wt, wt_opt, cols, 4 * hid);
+    for (opt = 0; opt < 2; opt++)
+    {
+        memset(buf_ref, 0, (6 * hid + in) * sizeof(q15_t));
+        memset(buf, 0, (6 * hid + in) * sizeof(q15_t));
+        match = 1;
+        for (step = 0; step < NN_BENCH_RNN_STEPS && match; step++)
+        {
+            arm_lstm_step_q7_q15_ref(x + step * in, in, hid, wt, bias, sh->bias_shift, sh->out_shift,
+                                     int_width, cell_int_width, buf_ref);
+            if (opt)
+            {
+                arm_lstm_step_q7_q15_opt(x + step * in, in, hid, wt_opt, bias, sh->bias_shift, sh->out_shift,
+                                         int_width, cell_int_width, buf);
+            } else
+            {
+                arm_lstm_step_q7_q15(x + step * in, in, hid, wt, bias, sh->bias_shift, sh->out_shift,
+                                     int_width, cell_int_width, buf);
+            }
+            match = nn_bench_cmp_q15(buf_ref + in, buf + in, 2 * hid);
+        }
+        t = 0;
+        if (match && opt)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          arm_lstm_step_q7_q15_opt(x, in, hid, wt_opt, bias, sh->bias_shift, sh->out_shift,
+                                                   int_width, cell_int_width, buf));
+        } else if (match)
+        {
+            NN_BENCH_TIME(t, NN_BENCH_NOTHING,
+                          arm_lstm_step_q7_q15(x, in, hid, wt, bias, sh->bias_shift, sh->out_shift,
+                                               int_width, cell_int_width, buf));
+        }
+        nn_bench_run(opt ? "arm_lstm_step_q7_q15_opt" : "arm_lstm_step_q7_q15", str, lstm_macs, t, match);
+    }
+
+    free(x);
+    free(wt);
+    free(wt_opt);
+    free(wt_hidden);
+    free(wt_hidden_opt);
+    free(bias);
+    free(buf_ref);
+    free(buf);
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Arena */
+/*--------------------------------------------------------------------------------*/
+
+/**
+ *  Layer i of gesture_imu_graph.json, with the buffers at p. Returns the
+ *  buffer the layer wrote.
+ */
+static NN_ARENA_BUF_t nn_bench_arena_layer(int i, q7_t * const * p, const NN_BENCH_ARENA_NET_t * w)
+{
+    switch (i)
+    {
+    case 0:
+        arm_convolve_1D_causal_q7(p[NN_ARENA_IMU], 64, 6, w->wt[0], 16, 5, 1, w->bias[0], w->bias_shift[0],
+                                  w->out_shift[0], p[NN_ARENA_TC1], (q15_t *) p[NN_ARENA_TC1_BUF], NULL);
+        return NN_ARENA_TC1;
+    case 1:
+        arm_relu_q7(p[NN_ARENA_TC1], 64 * 16);
+        return NN_ARENA_TC1;
+    case 2:
+        arm_convolve_1D_causal_q7(p[NN_ARENA_TC1], 64, 16, w->wt[1], 32, 3, 2, w->bias[1], w->bias_shift[1],
+                                  w->out_shift[1], p[NN_ARENA_TC2], (q15_t *) p[NN_ARENA_TC2_BUF], NULL);
+        return NN_ARENA_TC2;
+    case 3:
+        arm_relu_q7(p[NN_ARENA_TC2], 64 * 32);
+        return NN_ARENA_TC2;
+    case 4:
+        arm_convolve_1D_causal_q7(p[NN_ARENA_TC2], 64, 32, w->wt[2], 32, 3, 4, w->bias[2], w->bias_shift[2],
+                                  w->out_shift[2], p[NN_ARENA_TC3], (q15_t *) p[NN_ARENA_TC3_BUF], NULL);
+        return NN_ARENA_TC3;
+    case 5:
+        arm_relu_q7(p[NN_ARENA_TC3], 64 * 32);
+        return NN_ARENA_TC3;
+    case 6:
+        arm_convolve_HWC_q7_fast_nonsquare(p[NN_ARENA_TC3], 64, 1, 32, w->wt[3], 32, 4, 1, 0, 0, 4, 1, w->bias[3],
+                                           w->bias_shift[3], w->out_shift[3], p[NN_ARENA_DOWN], 16, 1,
+                                           (q15_t *) p[NN_ARENA_DOWN_BUF], NULL);
+        return NN_ARENA_DOWN;
+    case 7:
+        arm_relu_q7(p[NN_ARENA_DOWN], 16 * 32);
+        return NN_ARENA_DOWN;
+    case 8:
+        arm_fully_connected_q7(p[NN_ARENA_DOWN], w->wt[4], 16 * 32, 64, w->bias_shift[4], w->out_shift[4],
+                               w->bias[4], p[NN_ARENA_FC1], (q15_t *) p[NN_ARENA_FC1_BUF]);
+        return NN_ARENA_FC1;
+    case 9:
+        arm_relu_q7(p[NN_ARENA_FC1], 64);
+        return NN_ARENA_FC1;
+    case 10:
+        arm_fully_connected_q7(p[NN_ARENA_FC1], w->wt[5], 64, 8, w->bias_shift[5], w->out_shift[5],
+                               w->bias[5], p[NN_ARENA_FC2], (q15_t *) p[NN_ARENA_FC2_BUF]);
+        return NN_ARENA_FC2;
+    default:
+        arm_softmax_q7(p[NN_ARENA_FC2], 8, p[NN_ARENA_FC2]);
+        return NN_ARENA_FC2;
+    }
+}
+
+static void nn_bench_arena_run(q7_t * const * p, const NN_BENCH_ARENA_NET_t * w)
+{
+    int i;
+
+    for (i = 0; i < 12; i++)
+    {
+        nn_bench_arena_layer(i, p, w);
+    }
+}
+
+/**
+ *  gesture_imu from one array per buffer and from the arena of
+ *  gesture_imu_arena.h, which the Makefile plans with nn_arena.py, layer
+ *  by layer in step. The output of every layer must match, so a plan that
+ *  places a buffer over one still to be read fails at the reader.
+ *  NN_BENCH_SHAPES random weight sets and windows, then one inference
+ *  from the arena is timed.
+ */
+static void nn_bench_arena(void)
+{
+    NN_BENCH_ARENA_NET_t w;
+    q7_t * arena = nn_bench_alloc(GESTURE_IMU_ARENA_SIZE);
+    q7_t * sep[NN_ARENA_NUM];
+    q7_t * in_arena[NN_ARENA_NUM];
+    char str[NN_BENCH_SHAPE_STR];
+    uint64_t macs = 64 * 16 * 30 + 64 * 32 * 48 + 64 * 32 * 96 + 16 * 32 * 128 + 64 * 512 + 8 * 64;
+    int separate = 0;
+    int match = 1;
+    int set;
+    int i;
+    NN_ARENA_BUF_t b;
+    double t;
+
+    for (b = 0; b < NN_ARENA_NUM; b++)
+    {
+        sep[b] = nn_bench_alloc(nn_bench_arena_buf[b].size);
+        in_arena[b] = arena + nn_bench_arena_buf[b].offset;
+        separate += (nn_bench_arena_buf[b].size + 3) & ~3;
+    }
+    for (i = 0; i < 6; i++)
+    {
+        w.wt[i] = nn_bench_alloc(nn_bench_arena_wt[i]);
+        w.bias[i] = nn_bench_alloc(nn_bench_arena_bias[i]);
+    }
+
+    for (set = 0; set < nn_bench.shapes; set++)
+    {
+        for (i = 0; i < 6; i++)
+        {
+            nn_bench_fill_q7(w.wt[i], nn_bench_arena_wt[i]);
+            nn_bench_fill_q7(w.bias[i], nn_bench_arena_bias[i]);
+            w.bias_shift[i] = nn_bench_rand(0, 3);
+            w.out_shift[i] = nn_bench_rand(7, 10);
+        }
+        nn_bench_fill_q7(sep[NN_ARENA_IMU], nn_bench_arena_buf[NN_ARENA_IMU].size);
+        memcpy(in_arena[NN_ARENA_IMU], sep[NN_ARENA_IMU], nn_bench_arena_buf[NN_ARENA_IMU].size);
+        for (i = 0; i < 12; i++)
+        {
+            b = nn_bench_arena_layer(i, sep, &w);
+            nn_bench_arena_layer(i, in_arena, &w);
+            if (memcmp(sep[b], in_arena[b], nn_bench_arena_buf[b].size) != 0)
+            {
+                match = 0;
+            }
+        }
+    }
+
+    snprintf(str, sizeof(str), "%d weight sets, arena %d B, arrays %d B", nn_bench.shapes,
+             GESTURE_IMU_ARENA_SIZE, separate);
+    t = 0;
+    if (match)
+    {
+        NN_BENCH_TIME(t, NN_BENCH_NOTHING, nn_bench_arena_run(in_arena, &w));
+    }
+    nn_bench_run("gesture_imu_arena.h", str, macs, t, match);
+
+    for (b = 0; b < NN_ARENA_NUM; b++)
+    {
+        free(sep[b]);
+    }
+    for (i = 0; i < 6; i++)
+    {
+        free(w.wt[i]);
+        free(w.bias[i]);
+    }
+    free(arena);
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Report */
+/*--------------------------------------------------------------------------------*/
+
+static void nn_bench_json(const char * path)
+{
+    FILE * f = fopen(path, "w");
+    int i;
+
+    if (f == NULL)
+    {
+        fprintf(stderr, "nn_bench: cannot write %s\n", path);
+        return;
+    }
+    fprintf(f, "{\n \"platform\": \"host\",\n \"seed\": %u,\n \"runs\": [", nn_bench.seed);
+    for (i = 0; i < nn_bench.run_num; i++)
+    {
+        const NN_BENCH_RUN_t * r = &nn_bench.runs[i];
+
+        fprintf(f, "%s\n  {\"kernel\": \"%s\", \"shape\": \"%s\", \"macs\": %llu, \"ns\": %.1f, "
+                "\"mac_per_s\": %.0f, \"match\": %s}", i ? "," : "", r->kernel, r->shape,
+                (unsigned long long) r->macs, r->ns, r->ns > 0 ? r->macs * 1e9 / r->ns : 0.0,
+                r->match ? "true" : "false");
+    }
+    fprintf(f, "\n ],\n \"passed\": %d,\n \"failed\": %d\n}\n", nn_bench.run_num - nn_bench.failed,
+            nn_bench.failed);
+    fclose(f);
+}
+
+/*--------------------------------------------------------------------------------*/
+/* Main */
+/*--------------------------------------------------------------------------------*/
+
+int main(void)
+{
+    static const int conv_ch[] = { 1, 2, 3, 4, 6, 8, 12, 16, 24, 32 };
+    static const int conv_q15_ch[] = { 1, 2, 3, 4, 8, 16 };
+    const char * json = getenv("NN_BENCH_JSON");
+    const char * env;
+    NN_BENCH_SHAPE_t sh;
+    unsigned i;
+    int n;
+
+    env = getenv("NN_BENCH_SEED");
+    nn_bench.seed = env ? (unsigned) strtoul(env, NULL, 0) : 1;
+    env = getenv("NN_BENCH_SHAPES");
+    nn_bench.shapes = env ? atoi(env) : 16;
+    env = getenv("NN_BENCH_MS");
+    nn_bench.min_ns = (uint64_t) (env ? atoi(env) : 20) * 1000000u;
+    srand(nn_bench.seed);
+
+    printf("%-44s %-40s %-8s %15s %17s\n", "kernel", "shape", "result", "time/call", "rate");
+
+    for (i = 0; i < sizeof(nn_bench_conv_shapes) / sizeof(nn_bench_conv_shapes[0]); i++)
+    {
+        sh = nn_bench_conv_shapes[i];
+        nn_bench_conv_q7(&sh, 0);
+        sh.bias_shift = 0;
+        sh.out_shift = 15;
+        nn_bench_conv_q15(&sh);
+        sh = nn_bench_conv_shapes[i];
+        sh.ch_out = sh.ch_in;
+        nn_bench_conv_q7(&sh, 1);
+    }
+    for (n = 0; n < nn_bench.shapes; n++)
+    {
+        nn_bench_rand_conv(&sh, n & 1, 0, conv_ch, sizeof(conv_ch) / sizeof(conv_ch[0]), 0);
+        nn_bench_conv_q7(&sh, 0);
+        nn_bench_rand_conv(&sh, n & 1, 1, conv_ch, sizeof(conv_ch) / sizeof(conv_ch[0]), 0);
+        nn_bench_conv_q7(&sh, 1);
+        nn_bench_rand_conv(&sh, n & 1, 0, conv_q15_ch, sizeof(conv_q15_ch) / sizeof(conv_q15_ch[0]), 1);
+        nn_bench_conv_q15(&sh);
+    }
+
+    for (i = 0; i < sizeof(nn_bench_conv1d_shapes) / sizeof(nn_bench_conv1d_shapes[0]); i++)
+    {
+        sh = nn_bench_conv1d_shapes[i];
+        nn_bench_conv1d(&sh, 0);
+        sh.bias_shift = 0;
+        sh.out_shift = 15;
+        nn_bench_conv1d(&sh, 1);
+    }
+    for (n = 0; n < nn_bench.shapes; n++)
+    {
+        memset(&sh, 0, sizeof(sh));
+        sh.in_x = nn_bench_rand(1, 256);
+        sh.ch_in = nn_bench_pick(conv_ch, sizeof(conv_ch) / sizeof(conv_ch[0]));
+        sh.ch_out = nn_bench_pick(conv_ch, sizeof(conv_ch) / sizeof(conv_ch[0]));
+        sh.k_x = nn_bench_rand(1, 7);
+        sh.dilation = nn_bench_rand(1, 8);
+        sh.bias_shift = nn_bench_rand(0, 3);
+        sh.out_shift = nn_bench_rand(5, 9);
+        nn_bench_conv1d(&sh, 0);
+        sh.bias_shift = 0;
+        sh.out_shift = nn_bench_rand(10, 15);
+        nn_bench_conv1d(&sh, 1);
+    }
+
+    for (i = 0; i < sizeof(nn_bench_fc_shapes) / sizeof(nn_bench_fc_shapes[0]); i++)
+    {
+        nn_bench_fc(&nn_bench_fc_shapes[i]);
+    }
+    for (n = 0; n < nn_bench.shapes; n++)
+    {
+        memset(&sh, 0, sizeof(sh));
+        sh.ch_in = nn_bench_rand(1, 512);
+        sh.ch_out = nn_bench_rand(1, 128);
+        sh.bias_shift = nn_bench_rand(0, 3);
+        sh.out_shift = nn_bench_rand(5, 9);
+        nn_bench_fc(&sh);
+    }
+
+    for (i = 0; i < sizeof(nn_bench_pool_shapes) / sizeof(nn_bench_pool_shapes[0]); i++)
+    {
+        nn_bench_pool(&nn_bench_pool_shapes[i]);
+    }
+    for (n = 0; n < nn_bench.shapes; n++)
+    {
+        memset(&sh, 0, sizeof(sh));
+        sh.k_x = nn_bench_rand(2, 3);
+        sh.stride_x = nn_bench_rand(1, 2);
+        sh.in_x = nn_bench_rand(sh.k_x, 32);
+        sh.ch_in = nn_bench_pick(conv_ch, sizeof(conv_ch) / sizeof(conv_ch[0]));
+        sh.out_x = nn_bench_out_dim(sh.in_x, sh.k_x, 0, sh.stride_x);
+        nn_bench_pool(&sh);
+    }
+
+    for (i = 0; i < sizeof(nn_bench_vec_lens) / sizeof(nn_bench_vec_lens[0]); i++)
+    {
+        nn_bench_vec(nn_bench_vec_lens[i]);
+    }
+    for (n = 0; n < nn_bench.shapes; n++)
+    {
+        nn_bench_vec(nn_bench_rand(1, 256));
+    }
+
+    nn_bench_acti();
+    for (i = 0; i < sizeof(nn_bench_rnn_shapes) / sizeof(nn_bench_rnn_shapes[0]); i++)
+    {
+        nn_bench_rnn(&nn_bench_rnn_shapes[i], 3, 1);
+    }
+    for (n = 0; n < nn_bench.shapes; n++)
+    {
+        memset(&sh, 0, sizeof(sh));
+        sh.ch_in = nn_bench_rand(1, 64);
+        sh.ch_out = nn_bench_rand(1, 128);
+        sh.bias_shift = nn_bench_rand(0, 3);
+        sh.out_shift = nn_bench_rand(10, 14);
+        nn_bench_rnn(&sh, nn_bench_rand(0, 3), nn_bench_rand(0, 3));
+    }
+
+    nn_bench_arena();
+
+    nn_bench_json(json ? json : "nn_bench.json");
+    printf("runs %d, matched %d, mismatched %d\n", nn_bench.run_num,
+           nn_bench.run_num - nn_bench.failed, nn_bench.failed);
+    free(nn_bench.runs);
+
+    return nn_bench.failed ? 1 : 0;
+}
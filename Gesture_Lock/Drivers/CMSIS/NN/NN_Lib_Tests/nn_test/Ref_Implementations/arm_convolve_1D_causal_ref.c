@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2010-2018 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ref_functions.h"
+
+void arm_convolve_1D_causal_q7_ref(const q7_t * Im_in,    // input sequence
+                                   const uint16_t dim_im_in,    // input length, also the output length
+                                   const uint16_t ch_im_in, // number of input channels
+                                   const q7_t * wt, // kernel weights
+                                   const uint16_t ch_im_out,    // number of filters, i.e., output channels
+                                   const uint16_t dim_kernel,   // filter kernel size
+                                   const uint16_t dilation, // distance between kernel taps
+                                   const q7_t * bias,   // bias
+                                   const uint16_t bias_shift,   // amount of left-shift for bias
+                                   const uint16_t out_shift,    // amount of right-shift for output
+                                   q7_t * Im_out    // output sequence
+    )
+{
+    int       i, t, k, l;
+    int       conv_out;
+    int       in_t;
+
+    for (i = 0; i < ch_im_out; i++)
+    {
+        for (t = 0; t < dim_im_in; t++)
+        {
+#ifndef ARM_NN_TRUNCATE
+            conv_out = ((q31_t) (bias[i]) << bias_shift) + (0x1 << (out_shift - 1));
+#else
+            conv_out = bias[i] << bias_shift;
+#endif
+            for (k = 0; k < dim_kernel; k++)
+            {
+                // taps before the start of the sequence are zero
+                in_t = t - (dim_kernel - 1 - k) * dilation;
+                if (in_t >= 0)
+                {
+                    for (l = 0; l < ch_im_in; l++)
+                    {
+                        conv_out += Im_in[in_t * ch_im_in + l] * wt[(i * dim_kernel + k) * ch_im_in + l];
+                    }
+                }
+            }
+            Im_out[i + t * ch_im_out] = (q7_t) __SSAT((conv_out >> out_shift), 8);
+        }
+    }
+}
+
+void arm_convolve_1D_causal_q15_ref(const q15_t * Im_in,  // input sequence
+                                    const uint16_t dim_im_in,   // input length, also the output length
+                                    const uint16_t ch_im_in,    // number of input channels
+                                    const q15_t * wt,   // kernel weights
+                                    const uint16_t ch_im_out,   // number of filters, i.e., output channels
+                                    const uint16_t dim_kernel,  // filter kernel size
+                                    const uint16_t dilation,    // distance between kernel taps
+                                    const q15_t * bias, // bias
+                                    const uint16_t bias_shift,  // amount of left-shift for bias
+                                    const uint16_t out_shift,   // amount of right-shift for output
+                                    q15_t * Im_out  // output sequence
+    )
+{
+    int       i, t, k, l;
+    int       conv_out;
+    int       in_t;
+
+    for (i = 0; i < ch_im_out; i++)
+    {
+        for (t = 0; t < dim_im_in; t++)
+        {
+#ifndef ARM_NN_TRUNCATE
+            conv_out = ((q31_t) (bias[i]) << bias_shift) + (0x1 << (out_shift - 1));
+#else
+            conv_out = bias[i] << bias_shift;
+#endif
+            for (k = 0; k < dim_kernel; k++)
+            {
+                // taps before the start of the sequence are zero
+                in_t = t - (dim_kernel - 1 - k) * dilation;
+                if (in_t >= 0)
+                {
+                    for (l = 0; l < ch_im_in; l++)
+                    {
+                        conv_out += Im_in[in_t * ch_im_in + l] * wt[(i * dim_kernel + k) * ch_im_in + l];
+                    }
+                }
+            }
+            Im_out[i + t * ch_im_out] = (q15_t) __SSAT((conv_out >> out_shift), 16);
+        }
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2010-2018 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ref_functions.h"
+
+/*
+ * One matrix product per gate through arm_fully_connected_mat_q7_vec_q15_ref
+ * and the element-wise updates written out, on the same buffer layout as
+ * arm_gru_step_q7_q15/arm_lstm_step_q7_q15 so the states can be compared.
+ * The activations are the library table look-ups.
+ */
+
+arm_status arm_gru_step_q7_q15_ref(const q15_t * input,
+                                   const uint16_t dim_input,
+                                   const uint16_t dim_hidden,
+                                   const q7_t * wt_gates,
+                                   const q7_t * bias_gates,
+                                   const q7_t * wt_hidden,
+                                   const q7_t * bias_hidden,
+                                   const uint16_t bias_shift,
+                                   const uint16_t out_shift,
+                                   const uint16_t int_width,
+                                   q15_t * buffer)
+{
+    const int cols = dim_input + dim_hidden;
+    q15_t    *rh = buffer;
+    q15_t    *x = buffer + dim_hidden;
+    q15_t    *h = x + dim_input;
+    q15_t    *z = h + dim_hidden;
+    q15_t    *r = z + dim_hidden;
+    q15_t    *n = r;
+    int       i;
+
+    if (int_width > 3)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    for (i = 0; i < dim_input; i++)
+    {
+        x[i] = input[i];
+    }
+
+    arm_fully_connected_mat_q7_vec_q15_ref(x, wt_gates, cols, dim_hidden, bias_shift, out_shift, bias_gates, z, NULL);
+    arm_fully_connected_mat_q7_vec_q15_ref(x, wt_gates + dim_hidden * cols, cols, dim_hidden, bias_shift, out_shift,
+                                           bias_gates + dim_hidden, r, NULL);
+    arm_nn_activations_direct_q15(z, dim_hidden, int_width, ARM_SIGMOID);
+    arm_nn_activations_direct_q15(r, dim_hidden, int_width, ARM_SIGMOID);
+
+    for (i = 0; i < dim_hidden; i++)
+    {
+        rh[i] = (q15_t) (((int) r[i] * h[i]) >> 15);
+    }
+
+    arm_fully_connected_mat_q7_vec_q15_ref(rh, wt_hidden, cols, dim_hidden, bias_shift, out_shift, bias_hidden, n,
+                                           NULL);
+    arm_nn_activations_direct_q15(n, dim_hidden, int_width, ARM_TANH);
+
+    for (i = 0; i < dim_hidden; i++)
+    {
+        int       v = h[i] + (((int) z[i] * (n[i] - h[i])) >> 15);
+
+        h[i] = (q15_t) (v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+
+    return ARM_MATH_SUCCESS;
+}
+
+arm_status arm_lstm_step_q7_q15_ref(const q15_t * input,
+                                    const uint16_t dim_input,
+                                    const uint16_t dim_hidden,
+                                    const q7_t * wt,
+                                    const q7_t * bias,
+                                    const uint16_t bias_shift,
+                                    const uint16_t out_shift,
+                                    const uint16_t int_width,
+                                    const uint16_t cell_int_width,
+                                    q15_t * buffer)
+{
+    const int cols = dim_input + dim_hidden;
+    q15_t    *x = buffer;
+    q15_t    *h = x + dim_input;
+    q15_t    *c = h + dim_hidden;
+    q15_t    *gate[4];
+    int       g, i;
+
+    if (int_width > 3 || cell_int_width > 3)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    for (i = 0; i < dim_input; i++)
+    {
+        x[i] = input[i];
+    }
+
+    /* i, f, g, o */
+    for (g = 0; g < 4; g++)
+    {
+        gate[g] = c + (g + 1) * dim_hidden;
+        arm_fully_connected_mat_q7_vec_q15_ref(x, wt + g * dim_hidden * cols, cols, dim_hidden, bias_shift,
+                                               out_shift, bias + g * dim_hidden, gate[g], NULL);
+        arm_nn_activations_direct_q15(gate[g], dim_hidden, int_width, g == 2 ? ARM_TANH : ARM_SIGMOID);
+    }
+
+    for (i = 0; i < dim_hidden; i++)
+    {
+        int       v = (((int) gate[1][i] * c[i]) >> 15) + (((int) gate[0][i] * gate[2][i]) >> (15 + cell_int_width));
+
+        c[i] = (q15_t) (v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+        gate[2][i] = c[i];
+    }
+
+    arm_nn_activations_direct_q15(gate[2], dim_hidden, cell_int_width, ARM_TANH);
+    for (i = 0; i < dim_hidden; i++)
+    {
+        h[i] = (q15_t) (((int) gate[3][i] * gate[2][i]) >> 15);
+    }
+
+    return ARM_MATH_SUCCESS;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2010-2018 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ref_functions.h"
+
+/*
+ * Same base-2 approximation as arm_softmax_q7/q15, written out without
+ * the saturation intrinsics.
+ */
+
+static int ref_clamp(int x, int lo, int hi)
+{
+    return x < lo ? lo : (x > hi ? hi : x);
+}
+
+void arm_softmax_q7_ref(const q7_t * vec_in, const uint16_t dim_vec, q7_t * p_out)
+{
+    int       i;
+    int       base = -257;
+    int       sum = 0;
+    int       output_base;
+
+    for (i = 0; i < dim_vec; i++)
+    {
+        if (vec_in[i] > base)
+            base = vec_in[i];
+    }
+    base = base - 8;
+
+    for (i = 0; i < dim_vec; i++)
+    {
+        if (vec_in[i] > base)
+            sum += 1 << ref_clamp(vec_in[i] - base, 0, 31);
+    }
+
+    output_base = 0x100000 / sum;
+
+    for (i = 0; i < dim_vec; i++)
+    {
+        if (vec_in[i] > base)
+            p_out[i] = (q7_t) ref_clamp(output_base >> ref_clamp(13 + base - vec_in[i], 0, 31), -128, 127);
+        else
+            p_out[i] = 0;
+    }
+}
+
+void arm_softmax_q15_ref(const q15_t * vec_in, const uint16_t dim_vec, q15_t * p_out)
+{
+    int       i;
+    int       base = -0x100000;
+    int       sum = 0;
+    int       output_base;
+
+    for (i = 0; i < dim_vec; i++)
+    {
+        if (vec_in[i] > base)
+            base = vec_in[i];
+    }
+    base = base - 16;
+
+    for (i = 0; i < dim_vec; i++)
+    {
+        if (vec_in[i] > base)
+            sum += 1 << ref_clamp(vec_in[i] - base, 0, 31);
+    }
+
+    output_base = (int)(0x100000000LL / sum);
+
+    for (i = 0; i < dim_vec; i++)
+    {
+        if (vec_in[i] > base)
+            p_out[i] = (q15_t) ref_clamp(output_base >> ref_clamp(17 + base - vec_in[i], 0, 31), -32768, 32767);
+        else
+            p_out[i] = 0;
+    }
+}
@@ -143,6 +143,32 @@ extern    "C"
                                                                 q7_t * bufferB  //buffer space for output
         );
 
+    void      arm_convolve_1D_causal_q7_ref(const q7_t * Im_in, // input sequence
+                                            const uint16_t dim_im_in, // input length, also the output length
+                                            const uint16_t ch_im_in,  // number of input channels
+                                            const q7_t * wt, // kernel weights
+                                            const uint16_t ch_im_out, // number of filters, i.e., output channels
+                                            const uint16_t dim_kernel,    // filter kernel size
+                                            const uint16_t dilation,  // distance between kernel taps
+                                            const q7_t * bias,   // bias
+                                            const uint16_t bias_shift,    // amount of left-shift for bias
+                                            const uint16_t out_shift, // amount of right-shift for output
+                                            q7_t * Im_out  // output sequence
+        );
+
+    void      arm_convolve_1D_causal_q15_ref(const q15_t * Im_in, // input sequence
+                                             const uint16_t dim_im_in, // input length, also the output length
+                                             const uint16_t ch_im_in,  // number of input channels
+                                             const q15_t * wt, // kernel weights
+                                             const uint16_t ch_im_out, // number of filters, i.e., output channels
+                                             const uint16_t dim_kernel,    // filter kernel size
+                                             const uint16_t dilation,  // distance between kernel taps
+                                             const q15_t * bias,   // bias
+                                             const uint16_t bias_shift,    // amount of left-shift for bias
+                                             const uint16_t out_shift, // amount of right-shift for output
+                                             q15_t * Im_out  // output sequence
+        );
+
 /*
  *
  * Fully-connected reference implemenation
@@ -243,6 +269,45 @@ extern    "C"
 
     void      arm_nn_mult_q15_ref(q15_t * pSrcA, q15_t * pSrcB, q15_t * pDst, const uint16_t out_shift, uint32_t blockSize);
 
+/*
+ *
+ * Softmax reference implemenation
+ *
+ */
+
+    void      arm_softmax_q7_ref(const q7_t * vec_in, const uint16_t dim_vec, q7_t * p_out);
+
+    void      arm_softmax_q15_ref(const q15_t * vec_in, const uint16_t dim_vec, q15_t * p_out);
+
+/*
+ *
+ * Recurrent cell reference implemenation
+ *
+ */
+
+    arm_status arm_gru_step_q7_q15_ref(const q15_t * input,    // input sample
+                                       const uint16_t dim_input,   // input sample length
+                                       const uint16_t dim_hidden,  // hidden state length
+                                       const q7_t * wt_gates,  // update and reset gate weights
+                                       const q7_t * bias_gates,    // update and reset gate bias
+                                       const q7_t * wt_hidden, // candidate state weights
+                                       const q7_t * bias_hidden,   // candidate state bias
+                                       const uint16_t bias_shift,  // amount of left-shift for bias
+                                       const uint16_t out_shift,   // amount of right-shift for gate inputs
+                                       const uint16_t int_width,   // integer bits of gate inputs
+                                       q15_t * buffer);    // state and buffer space
+
+    arm_status arm_lstm_step_q7_q15_ref(const q15_t * input,   // input sample
+                                        const uint16_t dim_input,  // input sample length
+                                        const uint16_t dim_hidden, // hidden and cell state length
+                                        const q7_t * wt,   // gate weights
+                                        const q7_t * bias, // gate bias
+                                        const uint16_t bias_shift, // amount of left-shift for bias
+                                        const uint16_t out_shift,  // amount of right-shift for gate inputs
+                                        const uint16_t int_width,  // integer bits of gate inputs
+                                        const uint16_t cell_int_width, // integer bits of cell state
+                                        q15_t * buffer);   // state and buffer space
+
 #ifdef __cplusplus
 }
 #endif
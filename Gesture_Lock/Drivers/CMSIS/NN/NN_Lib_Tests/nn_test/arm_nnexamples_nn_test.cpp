@@ -797,5 +797,5 @@ int main()
         printf("Test failed passed\n");
     }
 
-    return 0;
+    return test_pass ? 0 : 1;
 }
@@ -0,0 +1,329 @@
+#!/usr/bin/env python3
+"""Plan one static arena for the activations and kernel buffers of a network.
+
+  nn_arena.py GRAPH.json [-o ARENA.h] [--align N]
+      Read the layer graph, work out the layers each buffer is live for,
+      pack the buffers into one arena so that buffers of disjoint lifetimes
+      share space, print the plan and write a C header of byte offsets.
+
+The CMSIS-NN kernels take every input, output and scratch buffer from the
+caller. Declaring one static array per layer, as the examples do, costs the
+sum of all of them; the arena costs the most that is live at once, plus
+what packing loses. The graph is a JSON file:
+
+  {
+    "name": "cifar10",
+    "baseline": {"bytes": 44170, "note": "what the hand-written code uses"},
+    "inputs": [{"name": "data", "type": "q7", "shape": [32, 32, 3]}],
+    "layers": [
+      {"name": "conv1", "op": "conv_q7", "in": "data", "out": "conv1",
+       "ch_out": 32, "k": 5, "pad": 2, "stride": 1, "kernel": "rgb"},
+      {"name": "relu1", "op": "relu_q7", "in": "conv1"},
+      ...
+    ],
+    "outputs": ["ip1"]
+  }
+
+Shapes are [x, y, ch] (HWC, y is 1 for 1-D) or [n] for vectors. k, pad
+and stride take a number or [x, y]. out_dim, a number or [x, y], sets
+the output size of a window op where it is not the usual
+(in + 2 * pad - k) / stride + 1, as the pools of the examples that clip
+the last window at the edge. Ops that work in place leave out
+"out"; their result is the input buffer. Each op's scratch size follows
+the "Buffer size" notes in arm_nnfunctions.h. Inputs are live from the
+start, outputs to the end, so the caller can fill and read them around a
+run. Every buffer starts on an --align boundary, 4 by default for the
+word loads of the kernels.
+
+Graphs: Examples/ARM/arm_nn_examples/cifar10/arm_nnexamples_cifar10_graph.json
+(arm_nnexamples_cifar10_arena.h is generated from it) and
+gesture_imu_graph.json, the IMU classifier of the nn_bench shapes.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+ELEM = {"q7": 1, "q15": 2}
+
+
+# ----------------------------------------------------------------------------
+# Ops: output type and shape, scratch bytes, how they use their input
+# ----------------------------------------------------------------------------
+
+def pair(v):
+    return (v, v) if isinstance(v, int) else (v[0], v[1])
+
+
+def numel(shape):
+    n = 1
+    for d in shape:
+        n *= d
+    return n
+
+
+def conv_shape(layer, shape, ch_out):
+    kx, ky = pair(layer["k"])
+    px, py = pair(layer.get("pad", 0))
+    sx, sy = pair(layer.get("stride", 1))
+    x, y, _ = shape
+    if "out_dim" in layer:
+        ox, oy = pair(layer["out_dim"])
+        return [ox, oy, ch_out], kx * ky
+    return [(x + 2 * px - kx) // sx + 1, (y + 2 * py - ky) // sy + 1, ch_out], kx * ky
+
+
+def op_conv(layer, t, shape, q):
+    out, kk = conv_shape(layer, shape, layer["ch_out"])
+    # bufferA: two im2col columns of q15
+    slack = 1 if layer.get("kernel") == "rgb" else 0
+    return dict(type=q, shape=out, scratch=2 * 2 * shape[2] * kk, in_slack=slack)
+
+
+def op_depthwise(layer, t, shape, q):
+    out, kk = conv_shape(layer, shape, shape[2])
+    return dict(type=q, shape=out, scratch=2 * 2 * shape[2] * kk)
+
+
+def op_conv1d(layer, t, shape, q):
+    # bufferA: two columns of dim_kernel * ch_im_in q15
+    return dict(type=q, shape=[shape[0], 1, layer["ch_out"]], scratch=2 * 2 * shape[2] * layer["k"])
+
+
+def op_pool(layer, t, shape, q):
+    out, _ = conv_shape(layer, shape, shape[2])
+    # both pools run over x in the input first, average pooling sums a row
+    # of q15 in bufferA. Without padding an output row never lands on an
+    # input row still to be read and the rows are copied with memmove, so
+    # the output can start where the input does
+    scratch = 2 * out[0] * shape[2] if layer["op"].startswith("avepool") else 0
+    over = pair(layer.get("pad", 0)) == (0, 0)
+    return dict(type=q, shape=out, scratch=scratch, clobbers=True, over_input=over)
+
+
+def op_fc(layer, t, shape, q):
+    # vec_buffer: the q7 vector widened to q15, the other formats need none
+    scratch = 2 * numel(shape) if layer["op"] == "fc_q7" else 0
+    out_type = "q7" if layer["op"] == "fc_q7" else "q15"
+    return dict(type=out_type, shape=[layer["rows"]], scratch=scratch)
+
+
+def op_inplace(layer, t, shape, q):
+    return dict(type=t, shape=shape, scratch=0, inplace=True)
+
+
+OPS = {
+    "conv_q7": (op_conv, "q7"),
+    "conv_q15": (op_conv, "q15"),
+    "depthwise_q7": (op_depthwise, "q7"),
+    "conv1d_q7": (op_conv1d, "q7"),
+    "conv1d_q15": (op_conv1d, "q15"),
+    "maxpool_q7": (op_pool, "q7"),
+    "avepool_q7": (op_pool, "q7"),
+    "fc_q7": (op_fc, "q7"),
+    "fc_q15": (op_fc, "q15"),
+    "fc_mat_q7_vec_q15": (op_fc, "q15"),
+    "relu_q7": (op_inplace, "q7"),
+    "relu_q15": (op_inplace, "q15"),
+    "sigmoid_q7": (op_inplace, "q7"),
+    "sigmoid_q15": (op_inplace, "q15"),
+    "tanh_q7": (op_inplace, "q7"),
+    "tanh_q15": (op_inplace, "q15"),
+    "softmax_q7": (op_inplace, "q7"),
+    "softmax_q15": (op_inplace, "q15"),
+}
+
+
+# ----------------------------------------------------------------------------
+# Lifetimes
+# ----------------------------------------------------------------------------
+
+class Buffer:
+    def __init__(self, name, size, first, what, parent=None):
+        self.name = name
+        self.size = size
+        self.first = first
+        self.last = first
+        self.what = what
+        self.offset = None
+        # a tensor written over the start of another one shares its space
+        self.parent = parent
+
+    def overlaps(self, other):
+        return self.first <= other.last and other.first <= self.last
+
+
+def build(graph):
+    """Buffers with their first and last layer, in order of appearance.
+    A buffer with a parent is placed at the parent's offset."""
+    tensors = {}    # tensor name -> (buffer, type, shape)
+    buffers = []
+    last = len(graph["layers"]) - 1
+
+    for t in graph.get("inputs", []):
+        b = Buffer(t["name"], numel(t["shape"]) * ELEM[t["type"]], 0,
+                   "%s %s" % (t["type"], "x".join(map(str, t["shape"]))))
+        buffers.append(b)
+        tensors[t["name"]] = (b, t["type"], t["shape"])
+
+    for i, layer in enumerate(graph["layers"]):
+        op = layer["op"]
+        if op not in OPS:
+            sys.exit("%s: unknown op %s, one of %s" % (layer["name"], op, ", ".join(sorted(OPS))))
+        if layer["in"] not in tensors:
+            sys.exit("%s: input %s is not produced before it" % (layer["name"], layer["in"]))
+        src, t, shape = tensors[layer["in"]]
+        fn, q = OPS[op]
+        if t != q:
+            sys.exit("%s: %s takes %s, %s is %s" % (layer["name"], op, q, layer["in"], t))
+        info = fn(layer, t, shape, q)
+        src.last = max(src.last, i)
+        if src.parent is None:
+            src.size += info.get("in_slack", 0)
+
+        if info.get("clobbers"):
+            # the input is overwritten, nothing after this layer may read it
+            for later in graph["layers"][i + 1:]:
+                if later["in"] == layer["in"]:
+                    sys.exit("%s overwrites %s, which %s reads later" %
+                             (layer["name"], layer["in"], later["name"]))
+        if info.get("inplace"):
+            if layer.get("out", layer["in"]) != layer["in"]:
+                out = Buffer(layer["out"], src.size, i, "%s %s" % (t, "x".join(map(str, shape))))
+                buffers.append(out)
+                tensors[layer["out"]] = (out, t, shape)
+            continue
+
+        out = Buffer(layer["out"], numel(info["shape"]) * ELEM[info["type"]], i,
+                     "%s %s" % (info["type"], "x".join(map(str, info["shape"]))),
+                     root(src) if info.get("over_input") else None)
+        if out.parent is not None:
+            out.what += ", over " + out.parent.name
+        buffers.append(out)
+        tensors[layer["out"]] = (out, info["type"], info["shape"])
+        if info["scratch"]:
+            buffers.append(Buffer(layer["name"] + "_buf", info["scratch"], i,
+                                  "scratch of %s" % layer["name"]))
+
+    for name in graph.get("outputs", []):
+        tensors[name][0].last = last
+    return buffers
+
+
+def root(b):
+    while b.parent is not None:
+        b = b.parent
+    return b
+
+
+# ----------------------------------------------------------------------------
+# Packing
+# ----------------------------------------------------------------------------
+
+def round_up(n, align):
+    return (n + align - 1) // align * align
+
+
+def pack(buffers, align):
+    """Greedy by size: the largest group first, each at the lowest aligned
+    offset clear of the placed buffers it overlaps in time. A group is a
+    buffer and the buffers written over it, all at one offset. Returns the
+    arena size."""
+    groups = {}
+    for b in buffers:
+        groups.setdefault(root(b), []).append(b)
+    placed = []
+    for r, group in sorted(groups.items(), key=lambda g: (-max(b.size for b in g[1]), g[0].first)):
+        conflicts = [(p, b) for p in placed for b in group if p.overlaps(b)]
+        offset = 0
+        moved = True
+        while moved:
+            moved = False
+            for p, b in conflicts:
+                if offset < p.offset + p.size and p.offset < offset + b.size:
+                    offset = round_up(p.offset + p.size, align)
+                    moved = True
+        for b in group:
+            b.offset = offset
+        placed += group
+    return max((b.offset + b.size for b in buffers), default=0)
+
+
+def live_peak(buffers, layers, align):
+    """Most bytes live at one layer, what any packing needs at least. The
+    buffers of a group overlap, a group counts its largest live one."""
+    peak = 0
+    for i in range(layers):
+        live = {}
+        for b in buffers:
+            if b.first <= i <= b.last:
+                live[root(b)] = max(live.get(root(b), 0), round_up(b.size, align))
+        peak = max(peak, sum(live.values()))
+    return peak
+
+
+# ----------------------------------------------------------------------------
+# Output
+# ----------------------------------------------------------------------------
+
+def header(graph, buffers, size, src, align):
+    prefix = graph["name"].upper()
+    guard = "_%s_ARENA_H_" % prefix
+    width = max(len("%s_%s_OFFSET" % (prefix, b.name.upper())) for b in buffers) + 2
+    lines = [
+        "/* Generated by nn_arena.py from %s, do not edit." % src,
+        " *",
+        " * One arena of %s_ARENA_SIZE bytes holds the activations and kernel" % prefix,
+        " * buffers of %s. Offsets are in bytes from the start of the arena," % graph["name"],
+        " * which must be %d-byte aligned. Buffers not live at the same layer" % align,
+        " * share space, so a buffer is only valid between its first and last layer.",
+        " */",
+        "",
+        "#ifndef %s" % guard,
+        "#define %s" % guard,
+        "",
+        "#define %-*s %d" % (width, prefix + "_ARENA_SIZE", size),
+        "",
+    ]
+    for b in buffers:
+        lines.append("#define %-*s %-6d /* %5d bytes, layers %d..%d, %s */" %
+                     (width, "%s_%s_OFFSET" % (prefix, b.name.upper()), b.offset, b.size,
+                      b.first, b.last, b.what))
+    lines += ["", "#endif /* %s */" % guard, ""]
+    return "\r\n".join(lines)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("graph")
+    ap.add_argument("-o", "--output", help="header to write")
+    ap.add_argument("--align", type=int, default=4, help="buffer alignment, default 4")
+    args = ap.parse_args()
+
+    with open(args.graph) as f:
+        graph = json.load(f)
+    buffers = build(graph)
+    size = pack(buffers, args.align)
+    separate = sum(round_up(b.size, args.align) for b in buffers)
+    peak = live_peak(buffers, len(graph["layers"]), args.align)
+
+    print("%-16s %7s %7s %8s  %s" % ("buffer", "bytes", "offset", "layers", ""))
+    for b in buffers:
+        print("%-16s %7d %7d %3d..%-3d  %s" % (b.name, b.size, b.offset, b.first, b.last, b.what))
+    print("%s: %d buffers, one array each %d bytes, arena %d bytes, live peak %d bytes" %
+          (graph["name"], len(buffers), separate, size, peak))
+    if "baseline" in graph:
+        base = graph["baseline"]
+        print("baseline %d bytes (%s), arena saves %d" %
+              (base["bytes"], base.get("note", ""), base["bytes"] - size))
+
+    if args.output:
+        with open(args.output, "w", newline="") as f:
+            f.write(header(graph, buffers, size, os.path.basename(args.graph), args.align))
+        print("wrote %s" % args.output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -84,8 +84,10 @@ void arm_nn_activations_direct_q15(q15_t * data, uint16_t size, uint16_t int_wid
         q15_t     out;
         q15_t     in = *pIn++;
         q15_t     frac = (uint32_t) in & bit_mask;
-        q15_t     value = lookup_table[__USAT(in >> shift_size, 8)];
-        q15_t     value2 = lookup_table[__USAT(1 + (in >> shift_size), 8)];
+        q15_t     index = in >> shift_size;
+        /* the tables are in two's complement order, negative inputs index the upper half */
+        q15_t     value = lookup_table[(uint8_t) index];
+        q15_t     value2 = lookup_table[(uint8_t) (index == 127 ? index : index + 1)];
 
         /* doing the interpolation here for better accuracy */
         out = ((q31_t) (full_frac - frac) * value + (q31_t) value2 * frac) >> shift_size;
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2010-2018 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_convolve_1D_causal_q15.c
+ * Description:	 Q15 version of 1-D causal dilated convolution
+ *
+ * $Date:        19. October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+#include "arm_math.h"
+#include "arm_nnfunctions.h"
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup NNConv
+ * @{
+ */
+
+  /**
+   * @brief Q15 1-D causal dilated convolution function
+   * @param[in]       Im_in       pointer to input tensor
+   * @param[in]       dim_im_in   input tensor length, also the output length
+   * @param[in]       ch_im_in    number of input tensor channels
+   * @param[in]       wt          pointer to kernel weights
+   * @param[in]       ch_im_out   number of filters, i.e., output tensor channels
+   * @param[in]       dim_kernel  filter kernel size
+   * @param[in]       dilation    distance between kernel taps, 1 for a plain convolution
+   * @param[in]       bias        pointer to bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for output
+   * @param[in,out]   Im_out      pointer to output tensor
+   * @param[in,out]   bufferA     pointer to buffer space for input 
+   * @param[in,out]   bufferB     pointer to buffer space for output
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * @details
+   *
+   * <b>Buffer size:</b>
+   *
+   * bufferA size: ch_im_in*dim_kernel
+   *
+   * bufferB size: 0
+   *
+   * Tensors are channel-last: Im_in is dim_im_in x ch_im_in, Im_out is
+   * dim_im_in x ch_im_out and wt is ch_im_out x dim_kernel x ch_im_in.
+   * Output sample t only sees inputs up to t:
+   *
+   *   Im_out[t] = bias + sum_k wt[k] * Im_in[t - (dim_kernel - 1 - k) * dilation]
+   *
+   * with the inputs before the start taken as 0. The last tap is the
+   * current sample. Each im2col column is multiplied with the weights as in
+   * arm_convolve_HWC_q15_basic.
+   */
+
+arm_status
+arm_convolve_1D_causal_q15(const q15_t * Im_in,
+                           const uint16_t dim_im_in,
+                           const uint16_t ch_im_in,
+                           const q15_t * wt,
+                           const uint16_t ch_im_out,
+                           const uint16_t dim_kernel,
+                           const uint16_t dilation,
+                           const q15_t * bias,
+                           const uint16_t bias_shift,
+                           const uint16_t out_shift,
+                           q15_t * Im_out,
+                           q15_t * bufferA,
+                           q7_t * bufferB)
+{
+
+    if (dilation == 0)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+#if defined (ARM_MATH_DSP)
+    /* Run the following code for Cortex-M4 and Cortex-M7 */
+
+    int32_t   i_out, i_ker;
+    q15_t    *pBuffer;
+    q15_t    *pOut = Im_out;
+    const q15_t *pA;
+    const uint16_t numCol_A = ch_im_in * dim_kernel;
+    int       i;
+
+    for (i_out = 0; i_out < dim_im_in; i_out++)
+    {
+        /* This part implements the im2col function */
+        pBuffer = bufferA;
+        for (i_ker = i_out - (int32_t)(dim_kernel - 1) * dilation; i_ker <= i_out; i_ker += dilation)
+        {
+            if (i_ker < 0)
+            {
+                /* Filling 0 for the samples before the start */
+                memset(pBuffer, 0, sizeof(q15_t)*ch_im_in);
+            } else
+            {
+                memcpy(pBuffer, (q15_t *) Im_in + i_ker * ch_im_in, sizeof(q15_t)*ch_im_in);
+            }
+            pBuffer += ch_im_in;
+        }
+
+        pA = wt;
+        for (i = 0; i < ch_im_out; i++)
+        {
+            q31_t     sum = ((q31_t)bias[i] << bias_shift) + NN_ROUND(out_shift);
+            q15_t    *pB = bufferA;
+            uint16_t  colCnt = numCol_A >> 2;
+            while (colCnt)
+            {
+                q31_t     inA1 = *__SIMD32(pA)++;
+                q31_t     inB1 = *__SIMD32(pB)++;
+                q31_t     inA2 = *__SIMD32(pA)++;
+                q31_t     inB2 = *__SIMD32(pB)++;
+
+                sum = __SMLAD(inA1, inB1, sum);
+                sum = __SMLAD(inA2, inB2, sum);
+
+                colCnt--;
+            }
+            colCnt = numCol_A & 0x3;
+            while (colCnt)
+            {
+                q15_t     inA1 = *pA++;
+                q15_t     inB1 = *pB++;
+                sum += inA1 * inB1;
+                colCnt--;
+            }
+            *pOut = (q15_t) __SSAT((sum >> out_shift), 16);
+            pOut++;
+        }
+    }
+
+#else
+    /* Run the following code as reference implementation for Cortex-M0 and Cortex-M3 */
+
+    int32_t   i, t, k, l, in_t;
+    q31_t     conv_out;
+
+    for (t = 0; t < dim_im_in; t++)
+    {
+        for (i = 0; i < ch_im_out; i++)
+        {
+            conv_out = ((q31_t)bias[i] << bias_shift) + NN_ROUND(out_shift);
+            for (k = 0; k < dim_kernel; k++)
+            {
+                in_t = t - (int32_t)(dim_kernel - 1 - k) * dilation;
+                if (in_t >= 0)
+                {
+                    for (l = 0; l < ch_im_in; l++)
+                    {
+                        conv_out += Im_in[in_t * ch_im_in + l] * wt[(i * dim_kernel + k) * ch_im_in + l];
+                    }
+                }
+            }
+            Im_out[t * ch_im_out + i] = (q15_t) __SSAT((conv_out >> out_shift), 16);
+        }
+    }
+
+#endif                          /* ARM_MATH_DSP */
+
+    /* Return to application */
+    return ARM_MATH_SUCCESS;
+}
+
+/**
+ * @} end of NNConv group
+ */
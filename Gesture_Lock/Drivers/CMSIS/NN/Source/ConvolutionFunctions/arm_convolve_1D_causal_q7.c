@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2010-2018 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_convolve_1D_causal_q7.c
+ * Description:	 Q7 version of 1-D causal dilated convolution
+ *
+ * $Date:        19. October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+#include "arm_math.h"
+#include "arm_nnfunctions.h"
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup NNConv
+ * @{
+ */
+
+  /**
+   * @brief Q7 1-D causal dilated convolution function
+   * @param[in]       Im_in       pointer to input tensor
+   * @param[in]       dim_im_in   input tensor length, also the output length
+   * @param[in]       ch_im_in    number of input tensor channels
+   * @param[in]       wt          pointer to kernel weights
+   * @param[in]       ch_im_out   number of filters, i.e., output tensor channels
+   * @param[in]       dim_kernel  filter kernel size
+   * @param[in]       dilation    distance between kernel taps, 1 for a plain convolution
+   * @param[in]       bias        pointer to bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for output
+   * @param[in,out]   Im_out      pointer to output tensor
+   * @param[in,out]   bufferA     pointer to buffer space for input 
+   * @param[in,out]   bufferB     pointer to buffer space for output
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * @details
+   *
+   * <b>Buffer size:</b>
+   *
+   * bufferA size: 2*ch_im_in*dim_kernel
+   *
+   * bufferB size: 0
+   *
+   * Tensors are channel-last: Im_in is dim_im_in x ch_im_in, Im_out is
+   * dim_im_in x ch_im_out and wt is ch_im_out x dim_kernel x ch_im_in.
+   * Output sample t only sees inputs up to t:
+   *
+   *   Im_out[t] = bias + sum_k wt[k] * Im_in[t - (dim_kernel - 1 - k) * dilation]
+   *
+   * with the inputs before the start taken as 0. The last tap is the
+   * current sample. The im2col columns go through
+   * arm_nn_mat_mult_kernel_q7_q15 two at a time, as in the 2-D kernels.
+   */
+
+arm_status
+arm_convolve_1D_causal_q7(const q7_t * Im_in,
+                          const uint16_t dim_im_in,
+                          const uint16_t ch_im_in,
+                          const q7_t * wt,
+                          const uint16_t ch_im_out,
+                          const uint16_t dim_kernel,
+                          const uint16_t dilation,
+                          const q7_t * bias,
+                          const uint16_t bias_shift,
+                          const uint16_t out_shift,
+                          q7_t * Im_out,
+                          q15_t * bufferA,
+                          q7_t * bufferB)
+{
+
+    if (dilation == 0)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+#if defined (ARM_MATH_DSP)
+    /* Run the following code for Cortex-M4 and Cortex-M7 */
+
+    int32_t   i_out, i_ker;
+    q15_t    *pBuffer = bufferA;
+    q7_t     *pOut = Im_out;
+    const uint16_t numCol_A = ch_im_in * dim_kernel;
+
+    /* This part implements the im2col function */
+    for (i_out = 0; i_out < dim_im_in; i_out++)
+    {
+        for (i_ker = i_out - (int32_t)(dim_kernel - 1) * dilation; i_ker <= i_out; i_ker += dilation)
+        {
+            if (i_ker < 0)
+            {
+                /* Filling 0 for the samples before the start */
+                memset(pBuffer, 0, sizeof(q15_t)*ch_im_in);
+            } else
+            {
+                arm_q7_to_q15_no_shift((q7_t *) Im_in + i_ker * ch_im_in, pBuffer, ch_im_in);
+            }
+            pBuffer += ch_im_in;
+        }
+
+        /* Computation is filed for every 2 columns */
+        if (pBuffer == bufferA + 2 * numCol_A)
+        {
+            pOut = arm_nn_mat_mult_kernel_q7_q15(wt, bufferA, ch_im_out, numCol_A, bias_shift, out_shift, bias, pOut);
+
+            /* counter reset */
+            pBuffer = bufferA;
+        }
+    }
+
+    /* left-over because odd number of output samples */
+    if (pBuffer != bufferA)
+    {
+        const q7_t *pA = wt;
+        int       i;
+
+        for (i = 0; i < ch_im_out; i++)
+        {
+            /* Load the accumulator with bias first */
+            q31_t     sum = ((q31_t)bias[i] << bias_shift) + NN_ROUND(out_shift);
+
+            /* Point to the beging of the im2col buffer */
+            q15_t    *pB = bufferA;
+
+            /* Each time it process 4 entries */
+            uint16_t  colCnt = numCol_A >> 2;
+
+            while (colCnt)
+            {
+                q31_t     inA1, inA2;
+                q31_t     inB1, inB2;
+
+                pA = (q7_t *) read_and_pad((void *)pA, &inA1, &inA2);
+
+                inB1 = *__SIMD32(pB)++;
+                sum = __SMLAD(inA1, inB1, sum);
+                inB2 = *__SIMD32(pB)++;
+                sum = __SMLAD(inA2, inB2, sum);
+
+                colCnt--;
+            }
+            colCnt = numCol_A & 0x3;
+            while (colCnt)
+            {
+                q7_t      inA1 = *pA++;
+                q15_t     inB1 = *pB++;
+                sum += inA1 * inB1;
+                colCnt--;
+            }
+            *pOut++ = (q7_t) __SSAT((sum >> out_shift), 8);
+        }
+    }
+#else
+    /* Run the following code as reference implementation for Cortex-M0 and Cortex-M3 */
+
+    int32_t   i, t, k, l, in_t;
+    q31_t     conv_out;
+
+    for (t = 0; t < dim_im_in; t++)
+    {
+        for (i = 0; i < ch_im_out; i++)
+        {
+            conv_out = ((q31_t)bias[i] << bias_shift) + NN_ROUND(out_shift);
+            for (k = 0; k < dim_kernel; k++)
+            {
+                in_t = t - (int32_t)(dim_kernel - 1 - k) * dilation;
+                if (in_t >= 0)
+                {
+                    for (l = 0; l < ch_im_in; l++)
+                    {
+                        conv_out += Im_in[in_t * ch_im_in + l] * wt[(i * dim_kernel + k) * ch_im_in + l];
+                    }
+                }
+            }
+            Im_out[t * ch_im_out + i] = (q7_t) __SSAT((conv_out >> out_shift), 8);
+        }
+    }
+
+#endif                          /* ARM_MATH_DSP */
+
+    /* Return to application */
+    return ARM_MATH_SUCCESS;
+}
+
+/**
+ * @} end of NNConv group
+ */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2010-2018 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_convolve_1D_stream_q7.c
+ * Description:	 Q7 version of streaming 1-D causal dilated convolution
+ *
+ * $Date:        19. October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+#include "arm_math.h"
+#include "arm_nnfunctions.h"
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup NNConv
+ * @{
+ */
+
+  /**
+   * @brief Q7 streaming 1-D causal dilated convolution function
+   * @param[in]       sample      pointer to the newest input sample, ch_im_in values
+   * @param[in]       ch_im_in    number of input tensor channels
+   * @param[in]       wt          pointer to kernel weights
+   * @param[in]       ch_im_out   number of filters, i.e., output tensor channels
+   * @param[in]       dim_kernel  filter kernel size
+   * @param[in]       dilation    distance between kernel taps, 1 for a plain convolution
+   * @param[in]       bias        pointer to bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for output
+   * @param[in,out]   ring        pointer to the past input samples
+   * @param[in,out]   head        slot of ring the next sample goes to
+   * @param[in,out]   out         pointer to the output sample, ch_im_out values
+   * @param[in,out]   bufferA     pointer to buffer space for input 
+   * @param[in,out]   bufferB     pointer to buffer space for output
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * @details
+   *
+   * <b>Buffer size:</b>
+   *
+   * ring size: ((dim_kernel-1)*dilation+1)*ch_im_in
+   *
+   * bufferA size: ch_im_in*dim_kernel
+   *
+   * bufferB size: ch_im_in*dim_kernel
+   *
+   * Computes one output sample of arm_convolve_1D_causal_q7 per call, with
+   * the same weights layout and the same result, at the cost of a single
+   * im2col column instead of the whole window. ring holds the receptive
+   * field, the newest sample overwrites the oldest. Clear ring and set
+   * *head to 0 before the first sample, the zeros then stand for the
+   * samples before the start. The window is gathered into bufferB and
+   * multiplied with arm_fully_connected_q7.
+   */
+
+arm_status
+arm_convolve_1D_stream_q7(const q7_t * sample,
+                          const uint16_t ch_im_in,
+                          const q7_t * wt,
+                          const uint16_t ch_im_out,
+                          const uint16_t dim_kernel,
+                          const uint16_t dilation,
+                          const q7_t * bias,
+                          const uint16_t bias_shift,
+                          const uint16_t out_shift,
+                          q7_t * ring,
+                          uint16_t * head,
+                          q7_t * out,
+                          q15_t * bufferA,
+                          q7_t * bufferB)
+{
+    const uint16_t len = (dim_kernel - 1) * dilation + 1;
+    q7_t     *pWin = bufferB;
+    uint16_t  slot;
+    int       k;
+
+    if (dilation == 0 || *head >= len)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    /* the newest sample replaces the oldest one */
+    memcpy(ring + *head * ch_im_in, sample, ch_im_in);
+
+    /* gather the taps, oldest first, the oldest is the slot after head */
+    slot = *head + 1;
+    if (slot == len)
+    {
+        slot = 0;
+    }
+    for (k = 0; k < dim_kernel; k++)
+    {
+        memcpy(pWin, ring + slot * ch_im_in, ch_im_in);
+        pWin += ch_im_in;
+        slot += dilation;
+        if (slot >= len)
+        {
+            slot -= len;
+        }
+    }
+
+    *head = (*head + 1 == len) ? 0 : *head + 1;
+
+    return arm_fully_connected_q7(bufferB, wt, ch_im_in * dim_kernel, ch_im_out, bias_shift, out_shift, bias, out, bufferA);
+}
+
+/**
+ * @} end of NNConv group
+ */
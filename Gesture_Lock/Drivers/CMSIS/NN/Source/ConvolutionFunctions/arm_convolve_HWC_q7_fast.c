@@ -74,6 +74,8 @@
    *
    * ch_im_out is multipe of 2    ( bacause 2x2 mat_mult kernel )
    *
+   * padding is at most dim_im_out ( the top rows and left columns run to padding )
+   *
    * The im2col converts the Q7 tensor input into Q15 column, which is stored in
    * bufferA. There is reordering happenning during this im2col process with
    * arm_q7_to_q15_reordered_no_shift. For every four elements, the second and
@@ -119,7 +121,7 @@ arm_convolve_HWC_q7_fast(const q7_t * Im_in,
     q15_t    *pBuffer = bufferA;
     q7_t     *pOut = Im_out;
 
-    if (ch_im_in % 4 != 0 || ch_im_out % 2 != 0)
+    if (ch_im_in % 4 != 0 || ch_im_out % 2 != 0 || padding > dim_im_out)
     {
         /* check if the input dimension meets the constraints */
         return ARM_MATH_SIZE_MISMATCH;
@@ -360,7 +362,7 @@ arm_convolve_HWC_q7_fast(const q7_t * Im_in,
     int       conv_out;
     signed char in_row, in_col;
 
-    if (ch_im_in % 4 != 0 || ch_im_out % 2 != 0)
+    if (ch_im_in % 4 != 0 || ch_im_out % 2 != 0 || padding > dim_im_out)
     {
         /* check if the input dimension meets the constraints */
         return ARM_MATH_SIZE_MISMATCH;
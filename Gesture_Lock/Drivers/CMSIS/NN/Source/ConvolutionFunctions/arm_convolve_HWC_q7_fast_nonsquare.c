@@ -69,6 +69,8 @@
  * some contraints:
  *   ch_im_in is multiple of 4
  *   ch_im_out is multiple of 2
+ *   padding_x is at most dim_im_out_x, padding_y at most dim_im_out_y
+ *   (the top rows and left columns run to the padding)
  */
 
 arm_status arm_convolve_HWC_q7_fast_nonsquare(const q7_t * Im_in,
@@ -106,7 +108,7 @@ arm_status arm_convolve_HWC_q7_fast_nonsquare(const q7_t * Im_in,
     q15_t    *pBuffer = bufferA;
     q7_t     *pOut = Im_out;
 
-    if (ch_im_in % 4 != 0 || ch_im_out % 2 != 0)
+    if (ch_im_in % 4 != 0 || ch_im_out % 2 != 0 || padding_x > dim_im_out_x || padding_y > dim_im_out_y)
     {
         /* check if the input dimension meets the constraints */
         return ARM_MATH_SIZE_MISMATCH;
@@ -332,7 +334,7 @@ arm_status arm_convolve_HWC_q7_fast_nonsquare(const q7_t * Im_in,
     int       conv_out;
     int       in_row, in_col;
 
-    if (ch_im_in % 4 != 0 || ch_im_out % 2 != 0)
+    if (ch_im_in % 4 != 0 || ch_im_out % 2 != 0 || padding_x > dim_im_out_x || padding_y > dim_im_out_y)
     {
         /* check if the input dimension meets the constraints */
         return ARM_MATH_SIZE_MISMATCH;
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2010-2018 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_gru_step_q7_q15.c
+ * Description:	 Mixed Q15-Q7 gated recurrent unit step
+ *
+ * $Date:        19. October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+#include "arm_math.h"
+#include "arm_nnfunctions.h"
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup RNN
+ * @{
+ */
+
+/*
+ * One step for both weight layouts, opt selects
+ * arm_fully_connected_mat_q7_vec_q15_opt for the matrix products.
+ */
+static arm_status arm_gru_step(const q15_t * input,
+                               const uint16_t dim_input,
+                               const uint16_t dim_hidden,
+                               const q7_t * wt_gates,
+                               const q7_t * bias_gates,
+                               const q7_t * wt_hidden,
+                               const q7_t * bias_hidden,
+                               const uint16_t bias_shift,
+                               const uint16_t out_shift,
+                               const uint16_t int_width,
+                               q15_t * buffer,
+                               const int opt)
+{
+    q15_t    *reset = buffer;
+    q15_t    *x = buffer + dim_hidden;
+    q15_t    *h = x + dim_input;
+    q15_t    *update = h + dim_hidden;
+    q15_t    *gate = update + dim_hidden;
+    int       i;
+
+    if (int_width > 3)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    memcpy(x, input, dim_input * sizeof(q15_t));
+
+    /* update and reset gates in one pass over {x, h} */
+    if (opt)
+    {
+        arm_fully_connected_mat_q7_vec_q15_opt(x, wt_gates, dim_input + dim_hidden, 2 * dim_hidden, bias_shift,
+                                               out_shift, bias_gates, update, NULL);
+    } else
+    {
+        arm_fully_connected_mat_q7_vec_q15(x, wt_gates, dim_input + dim_hidden, 2 * dim_hidden, bias_shift,
+                                           out_shift, bias_gates, update, NULL);
+    }
+    arm_nn_activations_direct_q15(update, 2 * dim_hidden, int_width, ARM_SIGMOID);
+
+    /* r * h goes ahead of x, the gates are in [0, 1) */
+    for (i = 0; i < dim_hidden; i++)
+    {
+        reset[i] = (q15_t) (((q31_t) gate[i] * h[i]) >> 15);
+    }
+
+    /* candidate state over {r * h, x}, into the reset gate slot */
+    if (opt)
+    {
+        arm_fully_connected_mat_q7_vec_q15_opt(reset, wt_hidden, dim_hidden + dim_input, dim_hidden, bias_shift,
+                                               out_shift, bias_hidden, gate, NULL);
+    } else
+    {
+        arm_fully_connected_mat_q7_vec_q15(reset, wt_hidden, dim_hidden + dim_input, dim_hidden, bias_shift,
+                                           out_shift, bias_hidden, gate, NULL);
+    }
+    arm_nn_activations_direct_q15(gate, dim_hidden, int_width, ARM_TANH);
+
+    /* h = (1 - z) * h + z * n */
+    for (i = 0; i < dim_hidden; i++)
+    {
+        h[i] = (q15_t) __SSAT(h[i] + (((q31_t) update[i] * (gate[i] - h[i])) >> 15), 16);
+    }
+
+    return ARM_MATH_SUCCESS;
+}
+
+  /**
+   * @brief Mixed Q15-Q7 gated recurrent unit step function
+   * @param[in]       input       pointer to the input sample, dim_input values
+   * @param[in]       dim_input   length of the input sample
+   * @param[in]       dim_hidden  length of the hidden state
+   * @param[in]       wt_gates    pointer to update and reset gate weights
+   * @param[in]       bias_gates  pointer to update and reset gate bias
+   * @param[in]       wt_hidden   pointer to candidate state weights
+   * @param[in]       bias_hidden pointer to candidate state bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for the gate inputs
+   * @param[in]       int_width   integer bits of the gate inputs, at most 3
+   * @param[in,out]   buffer      pointer to the state and buffer space
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * @details
+   *
+   * <b>Buffer size:</b>
+   *
+   * buffer size: 4*dim_hidden+dim_input
+   *
+   * Computes one step of
+   * <pre>z = sigmoid(W_z &sdot; {x, h} + b_z)
+   * r = sigmoid(W_r &sdot; {x, h} + b_r)
+   * n = tanh(W_n &sdot; {r &times; h, x} + b_n)
+   * h = (1 - z) &times; h + z &times; n </pre>
+   * as in the GRU example, with the gates and h in Q15. The buffer is laid
+   * out as | r &times; h | x | h | z | r, n | so both concatenations are
+   * in place. It holds h between calls: clear it before the first step,
+   * the state is read at buffer + dim_hidden + dim_input.
+   *
+   * wt_gates is the 2*dim_hidden x (dim_input+dim_hidden) matrix of W_z
+   * rows then W_r rows, columns in the order of {x, h}, one product for
+   * both gates. wt_hidden is dim_hidden x (dim_hidden+dim_input) with
+   * columns in the order of {r &times; h, x}. bias_gates holds b_z then b_r.
+   *
+   * A step costs 3*dim_hidden*(dim_input+dim_hidden) MACs in the matrix
+   * products and a few operations per hidden unit, the same for every
+   * step.
+   *
+   * Cycle budget on the F411, counted from the Cortex-M4 instruction
+   * timings, not measured on the part: the inner loop of
+   * arm_fully_connected_mat_q7_vec_q15 issues 4 SMLAD (8 MACs) with 4
+   * SXTB16, 4 PKH, 4 loads and the loop branch, about 23 cycles or 2.9 per
+   * MAC. Each hidden unit adds 3 activations, a table lookup with
+   * interpolation of about 20 cycles each, 3 output rows of about 8 cycles
+   * of bias, saturation and store, and about 22 cycles in the two
+   * element-wise loops: 2.9*MACs + 110*dim_hidden cycles. For dim_input 6
+   * and dim_hidden 32 that is about 14100 cycles, 147 us at 96 MHz. The
+   * ART accelerator is taken to hide the flash wait states in the loops.
+   */
+
+arm_status
+arm_gru_step_q7_q15(const q15_t * input,
+                    const uint16_t dim_input,
+                    const uint16_t dim_hidden,
+                    const q7_t * wt_gates,
+                    const q7_t * bias_gates,
+                    const q7_t * wt_hidden,
+                    const q7_t * bias_hidden,
+                    const uint16_t bias_shift,
+                    const uint16_t out_shift,
+                    const uint16_t int_width,
+                    q15_t * buffer)
+{
+    return arm_gru_step(input, dim_input, dim_hidden, wt_gates, bias_gates, wt_hidden, bias_hidden, bias_shift,
+                        out_shift, int_width, buffer, 0);
+}
+
+  /**
+   * @brief Mixed Q15-Q7 opt gated recurrent unit step function
+   * @param[in]       input       pointer to the input sample, dim_input values
+   * @param[in]       dim_input   length of the input sample
+   * @param[in]       dim_hidden  length of the hidden state
+   * @param[in]       wt_gates    pointer to update and reset gate weights
+   * @param[in]       bias_gates  pointer to update and reset gate bias
+   * @param[in]       wt_hidden   pointer to candidate state weights
+   * @param[in]       bias_hidden pointer to candidate state bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for the gate inputs
+   * @param[in]       int_width   integer bits of the gate inputs, at most 3
+   * @param[in,out]   buffer      pointer to the state and buffer space
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * @details
+   *
+   * <b>Buffer size:</b>
+   *
+   * buffer size: 4*dim_hidden+dim_input
+   *
+   * Same as arm_gru_step_q7_q15, with both weight matrices reordered for
+   * arm_fully_connected_mat_q7_vec_q15_opt. wt_gates is reordered as one
+   * 2*dim_hidden row matrix.
+   *
+   * The reordered weights need no PKH: about 20 cycles per 8 MACs, 2.5 per
+   * MAC, and 4 rows share the loop set up. Budget, counted the same way as
+   * arm_gru_step_q7_q15: 2.5*MACs + 100*dim_hidden cycles, about 12300
+   * cycles or 128 us at 96 MHz for dim_input 6 and dim_hidden 32.
+   */
+
+arm_status
+arm_gru_step_q7_q15_opt(const q15_t * input,
+                        const uint16_t dim_input,
+                        const uint16_t dim_hidden,
+                        const q7_t * wt_gates,
+                        const q7_t * bias_gates,
+                        const q7_t * wt_hidden,
+                        const q7_t * bias_hidden,
+                        const uint16_t bias_shift,
+                        const uint16_t out_shift,
+                        const uint16_t int_width,
+                        q15_t * buffer)
+{
+    return arm_gru_step(input, dim_input, dim_hidden, wt_gates, bias_gates, wt_hidden, bias_hidden, bias_shift,
+                        out_shift, int_width, buffer, 1);
+}
+
+/**
+ * @} end of RNN group
+ */
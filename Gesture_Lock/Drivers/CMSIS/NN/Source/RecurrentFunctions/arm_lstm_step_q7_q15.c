@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2010-2018 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_lstm_step_q7_q15.c
+ * Description:	 Mixed Q15-Q7 long short-term memory step
+ *
+ * $Date:        19. October 2026
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+#include "arm_math.h"
+#include "arm_nnfunctions.h"
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup RNN
+ * @{
+ */
+
+/*
+ * One step for both weight layouts, opt selects
+ * arm_fully_connected_mat_q7_vec_q15_opt for the matrix product.
+ */
+static arm_status arm_lstm_step(const q15_t * input,
+                                const uint16_t dim_input,
+                                const uint16_t dim_hidden,
+                                const q7_t * wt,
+                                const q7_t * bias,
+                                const uint16_t bias_shift,
+                                const uint16_t out_shift,
+                                const uint16_t int_width,
+                                const uint16_t cell_int_width,
+                                q15_t * buffer,
+                                const int opt)
+{
+    q15_t    *x = buffer;
+    q15_t    *h = x + dim_input;
+    q15_t    *c = h + dim_hidden;
+    q15_t    *in_gate = c + dim_hidden;
+    q15_t    *forget_gate = in_gate + dim_hidden;
+    q15_t    *cell_gate = forget_gate + dim_hidden;
+    q15_t    *out_gate = cell_gate + dim_hidden;
+    int       i;
+
+    if (int_width > 3 || cell_int_width > 3)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    memcpy(x, input, dim_input * sizeof(q15_t));
+
+    /* all four gates in one pass over {x, h} */
+    if (opt)
+    {
+        arm_fully_connected_mat_q7_vec_q15_opt(x, wt, dim_input + dim_hidden, 4 * dim_hidden, bias_shift, out_shift,
+                                               bias, in_gate, NULL);
+    } else
+    {
+        arm_fully_connected_mat_q7_vec_q15(x, wt, dim_input + dim_hidden, 4 * dim_hidden, bias_shift, out_shift,
+                                           bias, in_gate, NULL);
+    }
+    arm_nn_activations_direct_q15(in_gate, 2 * dim_hidden, int_width, ARM_SIGMOID);
+    arm_nn_activations_direct_q15(cell_gate, dim_hidden, int_width, ARM_TANH);
+    arm_nn_activations_direct_q15(out_gate, dim_hidden, int_width, ARM_SIGMOID);
+
+    /* c = f * c + i * g, c has cell_int_width integer bits */
+    for (i = 0; i < dim_hidden; i++)
+    {
+        q31_t     sum = (((q31_t) forget_gate[i] * c[i]) >> 15)
+                        + (((q31_t) in_gate[i] * cell_gate[i]) >> (15 + cell_int_width));
+
+        c[i] = (q15_t) __SSAT(sum, 16);
+        cell_gate[i] = c[i];
+    }
+
+    /* h = o * tanh(c) */
+    arm_nn_activations_direct_q15(cell_gate, dim_hidden, cell_int_width, ARM_TANH);
+    for (i = 0; i < dim_hidden; i++)
+    {
+        h[i] = (q15_t) (((q31_t) out_gate[i] * cell_gate[i]) >> 15);
+    }
+
+    return ARM_MATH_SUCCESS;
+}
+
+  /**
+   * @brief Mixed Q15-Q7 long short-term memory step function
+   * @param[in]       input       pointer to the input sample, dim_input values
+   * @param[in]       dim_input   length of the input sample
+   * @param[in]       dim_hidden  length of the hidden and cell state
+   * @param[in]       wt          pointer to gate weights
+   * @param[in]       bias        pointer to gate bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for the gate inputs
+   * @param[in]       int_width   integer bits of the gate inputs, at most 3
+   * @param[in]       cell_int_width integer bits of the cell state, at most 3
+   * @param[in,out]   buffer      pointer to the state and buffer space
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * @details
+   *
+   * <b>Buffer size:</b>
+   *
+   * buffer size: 6*dim_hidden+dim_input
+   *
+   * Computes one step of
+   * <pre>i = sigmoid(W_i &sdot; {x, h} + b_i)
+   * f = sigmoid(W_f &sdot; {x, h} + b_f)
+   * g = tanh(W_g &sdot; {x, h} + b_g)
+   * o = sigmoid(W_o &sdot; {x, h} + b_o)
+   * c = f &times; c + i &times; g
+   * h = o &times; tanh(c) </pre>
+   * with the gates and h in Q15 and c with cell_int_width integer bits,
+   * saturated. The buffer is laid out as | x | h | c | i | f | g | o |. It
+   * holds h and c between calls: clear it before the first step, h is
+   * read at buffer + dim_input and c follows it.
+   *
+   * wt is the 4*dim_hidden x (dim_input+dim_hidden) matrix of the W_i,
+   * W_f, W_g and W_o rows, columns in the order of {x, h}, one product for
+   * all gates. bias holds the four biases in the same order.
+   *
+   * A step costs 4*dim_hidden*(dim_input+dim_hidden) MACs in the matrix
+   * product and a few operations per hidden unit, the same for every step.
+   *
+   * Cycle budget on the F411, counted from the Cortex-M4 instruction
+   * timings, not measured on the part: the matrix product runs at about
+   * 2.9 cycles per MAC, as in arm_gru_step_q7_q15. Each hidden unit adds 5
+   * activations (4 gates and tanh(c)) of about 20 cycles each, 4 output
+   * rows of about 8 cycles and about 24 cycles in the two element-wise
+   * loops: 2.9*MACs + 155*dim_hidden cycles. For dim_input 6 and
+   * dim_hidden 32 that is about 19100 cycles, 199 us at 96 MHz.
+   */
+
+arm_status
+arm_lstm_step_q7_q15(const q15_t * input,
+                     const uint16_t dim_input,
+                     const uint16_t dim_hidden,
+                     const q7_t * wt,
+                     const q7_t * bias,
+                     const uint16_t bias_shift,
+                     const uint16_t out_shift,
+                     const uint16_t int_width,
+                     const uint16_t cell_int_width,
+                     q15_t * buffer)
+{
+    return arm_lstm_step(input, dim_input, dim_hidden, wt, bias, bias_shift, out_shift, int_width,
+                         cell_int_width, buffer, 0);
+}
+
+  /**
+   * @brief Mixed Q15-Q7 opt long short-term memory step function
+   * @param[in]       input       pointer to the input sample, dim_input values
+   * @param[in]       dim_input   length of the input sample
+   * @param[in]       dim_hidden  length of the hidden and cell state
+   * @param[in]       wt          pointer to gate weights
+   * @param[in]       bias        pointer to gate bias
+   * @param[in]       bias_shift  amount of left-shift for bias
+   * @param[in]       out_shift   amount of right-shift for the gate inputs
+   * @param[in]       int_width   integer bits of the gate inputs, at most 3
+   * @param[in]       cell_int_width integer bits of the cell state, at most 3
+   * @param[in,out]   buffer      pointer to the state and buffer space
+   * @return     The function returns either
+   * <code>ARM_MATH_ARGUMENT_ERROR</code> or <code>ARM_MATH_SUCCESS</code> based on the outcome of argument checking.
+   *
+   * @details
+   *
+   * <b>Buffer size:</b>
+   *
+   * buffer size: 6*dim_hidden+dim_input
+   *
+   * Same as arm_lstm_step_q7_q15, with wt reordered as one 4*dim_hidden row
+   * matrix for arm_fully_connected_mat_q7_vec_q15_opt.
+   *
+   * Budget, counted as for arm_lstm_step_q7_q15 with the 2.5 cycles per MAC
+   * of the reordered product and 4 rows per loop set up: 2.5*MACs +
+   * 150*dim_hidden cycles, about 17000 cycles or 177 us at 96 MHz for
+   * dim_input 6 and dim_hidden 32.
+   */
+
+arm_status
+arm_lstm_step_q7_q15_opt(const q15_t * input,
+                         const uint16_t dim_input,
+                         const uint16_t dim_hidden,
+                         const q7_t * wt,
+                         const q7_t * bias,
+                         const uint16_t bias_shift,
+                         const uint16_t out_shift,
+                         const uint16_t int_width,
+                         const uint16_t cell_int_width,
+                         q15_t * buffer)
+{
+    return arm_lstm_step(input, dim_input, dim_hidden, wt, bias, bias_shift, out_shift, int_width,
+                         cell_int_width, buffer, 1);
+}
+
+/**
+ * @} end of RNN group
+ */
@@ -53,6 +53,7 @@
 #define i2c_read    MPU_Read_Len
 #define delay_ms    delay_ms
 #define get_ms      mget_ms
+#define fifo_resync_request MPU_Bus_Request_Resync
 //static inline int reg_int_cb(struct int_param_s *int_param)
 //{
 //    return msp430_reg_int_cb(int_param->cb, int_param->pin, int_param->lp_exit,
@@ -113,6 +114,13 @@ static inline int reg_int_cb(struct int_param_s *int_param)
 #error  Gyro driver is missing the system layer implementations.
 #endif
 
+/* Called when a FIFO read was cut short and the packet boundary is lost.
+ * Platforms without a deferred resync reset the FIFO right away.
+ */
+#ifndef fifo_resync_request
+#define fifo_resync_request()   mpu_reset_fifo()
+#endif
+
 #if !defined MPU6050 && !defined MPU9150 && !defined MPU6500 && !defined MPU9250
 #error  Which gyro are you using? Define MPUxxxx in your compiler options.
 #endif
@@ -155,6 +163,7 @@ static inline int reg_int_cb(struct int_param_s *int_param)
 #endif
 
 static int set_int_enable(unsigned char enable);
+static int mpu_init_config(void);
 
 /* Hardware registers needed by driver. */
 struct gyro_reg_s {
@@ -760,7 +769,7 @@ int mpu_read_reg(unsigned char reg, unsigned char *data)
  */
 int mpu_init(void)
 {
-    unsigned char data[6], rev;
+    unsigned char data[1];
 
     /* Reset device. */
     data[0] = BIT_RESET;
@@ -773,6 +782,18 @@ int mpu_init(void)
     if (i2c_write(st.hw->addr, st.reg->pwr_mgmt_1, 1, data))
         return -1;
 		HAL_Delay(10);
+    return mpu_init_config();
+}
+
+/**
+ *  @brief      The part of mpu_init after the reset and wake up waits.
+ *  mpu_init_step runs the waits as tick deadlines and this in one step.
+ *  @return     0 if successful.
+ */
+static int mpu_init_config(void)
+{
+    unsigned char data[6], rev;
+
 #if defined MPU6050
     /* Check product revision. */
     if (i2c_read(st.hw->addr, st.reg->accel_offs, 6, data))
@@ -1089,6 +1110,91 @@ int mpu_set_accel_bias(const long *accel_bias)
     return 0;
 }
 
+/**
+ *  @brief      Read the accel bias 6050 registers.
+ *  The values are the factory trim plus any user offset, LSB in +-16G
+ *  format. Bit 0 of each register is reserved for temperature compensation.
+ *  @param[out] accel_bias  Current register values.
+ *  @return     0 if successful.
+ */
+int mpu_read_6050_accel_bias(long *accel_bias)
+{
+    unsigned char data[6];
+
+    if (i2c_read(st.hw->addr, 0x06, 6, data))
+        return -1;
+    accel_bias[0] = (short)(((unsigned short)data[0] << 8) | data[1]);
+    accel_bias[1] = (short)(((unsigned short)data[2] << 8) | data[3]);
+    accel_bias[2] = (short)(((unsigned short)data[4] << 8) | data[5]);
+    return 0;
+}
+
+/**
+ *  @brief      Push biases to the gyro bias 6050 registers.
+ *  The gyro offset registers default to zero after reset, so the biases are
+ *  written as absolute offsets. Bias inputs are LSB in +-1000dps format.
+ *  @param[in]  gyro_bias   New biases.
+ *  @return     0 if successful.
+ */
+int mpu_set_gyro_bias_reg(const long *gyro_bias)
+{
+    unsigned char data[6];
+    long offs[3];
+
+    if (!gyro_bias)
+        return -1;
+    offs[0] = -gyro_bias[0];
+    offs[1] = -gyro_bias[1];
+    offs[2] = -gyro_bias[2];
+
+    data[0] = (offs[0] >> 8) & 0xff;
+    data[1] = (offs[0]) & 0xff;
+    data[2] = (offs[1] >> 8) & 0xff;
+    data[3] = (offs[1]) & 0xff;
+    data[4] = (offs[2] >> 8) & 0xff;
+    data[5] = (offs[2]) & 0xff;
+
+    if (i2c_write(st.hw->addr, 0x13, 6, data))
+        return -1;
+    return 0;
+}
+
+/**
+ *  @brief      Push biases to the accel bias 6050 registers.
+ *  This function expects biases relative to the current sensor output, and
+ *  these biases will be subtracted from the factory-supplied values, so it
+ *  must only be called once after each chip reset. Bias inputs are LSB in
+ *  +-16G format.
+ *  @param[in]  accel_bias  New biases.
+ *  @return     0 if successful.
+ */
+int mpu_set_accel_bias_6050_reg(const long *accel_bias)
+{
+    unsigned char data[6];
+    long accel_reg_bias[3];
+    unsigned char ii;
+
+    if (!accel_bias)
+        return -1;
+    if (mpu_read_6050_accel_bias(accel_reg_bias))
+        return -1;
+
+    for (ii = 0; ii < 3; ii++) {
+        /* Bit 0 is used for temperature compensation, keep it untouched. */
+        unsigned char temp_comp = accel_reg_bias[ii] & 0x01;
+        accel_reg_bias[ii] -= accel_bias[ii];
+        data[ii * 2] = (accel_reg_bias[ii] >> 8) & 0xff;
+        data[ii * 2 + 1] = ((accel_reg_bias[ii]) & 0xfe) | temp_comp;
+    }
+
+    if (i2c_write(st.hw->addr, 0x06, 6, data))
+        return -1;
+    return 0;
+}
+
+/* Number of FIFO resets, lets FIFO readers drop bytes held from before. */
+static unsigned long fifo_reset_count;
+
 /**
  *  @brief  Reset FIFO read/write pointers.
  *  @return 0 if successful.
@@ -1100,6 +1206,7 @@ int mpu_reset_fifo(void)
     if (!(st.chip_cfg.sensors))
         return -1;
 
+    fifo_reset_count++;
     data = 0;
     if (i2c_write(st.hw->addr, st.reg->int_enable, 1, &data))
         return -1;
@@ -1150,6 +1257,16 @@ int mpu_reset_fifo(void)
     return 0;
 }
 
+/**
+ *  @brief  Get the number of FIFO resets since power up.
+ *  Every reset discards the FIFO content, including a partial packet.
+ *  @return Reset count.
+ */
+unsigned long mpu_get_fifo_reset_count(void)
+{
+    return fifo_reset_count;
+}
+
 /**
  *  @brief      Get the gyro full-scale range.
  *  @param[out] fsr Current full-scale range.
@@ -1807,8 +1924,11 @@ int mpu_read_fifo_stream(unsigned short length, unsigned char *data,
         }
     }
 
-    if (i2c_read(st.hw->addr, st.reg->fifo_r_w, length, data))
+    if (i2c_read(st.hw->addr, st.reg->fifo_r_w, length, data)) {
+        /* Part of the packet may have been clocked out already. */
+        fifo_resync_request();
         return -1;
+    }
     more[0] = fifo_count / length - 1;
     return 0;
 }
@@ -2183,7 +2303,7 @@ int mpu_run_self_test(long *gyro, long *accel)
 #endif
     int result;
     unsigned char accel_fsr, fifo_sensors, sensors_on;
-    unsigned short gyro_fsr, sample_rate, lpf;
+    unsigned short gyro_fsr, sample_rate = 0, lpf;
     unsigned char dmp_was_on;
 
     if (st.chip_cfg.dmp_on) {
@@ -2329,8 +2449,66 @@ int mpu_read_mem(unsigned short mem_addr, unsigned short length,
     return 0;
 }
 
+/* DMP image is written and verified one full memory bank per transfer. */
+#define LOAD_CHUNK  (256)
+static unsigned char load_buf[LOAD_CHUNK];
+/* CRC of the image last loaded. */
+static unsigned short fw_signature;
+
+/**
+ *  @brief      CRC-16/CCITT-FALSE.
+ *  @param[in]  crc     Initial value, 0xFFFF for a new CRC.
+ *  @param[in]  data    Bytes to process.
+ *  @param[in]  length  Number of bytes.
+ *  @return     Updated CRC.
+ */
+static unsigned short mem_crc16(unsigned short crc, const unsigned char *data,
+    unsigned short length)
+{
+    unsigned char jj;
+
+    while (length--) {
+        crc ^= (unsigned short)(*data++) << 8;
+        for (jj = 0; jj < 8; jj++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+    return crc;
+}
+
+/**
+ *  @brief      Read back DMP memory and compare its CRC.
+ *  @param[in]  length  Length of DMP image.
+ *  @param[in]  crc     Expected CRC of the image.
+ *  @return     0 if DMP memory matches.
+ */
+static int mpu_verify_firmware(unsigned short length, unsigned short crc)
+{
+    unsigned short ii;
+    unsigned short this_read;
+    unsigned short got = 0xFFFF;
+
+    for (ii = 0; ii < length; ii += this_read) {
+        this_read = min(LOAD_CHUNK, length - ii);
+        if (mpu_read_mem(ii, this_read, load_buf))
+            return -1;
+        got = mem_crc16(got, load_buf, this_read);
+    }
+    return (got == crc) ? 0 : -2;
+}
+
+/**
+ *  @brief      Get the signature of the loaded DMP image.
+ *  @return     CRC of the image, 0 if no image is loaded.
+ */
+unsigned short mpu_get_firmware_signature(void)
+{
+    return st.chip_cfg.dmp_loaded ? fw_signature : 0;
+}
+
 /**
  *  @brief      Load and verify DMP image.
+ *  The image is written in bank sized bursts and verified by a single CRC
+ *  pass over DMP memory.
  *  @param[in]  length      Length of DMP image.
  *  @param[in]  firmware    DMP code.
  *  @param[in]  start_addr  Starting address of DMP code memory.
@@ -2342,9 +2520,8 @@ int mpu_load_firmware(unsigned short length, const unsigned char *firmware,
 {
     unsigned short ii;
     unsigned short this_write;
-    /* Must divide evenly into st.hw->bank_size to avoid bank crossings. */
-#define LOAD_CHUNK  (16)
-    unsigned char cur[LOAD_CHUNK], tmp[2];
+    unsigned short crc;
+    unsigned char tmp[2];
 
     if (st.chip_cfg.dmp_loaded)
         /* DMP should only be loaded once. */
@@ -2352,15 +2529,72 @@ int mpu_load_firmware(unsigned short length, const unsigned char *firmware,
 
     if (!firmware)
         return -1;
+    /* Must divide evenly into st.hw->bank_size to avoid bank crossings. */
+    if (st.hw->bank_size % LOAD_CHUNK)
+        return -1;
+
+    /* mpu_init resets the device, so DMP memory is never assumed kept. */
+    crc = mem_crc16(0xFFFF, firmware, length);
     for (ii = 0; ii < length; ii += this_write) {
         this_write = min(LOAD_CHUNK, length - ii);
         if (mpu_write_mem(ii, this_write, (unsigned char*)&firmware[ii]))
             return -1;
-        if (mpu_read_mem(ii, this_write, cur))
+    }
+    if (mpu_verify_firmware(length, crc))
+        return -2;
+
+    /* Set program start address. */
+    tmp[0] = start_addr >> 8;
+    tmp[1] = start_addr & 0xFF;
+    if (i2c_write(st.hw->addr, st.reg->prgm_start_h, 2, tmp))
+        return -1;
+
+    fw_signature = crc;
+    st.chip_cfg.dmp_loaded = 1;
+    st.chip_cfg.dmp_sample_rate = sample_rate;
+    return 0;
+}
+
+/**
+ *  @brief      Load and verify DMP image one bank per call.
+ *  For callers that must not block for the whole image (the bus recovery).
+ *  The image is written, then read back bank by bank and its CRC compared.
+ *  @param[in]  length      Length of DMP image.
+ *  @param[in]  firmware    DMP code.
+ *  @param[in]  start_addr  Starting address of DMP code memory.
+ *  @param[in]  sample_rate Fixed sampling rate used when DMP is enabled.
+ *  @param[in]  first       1 to start a load, 0 to go on.
+ *  @return     0 when loaded, 1 to call again, <0 as mpu_load_firmware.
+ */
+int mpu_load_firmware_step(unsigned short length, const unsigned char *firmware,
+    unsigned short start_addr, unsigned short sample_rate, unsigned char first)
+{
+    static unsigned short pos, got;
+    unsigned short this_len;
+    unsigned char tmp[2];
+
+    if (first) {
+        if (st.chip_cfg.dmp_loaded || !firmware || st.hw->bank_size % LOAD_CHUNK)
             return -1;
-        if (memcmp(firmware+ii, cur, this_write))
-            return -2;
+        pos = 0;
+        got = 0xFFFF;
+    }
+    if (pos < length) {
+        this_len = min(LOAD_CHUNK, length - pos);
+        if (mpu_write_mem(pos, this_len, (unsigned char*)&firmware[pos]))
+            return -1;
+        pos += this_len;
+        return 1;
     }
+    this_len = min(LOAD_CHUNK, 2 * length - pos);
+    if (mpu_read_mem(pos - length, this_len, load_buf))
+        return -1;
+    got = mem_crc16(got, load_buf, this_len);
+    pos += this_len;
+    if (pos < 2 * length)
+        return 1;
+    if (got != mem_crc16(0xFFFF, firmware, length))
+        return -2;
 
     /* Set program start address. */
     tmp[0] = start_addr >> 8;
@@ -2368,6 +2602,7 @@ int mpu_load_firmware(unsigned short length, const unsigned char *firmware,
     if (i2c_write(st.hw->addr, st.reg->prgm_start_h, 2, tmp))
         return -1;
 
+    fw_signature = got;
     st.chip_cfg.dmp_loaded = 1;
     st.chip_cfg.dmp_sample_rate = sample_rate;
     return 0;
@@ -2873,34 +3108,39 @@ static signed char gyro_orientation[9] = { 1, 0, 0,
                                            0, 1, 0,
                                            0, 0, 1};
 //MPU6050Բ
+//gyro,accel:Բõƫ(q16, dps/g),ɻmpu_apply_biasд
 //ֵ:0,
 //    ,ʧ
-u8 run_self_test(void)
+u8 run_self_test(long *gyro, long *accel)
 {
 	int result;
 	//char test_packet[4] = {0};
-	long gyro[3], accel[3]; 
 	result = mpu_run_self_test(gyro, accel);
 	if (result == 0x3) 
 	{
 		/* Test passed. We can trust the gyro data here, so let's push it down
-		* to the DMP.
+		* to the bias registers.
 		*/
-		float sens;
-		unsigned short accel_sens;
-		mpu_get_gyro_sens(&sens);
-		gyro[0] = (long)(gyro[0] * sens);
-		gyro[1] = (long)(gyro[1] * sens);
-		gyro[2] = (long)(gyro[2] * sens);
-		dmp_set_gyro_bias(gyro);
-		mpu_get_accel_sens(&accel_sens);
-		accel[0] *= accel_sens;
-		accel[1] *= accel_sens;
-		accel[2] *= accel_sens;
-		dmp_set_accel_bias(accel);
-		return 0;
+		return mpu_apply_bias(gyro, accel);
 	}else return 1;
 }
+//ԲƫдMPU6050ƫĴ,оƬλһ
+//gyro,accel:ƫ(q16, dps/g),run_self_testʽͬ
+//ֵ:0,
+//    ,ʧ
+u8 mpu_apply_bias(const long *gyro, const long *accel)
+{
+	long gyro_reg[3], accel_reg[3];
+	u8 i;
+	for(i=0;i<3;i++)
+	{
+		gyro_reg[i] = (long)(gyro[i] * 32.8f) >> 16;	//תΪ1000dps LSB
+		accel_reg[i] = (accel[i] * 2048L) >> 16;		//תΪ16g LSB
+	}
+	if(mpu_set_gyro_bias_reg(gyro_reg))return 1;
+	if(mpu_set_accel_bias_6050_reg(accel_reg))return 2;
+	return 0;
+}
 //Ƿ
 unsigned short inv_orientation_matrix_to_scalar(
     const signed char *mtx)
@@ -2973,13 +3213,98 @@ u8 mpu_dmp_init(void)
 		if(res)return 6; 
 		res=dmp_set_fifo_rate(DEFAULT_MPU_HZ);	//DMP(󲻳200Hz)
 		if(res)return 7;   
-		res=run_self_test();		//Լ
-		//if(res)return 8;    
+		//Լ/ƫУ׼ɵ(run_self_testmpu_apply_bias),ԱʹûУ׼
 		res=mpu_set_dmp_state(1);	//ʹDMP
 		if(res)return 9;     
 	}else return 10;
 	return 0;
 }
+//DMP̼,ֻѼٶȺԭʼFIFO,̬ں(fusion.c)ʹ
+//ʱʡȥDMP̼غУ,ʿɵ1kHz
+//ֵ:0,
+//    ,ʧ
+u8 mpu_raw_init(void)
+{
+	if(mpu_init())return 10;	//ʼMPU6050,2000dps,4g
+	if(mpu_set_sensors(INV_XYZ_GYRO|INV_XYZ_ACCEL))return 1;	//ҪĴ
+	if(mpu_configure_fifo(INV_XYZ_GYRO|INV_XYZ_ACCEL))return 2;	//FIFO
+	if(mpu_set_sample_rate(DEFAULT_MPU_HZ))return 3;	//ò
+	//Լ/ƫУ׼ɵ,ƫдĴFIFOеѼȥƫ
+	return 0;
+}
+//ֲmpu_dmp_init()mpu_raw_init(),߻ָ(mpubus.c)ÿѯһ
+//λͻѺĵȴʱж,;DMP̼ÿдУһbank
+//ÿһeMPL,Ϊdmp_enable_feature()еFIFOλ
+//dmp:1,ͬmpu_dmp_init();0,ͬmpu_raw_init()
+//ֵ:MPU_INIT_BUSY,δ,´ٵ
+//    0,
+//    ,ʧ,ͬmpu_dmp_init(),´εôӸλʼ
+u8 mpu_init_step(u8 dmp)
+{
+	static u8 step,first=1;
+	static u32 wait_tick;
+	unsigned char data;
+	int res=0;
+	if((int32_t)(HAL_GetTick()-wait_tick)<0)return MPU_INIT_BUSY;	//ȴδ
+	switch(step)
+	{
+		case 0:	//λ,ȴ100ms
+			data=BIT_RESET;
+			if(i2c_write(st.hw->addr,st.reg->pwr_mgmt_1,1,&data))res=10;
+			wait_tick=HAL_GetTick()+100;
+			break;
+		case 1:	//,ȴ10ms
+			data=0;
+			if(i2c_write(st.hw->addr,st.reg->pwr_mgmt_1,1,&data))res=10;
+			wait_tick=HAL_GetTick()+10;
+			break;
+		case 2:if(mpu_init_config())res=10;break;	//ʼMPU6050,2000dps,4g
+		case 3:if(mpu_set_sensors(INV_XYZ_GYRO|INV_XYZ_ACCEL))res=1;break;	//ҪĴ
+		case 4:if(mpu_configure_fifo(INV_XYZ_GYRO|INV_XYZ_ACCEL))res=2;break;	//FIFO
+		case 5:if(mpu_set_sample_rate(DEFAULT_MPU_HZ))res=3;break;	//ò
+		case 6:	//dmp̼,ÿһbank
+			res=dmp_load_motion_driver_firmware_step(first);
+			first=0;
+			if(res==1)return MPU_INIT_BUSY;
+			if(res)res=4;
+			break;
+		case 7:if(dmp_set_orientation(inv_orientation_matrix_to_scalar(gyro_orientation)))res=5;break;	//Ƿ
+		case 8:	//dmp
+			if(dmp_enable_feature(DMP_FEATURE_6X_LP_QUAT|DMP_FEATURE_TAP|
+			    DMP_FEATURE_ANDROID_ORIENT|DMP_FEATURE_SEND_RAW_ACCEL|DMP_FEATURE_SEND_CAL_GYRO|
+			    DMP_FEATURE_GYRO_CAL))res=6;
+			break;
+		case 9:if(dmp_set_fifo_rate(DEFAULT_MPU_HZ))res=7;break;	//DMP(󲻳200Hz)
+		case 10:if(mpu_set_dmp_state(1))res=9;break;	//ʹDMP
+	}
+	first=1;
+	if(res||step==(dmp?10:5))
+	{
+		step=0;
+		wait_tick=HAL_GetTick();
+		return res;
+	}
+	step++;
+	return MPU_INIT_BUSY;
+}
+//FIFOõһԭʼ(оƬϵ,Ӳλ)
+//ֵ:0,
+//    ,ݻʧ
+u8 mpu_raw_get_data(MPU_Data_t *mpu)
+{
+	unsigned long sensor_timestamp;
+	short gyro[3], accel[3];
+	unsigned char sensors, more;
+	if(mpu_read_fifo(gyro, accel, &sensor_timestamp, &sensors, &more))return 1;
+	if((sensors&(INV_XYZ_GYRO|INV_XYZ_ACCEL))!=(INV_XYZ_GYRO|INV_XYZ_ACCEL))return 2;	//FIFOлûһ
+	mpu->Accel_X_RAW = accel[0];
+	mpu->Accel_Y_RAW = accel[1];
+	mpu->Accel_Z_RAW = accel[2];
+	mpu->Gyro_X_RAW = gyro[0];
+	mpu->Gyro_Y_RAW = gyro[1];
+	mpu->Gyro_Z_RAW = gyro[2];
+	return 0;
+}
 //õdmp(ע,ҪȽ϶ջ,ֲе)
 //pitch: :0.1   Χ:-90.0 <---> +90.0
 //roll:  :0.1   Χ:-180.0<---> +180.0
@@ -25,6 +25,8 @@
 
 //ٶ
 #define DEFAULT_MPU_HZ  (100)		//100Hz
+//mpu_init_step()δ
+#define MPU_INIT_BUSY   (0xFF)
 
 #define INV_X_GYRO      (0x40)
 #define INV_Y_GYRO      (0x20)
@@ -103,6 +105,9 @@ int mpu_get_power_state(unsigned char *power_on);
 int mpu_set_sensors(unsigned char sensors);
 
 int mpu_set_accel_bias(const long *accel_bias);
+int mpu_read_6050_accel_bias(long *accel_bias);
+int mpu_set_gyro_bias_reg(const long *gyro_bias);
+int mpu_set_accel_bias_6050_reg(const long *accel_bias);
 
 /* Data getter/setter APIs */
 int mpu_get_gyro_reg(short *data, unsigned long *timestamp);
@@ -116,6 +121,7 @@ int mpu_read_fifo(short *gyro, short *accel, unsigned long *timestamp,
 int mpu_read_fifo_stream(unsigned short length, unsigned char *data,
     unsigned char *more);
 int mpu_reset_fifo(void);
+unsigned long mpu_get_fifo_reset_count(void);
 
 int mpu_write_mem(unsigned short mem_addr, unsigned short length,
     unsigned char *data);
@@ -123,6 +129,9 @@ int mpu_read_mem(unsigned short mem_addr, unsigned short length,
     unsigned char *data);
 int mpu_load_firmware(unsigned short length, const unsigned char *firmware,
     unsigned short start_addr, unsigned short sample_rate);
+int mpu_load_firmware_step(unsigned short length, const unsigned char *firmware,
+    unsigned short start_addr, unsigned short sample_rate, unsigned char first);
+unsigned short mpu_get_firmware_signature(void);
 
 int mpu_reg_dump(void);
 int mpu_read_reg(unsigned char reg, unsigned char *data);
@@ -132,8 +141,10 @@ int mpu_register_tap_cb(void (*func)(unsigned char, unsigned char));
 void mget_ms(unsigned long *time);
 unsigned short inv_row_2_scale(const signed char *row);
 unsigned short inv_orientation_matrix_to_scalar(const signed char *mtx);
-u8 run_self_test(void);
+u8 run_self_test(long *gyro, long *accel);
+u8 mpu_apply_bias(const long *gyro, const long *accel);
 u8 mpu_dmp_init(void);
+u8 mpu_init_step(u8 dmp);
 
 #ifndef __MPU_Data_t
 #define __MPU_Data_t
@@ -168,6 +179,8 @@ typedef struct {
 #endif
 
 u8 mpu_dmp_get_data(MPU_Data_t *mpu);
+u8 mpu_raw_init(void);
+u8 mpu_raw_get_data(MPU_Data_t *mpu);
 
 #endif  /* #ifndef _INV_MPU_H_ */
 
@@ -44,6 +44,7 @@
 #define get_ms      mget_ms
 #define log_i 		printf
 #define log_e  		printf
+#define fifo_resync_request MPU_Bus_Request_Resync
 
 #elif defined EMPL_TARGET_MSP430
 #include "msp430.h"
@@ -71,6 +72,11 @@
 #error  Gyro driver is missing the system layer implementations.
 #endif
 
+/* Platforms without a deferred resync reset the FIFO right away. */
+#ifndef fifo_resync_request
+#define fifo_resync_request()   mpu_reset_fifo()
+#endif
+
 /* These defines are copied from dmpDefaultMPU6050.c in the general MPL
  * releases. These defines may change for each DMP image, so be sure to modify
  * these values when switching to a new image.
@@ -478,6 +484,19 @@ static const unsigned short sStartAddress = 0x0400;
 #define QUAT_MAG_SQ_NORMALIZED  (1L<<28)
 #define QUAT_MAG_SQ_MIN         (QUAT_MAG_SQ_NORMALIZED - QUAT_ERROR_THRESH)
 #define QUAT_MAG_SQ_MAX         (QUAT_MAG_SQ_NORMALIZED + QUAT_ERROR_THRESH)
+/* Largest q14 component of a quaternion that can still pass, about
+ * sqrt(QUAT_MAG_SQ_MAX). Checking it first keeps the sum of squares well
+ * inside a signed long for any byte pattern.
+ */
+#define QUAT_Q14_MAX            (16896L)
+/* Smallest |dot product| of a quaternion with the last one accepted, 0.9
+ * in q28: a turn of up to ~50 degrees, five packets at 2000 dps and 200 Hz.
+ */
+#define QUAT_DOT_MIN            (QUAT_MAG_SQ_NORMALIZED / 10 * 9)
+/* Realigned packets that may fail the check in a row before the FIFO is
+ * reset, see dmp_fifo_realign.
+ */
+#define FIFO_REALIGN_MAX        (2)
 #endif
 
 struct dmp_s {
@@ -507,6 +526,24 @@ static struct dmp_s dmp={
   0
 };
 
+/* Software side of the FIFO. A packet is assembled here and bytes read
+ * past it are kept for the next call, so a misaligned stream can be
+ * realigned without resetting the FIFO.
+ */
+struct dmp_fifo_s {
+    unsigned char buf[2 * MAX_PACKET_LENGTH];
+    unsigned char count;            /* Bytes held in buf. */
+    unsigned char realigns;         /* Realigns since the last packet that
+                                       passed the check as read, or reset. */
+    unsigned long reset_seen;       /* mpu_get_fifo_reset_count() of buf. */
+    short last_q14[4];              /* Last quaternion returned, q14. */
+    unsigned char last_valid;       /* last_q14 holds one since the reset. */
+};
+
+static struct dmp_fifo_s fifo;
+static struct dmp_fifo_stats_s fifo_stats;
+static unsigned long fifo_reset_base;
+
 /**
  *  @brief  Load the DMP with this image.
  *  @return 0 if successful.
@@ -517,6 +554,18 @@ int dmp_load_motion_driver_firmware(void)
         DMP_SAMPLE_RATE);
 }
 
+/**
+ *  @brief      Load the DMP with this image one bank per call.
+ *  See mpu_load_firmware_step.
+ *  @param[in]  first   1 to start a load, 0 to go on.
+ *  @return     0 when loaded, 1 to call again, <0 on error.
+ */
+int dmp_load_motion_driver_firmware_step(unsigned char first)
+{
+    return mpu_load_firmware_step(DMP_CODE_SIZE, dmp_memory, sStartAddress,
+        DMP_SAMPLE_RATE, first);
+}
+
 /**
  *  @brief      Push gyro and accel orientation to the DMP.
  *  The orientation is represented here as the output of
@@ -1247,6 +1296,133 @@ int dmp_set_interrupt_mode(unsigned char mode)
     }
 }
 
+/**
+ *  @brief      Fill the packet buffer up to one packet.
+ *  Bytes held from before a FIFO reset are dropped first.
+ *  @param[in]  length  Packet length.
+ *  @param[out] more    Nonzero if more data is waiting.
+ *  @return     0 if a whole packet is held.
+ */
+static int dmp_fifo_fill(unsigned short length, unsigned char *more)
+{
+    unsigned long resets = mpu_get_fifo_reset_count();
+
+    if (fifo.reset_seen != resets) {
+        fifo.reset_seen = resets;
+        fifo.count = 0;
+        fifo.realigns = 0;
+        fifo.last_valid = 0;
+    }
+    if (fifo.count >= length) {
+        more[0] = (fifo.count >= 2 * length);
+        return 0;
+    }
+    if (mpu_read_fifo_stream(length - fifo.count, fifo.buf + fifo.count,
+            more))
+        return -1;
+    more[0] = (more[0] != 0);
+    fifo.count = length;
+    return 0;
+}
+
+/**
+ *  @brief      Drop the packet at the head of the buffer.
+ *  @param[in]  length  Packet length.
+ */
+static void dmp_fifo_consume(unsigned short length)
+{
+    if (fifo.count > length) {
+        memmove(fifo.buf, fifo.buf + length, fifo.count - length);
+        fifo.count -= length;
+    } else
+        fifo.count = 0;
+}
+
+#ifdef FIFO_CORRUPTION_CHECK
+/**
+ *  @brief      Check the quaternion at the head of a packet.
+ *  Integer only: the q30 components are scaled down to q14 and the
+ *  magnitude must be normalized to one. A zero component is refused too,
+ *  unless the quaternion is the identity the DMP starts from: the gesture
+ *  word that ends a packet is zero most of the time, and a stream
+ *  misaligned by a multiple of four bytes shows it as a component, e.g.
+ *  (gyro, 0, w, x) read eight bytes early. That passes the magnitude check
+ *  whenever the dropped components are small, and keeps passing while the
+ *  sensor turns slowly. Once the DMP has integrated any motion a q30
+ *  component is practically never exactly zero.
+ *  \n Since the last FIFO reset the quaternion must also be close to the
+ *  last one returned (QUAT_DOT_MIN): a window misaligned by four bytes,
+ *  (x, y, z, accel), passes the magnitude check while w is small, but is
+ *  far from (w, x, y, z) of the packet before.
+ *  @param[in]  data    Packet data, big endian q30 w, x, y, z.
+ *  @return     1 if the quaternion is valid.
+ */
+static int dmp_quat_valid(const unsigned char *data)
+{
+    long quat_q14, quat_mag_sq = 0, dot = 0;
+    unsigned char ii, zeros = 0;
+
+    for (ii = 0; ii < 16; ii += 4) {
+        if (!(data[ii] | data[ii+1] | data[ii+2] | data[ii+3]))
+            zeros++;
+        quat_q14 = (short)(((unsigned short)data[ii] << 8) | data[ii+1]);
+        if ((quat_q14 > QUAT_Q14_MAX) || (quat_q14 < -QUAT_Q14_MAX))
+            return 0;
+        quat_mag_sq += quat_q14 * quat_q14;
+        dot += quat_q14 * fifo.last_q14[ii >> 2];
+    }
+    /* Zeros only as the identity: x, y and z, not w. */
+    if (zeros && ((zeros != 3) ||
+        !(data[0] | data[1] | data[2] | data[3])))
+        return 0;
+    if (fifo.last_valid && (dot < QUAT_DOT_MIN) && (dot > -QUAT_DOT_MIN))
+        return 0;
+    return (quat_mag_sq >= QUAT_MAG_SQ_MIN) &&
+        (quat_mag_sq <= QUAT_MAG_SQ_MAX);
+}
+
+/**
+ *  @brief      Find the packet boundary again.
+ *  The packet at the head of the buffer failed the quaternion check, most
+ *  likely because a FIFO read was cut short by an I2C error. Up to one more
+ *  packet is read and the first offset holding a valid quaternion (and a
+ *  valid one a packet later, when held) becomes the new head. Bytes before
+ *  it are dropped, bytes after it stay buffered.
+ *  \n Only offsets whose whole quaternion is held are tried (shift + 16 <=
+ *  fifo.count), and the second quaternion is only checked when a packet
+ *  past the shift is held too. So when the extra read comes up short a
+ *  boundary near the end of the buffer is missed, and a single quaternion
+ *  shaped run of other packet bytes can be taken for one. The stream is
+ *  then still misaligned and the next packet fails again: dmp_read_fifo
+ *  resets the FIFO after FIFO_REALIGN_MAX such realigns in a row.
+ *  @param[in]  length  Packet length.
+ *  @return     0 if realigned.
+ */
+static int dmp_fifo_realign(unsigned short length)
+{
+    unsigned char more, shift;
+    unsigned short want = 2 * length - 1;
+
+    if ((fifo.count < want) && !mpu_read_fifo_stream(want - fifo.count,
+            fifo.buf + fifo.count, &more))
+        fifo.count = want;
+
+    for (shift = 1; shift + 16 <= fifo.count; shift++) {
+        if (!dmp_quat_valid(fifo.buf + shift))
+            continue;
+        if ((shift + length + 16 <= fifo.count) &&
+            !dmp_quat_valid(fifo.buf + shift + length))
+            continue;
+        memmove(fifo.buf, fifo.buf + shift, fifo.count - shift);
+        fifo.count -= shift;
+        fifo_stats.resyncs++;
+        fifo_stats.skipped += shift;
+        return 0;
+    }
+    return -1;
+}
+#endif
+
 /**
  *  @brief      Get one packet from the FIFO.
  *  If @e sensors does not contain a particular sensor, disregard the data
@@ -1259,18 +1435,21 @@ int dmp_set_interrupt_mode(unsigned char mode)
  *  \n If the FIFO has no new data, @e sensors will be zero.
  *  \n If the FIFO is disabled, @e sensors will be zero and this function will
  *  return a non-zero error code.
+ *  \n With FIFO_CORRUPTION_CHECK a packet with a bad quaternion is dropped
+ *  and the stream is realigned; the FIFO is only reset if no packet boundary
+ *  can be found or FIFO_REALIGN_MAX realigns in a row did not hold.
  *  @param[out] gyro        Gyro data in hardware units.
  *  @param[out] accel       Accel data in hardware units.
  *  @param[out] quat        3-axis quaternion data in hardware units.
  *  @param[out] timestamp   Timestamp in milliseconds.
  *  @param[out] sensors     Mask of sensors read from FIFO.
- *  @param[out] more        Number of remaining packets.
+ *  @param[out] more        Nonzero if more data is waiting.
  *  @return     0 if successful.
  */
 int dmp_read_fifo(short *gyro, short *accel, long *quat,
     unsigned long *timestamp, short *sensors, unsigned char *more)
 {
-    unsigned char fifo_data[MAX_PACKET_LENGTH];
+    unsigned char *fifo_data = fifo.buf;
     unsigned char ii = 0;
 
     /* TODO: sensors[0] only changes when dmp_enable_feature is called. We can
@@ -1279,14 +1458,37 @@ int dmp_read_fifo(short *gyro, short *accel, long *quat,
     sensors[0] = 0;
 
     /* Get a packet. */
-    if (mpu_read_fifo_stream(dmp.packet_length, fifo_data, more))
+    if (dmp_fifo_fill(dmp.packet_length, more))
         return -1;
 
-    /* Parse DMP packet. */
-    if (dmp.feature_mask & (DMP_FEATURE_LP_QUAT | DMP_FEATURE_6X_LP_QUAT)) {
 #ifdef FIFO_CORRUPTION_CHECK
-        long quat_q14[4], quat_mag_sq;
+    /* We can detect a corrupted FIFO by monitoring the quaternion data and
+     * ensuring that the magnitude is always normalized to one. This
+     * shouldn't happen in normal operation, but if an I2C error occurs,
+     * the FIFO reads might become misaligned.
+     */
+    if ((dmp.feature_mask & (DMP_FEATURE_LP_QUAT | DMP_FEATURE_6X_LP_QUAT)) &&
+        !dmp_quat_valid(fifo_data)) {
+        fifo_stats.drops++;
+        if ((fifo.realigns >= FIFO_REALIGN_MAX) ||
+            dmp_fifo_realign(dmp.packet_length)) {
+            /* No packet boundary in sight, or the last realigns found
+             * false ones: start over.
+             */
+            fifo.count = 0;
+            fifo.realigns = 0;
+            fifo_resync_request();
+            return -1;
+        }
+        fifo.realigns++;
+        if (dmp_fifo_fill(dmp.packet_length, more))
+            return -1;
+    } else
+        fifo.realigns = 0;
 #endif
+
+    /* Parse DMP packet. */
+    if (dmp.feature_mask & (DMP_FEATURE_LP_QUAT | DMP_FEATURE_6X_LP_QUAT)) {
         quat[0] = ((long)fifo_data[0] << 24) | ((long)fifo_data[1] << 16) |
             ((long)fifo_data[2] << 8) | fifo_data[3];
         quat[1] = ((long)fifo_data[4] << 24) | ((long)fifo_data[5] << 16) |
@@ -1297,27 +1499,11 @@ int dmp_read_fifo(short *gyro, short *accel, long *quat,
             ((long)fifo_data[14] << 8) | fifo_data[15];
         ii += 16;
 #ifdef FIFO_CORRUPTION_CHECK
-        /* We can detect a corrupted FIFO by monitoring the quaternion data and
-         * ensuring that the magnitude is always normalized to one. This
-         * shouldn't happen in normal operation, but if an I2C error occurs,
-         * the FIFO reads might become misaligned.
-         *
-         * Let's start by scaling down the quaternion data to avoid long long
-         * math.
-         */
-        quat_q14[0] = quat[0] >> 16;
-        quat_q14[1] = quat[1] >> 16;
-        quat_q14[2] = quat[2] >> 16;
-        quat_q14[3] = quat[3] >> 16;
-        quat_mag_sq = quat_q14[0] * quat_q14[0] + quat_q14[1] * quat_q14[1] +
-            quat_q14[2] * quat_q14[2] + quat_q14[3] * quat_q14[3];
-        if ((quat_mag_sq < QUAT_MAG_SQ_MIN) ||
-            (quat_mag_sq > QUAT_MAG_SQ_MAX)) {
-            /* Quaternion is outside of the acceptable threshold. */
-            mpu_reset_fifo();
-            sensors[0] = 0;
-            return -1;
-        }
+        fifo.last_q14[0] = (short)(quat[0] >> 16);
+        fifo.last_q14[1] = (short)(quat[1] >> 16);
+        fifo.last_q14[2] = (short)(quat[2] >> 16);
+        fifo.last_q14[3] = (short)(quat[3] >> 16);
+        fifo.last_valid = 1;
         sensors[0] |= INV_WXYZ_QUAT;
 #endif
     }
@@ -1344,10 +1530,35 @@ int dmp_read_fifo(short *gyro, short *accel, long *quat,
     if (dmp.feature_mask & (DMP_FEATURE_TAP | DMP_FEATURE_ANDROID_ORIENT))
         decode_gesture(fifo_data + ii);
 
+    dmp_fifo_consume(dmp.packet_length);
+    fifo_stats.packets++;
     get_ms(timestamp);
     return 0;
 }
 
+/**
+ *  @brief      Get the FIFO integrity counters.
+ *  @param[out] stats   Counters since power up or dmp_reset_fifo_stats.
+ *  @return     0 if successful.
+ */
+int dmp_get_fifo_stats(struct dmp_fifo_stats_s *stats)
+{
+    *stats = fifo_stats;
+    stats->resets = mpu_get_fifo_reset_count() - fifo_reset_base;
+    return 0;
+}
+
+/**
+ *  @brief      Clear the FIFO integrity counters.
+ *  @return     0 if successful.
+ */
+int dmp_reset_fifo_stats(void)
+{
+    memset(&fifo_stats, 0, sizeof(fifo_stats));
+    fifo_reset_base = mpu_get_fifo_reset_count();
+    return 0;
+}
+
 /**
  *  @brief      Register a function to be executed on a tap event.
  *  The tap direction is represented by one of the following:
@@ -49,8 +49,18 @@
 
 #define INV_WXYZ_QUAT       (0x100)
 
+/* FIFO integrity counters, see dmp_get_fifo_stats. */
+struct dmp_fifo_stats_s {
+    unsigned long packets;  /* Packets parsed. */
+    unsigned long drops;    /* Packets discarded as corrupted. */
+    unsigned long resyncs;  /* Realigned on a packet boundary, no reset. */
+    unsigned long resets;   /* FIFO resets, buffered samples lost. */
+    unsigned long skipped;  /* Bytes skipped while realigning. */
+};
+
 /* Set up functions. */
 int dmp_load_motion_driver_firmware(void);
+int dmp_load_motion_driver_firmware_step(unsigned char first);
 int dmp_set_fifo_rate(unsigned short rate);
 int dmp_get_fifo_rate(unsigned short *rate);
 int dmp_enable_feature(unsigned short mask);
@@ -92,6 +102,8 @@ int dmp_enable_gyro_cal(unsigned char enable);
  */
 int dmp_read_fifo(short *gyro, short *accel, long *quat,
     unsigned long *timestamp, short *sensors, unsigned char *more);
+int dmp_get_fifo_stats(struct dmp_fifo_stats_s *stats);
+int dmp_reset_fifo_stats(void);
 
 #endif  /* #ifndef _INV_MPU_DMP_MOTION_DRIVER_H_ */
 
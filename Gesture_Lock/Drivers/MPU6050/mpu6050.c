@@ -1,4 +1,6 @@
 #include "mpu6050.h"
+#include "imu_pre.h"
+#include "fusion.h"
  
 //////////////////////////////////////////////////////////////////////////////////	 
 //ֻѧϰʹãδɣκ;
@@ -131,11 +133,11 @@ u8 MPU_Get_Accelerometer(short *ax,short *ay,short *az)
 //IICд
 //addr:ַ 
 //reg:Ĵַ
-//len:д볤
+//len:д볤(ɳ255,DMP̼д)
 //buf:
 //ֵ:0,
 //    ,
-u8 MPU_Write_Len(u8 addr,u8 reg,u8 len,u8 *buf)
+u8 MPU_Write_Len(u8 addr,u8 reg,u16 len,u8 *buf)
 {
 	/*
 	u8 i; 
@@ -160,19 +162,19 @@ u8 MPU_Write_Len(u8 addr,u8 reg,u8 len,u8 *buf)
     MPU_IIC_Stop();	 
 	return 0;	
 	*/
-	if(HAL_I2C_Mem_Write(&I2Cx, MPU_ADDR, reg, 1, buf, len, i2c_timeout) == HAL_OK){
-		return 0;
-	}
-	else return 1;
+	HAL_StatusTypeDef status;
+	status=HAL_I2C_Mem_Write(&I2Cx, MPU_ADDR, reg, 1, buf, len, i2c_timeout);
+	MPU_Bus_Record(0,status,len);//ͳ
+	return status==HAL_OK?0:1;
 } 
 //IIC
 //addr:ַ
 //reg:ҪȡļĴַ
-//len:Ҫȡĳ
+//len:Ҫȡĳ(ɳ255,DMP̼У)
 //buf:ȡݴ洢
 //ֵ:0,
 //    ,
-u8 MPU_Read_Len(u8 addr,u8 reg,u8 len,u8 *buf)
+u8 MPU_Read_Len(u8 addr,u8 reg,u16 len,u8 *buf)
 { 
 	/*
  	MPU_IIC_Start(); 
@@ -197,11 +199,10 @@ u8 MPU_Read_Len(u8 addr,u8 reg,u8 len,u8 *buf)
     MPU_IIC_Stop();	//һֹͣ 
 	return 0;	
 	*/
-	
-	if(HAL_I2C_Mem_Read(&I2Cx, MPU_ADDR, reg, 1, buf, len, i2c_timeout) == HAL_OK){
-		return 0;
-	}
-	else return 1;
+	HAL_StatusTypeDef status;
+	status=HAL_I2C_Mem_Read(&I2Cx, MPU_ADDR, reg, 1, buf, len, i2c_timeout);
+	MPU_Bus_Record(1,status,len);//ͳ
+	return status==HAL_OK?0:1;
 }
 //IICдһֽ 
 //reg:Ĵַ
@@ -229,14 +230,14 @@ u8 MPU_Write_Byte(u8 reg,u8 data)
     MPU_IIC_Stop();	 
 	return 0;
 	*/
-	if(HAL_I2C_Mem_Write(&I2Cx, MPU_ADDR, reg, 1, &data, 1, i2c_timeout) == HAL_OK){
-		return 0;
-	}
-	else return 1;
+	HAL_StatusTypeDef status;
+	status=HAL_I2C_Mem_Write(&I2Cx, MPU_ADDR, reg, 1, &data, 1, i2c_timeout);
+	MPU_Bus_Record(0,status,1);//ͳ
+	return status==HAL_OK?0:1;
 }
 //IICһֽ 
 //reg:Ĵַ 
-//ֵ:
+//ֵ:,ʧʱΪ0(ͳ)
 u8 MPU_Read_Byte(u8 reg)
 {
 	/*
@@ -253,9 +254,12 @@ u8 MPU_Read_Byte(u8 reg)
     MPU_IIC_Stop();			//һֹͣ 
 	return res;		
 	*/
-	u8 res;
+	u8 res=0;
+	HAL_StatusTypeDef status;
 	//HAL_I2C_Mem_Write(I2Cx, MPU6050_ADDR, PWR_MGMT_1_REG, 1, &Data, 1, i2c_timeout);
-	HAL_I2C_Mem_Read(&I2Cx, MPU_ADDR, reg, 1, &res, 1, i2c_timeout);
+	status=HAL_I2C_Mem_Read(&I2Cx, MPU_ADDR, reg, 1, &res, 1, i2c_timeout);
+	MPU_Bus_Record(1,status,1);//ͳ
+	if(status!=HAL_OK)res=0;
 	return res;
 }
 
@@ -263,22 +267,49 @@ u8 MPU_Read_Byte(u8 reg)
 /**
  *  @brief      Update data from MPU6050.
  *  @param[out] MPU    MPU6050_t data structure.
- *  @return     0 if successful.
+ *  @return     0 if successful, 1 if no data or the bus is
+ *              being recovered.
  */
 
 
 u8 MPU_Update(MPU_Data_t *mpu){
+	int16_t acc[3], gyro[3];
+	float m[ImuPreCh];
+	
+	if(!MPU_Bus_Ready())return 1;//recovery runs in the main loop
+#if FusionEnable
+	if(mpu_raw_get_data(mpu)==0)//raw FIFO sample, no DMP image loaded
+		{
+			Fusion_Update(&(mpu->Accel_X_RAW), &(mpu->Gyro_X_RAW));
+			mpu->q[0] = fusion.q[0];
+			mpu->q[1] = fusion.q[1];
+			mpu->q[2] = fusion.q[2];
+			mpu->q[3] = fusion.q[3];
+			Fusion_Euler(fusion.q, &(mpu->pitch), &(mpu->roll), &(mpu->yaw));
+#else
 	if(mpu_dmp_get_data(mpu)==0)
 		{
 			MPU_Get_Accelerometer(&(mpu->Accel_X_RAW),&(mpu->Accel_Y_RAW),&(mpu->Accel_Z_RAW));	//õٶȴ
 			MPU_Get_Gyroscope(&(mpu->Gyro_X_RAW),&(mpu->Gyro_Y_RAW),&(mpu->Gyro_Z_RAW));	//õ
+#endif
 			
-			mpu->Ax = mpu->Accel_X_RAW / 8192.0 +2*(mpu->q[0]*mpu->q[2]-mpu->q[1]*mpu->q[3]);//value depends on the scale
-			mpu->Ay = mpu->Accel_Y_RAW / 8192.0 -2*(mpu->q[2]*mpu->q[3]+mpu->q[0]*mpu->q[1]);
-			mpu->Az = mpu->Accel_Z_RAW / 8192.0 -1+2*(mpu->q[1]*mpu->q[1]+mpu->q[2]*mpu->q[2]);
-			mpu->Gx = mpu->Gyro_X_RAW / 131.0;
-			mpu->Gy = mpu->Gyro_Y_RAW / 131.0;
-			mpu->Gz = mpu->Gyro_Z_RAW / 131.0;
+			acc[0] = mpu->Accel_X_RAW;
+			acc[1] = mpu->Accel_Y_RAW;
+			acc[2] = mpu->Accel_Z_RAW;
+			gyro[0] = mpu->Gyro_X_RAW;
+			gyro[1] = mpu->Gyro_Y_RAW;
+			gyro[2] = mpu->Gyro_Z_RAW;
+			//the threshold detector gets every sample from the float path, the
+			//feature window the Q15 chain (imu_pre.c) on full blocks
+			Imu_Pre_Motion(acc, gyro, mpu->q, m);
+			mpu->Ax = m[0];//gravity removed, g
+			mpu->Ay = m[1];
+			mpu->Az = m[2];
+			mpu->Gx = m[3];//deg/s
+			mpu->Gy = m[4];
+			mpu->Gz = m[5];
+			Imu_Pre_Push(acc, gyro, mpu->q);
+			if(imu_pre.n >= ImuPreBlock) Imu_Pre_Run();
 			mpu->UpdateFlag = 1;
 			
 			return 0;
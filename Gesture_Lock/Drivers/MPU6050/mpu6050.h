@@ -7,6 +7,7 @@
 #include "delay.h"
 #include "usart.h" 
 #include "inv_mpu.h"
+#include "mpubus.h"
 
   
 //#define MPU_ACCEL_OFFS_REG		0X06	//accel_offsĴ,ɶȡ汾,Ĵֲδᵽ
@@ -121,8 +122,8 @@ typedef struct {
 #endif
 
 u8 MPU_Init(void); 								//ʼMPU6050
-u8 MPU_Write_Len(u8 addr,u8 reg,u8 len,u8 *buf);//IICд
-u8 MPU_Read_Len(u8 addr,u8 reg,u8 len,u8 *buf); //IIC 
+u8 MPU_Write_Len(u8 addr,u8 reg,u16 len,u8 *buf);//IICд
+u8 MPU_Read_Len(u8 addr,u8 reg,u16 len,u8 *buf); //IIC 
 u8 MPU_Write_Byte(u8 reg,u8 data);				//IICдһֽ
 u8 MPU_Read_Byte(u8 reg);						//IICһֽ
 
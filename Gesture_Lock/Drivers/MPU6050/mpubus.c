@@ -0,0 +1,234 @@
+/**
+  ******************************************************************************
+  * File Name          : mpubus.c
+  * Description        : This file provides code for the MPU6050 I2C bus health
+	*											 monitor. Every transaction is counted, a run of
+	*											 failures puts the bus in fault and MPU_Bus_Poll()
+	*											 recovers it from the main loop: SCL clock-out, probe,
+	*											 then FIFO resync or a full restart, retried with
+	*											 exponential backoff. The sampling ISR only checks
+	*											 MPU_Bus_Ready() and never waits for the recovery.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mpubus.h"
+#include "mpu6050.h"
+#include "inv_mpu.h"
+#include "i2c.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define MPU_WHO_AM_I			0x68
+#define MPU_PWR_SLEEP			0x40
+#define MPU_USER_DMP_FIFO	0xC0	//DMP_EN | FIFO_EN
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct{
+	volatile MPU_Bus_State_t	state;
+	volatile uint8_t					resync;		//FIFO reset requested
+	uint8_t										err_cnt;	//consecutive failed transactions
+	uint16_t									backoff_ms;
+	uint32_t									retry_tick;
+	uint8_t										(*restart)(void);
+} MPU_Bus_Ctrl_t;
+
+/* Private variables ---------------------------------------------------------*/
+volatile MPU_Bus_Stats_t	mpu_bus_stats;
+MPU_Bus_Ctrl_t						mpu_bus = {MPU_BUS_OK, 0, 0, MPU_BUS_BACKOFF_MIN, 0, 0};
+/* Private function prototypes -----------------------------------------------*/
+void MPU_Bus_Backoff(void);
+int MPU_Bus_Probe(void);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Bus monitor initialize
+	*	@param	restart		configures MPU6050 and DMP from scratch one
+	*										step per call, returns 0 when done, 2 to be
+	*										called again, 1 on failure. Called by the
+	*										recovery when the device lost its configuration,
+	*										once per MPU_Bus_Poll(): a step may not wait on
+	*										the device (mpu_init_step()), and at run time it
+	*										may only configure the device and write the
+	*										cached calibration back, no self test, flash
+	*										erase or key (MPU_Restart() in main.c).
+  * @retval None
+  */
+void MPU_Bus_Init(uint8_t (*restart)(void)){
+	mpu_bus.state = MPU_BUS_OK;
+	mpu_bus.resync = 0;
+	mpu_bus.err_cnt = 0;
+	mpu_bus.backoff_ms = MPU_BUS_BACKOFF_MIN;
+	mpu_bus.restart = restart;
+}
+
+/**
+  * @brief  Account one I2C transaction, called by MPU_Write_Len and
+	*					friends with the HAL status. MPU_BUS_ERR_LIMIT failures
+	*					in a row put the bus in fault.
+	*	@param	rd			1: read, 0: write
+	*	@param	status	HAL status of the transaction
+	*	@param	len			data bytes
+  * @retval None
+  */
+void MPU_Bus_Record(uint8_t rd, HAL_StatusTypeDef status, uint16_t len){
+	uint32_t err;
+
+	if(status == HAL_OK){
+		if(rd){
+			mpu_bus_stats.rd_ok++;
+			mpu_bus_stats.rd_bytes += len;
+		}
+		else{
+			mpu_bus_stats.wr_ok++;
+			mpu_bus_stats.wr_bytes += len;
+		}
+		mpu_bus.err_cnt = 0;
+		return;
+	}
+
+	if(rd) mpu_bus_stats.rd_err++;
+	else mpu_bus_stats.wr_err++;
+	if(status == HAL_BUSY){
+		mpu_bus_stats.err_busy++;
+	}
+	else{
+		err = HAL_I2C_GetError(&hi2c1);
+		if(status == HAL_TIMEOUT || (err & HAL_I2C_ERROR_TIMEOUT)) mpu_bus_stats.err_timeout++;
+		if(err & HAL_I2C_ERROR_AF) mpu_bus_stats.err_nack++;
+		if(err & (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO | HAL_I2C_ERROR_OVR)) mpu_bus_stats.err_bus++;
+	}
+	if(++mpu_bus.err_cnt >= MPU_BUS_ERR_LIMIT){
+		MPU_Bus_Fault();
+	}
+}
+
+/**
+  * @brief  Put the bus in fault, MPU_Bus_Poll() starts the recovery
+  * @retval None
+  */
+void MPU_Bus_Fault(void){
+	if(mpu_bus.state != MPU_BUS_OK) return;
+	mpu_bus_stats.faults++;
+	mpu_bus.state = MPU_BUS_FAULT;
+}
+
+/**
+  * @brief  Ask for a FIFO reset, e.g. after a FIFO read was cut short and
+	*					the packet boundary is lost. Done by MPU_Bus_Poll().
+  * @retval None
+  */
+void MPU_Bus_Request_Resync(void){
+	mpu_bus.resync = 1;
+}
+
+/**
+  * @brief  Can the sampling path use the bus
+  * @retval 1: ready
+	*					0: recovery or resync pending, skip this sample
+  */
+uint8_t MPU_Bus_Ready(void){
+	return mpu_bus.state == MPU_BUS_OK && !mpu_bus.resync;
+}
+
+/**
+  * @brief  schedule the next recovery attempt, delay doubles up to
+	*					MPU_BUS_BACKOFF_MAX
+  * @retval None
+  */
+void MPU_Bus_Backoff(void){
+	mpu_bus.retry_tick = HAL_GetTick();
+	mpu_bus.state = MPU_BUS_BACKOFF;
+}
+
+/**
+  * @brief  check the device answers and still runs the DMP
+  * @retval int
+	*					0: answers, DMP and FIFO enabled
+	*					1: answers, configuration lost
+	*				 -1: no answer
+  */
+int MPU_Bus_Probe(void){
+	u8 who, pwr, user;
+
+	if(MPU_Read_Len(MPU_ADDR, MPU_DEVICE_ID_REG, 1, &who)) return -1;
+	if(who != MPU_WHO_AM_I) return -1;
+	if(MPU_Read_Len(MPU_ADDR, MPU_PWR_MGMT1_REG, 1, &pwr)) return -1;
+	if(MPU_Read_Len(MPU_ADDR, MPU_USER_CTRL_REG, 1, &user)) return -1;
+	if((pwr & MPU_PWR_SLEEP) || (user & MPU_USER_DMP_FIFO) != MPU_USER_DMP_FIFO) return 1;
+	return 0;
+}
+
+/**
+  * @brief  Run one step of the bus recovery, call from the main loop.
+	*					Never blocks longer than one clock-out or one step of
+	*					the restart.
+  * @retval bus state after this step
+  */
+MPU_Bus_State_t MPU_Bus_Poll(void){
+	int res;
+
+	switch(mpu_bus.state){
+		case MPU_BUS_OK:
+			if(mpu_bus.resync){
+				if(mpu_reset_fifo()){
+					MPU_Bus_Fault();
+					break;
+				}
+				mpu_bus_stats.fifo_resyncs++;
+				mpu_bus.resync = 0;
+			}
+			break;
+
+		case MPU_BUS_BACKOFF:
+			if(HAL_GetTick() - mpu_bus.retry_tick < mpu_bus.backoff_ms) break;
+			if(mpu_bus.backoff_ms < MPU_BUS_BACKOFF_MAX){
+				mpu_bus.backoff_ms *= 2;
+				if(mpu_bus.backoff_ms > MPU_BUS_BACKOFF_MAX) mpu_bus.backoff_ms = MPU_BUS_BACKOFF_MAX;
+			}
+			mpu_bus.state = MPU_BUS_FAULT;
+			break;
+
+		case MPU_BUS_FAULT:
+			mpu_bus_stats.recoveries++;
+			if(I2C1_Bus_Clear()){
+				mpu_bus_stats.clear_fail++;
+				MPU_Bus_Backoff();
+				break;
+			}
+			res = MPU_Bus_Probe();
+			if(res < 0){
+				MPU_Bus_Backoff();
+			}
+			else if(res > 0){
+				mpu_bus.state = MPU_BUS_RESTART;
+			}
+			else{
+				/* only the bus was lost, a transfer may have been cut mid packet */
+				mpu_bus.resync = 1;
+				mpu_bus.err_cnt = 0;
+				mpu_bus.backoff_ms = MPU_BUS_BACKOFF_MIN;
+				mpu_bus.state = MPU_BUS_OK;
+			}
+			break;
+
+		case MPU_BUS_RESTART:
+			/* device reset, DMP image check and cached biases, no calibration */
+			res = mpu_bus.restart ? mpu_bus.restart() : 1;
+			if(res == 2) break;
+			if(res){
+				MPU_Bus_Backoff();
+				break;
+			}
+			mpu_bus_stats.restarts++;
+			mpu_bus.resync = 0;
+			mpu_bus.err_cnt = 0;
+			mpu_bus.backoff_ms = MPU_BUS_BACKOFF_MIN;
+			mpu_bus.state = MPU_BUS_OK;
+			break;
+	}
+	return mpu_bus.state;
+}
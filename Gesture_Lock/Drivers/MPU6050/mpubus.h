@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * File Name          : mpubus.h
+  * Description        : This file provides code for the MPU6050 I2C bus health
+	*											 monitor: per-transaction error counters and the
+	*											 non-blocking bus recovery state machine.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __mpubus_H
+#define __mpubus_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define MPU_BUS_ERR_LIMIT		3			//consecutive failed transactions to declare a fault
+#define MPU_BUS_BACKOFF_MIN	10		//ms, first retry delay
+#define MPU_BUS_BACKOFF_MAX	1000	//ms, retry delay cap
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	MPU_BUS_OK = 0,
+	MPU_BUS_FAULT,			//recovery pending
+	MPU_BUS_BACKOFF,		//waiting for the next attempt
+	MPU_BUS_RESTART,		//bus is back, device must be configured again
+} MPU_Bus_State_t;
+
+typedef struct{
+	uint32_t	wr_ok;
+	uint32_t	wr_err;
+	uint32_t	rd_ok;
+	uint32_t	rd_err;
+	uint32_t	wr_bytes;
+	uint32_t	rd_bytes;
+	uint32_t	err_timeout;	//HAL_TIMEOUT
+	uint32_t	err_busy;			//HAL_BUSY, usually a stuck bus
+	uint32_t	err_nack;			//HAL_I2C_ERROR_AF
+	uint32_t	err_bus;			//HAL_I2C_ERROR_BERR / ARLO / OVR
+	uint32_t	faults;				//MPU_BUS_ERR_LIMIT reached
+	uint32_t	recoveries;		//recovery attempts
+	uint32_t	clear_fail;		//SDA still low after clock-out
+	uint32_t	restarts;			//device configured again after recovery
+	uint32_t	fifo_resyncs;	//FIFO reset to realign packets
+} MPU_Bus_Stats_t;
+/* Exported constants --------------------------------------------------------*/
+extern volatile MPU_Bus_Stats_t mpu_bus_stats;
+/* Exported functions prototypes ---------------------------------------------*/
+void MPU_Bus_Init(uint8_t (*restart)(void));
+void MPU_Bus_Record(uint8_t rd, HAL_StatusTypeDef status, uint16_t len);
+void MPU_Bus_Fault(void);
+void MPU_Bus_Request_Resync(void);
+uint8_t MPU_Bus_Ready(void);
+MPU_Bus_State_t MPU_Bus_Poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__mpubus_H */
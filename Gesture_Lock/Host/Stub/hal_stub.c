@@ -0,0 +1,226 @@
+/**
+  ******************************************************************************
+  * File Name          : hal_stub.c
+  * Description        : Host stand-in for the HAL parts every test needs:
+	*											 virtual time (HAL_GetTick, HAL_Delay, delay_ms move
+	*											 host_tick, nothing sleeps), GPIO as port variables,
+	*											 NVIC as no-ops and flash sectors 4..6 mapped at their
+	*											 device addresses, so the (Calib_Data_t*)CalibFlashAddr
+	*											 style pointers of the firmware work unchanged. An
+	*											 erase takes the typical sector erase time of the F411
+	*											 in virtual time. Host_Irq_Start() gives a race test
+	*											 a real asynchronous interrupt: SIGALRM runs its
+	*											 handler at any instruction of the main code, or when
+	*											 PRIMASK is cleared if it was set.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define HostFlashBase		0x08010000UL	//sector 4
+#define HostFlashSize		0x50000UL			//sectors 4, 5, 6
+
+/* Private variables ---------------------------------------------------------*/
+GPIO_TypeDef		host_gpio[3];
+DWT_Type				host_dwt;
+CoreDebug_Type	host_core_debug;
+volatile uint32_t	host_primask;
+uint32_t				host_tick;
+uint32_t				host_flash_erases;
+uint8_t					host_flash_fail;
+uint8_t					host_flash_locked = 1;
+void						(*host_gpio_write)(GPIO_TypeDef *port, uint16_t pin);
+uint32_t				SystemCoreClock = 96000000;	//HSE 25 MHz, PLL as SystemClock_Config()
+
+static void			(*host_irq)(void);
+static volatile sig_atomic_t host_irq_pend;	//came while masked
+static uint32_t	host_irq_masked;
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Map the flash sectors before main(), erased
+  * @retval None
+  */
+__attribute__((constructor)) static void Host_Flash_Map(void){
+	void *p = mmap((void*)HostFlashBase, HostFlashSize, PROT_READ | PROT_WRITE,
+								 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if(p != (void*)HostFlashBase){
+		perror("flash sectors at 0x08010000");
+		exit(2);
+	}
+	memset(p, 0xFF, HostFlashSize);
+}
+
+uint32_t HAL_GetTick(void){
+	return host_tick;
+}
+
+void HAL_Delay(uint32_t ms){
+	host_tick += ms;
+}
+
+void delay_ms(uint16_t ms){
+	host_tick += ms;
+}
+
+void delay_us(uint32_t us){
+	static uint32_t rest;
+	rest += us;
+	host_tick += rest / 1000;
+	rest %= 1000;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq){
+	(void)irq;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type irq){
+	(void)irq;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin){
+	return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state){
+	if(state == GPIO_PIN_SET) port->ODR |= pin;
+	else port->ODR &= ~(uint32_t)pin;
+	if(host_gpio_write) host_gpio_write(port, pin);
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init){
+	(void)port;
+	(void)init;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin){
+	port->ODR ^= pin;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void){
+	host_flash_locked = 0;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void){
+	host_flash_locked = 1;
+	return HAL_OK;
+}
+
+/**
+  * @brief  Program one byte or word, bits can only be cleared as on the
+	*					device
+  * @retval status
+  */
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uint32_t addr, uint64_t data){
+	uint32_t n = type == FLASH_TYPEPROGRAM_WORD ? 4 : 1;
+	uint8_t *p = (uint8_t*)(uintptr_t)addr;
+	uint32_t i;
+
+	if(host_flash_fail || host_flash_locked || addr < HostFlashBase || addr + n > HostFlashBase + HostFlashSize) return HAL_ERROR;
+	for(i=0;i<n;i++) p[i] &= (uint8_t)(data >> (8*i));
+	return HAL_OK;
+}
+
+/**
+  * @brief  Erase a sector: 64 KB sector 4 in 550 ms, 128 KB sectors in
+	*					1 s of virtual time (typical values of the F411)
+  * @retval None
+  */
+void FLASH_Erase_Sector(uint32_t sector, uint8_t range){
+	(void)range;
+	if(host_flash_locked) return;
+	host_flash_erases++;
+	if(sector == FLASH_SECTOR_4){
+		memset((void*)HostFlashBase, 0xFF, 0x10000);
+		host_tick += 550;
+	}
+	else if(sector == FLASH_SECTOR_5 || sector == FLASH_SECTOR_6){
+		memset((void*)(uintptr_t)(0x08020000UL + (sector - FLASH_SECTOR_5) * 0x20000UL), 0xFF, 0x20000);
+		host_tick += 1000;
+	}
+}
+
+HAL_StatusTypeDef FLASH_WaitForLastOperation(uint32_t timeout){
+	(void)timeout;
+	return host_flash_fail ? HAL_ERROR : HAL_OK;
+}
+
+/**
+  * @brief  SIGALRM: the interrupt, or pending while PRIMASK is set. Equal
+	*					priority as on the device, the handler is not interrupted.
+  * @retval None
+  */
+static void Host_Irq_Signal(int sig){
+	(void)sig;
+	if(host_primask){
+		if(!host_irq_pend) host_irq_masked++;
+		host_irq_pend = 1;
+		return;
+	}
+	host_primask = 1;
+	host_irq_pend = 0;
+	host_irq();
+	host_primask = 0;
+}
+
+/**
+  * @brief  run an interrupt that came while masked, called by
+	*					__set_PRIMASK(0) and __enable_irq()
+  * @retval None
+  */
+void Host_Irq_Unmasked(void){
+	if(!host_irq_pend) return;
+	host_primask = 1;
+	while(__atomic_exchange_n(&host_irq_pend, 0, __ATOMIC_SEQ_CST)) host_irq();
+	host_primask = 0;
+}
+
+/**
+  * @brief  raise the interrupt handler every period of real time
+	*	@param	isr		handler
+	*	@param	us		period
+  * @retval None
+  */
+void Host_Irq_Start(void (*isr)(void), uint32_t us){
+	struct sigaction sa;
+	struct itimerval t;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = Host_Irq_Signal;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	host_irq = isr;
+	host_irq_masked = 0;
+	sigaction(SIGALRM, &sa, 0);
+	t.it_interval.tv_sec = 0;
+	t.it_interval.tv_usec = us;
+	t.it_value = t.it_interval;
+	setitimer(ITIMER_REAL, &t, 0);
+}
+
+/**
+  * @brief  stop the interrupt
+  * @retval times it came while PRIMASK was set
+  */
+uint32_t Host_Irq_Stop(void){
+	struct itimerval t;
+
+	memset(&t, 0, sizeof(t));
+	setitimer(ITIMER_REAL, &t, 0);
+	signal(SIGALRM, SIG_IGN);
+	host_irq_pend = 0;
+	return host_irq_masked;
+}
@@ -0,0 +1,31 @@
+/**
+  ******************************************************************************
+  * File Name          : serial_debug.h
+  * Description        : Host stand-in for Inc/serial_debug.h without the
+	*											 printf retarget and the USB stack: the plot and
+	*											 stream calls of Src/serial_debug.c, defined by the
+	*											 test that needs them (sched_test.c).
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __serial_debug_H
+#define __serial_debug_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported functions prototypes ---------------------------------------------*/
+int Plot_Data(void);
+int Stream_Data(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__serial_debug_H */
@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * File Name          : stm32f4xx.h
+  * Description        : Host stand-in for the device header: core types, the
+	*											 GPIO ports, DWT and PRIMASK as plain variables so the
+	*											 application modules build natively. See hal_stub.c.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __stm32f4xx_H
+#define __stm32f4xx_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+/* Exported macro ------------------------------------------------------------*/
+#define __IO								volatile
+#define __I									volatile const
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE			static inline
+#endif
+#ifndef __weak
+#define __weak							__attribute__((weak))
+#endif
+#define UNUSED(x)						((void)(x))
+
+#define GPIOA								(&host_gpio[0])
+#define GPIOB								(&host_gpio[1])
+#define GPIOC								(&host_gpio[2])
+#define GPIOA_BASE					0x40020000UL
+#define GPIOB_BASE					0x40020400UL
+#define GPIOC_BASE					0x40020800UL
+#define GPIOD_BASE					0x40020C00UL
+#define GPIOE_BASE					0x40021000UL
+#define GPIOF_BASE					0x40021400UL
+#define GPIOG_BASE					0x40021800UL
+
+#define DWT									(&host_dwt)
+#define CoreDebug						(&host_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk					1UL
+#define CoreDebug_DEMCR_TRCENA_Msk			(1UL << 24)
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	EXTI0_IRQn = 6,
+	DMA1_Stream0_IRQn = 11,
+	TIM2_IRQn = 28,
+	I2C1_EV_IRQn = 31,
+	SPI1_IRQn = 35,
+	USART1_IRQn = 37,
+	DMA2_Stream3_IRQn = 59,
+	OTG_FS_IRQn = 67,
+	DMA2_Stream7_IRQn = 70,
+} IRQn_Type;
+
+typedef struct{
+	__IO uint32_t	IDR;						//input pins, set by the tests
+	__IO uint32_t	ODR;						//output pins, set by the code
+} GPIO_TypeDef;
+
+typedef struct{
+	__IO uint32_t	CTRL;
+	__IO uint32_t	CYCCNT;				//advanced by the tests, host_cycles()
+} DWT_Type;
+
+typedef struct{
+	__IO uint32_t	DEMCR;
+} CoreDebug_Type;
+/* Exported constants --------------------------------------------------------*/
+extern GPIO_TypeDef		host_gpio[3];
+extern DWT_Type				host_dwt;
+extern CoreDebug_Type	host_core_debug;
+extern volatile uint32_t	host_primask;
+extern uint32_t				SystemCoreClock;
+/* Exported functions prototypes ---------------------------------------------*/
+void Host_Irq_Unmasked(void);
+
+/* the memory clobbers keep the compiler from moving accesses out of a
+	 masked section, as the CMSIS intrinsics do */
+__STATIC_INLINE uint32_t __get_PRIMASK(void){ return host_primask; }
+__STATIC_INLINE void __set_PRIMASK(uint32_t m){
+	__asm__ volatile("" ::: "memory");
+	host_primask = m;
+	if(!m) Host_Irq_Unmasked();
+}
+__STATIC_INLINE void __disable_irq(void){
+	host_primask = 1;
+	__asm__ volatile("" ::: "memory");
+}
+__STATIC_INLINE void __enable_irq(void){
+	__asm__ volatile("" ::: "memory");
+	host_primask = 0;
+	Host_Irq_Unmasked();
+}
+__STATIC_INLINE void __DSB(void){ __sync_synchronize(); }
+__STATIC_INLINE void __DMB(void){ __sync_synchronize(); }
+__STATIC_INLINE void __NOP(void){}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__stm32f4xx_H */
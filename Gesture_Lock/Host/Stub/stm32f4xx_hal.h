@@ -0,0 +1,159 @@
+/**
+  ******************************************************************************
+  * File Name          : stm32f4xx_hal.h
+  * Description        : Host stand-in for the HAL: the types, constants and
+	*											 calls the application modules use. Time, GPIO, NVIC
+	*											 and flash are in hal_stub.c; I2C, UART and SPI are
+	*											 defined by the mock of each test (mpu_emu.c, ...).
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __stm32f4xx_hal_H
+#define __stm32f4xx_hal_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx.h"
+/* Exported macro ------------------------------------------------------------*/
+#define GPIO_PIN_0					0x0001U
+#define GPIO_PIN_1					0x0002U
+#define GPIO_PIN_2					0x0004U
+#define GPIO_PIN_3					0x0008U
+#define GPIO_PIN_4					0x0010U
+#define GPIO_PIN_5					0x0020U
+#define GPIO_PIN_6					0x0040U
+#define GPIO_PIN_7					0x0080U
+#define GPIO_PIN_8					0x0100U
+#define GPIO_PIN_9					0x0200U
+#define GPIO_PIN_10					0x0400U
+#define GPIO_PIN_13					0x2000U
+#define GPIO_MODE_OUTPUT_PP			0x01U
+#define GPIO_NOPULL					0x00U
+#define GPIO_SPEED_FREQ_VERY_HIGH	0x03U
+
+#define HAL_I2C_ERROR_NONE		0x00U
+#define HAL_I2C_ERROR_BERR		0x01U
+#define HAL_I2C_ERROR_ARLO		0x02U
+#define HAL_I2C_ERROR_AF			0x04U
+#define HAL_I2C_ERROR_OVR			0x08U
+#define HAL_I2C_ERROR_TIMEOUT	0x20U
+
+#define FLASH_SECTOR_4				4U
+#define FLASH_SECTOR_5				5U
+#define FLASH_SECTOR_6				6U
+#define FLASH_VOLTAGE_RANGE_3	2U
+#define FLASH_TYPEPROGRAM_BYTE	0U
+#define FLASH_TYPEPROGRAM_WORD	2U
+
+#define __HAL_TIM_SET_AUTORELOAD(h, v)	((h)->ARR = (v))
+#define __HAL_GPIO_EXTI_CLEAR_IT(pin)		((void)(pin))
+#define __HAL_LINKDMA(h, f, d)					((h)->f = &(d), (d).Parent = (h))
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	HAL_OK = 0,
+	HAL_ERROR,
+	HAL_BUSY,
+	HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef enum{
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef enum{
+	HAL_SPI_STATE_RESET = 0,
+	HAL_SPI_STATE_READY,
+	HAL_SPI_STATE_BUSY_TX
+} HAL_SPI_StateTypeDef;
+
+typedef enum{
+	HAL_UART_STATE_RESET = 0,
+	HAL_UART_STATE_READY = 0x20,
+	HAL_UART_STATE_BUSY_TX = 0x21
+} HAL_UART_StateTypeDef;
+
+typedef struct{
+	uint32_t	Pin;
+	uint32_t	Mode;
+	uint32_t	Pull;
+	uint32_t	Speed;
+	uint32_t	Alternate;
+} GPIO_InitTypeDef;
+
+typedef struct{
+	void			*Parent;
+} DMA_HandleTypeDef;
+
+typedef struct{
+	uint32_t	ErrorCode;
+} I2C_HandleTypeDef;
+
+typedef struct{
+	HAL_UART_StateTypeDef	gState;
+	DMA_HandleTypeDef			*hdmatx;
+} UART_HandleTypeDef;
+
+typedef struct{
+	HAL_SPI_StateTypeDef	State;
+	DMA_HandleTypeDef			*hdmatx;
+} SPI_HandleTypeDef;
+
+typedef struct{
+	uint32_t	ARR;
+} TIM_HandleTypeDef;
+/* Exported constants --------------------------------------------------------*/
+extern uint32_t	host_tick;				//ms, HAL_GetTick()
+extern uint32_t	host_flash_erases;	//sector erases, each advances host_tick
+extern uint8_t	host_flash_fail;		//erase and program fail while set
+extern uint8_t	host_flash_locked;	//HAL_FLASH_Lock() state
+extern void			(*host_gpio_write)(GPIO_TypeDef *port, uint16_t pin);	//set by a mock to watch output pins
+/* Exported functions prototypes ---------------------------------------------*/
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t ms);
+void Host_Irq_Start(void (*isr)(void), uint32_t us);
+uint32_t Host_Irq_Stop(void);
+void HAL_NVIC_EnableIRQ(IRQn_Type irq);
+void HAL_NVIC_DisableIRQ(IRQn_Type irq);
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin);
+void HAL_GPIO_EXTI_Callback(uint16_t pin);
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uint32_t addr, uint64_t data);
+void FLASH_Erase_Sector(uint32_t sector, uint8_t range);
+HAL_StatusTypeDef FLASH_WaitForLastOperation(uint32_t timeout);
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *h, uint16_t dev, uint16_t reg, uint16_t reg_size, uint8_t *buf, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *h, uint16_t dev, uint16_t reg, uint16_t reg_size, uint8_t *buf, uint16_t len, uint32_t timeout);
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *h);
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *h, uint8_t *buf, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *h, uint8_t *buf, uint16_t len);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *h);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *h);
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *h);
+HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef *h);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *h, uint8_t *buf, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *h, uint8_t *buf, uint16_t len);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *h);
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *h);
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *h);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__stm32f4xx_hal_H */
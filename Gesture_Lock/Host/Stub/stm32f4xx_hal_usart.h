@@ -0,0 +1,2 @@
+/* Host build: everything is in the stub stm32f4xx_hal.h */
+#include "stm32f4xx_hal.h"
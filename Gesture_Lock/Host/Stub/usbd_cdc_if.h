@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * File Name          : usbd_cdc_if.h
+  * Description        : Host stand-in for the USB device stack as the
+	*											 application modules see it: the device handle, its
+	*											 state and the CDC calls of Src/usbd_cdc_if.c. The
+	*											 calls are defined by the USB mock of each test
+	*											 (cdc_test.c, ...).
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_CDC_IF_H__
+#define __USBD_CDC_IF_H__
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define USBD_STATE_DEFAULT			0x01U		//usbd_def.h
+#define USBD_STATE_ADDRESSED		0x02U
+#define USBD_STATE_CONFIGURED		0x03U
+#define USBD_STATE_SUSPENDED		0x04U
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	USBD_OK = 0U,
+	USBD_BUSY,
+	USBD_FAIL
+} USBD_StatusTypeDef;
+
+typedef struct{
+	volatile uint8_t	dev_state;
+	void							*pClassData;
+} USBD_HandleTypeDef;
+/* Exported constants --------------------------------------------------------*/
+extern USBD_HandleTypeDef hUsbDeviceFS;
+/* Exported functions prototypes ---------------------------------------------*/
+uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
+uint8_t CDC_Tx_Idle(void);
+void CDC_Rx_Resume(uint8_t *Buf);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __USBD_CDC_IF_H__ */
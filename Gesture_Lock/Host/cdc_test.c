@@ -0,0 +1,339 @@
+/**
+  ******************************************************************************
+  * File Name          : cdc_test.c
+  * Description        : Host loopback test and bandwidth benchmark of the
+	*											 USB CDC stream (cdc_stream.c). The USB mock reads the
+	*											 IN transfers 64 bytes per packet, with a ZLP after a
+	*											 transfer that ends on a packet boundary, a set number
+	*											 of packets per 1 ms USB frame, and calls Cdc_Tx_Cplt()
+	*											 as USBD_CDC_DataIn() does. The benchmark streams
+	*											 CmdSample frames from the telemetry task at 100 to
+	*											 1000 Hz (FusionHzMax) and prints what gets through,
+	*											 the drops, the bytes per transfer, the ring high water
+	*											 mark and the latency. Then a host that stops reading,
+	*											 a link reset with a transfer in flight, and the
+	*											 transfer complete interrupt racing Cdc_Poll(). Every
+	*											 byte read is compared with the bytes Cdc_Write()
+	*											 accepted. Usage: cdc_test [seed [race ms]]
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cdc_stream.h"
+#include "usbd_cdc_if.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestBenchMs			5000
+#define TestFrameLen		35				//CmdSample: 0x00, COBS(cmd, seq, 28 bytes, crc16), 0x00
+#define TestExpMax			(4u << 20)
+#define TestFrameMax		(TestExpMax / TestFrameLen)
+#define TestIrqUs				20				//race test interrupt period
+#define TestIrqPkts			1					//packets the host reads per interrupt
+
+/* Private types -------------------------------------------------------------*/
+typedef struct{
+	uint32_t	tried;					//frames offered
+	uint32_t	queued;					//frames accepted by Cdc_Write()
+	uint32_t	bad;						//bytes read that differ from the accepted ones
+	uint32_t	lat_max;				//ms, frame written to its last byte read
+	uint64_t	lat_sum;
+	uint32_t	lat_n;
+} Test_Count_t;
+
+/* Private variables ---------------------------------------------------------*/
+USBD_HandleTypeDef	hUsbDeviceFS;
+
+static uint8_t					*usb_buf;
+static uint16_t					usb_len;			//bytes of the transfer in flight
+static uint16_t					usb_pos;			//bytes read by the host
+static volatile uint8_t	usb_busy;
+static uint32_t					usb_pkts;			//IN packets read, ZLPs included
+
+static uint8_t					exp_buf[TestExpMax];		//bytes accepted, in order
+static uint32_t					exp_len;
+static uint32_t					exp_tick[TestFrameMax];	//tick each frame was accepted at
+static uint32_t					rx_pos;				//bytes of exp_buf read, or skipped by a reset
+static Test_Count_t			cnt;
+static int							fails;
+/* Private user code ---------------------------------------------------------*/
+
+uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len){
+	if(usb_busy) return USBD_BUSY;
+	usb_buf = Buf;
+	usb_len = Len;
+	usb_pos = 0;
+	usb_busy = 1;
+	return USBD_OK;
+}
+
+uint8_t CDC_Tx_Idle(void){
+	return !usb_busy;
+}
+
+void CDC_Rx_Resume(uint8_t *Buf){
+}
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+/**
+  * @brief  the host reads one byte, checked against the accepted stream,
+	*					the latency taken on the last byte of a frame
+  * @retval None
+  */
+static void Test_Rx(uint8_t c){
+	uint32_t t;
+
+	if(rx_pos >= exp_len || c != exp_buf[rx_pos]) cnt.bad++;
+	rx_pos++;
+	if(rx_pos % TestFrameLen == 0 && rx_pos <= exp_len){
+		t = host_tick - exp_tick[rx_pos / TestFrameLen - 1];
+		cnt.lat_sum += t;
+		cnt.lat_n++;
+		if(t > cnt.lat_max) cnt.lat_max = t;
+	}
+}
+
+/**
+  * @brief  the host reads up to n IN packets. A short packet or the ZLP
+	*					after a full one ends the transfer: TxState is cleared and
+	*					the complete callback starts the next one at once.
+  * @retval None
+  */
+static void Test_Usb_Run(uint32_t n){
+	uint16_t k;
+
+	while(n-- && usb_busy){
+		usb_pkts++;
+		k = usb_len - usb_pos;
+		if(k > CdcPacketSize) k = CdcPacketSize;
+		while(k--) Test_Rx(usb_buf[usb_pos++]);
+		if(usb_pos < usb_len) continue;
+		if(usb_len % CdcPacketSize == 0 && usb_len != 0){
+			usb_len = 0;					//ZLP in the next packet
+			usb_pos = 0;
+			continue;
+		}
+		usb_busy = 0;
+		Cdc_Tx_Cplt();
+	}
+}
+
+/**
+  * @brief  offer one CmdSample sized frame, its bytes from the sequence
+  * @retval 0: queued, 1: dropped
+  */
+static uint8_t Test_Frame(void){
+	uint8_t f[TestFrameLen];
+	uint32_t seq = cnt.tried++, i;
+
+	f[0] = 0;
+	for(i=1;i<TestFrameLen-1;i++) f[i] = (uint8_t)(seq * 31 + i) | 1;
+	f[TestFrameLen-1] = 0;
+	if(Cdc_Write(f, TestFrameLen)) return 1;
+	if(exp_len + TestFrameLen <= TestExpMax){
+		memcpy(&exp_buf[exp_len], f, TestFrameLen);
+		exp_tick[exp_len / TestFrameLen] = host_tick;
+		exp_len += TestFrameLen;
+	}
+	cnt.queued++;
+	return 0;
+}
+
+static void Test_Reset(void){
+	hUsbDeviceFS.dev_state = USBD_STATE_CONFIGURED;
+	usb_busy = 0;
+	usb_pkts = 0;
+	Cdc_Init();
+	exp_len = 0;
+	rx_pos = 0;
+	memset(&cnt, 0, sizeof(cnt));
+}
+
+/**
+  * @brief  one ms: the USB frame, then the samples of the ms, each
+	*					followed by the telemetry task, and the storage task
+	*	@param	hz		sample rate, 0: none
+	*	@param	pkts	IN packets the host reads in the frame
+  * @retval None
+  */
+static void Test_Ms(uint32_t hz, uint32_t pkts){
+	static uint32_t acc;
+
+	host_tick++;
+	Test_Usb_Run(pkts);
+	acc += hz;
+	while(acc >= 1000){
+		acc -= 1000;
+		Test_Frame();
+		Cdc_Poll();
+	}
+	if(host_tick % 20 == 0) Cdc_Poll();
+}
+
+/**
+  * @brief  run without samples until everything accepted is read
+  * @retval None
+  */
+static void Test_Drain(uint32_t pkts){
+	uint32_t ms;
+	for(ms=0;ms<1000 && (usb_busy || cdc_stats.bytes != cdc_stats.sent + cdc_stats.lost);ms++){
+		Test_Ms(0, pkts);
+		Cdc_Poll();
+	}
+}
+
+/**
+  * @brief  the sample stream at hz for TestBenchMs
+	*	@param	hz		sample rate
+	*	@param	pkts	IN packets the host reads per ms
+  * @retval None
+  */
+static void Test_Bench(uint32_t hz, uint32_t pkts){
+	uint32_t ms, rate;
+	char what[96];
+
+	Test_Reset();
+	for(ms=0;ms<TestBenchMs;ms++){
+		Test_Ms(hz, pkts);
+		if(ms == TestBenchMs - 1) rate = cdc_stats.rate;
+	}
+	Test_Drain(pkts);
+	printf("%5u  %4u  %6u  %6u  %5.1f%%  %6.1f  %4u  %4.1f  %3u\n", (unsigned)hz, (unsigned)pkts,
+				 (unsigned)(cnt.tried * TestFrameLen * 1000ull / TestBenchMs), (unsigned)rate,
+				 cnt.tried ? 100.0 * (cnt.tried - cnt.queued) / cnt.tried : 0.0,
+				 cdc_stats.transfers ? (double)cdc_stats.sent / cdc_stats.transfers : 0.0,
+				 (unsigned)cdc_stats.fill_max, cnt.lat_n ? (double)cnt.lat_sum / cnt.lat_n : 0.0,
+				 (unsigned)cnt.lat_max);
+
+	snprintf(what, sizeof(what), "bench %u Hz, %u pkt/ms: bytes read differ", (unsigned)hz, (unsigned)pkts);
+	Test_Check(cnt.bad == 0 && rx_pos == exp_len, what);
+	snprintf(what, sizeof(what), "bench %u Hz, %u pkt/ms: drops not counted", (unsigned)hz, (unsigned)pkts);
+	Test_Check(cdc_stats.dropped == (cnt.tried - cnt.queued) * TestFrameLen, what);
+	if(hz * TestFrameLen <= pkts * CdcPacketSize * 1000 / 2){
+		snprintf(what, sizeof(what), "bench %u Hz, %u pkt/ms: drops or late frames", (unsigned)hz, (unsigned)pkts);
+		Test_Check(cnt.queued == cnt.tried && cnt.lat_max <= 5, what);
+	}
+}
+
+/**
+  * @brief  the host stops reading for a while, then the USB link is reset
+	*					with a transfer in flight, at 1000 Hz
+  * @retval None
+  */
+static void Test_Faults(void){
+	uint32_t ms, dropped, lost, skip;
+	char what[128];
+
+	Test_Reset();
+	for(ms=0;ms<500;ms++) Test_Ms(1000, 19);
+	for(ms=0;ms<500;ms++) Test_Ms(1000, 0);			//application not reading
+	for(ms=0;ms<10;ms++) Test_Ms(1000, 19);
+	dropped = cnt.tried - cnt.queued;
+	for(ms=0;ms<490;ms++) Test_Ms(1000, 19);
+	Test_Drain(19);
+	printf("\nhost stalled 500 ms: %u of %u frames dropped, ring high water %u, %u bytes differ\n",
+				 (unsigned)dropped, (unsigned)cnt.tried, (unsigned)cdc_stats.fill_max, (unsigned)cnt.bad);
+	Test_Check(dropped > 0 && cdc_stats.fill_max > CdcRingSize - TestFrameLen, "stalled host: ring never full");
+	Test_Check(cnt.bad == 0 && rx_pos == exp_len, "stalled host: bytes read differ");
+	Test_Check(cdc_stats.dropped == dropped * TestFrameLen, "stalled host: drops not counted");
+	Test_Check(cnt.tried - cnt.queued == dropped, "stalled host: drops 10 ms after the host reads again");
+
+	/* unplugged with a transfer half read: the rest of it is gone, the
+		 link comes back through CDC_Init_FS() */
+	Test_Reset();
+	for(ms=0;ms<200;ms++) Test_Ms(1000, 19);
+	for(ms=0;ms<20;ms++) Test_Ms(1000, 0);
+	for(ms=0;ms<1000 && (usb_pos < CdcPacketSize || usb_len - usb_pos < CdcPacketSize);ms++) Test_Ms(1000, 1);
+	skip = usb_len - usb_pos;
+	rx_pos += skip;
+	usb_busy = 0;
+	hUsbDeviceFS.dev_state = USBD_STATE_DEFAULT;
+	dropped = cnt.tried - cnt.queued;
+	for(ms=0;ms<50;ms++) Test_Ms(1000, 0);
+	dropped = cnt.tried - cnt.queued - dropped;
+	hUsbDeviceFS.dev_state = USBD_STATE_CONFIGURED;
+	lost = usb_len;
+	Cdc_Link_Reset();
+	for(ms=0;ms<200;ms++) Test_Ms(1000, 19);
+	Test_Drain(19);
+	printf("link reset: %u bytes in flight lost (%u unread), %u frames dropped while down, %u bytes differ\n",
+				 (unsigned)cdc_stats.lost, (unsigned)skip, (unsigned)dropped, (unsigned)cnt.bad);
+	snprintf(what, sizeof(what), "link reset: lost %u, %u in flight", (unsigned)cdc_stats.lost, (unsigned)lost);
+	Test_Check(cdc_stats.lost == lost, what);
+	Test_Check(dropped == 50, "link reset: frames accepted while the link is down");
+	Test_Check(cnt.bad == 0 && rx_pos == exp_len, "link reset: bytes read differ");
+	Test_Check(cdc_stats.bytes == cdc_stats.sent + cdc_stats.lost, "link reset: bytes sent and lost do not add up");
+}
+
+/* race test interrupt: the USB, completions start the next buffer */
+static volatile uint32_t irq_count;
+
+static void Test_Isr(void){
+	irq_count++;
+	Test_Usb_Run(TestIrqPkts);
+}
+
+/**
+  * @brief  frames written and Cdc_Poll() run from the main code while a
+	*					real asynchronous interrupt reads the packets and ends
+	*					the transfers
+	*	@param	ms		real time to run
+  * @retval None
+  */
+static void Test_Race(uint32_t ms){
+	struct timespec t0, t;
+	uint32_t loops = 0;
+
+	Test_Reset();
+	irq_count = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	Host_Irq_Start(Test_Isr, TestIrqUs);
+	do{
+		if(rand() % 8 == 0) Test_Frame();
+		Cdc_Poll();
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		loops++;
+	}while((t.tv_sec - t0.tv_sec) * 1000 + (t.tv_nsec - t0.tv_nsec) / 1000000 < (long)ms && exp_len < TestExpMax - 4096);
+	Host_Irq_Stop();
+	Test_Drain(19);
+
+	printf("\nrace: %u interrupts, %u transfers, %u of %u frames out, %u dropped, %u bytes differ\n",
+				 (unsigned)irq_count, (unsigned)cdc_stats.transfers, (unsigned)(rx_pos / TestFrameLen),
+				 (unsigned)cnt.tried, (unsigned)(cnt.tried - cnt.queued), (unsigned)cnt.bad);
+	Test_Check(cdc_stats.transfers > 1000, "race: too few transfers");
+	Test_Check(cnt.bad == 0 && rx_pos == exp_len, "race: bytes read differ");
+	Test_Check(cdc_stats.dropped == (cnt.tried - cnt.queued) * TestFrameLen, "race: drops not counted");
+}
+
+int main(int argc, char **argv){
+	static const uint32_t rates[] = {100, 200, 500, 1000};
+	static const uint32_t pkts[] = {1, 19};
+	unsigned seed = argc > 1 ? atoi(argv[1]) : 1;
+	uint32_t race_ms = argc > 2 ? atoi(argv[2]) : 1000, i, k;
+
+	srand(seed);
+	printf("CmdSample frames of %u bytes, %u s, host reading 1 or 19 packets per ms\n",
+				 (unsigned)TestFrameLen, (unsigned)(TestBenchMs / 1000));
+	printf("   Hz  pkts   offer    sent    drop  B/xfer  fill   lat  max  (B/s, ms)\n");
+	for(k=0;k<sizeof(pkts)/sizeof(pkts[0]);k++){
+		for(i=0;i<sizeof(rates)/sizeof(rates[0]);i++) Test_Bench(rates[i], pkts[k]);
+	}
+
+	Test_Faults();
+	Test_Race(race_ms);
+
+	printf("\n%s\n", fails ? "FAILED" : "cdc stream checks passed");
+	return fails != 0;
+}
@@ -0,0 +1,547 @@
+/**
+  ******************************************************************************
+  * File Name          : cmd_test.c
+  * Description        : Host test, fuzzer and round trip benchmark of the
+	*											 framed command protocol (cmd.c) over the USB CDC
+	*											 stream (cdc_stream.c). The USB mock delivers OUT
+	*											 packets as CDC_Receive_FS() does, into the buffer
+	*											 Cmd_Rx() returned and only while the endpoint is not
+	*											 held, and reads the IN transfers back 64 bytes per
+	*											 packet. COBS is checked against a reference coder on
+	*											 random and hostile input, the receiver is fed valid
+	*											 frames mixed with garbage, overlong runs and bad CRCs
+	*											 in packets of random size, the lock is checked on
+	*											 every command that needs it, and pings of 0 to 128
+	*											 bytes are timed in 1 ms USB frames for the rates the
+	*											 scheduler runs Cmd_Poll() at.
+	*											 Usage: cmd_test [seed [fuzz bytes]]
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cmd.h"
+#include "cdc_stream.h"
+#include "usbd_cdc_if.h"
+#include "param.h"
+#include "telemetry.h"
+#include "key.h"
+#include "mpu6050.h"
+#include "mpubus.h"
+#include "state_machine.h"
+#include "sched.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestCobsMax			600				//longest fuzzed COBS input
+#define TestTxMax				(1u << 16)	//host to device bytes waiting
+#define TestReplyMax		(1u << 13)
+#define TestRttPings		200
+
+/* Private types -------------------------------------------------------------*/
+typedef struct{
+	uint8_t		cmd;
+	uint8_t		seq;
+	uint8_t		len;
+	uint8_t		data[CmdPayloadMax];
+} Test_Reply_t;
+
+/* Private variables ---------------------------------------------------------*/
+USBD_HandleTypeDef			hUsbDeviceFS;
+MPU_Data_t							mpu_data;
+volatile Tlm_Stats_t		tlm_stats;
+volatile uint32_t				key_dropped;
+volatile MPU_Bus_Stats_t	mpu_bus_stats;
+
+uint16_t Cobs_Encode(const uint8_t *src, uint16_t len, uint8_t *dst);
+uint16_t Cobs_Decode(uint8_t *buf, uint16_t len);
+
+static uint8_t					*rx_base;			//start of the receive buffer
+static uint8_t					*rx_ptr;			//where the next OUT packet goes, NULL: NAK
+static uint32_t					rx_overrun;		//packets that would have passed the buffer
+static uint8_t					tx[TestTxMax];//host to device
+static uint32_t					tx_len, tx_pos;
+
+static uint8_t					*usb_buf;			//IN transfer in flight
+static uint16_t					usb_len, usb_pos;
+static uint8_t					usb_busy;
+
+static uint8_t					in[CmdRxSize];//device to host, frame being read
+static uint32_t					in_len;
+static uint32_t					in_bad;				//frames that fail COBS or CRC
+static Test_Reply_t			reply[TestReplyMax];
+static uint32_t					reply_cnt;
+
+static uint8_t					unlocked;
+static uint32_t					param_calls;
+static uint32_t					verify_calls;
+static int							fails;
+/* Private user code ---------------------------------------------------------*/
+
+/* the rest of the firmware, as cmd.c sees it */
+uint8_t Param_Command(uint8_t func, const uint8_t *data, uint8_t len, uint8_t *out){
+	uint8_t n = 0;
+	param_calls++;
+	if(func == ParamFuncSet && len) out[n++] = data[0];
+	out[n++] = Param_OK;
+	return n;
+}
+
+uint8_t Sched_Stats_Pack(uint8_t *out){
+	memset(out, 0, Task_Num*SchedStatsBytes);
+	return Task_Num*SchedStatsBytes;
+}
+
+void Sched_Reset_Stats(void){
+}
+
+int Motion_Key_Enroll(const uint8_t *seq, uint8_t len){
+	return unlocked ? 0 : 2;
+}
+
+int Motion_Key_Verify(const uint8_t *seq, uint8_t len){
+	verify_calls++;
+	return 0;
+}
+
+int Is_Unlocked(void){
+	return unlocked;
+}
+
+uint8_t Tlm_Write(const uint8_t *buf, uint16_t len){
+	return 0;
+}
+
+/* USB: IN transfers from the CDC stream, OUT packets into Cmd_Rx() */
+uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len){
+	if(usb_busy) return USBD_BUSY;
+	usb_buf = Buf;
+	usb_len = Len;
+	usb_pos = 0;
+	usb_busy = 1;
+	return USBD_OK;
+}
+
+uint8_t CDC_Tx_Idle(void){
+	return !usb_busy;
+}
+
+void CDC_Rx_Resume(uint8_t *Buf){
+	rx_ptr = Buf;
+}
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+/**
+  * @brief  reference CRC16 CCITT, bit by bit as the host tools do it
+  * @retval crc
+  */
+static uint16_t Test_Crc16(const uint8_t *buf, uint32_t len){
+	uint16_t crc = 0xFFFF;
+	uint8_t b;
+	while(len--){
+		crc ^= (uint16_t)*buf++ << 8;
+		for(b=0;b<8;b++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+/**
+  * @brief  reference COBS decoder
+	*	@param	out		decoded bytes, may be NULL
+  * @retval decoded bytes, -1: bad encoding
+  */
+static int Test_Cobs_Decode(const uint8_t *src, uint32_t len, uint8_t *out){
+	uint32_t r = 0, w = 0, code, i;
+
+	if(len == 0) return -1;
+	while(r < len){
+		code = src[r++];
+		if(code == 0 || r + code - 1 > len) return -1;
+		for(i=1;i<code;i++,w++) if(out) out[w] = src[r++];
+		if(code != 0xFF && r < len){
+			if(out) out[w] = 0;
+			w++;
+		}
+	}
+	return w;
+}
+
+/**
+  * @brief  encode a request frame, with both delimiters
+  * @retval bytes
+  */
+static uint32_t Test_Encode(uint8_t cmd, uint8_t seq, const uint8_t *data, uint8_t len, uint8_t *out){
+	uint8_t raw[2+CmdPayloadMax+2];
+	uint16_t crc, n;
+
+	raw[0] = cmd;
+	raw[1] = seq;
+	memcpy(&raw[2], data, len);
+	crc = Test_Crc16(raw, len + 2);
+	raw[len+2] = crc >> 8;
+	raw[len+3] = crc;
+	out[0] = 0;
+	n = Cobs_Encode(raw, len + 4, &out[1]) + 1;
+	out[n++] = 0;
+	return n;
+}
+
+static void Test_Send(const uint8_t *buf, uint32_t len){
+	if(tx_len + len > TestTxMax) return;
+	memcpy(&tx[tx_len], buf, len);
+	tx_len += len;
+}
+
+static void Test_Request(uint8_t cmd, uint8_t seq, const uint8_t *data, uint8_t len){
+	uint8_t f[CmdRxSize];
+	Test_Send(f, Test_Encode(cmd, seq, data, len, f));
+}
+
+/**
+  * @brief  the host sends up to n OUT packets while the endpoint takes them
+	*	@param	size	bytes per packet, 0: random 1 to 64
+  * @retval None
+  */
+static void Test_Usb_Out(uint32_t n, uint32_t size){
+	uint32_t k;
+
+	while(n-- && rx_ptr != NULL && tx_pos < tx_len){
+		k = size ? size : 1 + rand() % CdcPacketSize;
+		if(k > tx_len - tx_pos) k = tx_len - tx_pos;
+		if(rx_ptr < rx_base || rx_ptr + CdcPacketSize > rx_base + CmdRxSize){
+			rx_overrun++;					//the packet could have passed the buffer
+			break;
+		}
+		memcpy(rx_ptr, &tx[tx_pos], k);
+		tx_pos += k;
+		rx_ptr = Cmd_Rx(rx_ptr, k);
+	}
+	if(tx_pos == tx_len) tx_pos = tx_len = 0;
+}
+
+/**
+  * @brief  one byte read by the host, frames split on the delimiter
+  * @retval None
+  */
+static void Test_In_Byte(uint8_t c){
+	uint8_t raw[CmdRxSize];
+	Test_Reply_t *r;
+	int n;
+
+	if(c != 0){
+		if(in_len < sizeof(in)) in[in_len++] = c;
+		return;
+	}
+	if(in_len == 0) return;
+	n = Test_Cobs_Decode(in, in_len, raw);
+	in_len = 0;
+	if(n < 4 || n > CmdPayloadMax + 4 || Test_Crc16(raw, n - 2) != (raw[n-2] << 8 | raw[n-1])){
+		in_bad++;
+		return;
+	}
+	if(reply_cnt >= TestReplyMax) return;
+	r = &reply[reply_cnt++];
+	r->cmd = raw[0];
+	r->seq = raw[1];
+	r->len = n - 4;
+	memcpy(r->data, &raw[2], n - 4);
+}
+
+/**
+  * @brief  the host reads up to n IN packets
+  * @retval None
+  */
+static void Test_Usb_In(uint32_t n){
+	uint16_t k;
+
+	while(n-- && usb_busy){
+		k = usb_len - usb_pos;
+		if(k > CdcPacketSize) k = CdcPacketSize;
+		while(k--) Test_In_Byte(usb_buf[usb_pos++]);
+		if(usb_pos < usb_len) continue;
+		if(usb_len % CdcPacketSize == 0 && usb_len != 0){
+			usb_len = usb_pos = 0;	//ZLP
+			continue;
+		}
+		usb_busy = 0;
+		Cdc_Tx_Cplt();
+	}
+}
+
+static void Test_Reset(void){
+	hUsbDeviceFS.dev_state = USBD_STATE_CONFIGURED;
+	Cdc_Init();
+	rx_base = rx_ptr = Cmd_Rx_Reset();
+	memset((void*)&cmd_stats, 0, sizeof(cmd_stats));
+	rx_overrun = 0;
+	tx_len = tx_pos = 0;
+	usb_busy = 0;
+	in_len = in_bad = 0;
+	reply_cnt = 0;
+}
+
+/**
+  * @brief  one ms: the USB frame, then the main loop every poll ms
+	*	@param	poll	ms between Cmd_Poll() runs
+	*	@param	size	OUT packet size, 0: random
+  * @retval None
+  */
+static void Test_Ms(uint32_t poll, uint32_t size){
+	host_tick++;
+	Test_Usb_Out(19, size);
+	Test_Usb_In(19);
+	if(host_tick % poll == 0){
+		Cmd_Poll();
+		Cdc_Poll();
+	}
+}
+
+/**
+  * @brief  COBS: random data through Cobs_Encode() and Cobs_Decode(),
+	*					then random and hostile input against the reference
+	*					decoder, with guard bytes after it
+  * @retval None
+  */
+static void Test_Cobs(uint32_t runs){
+	uint8_t src[TestCobsMax], enc[TestCobsMax + TestCobsMax/254 + 8], ref[TestCobsMax];
+	uint32_t i, len, bad_rt = 0, bad_dec = 0, bad_guard = 0, k;
+	uint16_t n, d;
+	int r;
+
+	for(i=0;i<runs;i++){
+		len = rand() % (TestCobsMax - 8);
+		k = rand() % 4;										//zeros: none, rare, half, all
+		for(n=0;n<len;n++) src[n] = k == 0 ? 1 + rand() % 255 : k == 1 ? (rand() % 64 ? rand() : 0) :
+																k == 2 ? (rand() & 1) * (rand() | 1) : 0;
+		n = Cobs_Encode(src, len, enc);
+		if(n > len + len/254 + 1 || memchr(enc, 0, n) != NULL) bad_rt++;
+		d = Cobs_Decode(enc, n);
+		if(len && (d != len || memcmp(enc, src, len) != 0)) bad_rt++;
+	}
+
+	for(i=0;i<runs;i++){
+		len = rand() % (TestCobsMax - 8);
+		k = rand() % 3;										//random, small codes, long codes
+		for(n=0;n<len;n++) src[n] = k == 0 ? rand() : k == 1 ? rand() % 8 : 0xF0 + rand() % 16;
+		if(rand() % 4 == 0 && len) src[rand() % len] = 0;
+		memcpy(enc, src, len);
+		memset(&enc[len], 0xA5, 8);
+		r = Test_Cobs_Decode(src, len, ref);
+		d = Cobs_Decode(enc, len);
+		for(n=0;n<8;n++) if(enc[len+n] != 0xA5) break;
+		if(n < 8) bad_guard++;
+		if(r < 0 ? d != 0 : d != r || memcmp(enc, ref, d) != 0) bad_dec++;
+	}
+	printf("COBS: %u round trips, %u wrong; %u fuzzed decodes, %u wrong, %u past the input\n",
+				 (unsigned)runs, (unsigned)bad_rt, (unsigned)runs, (unsigned)bad_dec, (unsigned)bad_guard);
+	Test_Check(bad_rt == 0, "COBS round trip");
+	Test_Check(bad_dec == 0, "COBS decoder differs from the reference");
+	Test_Check(bad_guard == 0, "COBS decoder wrote past its input");
+}
+
+/**
+  * @brief  valid pings mixed with garbage, overlong runs, cut short and
+	*					bad CRC frames, sent in packets of random size. Every
+	*					ping must be answered, nothing else.
+	*	@param	bytes		to send
+  * @retval None
+  */
+static void Test_Rx_Fuzz(uint32_t bytes){
+	uint8_t f[CmdRxSize], d[CmdPayloadMax], raw[1300];
+	uint8_t seq = 0;
+	uint32_t sent = 0, pings = 0, junk = 0, k, n, i, wrong = 0, ms;
+	int r;
+	char what[128];
+
+	Test_Reset();
+	unlocked = 1;
+	while(sent < bytes){
+		k = rand() % 8;
+		if(k < 3){																			//ping
+			n = rand() % (CmdPayloadMax + 1);
+			for(i=0;i<n;i++) d[i] = seq * 13 + i;
+			n = Test_Encode(CmdPing, seq++, d, n, f);
+			pings++;
+			Test_Send(f, n);
+		}
+		else{
+			if(k == 3) n = 300 + rand() % 900;							//overlong, no delimiter
+			else n = 1 + rand() % 200;
+			for(i=0;i<n;i++) raw[i] = k == 3 ? 1 + rand() % 255 : k == 4 ? rand() : (rand() % 16 ? rand() | 1 : 0);
+			if(k == 5){																		//ping cut short
+				n = Test_Encode(CmdPing, 0xEE, d, rand() % CmdPayloadMax, raw);
+				n = 1 + rand() % (n - 2);
+			}
+			if(k == 6){																		//bad CRC
+				n = Test_Encode(CmdPing, 0xEE, d, rand() % CmdPayloadMax, raw);
+				raw[2 + rand() % (n - 3)] ^= 0x10;
+			}
+			/* a random run that decodes to a frame with a good CRC would be
+				 answered: break its CRC */
+			for(i=0;i<n;){
+				for(k=i;k<n && raw[k];k++);
+				r = Test_Cobs_Decode(&raw[i], k - i, f);
+				if(r >= 4 && r <= CmdPayloadMax + 4 && Test_Crc16(f, r - 2) == (f[r-2] << 8 | f[r-1])){
+					raw[k-1] = raw[k-1] == 0xFF ? 0xFE : raw[k-1] + 1;
+					continue;
+				}
+				i = k + 1;
+			}
+			raw[n++] = 0;																	//ends it, the next ping may not
+			junk++;
+			Test_Send(raw, n);
+		}
+		sent += n;
+		for(ms=0;ms<1000 && tx_len;ms++) Test_Ms(1, 0);
+	}
+	for(ms=0;ms<1000;ms++) Test_Ms(1, 0);
+
+	for(i=0;i<reply_cnt;i++){									//every ping, in order
+		if(reply[i].cmd != CmdPing || reply[i].seq != (uint8_t)i){
+			wrong++;
+			continue;
+		}
+		for(n=0;n<reply[i].len;n++) if(reply[i].data[n] != (uint8_t)(i * 13 + n)) break;
+		if(n < reply[i].len) wrong++;
+	}
+	printf("receiver: %u bytes, %u pings, %u garbage runs, %u replies, %u wrong,\n"
+				 "          %u frames, %u COBS errors, %u CRC errors, %u overflows, %u packets past the buffer\n",
+				 (unsigned)sent, (unsigned)pings, (unsigned)junk, (unsigned)reply_cnt, (unsigned)wrong,
+				 (unsigned)cmd_stats.frames, (unsigned)cmd_stats.cobs_err, (unsigned)cmd_stats.crc_err,
+				 (unsigned)cmd_stats.overflow, (unsigned)rx_overrun);
+	Test_Check(rx_overrun == 0, "receiver: an OUT packet could pass the receive buffer");
+	snprintf(what, sizeof(what), "receiver: %u pings, %u replies", (unsigned)pings, (unsigned)reply_cnt);
+	Test_Check(reply_cnt == (pings < TestReplyMax ? pings : TestReplyMax) && wrong == 0, what);
+	Test_Check(in_bad == 0 && cdc_stats.dropped == 0, "receiver: replies broken or dropped");
+	Test_Check(cmd_stats.overflow > 0 && cmd_stats.cobs_err > 0 && cmd_stats.crc_err > 0,
+						 "receiver: garbage not seen as overflow, COBS and CRC errors");
+}
+
+/**
+  * @brief  one request, the reply after the main loop ran
+  * @retval reply, NULL if none
+  */
+static const Test_Reply_t *Test_Call(uint8_t cmd, const uint8_t *data, uint8_t len){
+	uint32_t ms;
+	reply_cnt = 0;
+	Test_Request(cmd, 0x40, data, len);
+	for(ms=0;ms<10 && reply_cnt == 0;ms++) Test_Ms(1, CdcPacketSize);
+	return reply_cnt ? &reply[0] : NULL;
+}
+
+/**
+  * @brief  commands that need the lock open, locked and unlocked
+  * @retval None
+  */
+static void Test_Lock(void){
+	static const struct{
+		const char	*name;
+		uint8_t			cmd;
+		uint8_t			len;
+		uint8_t			data[5];
+		uint8_t			locked;			//refused while locked
+		uint8_t			at;					//status byte in the reply
+		uint8_t			err;
+	} c[] = {
+		{"param get",			ParamFuncGet,			1, {0},						0, 0, 0},
+		{"param set",			ParamFuncSet,			5, {0, 0, 0, 1, 0},	1, 1, Param_Err_Locked},
+		{"param save",		ParamFuncSave,		0, {0},						1, 0, Param_Err_Locked},
+		{"param default",	ParamFuncDefault,	0, {0},						1, 0, Param_Err_Locked},
+		{"sched stats",		CmdSched,					1, {0},						0, 0, 0},
+		{"stream on",			CmdStream,				1, {1},						1, 0, Cmd_Err_Locked},
+		{"stream off",		CmdStream,				1, {0},						0, 0, 0},
+		{"trace",					CmdTrace,					0, {0},						1, 0, Cmd_Err_Locked},
+		{"enroll",				CmdEnroll,				4, {1, 2, 3, 4},	1, 0, Cmd_Err_Locked},
+		{"verify",				CmdVerify,				4, {1, 2, 3, 4},	1, 0, Cmd_Err_Locked},
+		{"stats",					CmdStats,					0, {0},						0, 0, 0},
+	};
+	const Test_Reply_t *r;
+	uint32_t i, calls;
+	char what[96];
+
+	Test_Reset();
+	for(unlocked=0;unlocked<2;unlocked++){
+		for(i=0;i<sizeof(c)/sizeof(c[0]);i++){
+			calls = param_calls + verify_calls;
+			r = Test_Call(c[i].cmd, c[i].data, c[i].len);
+			snprintf(what, sizeof(what), "%s %s: no reply", unlocked ? "unlocked" : "locked", c[i].name);
+			Test_Check(r != NULL && r->cmd == c[i].cmd && r->len > c[i].at, what);
+			if(r == NULL || r->len <= c[i].at) continue;
+			if(!unlocked && c[i].locked){
+				snprintf(what, sizeof(what), "locked %s: status %u", c[i].name, r->data[c[i].at]);
+				Test_Check(r->data[c[i].at] == c[i].err && param_calls + verify_calls == calls, what);
+			}
+			else{
+				snprintf(what, sizeof(what), "%s %s: refused", unlocked ? "unlocked" : "locked", c[i].name);
+				Test_Check(r->data[c[i].at] == 0, what);
+			}
+		}
+	}
+	printf("lock: %u commands checked locked and unlocked\n", (unsigned)(sizeof(c)/sizeof(c[0])));
+}
+
+/**
+  * @brief  ping round trips in 1 ms USB frames, one request at a time
+	*	@param	poll	ms between Cmd_Poll() runs
+	*	@param	len		ping payload bytes
+  * @retval None
+  */
+static void Test_Rtt(uint32_t poll, uint8_t len){
+	uint8_t d[CmdPayloadMax];
+	uint32_t i, t, sum = 0, lo = ~0u, hi = 0, ms, lost = 0;
+	char what[96];
+
+	Test_Reset();
+	memset(d, 0x5A, len);
+	for(i=0;i<TestRttPings;i++){
+		for(ms=rand()%poll;ms;ms--) Test_Ms(poll, CdcPacketSize);	//any phase of the poll
+		reply_cnt = 0;
+		t = host_tick;
+		Test_Request(CmdPing, i, d, len);
+		for(ms=0;ms<100 && reply_cnt == 0;ms++) Test_Ms(poll, CdcPacketSize);
+		if(reply_cnt == 0 || reply[0].seq != (uint8_t)i || reply[0].len != len){
+			lost++;
+			continue;
+		}
+		t = host_tick - t;
+		sum += t;
+		if(t < lo) lo = t;
+		if(t > hi) hi = t;
+	}
+	printf("%5u  %4u  %4u  %5.1f  %4u\n", (unsigned)poll, (unsigned)len, (unsigned)lo,
+				 (double)sum / TestRttPings, (unsigned)hi);
+	snprintf(what, sizeof(what), "round trip, poll %u ms, %u bytes: %u lost, max %u ms",
+					 (unsigned)poll, (unsigned)len, (unsigned)lost, (unsigned)hi);
+	Test_Check(lost == 0 && hi <= poll + 3, what);
+}
+
+int main(int argc, char **argv){
+	static const uint32_t polls[] = {1, 5, 20};		//1000 Hz, 200 Hz, storage task only
+	static const uint8_t lens[] = {0, 16, 64, CmdPayloadMax};
+	unsigned seed = argc > 1 ? atoi(argv[1]) : 1;
+	uint32_t bytes = argc > 2 ? atoi(argv[2]) : 200000, i, k;
+
+	srand(seed);
+	Test_Cobs(20000);
+	Test_Rx_Fuzz(bytes);
+	Test_Lock();
+
+	printf("\nping round trip, 1 ms USB frames, %u pings each (ms)\n", (unsigned)TestRttPings);
+	printf(" poll   len   min    avg   max\n");
+	for(i=0;i<sizeof(polls)/sizeof(polls[0]);i++){
+		for(k=0;k<sizeof(lens);k++) Test_Rtt(polls[i], lens[k]);
+	}
+
+	printf("\n%s\n", fails ? "FAILED" : "command protocol checks passed");
+	return fails != 0;
+}
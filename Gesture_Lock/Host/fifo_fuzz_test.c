@@ -0,0 +1,369 @@
+/**
+  ******************************************************************************
+  * File Name          : fifo_fuzz_test.c
+  * Description        : Host fuzz test of the DMP FIFO reader (dmp_read_fifo,
+	*											 dmp_fifo_realign in inv_mpu_dmp_motion_driver.c) on
+	*											 the MPU6050 emulator. The DMP is played by the test:
+	*											 one 32 byte packet every 5 ms, a quaternion turning
+	*											 smoothly, gravity in a random direction and the
+	*											 sequence number in gyro Z, while
+	*											 random faults hit the stream:
+	*											 bytes lost or inserted without notice, FIFO reads
+	*											 cut short, bursts that overflow the FIFO and NACK
+	*											 runs that fault the bus. Every packet the driver
+	*											 returns is checked against the packets sent.
+	*											 The same stream, packets and faults drawn from
+	*											 the seed, is read twice: by the realigning reader
+	*											 and by the eMPL reader it replaced, which resets the
+	*											 FIFO on every bad quaternion (Test_Legacy_Read).
+	*											 Printed for both: packets delivered, lost and wrong
+	*											 packets accepted, realigns, FIFO resets and the
+	*											 longest time without a good packet after a fault.
+	*											 The test fails if a misaligned stream is not
+	*											 recovered within TestRecoverMax, wrong packets pass
+	*											 too often or realigning loses as many packets as
+	*											 resetting.
+	*											 Usage: fifo_fuzz_test [seed [steps]]
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mpu_emu.h"
+#include "mpu6050.h"
+#include "inv_mpu_dmp_motion_driver.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestPacket			32		//quaternion, accel, gyro, gesture
+#define TestHistory			1024	//packets kept to check the output, power of 2
+#define TestLoopMs			5			//DMP rate 200 Hz, one read per loop
+#define TestFaultRate		0.02	//faults per packet
+#define TestTurnRate		360		//deg/s, fastest turn of the DMP quaternion
+#define TestRecoverMax	250		//ms without a good packet after a fault, a FIFO reset and refill
+#define TestWrongMax		0.01	//wrong packets accepted per fault
+#define TestWrongRun		4			//wrong packets accepted in a row, 20 ms
+#define TestQuatMagMin	((1L<<28) - (1L<<24))	//QUAT_MAG_SQ_MIN of the driver
+#define TestQuatMagMax	((1L<<28) + (1L<<24))
+/* Bytes lost past the quaternion of the packet being read go unnoticed
+	 until the next one, so a wrong packet now and then is expected: about
+	 0.003 per fault and 3 in a row over seeds 1..8 here. The reset reader
+	 with the magnitude check alone passes 0.06 to 0.14 per fault and runs
+	 of 50 to 130, a window four bytes late while w is small. */
+
+/* Private types -------------------------------------------------------------*/
+typedef struct{
+	uint8_t		data[TestPacket];
+} Test_Packet_t;
+
+typedef struct{
+	uint32_t	delivered;
+	uint32_t	wrong;
+	uint32_t	run_max;							//wrong packets in a row
+	uint32_t	order;								//repeated or older packets
+	uint32_t	lost;									//sent, never delivered right
+	uint32_t	gap_max;							//ms between good packets
+	uint32_t	faults;
+	uint32_t	fault_kind[5];
+	struct dmp_fifo_stats_s	fs;
+	uint32_t	bus_faults;
+} Test_Result_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Test_Packet_t	sent[TestHistory];
+static uint32_t				seq;
+static uint64_t				rand_pkt, rand_fault;	//packet and fault streams
+static double					turn_q[4], turn_axis[3];
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  0..n-1 from one of the streams, so that the faults are drawn
+	*					the same whatever the reader does
+  * @retval random number
+  */
+static uint32_t Rand_From(uint64_t *s, uint32_t n){
+	*s = *s * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (uint32_t)(*s >> 33) % n;
+}
+
+static uint32_t Rand(uint32_t n){
+	return Rand_From(&rand_pkt, n);
+}
+
+static uint32_t Rand_Fault(uint32_t n){
+	return Rand_From(&rand_fault, n);
+}
+
+static void Put32(uint8_t *p, int32_t v){
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static void Put16(uint8_t *p, int16_t v){
+	p[0] = v >> 8;
+	p[1] = v;
+}
+
+/**
+  * @brief  random unit vector
+  * @retval None
+  */
+static void Test_Unit(double *v, uint8_t n){
+	double m;
+	uint8_t i;
+
+	do{
+		m = 0;
+		for(i=0;i<n;i++){
+			v[i] = Rand(20001) / 10000.0 - 1;
+			m += v[i] * v[i];
+		}
+	}while(m < 1e-2 || m > 1);
+	m = sqrt(m);
+	for(i=0;i<n;i++) v[i] /= m;
+}
+
+/**
+  * @brief  Make the next DMP packet: the quaternion turns at up to
+	*					TestTurnRate about an axis that changes now and then, as
+	*					the DMP output does; 1 g (8192 at +-4 g) in a random
+	*					direction, gyro up to +-1000 LSB with the sequence
+	*					number mod TestHistory in Z, gesture bytes zero
+  * @retval None
+  */
+static void Test_Packet_Make(Test_Packet_t *pkt){
+	double *q = turn_q, *axis = turn_axis;
+	double a[3], d[4], r[4], h, n;
+	uint8_t i;
+
+	if(seq == 0 || Rand(200) == 0) Test_Unit(axis, 3);
+	h = TestTurnRate / 180.0 * 3.14159265 * TestLoopMs / 1000.0 / 2 * Rand(1001) / 1000.0;
+	d[0] = cos(h);
+	for(i=0;i<3;i++) d[i+1] = sin(h) * axis[i];
+	r[0] = q[0]*d[0] - q[1]*d[1] - q[2]*d[2] - q[3]*d[3];
+	r[1] = q[0]*d[1] + q[1]*d[0] + q[2]*d[3] - q[3]*d[2];
+	r[2] = q[0]*d[2] - q[1]*d[3] + q[2]*d[0] + q[3]*d[1];
+	r[3] = q[0]*d[3] + q[1]*d[2] - q[2]*d[1] + q[3]*d[0];
+	n = sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2] + r[3]*r[3]);
+	for(i=0;i<4;i++) q[i] = r[i] / n;
+
+	Test_Unit(a, 3);
+	memset(pkt->data, 0, TestPacket);
+	for(i=0;i<4;i++) Put32(pkt->data + 4*i, (int32_t)(q[i] * 1073741823.0));
+	for(i=0;i<3;i++) Put16(pkt->data + 16 + 2*i, (int16_t)(a[i] * 8192 + Rand(200) - 100));
+	Put16(pkt->data + 22, Rand(2000) - 1000);
+	Put16(pkt->data + 24, Rand(2000) - 1000);
+	Put16(pkt->data + 26, (seq & (TestHistory-1)) - TestHistory/2);
+	seq++;
+}
+
+/**
+  * @brief  Compare an output with the packet it claims to be
+  * @retval 1: same data as the packet with that sequence number
+  */
+static int Test_Packet_Match(const long *quat, const short *accel, const short *gyro){
+	const Test_Packet_t *pkt = &sent[(gyro[2] + TestHistory/2) & (TestHistory-1)];
+	const uint8_t *d = pkt->data;
+	uint8_t i;
+
+	for(i=0;i<4;i++){
+		if((int32_t)quat[i] != (int32_t)((uint32_t)d[4*i] << 24 | d[4*i+1] << 16 | d[4*i+2] << 8 | d[4*i+3])) return 0;
+	}
+	for(i=0;i<3;i++){
+		if(accel[i] != (int16_t)(d[16+2*i] << 8 | d[17+2*i])) return 0;
+		if(gyro[i] != (int16_t)(d[22+2*i] << 8 | d[23+2*i])) return 0;
+	}
+	return 1;
+}
+
+/**
+  * @brief  The eMPL reader before the realign: one packet straight from
+	*					the FIFO, the FIFO reset whenever the quaternion magnitude
+	*					is off
+  * @retval 0: packet read
+  */
+static int Test_Legacy_Read(short *gyro, short *accel, long *quat, unsigned char *more){
+	uint8_t d[TestPacket];
+	long q14, mag = 0;
+	uint8_t i;
+
+	if(mpu_read_fifo_stream(TestPacket, d, more)) return -1;
+	for(i=0;i<4;i++){
+		quat[i] = (long)(int32_t)((uint32_t)d[4*i] << 24 | d[4*i+1] << 16 | d[4*i+2] << 8 | d[4*i+3]);
+		q14 = quat[i] >> 16;
+		mag += q14 * q14;
+	}
+	if(mag < TestQuatMagMin || mag > TestQuatMagMax){
+		mpu_reset_fifo();
+		return -1;
+	}
+	for(i=0;i<3;i++){
+		accel[i] = (short)(d[16+2*i] << 8 | d[17+2*i]);
+		gyro[i] = (short)(d[22+2*i] << 8 | d[23+2*i]);
+	}
+	return 0;
+}
+
+static uint8_t Test_Restart(void){
+	uint8_t res = mpu_init_step(1);
+
+	return res == MPU_INIT_BUSY ? 2 : res != 0;
+}
+
+/**
+  * @brief  Play the stream to one reader
+	*	@param	legacy	0: dmp_read_fifo, 1: Test_Legacy_Read
+	*	@param	seed		packet and fault streams
+	*	@param	steps		packets, 5 ms each
+	*	@param	r				results out
+  * @retval 0, 1 if the device did not start
+  */
+static int Test_Fuzz(uint8_t legacy, unsigned seed, uint32_t steps, Test_Result_t *r){
+	uint32_t step, k, n, nack = 0;
+	uint32_t run = 0, last_good, gap;
+	int32_t last_seq = -1;
+	unsigned long stamp;
+	long quat[4];
+	short gyro[3], accel[3], sensors;
+	unsigned char more;
+	uint8_t junk[TestPacket];
+	int res;
+
+	memset(r, 0, sizeof(*r));
+	rand_pkt = rand_fault = seed;
+	Rand_Fault(1);//the streams apart
+	seq = 0;
+	turn_q[0] = 1;
+	turn_q[1] = turn_q[2] = turn_q[3] = 0;
+	Mpu_Emu_Power_On();
+	memset((void*)&mpu_bus_stats, 0, sizeof(mpu_bus_stats));
+	MPU_Bus_Init(Test_Restart);
+	if(mpu_dmp_init()) return 1;
+	dmp_reset_fifo_stats();
+	last_good = host_tick;
+
+	for(step=0;step<steps;step++){
+		/* the DMP writes one packet */
+		Test_Packet_Make(&sent[seq & (TestHistory-1)]);
+		Mpu_Emu_Fifo_Push(sent[(seq-1) & (TestHistory-1)].data, TestPacket);
+
+		/* faults hit the stream; a NACK run waits until the bus is back,
+			 so it hits the stream being read, not the recovery */
+		if(Rand_Fault(1000000) < TestFaultRate * 1000000){
+			r->faults++;
+			k = Rand_Fault(5);
+			n = 1 + Rand_Fault(TestPacket - 1);
+			r->fault_kind[k]++;
+			switch(k){
+				case 0://bytes lost
+					Mpu_Emu_Fifo_Drop(n);
+					break;
+				case 1://bytes inserted
+					for(k=0;k<n;k++) junk[k] = Rand_Fault(256);
+					Mpu_Emu_Fifo_Push(junk, n);
+					break;
+				case 2://FIFO read cut short
+					mpu_emu.fifo_cut = n;
+					break;
+				case 3://main loop stalled, FIFO overflows
+					for(k=0;k<40;k++){
+						Test_Packet_Make(&sent[seq & (TestHistory-1)]);
+						Mpu_Emu_Fifo_Push(sent[(seq-1) & (TestHistory-1)].data, TestPacket);
+					}
+					break;
+				case 4://NACK run, bus fault
+					nack++;
+					break;
+			}
+		}
+		if(nack && MPU_Bus_Ready()){
+			Mpu_Emu_Fail(MPU_BUS_ERR_LIMIT, HAL_ERROR, HAL_I2C_ERROR_AF);
+			nack--;
+		}
+
+		/* sampling task, then the recovery step of the main loop */
+		for(k=0;k<4 && MPU_Bus_Ready();k++){
+			if(legacy) res = Test_Legacy_Read(gyro, accel, quat, &more);
+			else res = dmp_read_fifo(gyro, accel, quat, &stamp, &sensors, &more);
+			if(res) break;
+			r->delivered++;
+			if(!Test_Packet_Match(quat, accel, gyro)){
+				r->wrong++;
+				if(++run > r->run_max) r->run_max = run;
+			}
+			else{
+				run = 0;
+				k = (gyro[2] + TestHistory/2) & (TestHistory-1);
+				n = (k - last_seq) & (TestHistory-1);
+				if(last_seq >= 0 && (n == 0 || n > TestHistory/2)) r->order++;//repeated or older
+				last_seq = k;
+				gap = host_tick - last_good;
+				if(gap > r->gap_max) r->gap_max = gap;
+				last_good = host_tick;
+			}
+			if(!more) break;
+		}
+		MPU_Bus_Poll();
+		host_tick += TestLoopMs;
+	}
+	r->lost = seq - (r->delivered - r->wrong);
+	dmp_get_fifo_stats(&r->fs);
+	r->bus_faults = mpu_bus_stats.faults;
+	return 0;
+}
+
+static void Test_Print(const char *name, const Test_Result_t *r){
+	printf("%-8s %9u %6u %6u %5u %6u %7lu %6lu %5u %5u ms\n", name, (unsigned)r->delivered,
+				 (unsigned)r->lost, (unsigned)r->wrong, (unsigned)r->run_max, (unsigned)r->order,
+				 r->fs.resyncs, r->fs.resets, (unsigned)r->bus_faults, (unsigned)r->gap_max);
+}
+
+int main(int argc, char **argv){
+	unsigned seed = argc > 1 ? atoi(argv[1]) : 1;
+	uint32_t steps = argc > 2 ? atoi(argv[2]) : 200000;
+	Test_Result_t re, le;
+	int fail;
+
+	if(Test_Fuzz(0, seed, steps, &re) || Test_Fuzz(1, seed, steps, &le)){
+		printf("FAIL  mpu_dmp_init\n");
+		return 1;
+	}
+	printf("seed %u, %u packets sent, %u faults (lost %u, inserted %u, cut %u, overflow %u, nack %u)\n\n",
+				 seed, (unsigned)seq, (unsigned)re.faults, (unsigned)re.fault_kind[0], (unsigned)re.fault_kind[1],
+				 (unsigned)re.fault_kind[2], (unsigned)re.fault_kind[3], (unsigned)re.fault_kind[4]);
+	printf("reader   delivered   lost  wrong   run  order realign resets   bus   longest gap\n");
+	Test_Print("realign", &re);
+	Test_Print("reset", &le);
+
+	fail = 0;
+	if(re.gap_max > TestRecoverMax){
+		printf("FAIL  stream not recovered within %u ms\n", TestRecoverMax);
+		fail = 1;
+	}
+	if(re.wrong > re.faults * TestWrongMax){
+		printf("FAIL  %u wrong packets accepted\n", (unsigned)re.wrong);
+		fail = 1;
+	}
+	if(re.run_max > TestWrongRun){
+		printf("FAIL  misaligned stream accepted for %u packets\n", (unsigned)re.run_max);
+		fail = 1;
+	}
+	if(re.order){
+		printf("FAIL  packets out of order\n");
+		fail = 1;
+	}
+	if(re.lost >= le.lost){
+		printf("FAIL  realigning loses %u packets, resetting %u\n", (unsigned)re.lost, (unsigned)le.lost);
+		fail = 1;
+	}
+	printf("\n%s\n", fail ? "FAILED" : "FIFO checks passed");
+	return fail;
+}
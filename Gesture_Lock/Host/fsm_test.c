@@ -0,0 +1,586 @@
+/**
+  ******************************************************************************
+  * File Name          : fsm_test.c
+  * Description        : Host simulation of the main state machine
+	*											 (state_machine.c, the gl_trans table) in virtual
+	*											 time. The user key on PA0 is driven through key.c as
+	*											 on the board, gestures are played into mpu_data as
+	*											 100 Hz accel samples and the main loop runs
+	*											 State_Update_Main() every ms. The screen is kept as
+	*											 text by the OLED calls below and read back as the
+	*											 state it shows.
+	*											 Scripted runs check each path of the table and its
+	*											 timers (unlock, wrong key, record, too short, unlock
+	*											 first, double click, flash failing under a save).
+	*											 The key log in sector 4 is then filled past its end:
+	*											 one erase, at the boot or under the save that finds
+	*											 it full, and the key survives both.
+	*											 A random run then presses, gestures and waits at
+	*											 random: every change of screen
+	*											 must be a row of gl_trans, every row must be taken,
+	*											 no timed screen may stay past its timer and the lock
+	*											 may only open on the key stored in flash.
+	*											 Usage: fsm_test [seed [actions]]
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "state_machine.h"
+#include "key.h"
+#include "oled.h"
+#include "mpu6050.h"
+#include "param.h"
+#include "cmd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestSampleMs		10		//DMP output, 100 Hz
+#define TestGestureMs		600		//one gesture and the holdoff after it
+#define TestSlack				5			//ms, main loop and SysTick granularity
+#define TestTimedMax		6000	//longest UI timer (Saved)
+#define TestKeySlots		(0x10000/sizeof(Gesture_Seq_t))	//key records in sector 4
+#define TestBootFree		64		//FlashBootFree
+
+/* Private types -------------------------------------------------------------*/
+typedef enum{
+	S_Standby = 0,
+	S_Unlock,
+	S_Record,
+	S_Unlock_First,
+	S_Checking,
+	S_Match,
+	S_Unlocked,
+	S_Fail,
+	S_Saving,
+	S_Saved,
+	S_Too_Short,
+	S_Save_Fail,
+	S_Unknown,
+	S_Num
+} Test_State_t;
+
+/* Private variables ---------------------------------------------------------*/
+MPU_Data_t		mpu_data;
+Param_t				param;
+extern Gesture_Seq_t	*key;
+extern uint16_t				flash_next;
+
+int Flash_Save_Seq(Gesture_Seq_t* k);
+void Flash_Scan(void);
+
+static const char *state_names[S_Num] = {
+	"Standby", "Unlock", "Record", "Unlock_First", "Checking", "Match",
+	"Unlocked", "Fail", "Saving", "Saved", "Too_Short", "Save_Fail", "?"
+};
+
+//gl_trans as screen changes, the Message row split per child
+static const uint8_t edges[][2] = {
+	{S_Standby,				S_Unlock},
+	{S_Standby,				S_Record},
+	{S_Standby,				S_Unlock_First},
+	{S_Unlock,				S_Checking},
+	{S_Record,				S_Saving},
+	{S_Record,				S_Too_Short},
+	{S_Checking,			S_Match},
+	{S_Checking,			S_Fail},
+	{S_Match,					S_Unlocked},
+	{S_Saving,				S_Saved},
+	{S_Saving,				S_Save_Fail},
+	{S_Unlock_First,	S_Standby},
+	{S_Unlocked,			S_Standby},
+	{S_Fail,					S_Standby},
+	{S_Saved,					S_Standby},
+	{S_Too_Short,			S_Standby},
+	{S_Save_Fail,			S_Standby},
+};
+#define EdgeNum		(sizeof(edges)/sizeof(edges[0]))
+
+static char			screen[OLED_PAGES][17];	//8x16 font: 16 columns, 2 pages a row
+static uint8_t	state;									//Test_State_t on screen
+static uint32_t	state_time;							//entered at
+static uint32_t	edge_cnt[EdgeNum];
+static uint32_t	bad_edges;
+static uint32_t	overstay;
+static uint8_t	shown[SeqLength];				//gestures shown in this input
+static uint8_t	shown_len;
+static uint32_t	opened, wrong_opened, refused, right_refused;
+static uint32_t	ref;										//scripted times are from here
+static int			fails;
+/* Private user code ---------------------------------------------------------*/
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+/**
+  * @brief  CmdLog sink, the log is not checked here
+  * @retval 0
+  */
+uint8_t Cmd_Write(uint8_t cmd, uint8_t seq, const uint8_t *data, uint8_t len){
+	return 0;
+}
+
+/* OLED: text only, the framebuffer has its own test ---------------------------*/
+void OLED_Clear(void){
+	memset(screen, ' ', sizeof(screen));
+	for(int i=0;i<OLED_PAGES;i++) screen[i][16] = 0;
+}
+
+void OLED_ShowChar(u8 x, u8 y, u8 chr){
+	if(y < OLED_PAGES && x / 8 < 16) screen[y][x / 8] = chr;
+}
+
+void OLED_ShowString(u8 x, u8 y, u8 *p){
+	while(*p){
+		OLED_ShowChar(x, y, *p++);
+		x += 8;
+		if(x > 120){//next row, as oled.c
+			x = 0;
+			y += 2;
+		}
+	}
+}
+
+void OLED_ShowNum(u8 x, u8 y, u32 num, u8 len, u8 size){
+	char buf[12];
+	snprintf(buf, sizeof(buf), "%*u", len, (unsigned)num);
+	OLED_ShowString(x, y, (u8*)buf);
+}
+
+void OLED_Refresh(void){
+}
+
+/**
+  * @brief  does a screen row start with this text
+  * @retval 1: yes
+  */
+static int Test_Row(uint8_t page, const char *text){
+	return strncmp(screen[page], text, strlen(text)) == 0;
+}
+
+/**
+  * @brief  the state the screen shows, timed screens of Checking and
+	*					Saving add a line instead of clearing
+  * @retval Test_State_t
+  */
+static uint8_t Test_Screen(void){
+	if(Test_Row(0, "Locked!") || Test_Row(0, "Unlocked!")) return S_Standby;
+	if(Test_Row(0, "Unlock Mode")) return S_Unlock;
+	if(Test_Row(0, "Record Mode")) return S_Record;
+	if(Test_Row(0, "Unlock first!")) return S_Unlock_First;
+	if(Test_Row(0, "Too short!!!")) return S_Too_Short;
+	if(Test_Row(0, "Checking...")){
+		if(Test_Row(4, "Unlock!!!!")) return S_Unlocked;
+		if(Test_Row(2, "Match!")) return S_Match;
+		if(Test_Row(2, "Fail!!!!")) return S_Fail;
+		return S_Checking;
+	}
+	if(Test_Row(0, "Saving...")){
+		if(Test_Row(6, "Saved!")) return S_Saved;
+		if(Test_Row(6, "Save failed!")) return S_Save_Fail;
+		return S_Saving;
+	}
+	return S_Unknown;
+}
+
+/**
+  * @brief  timer of a timed screen
+  * @retval ms, 0: not timed
+  */
+static uint32_t Test_Timer(uint8_t st){
+	switch(st){
+		case S_Unlock_First:	return 1000;
+		case S_Checking:			return 300;
+		case S_Match:					return 300;
+		case S_Unlocked:			return 3000;
+		case S_Fail:					return 3000;
+		case S_Saving:				return 300;
+		case S_Saved:					return 6000;
+		case S_Too_Short:			return 2000;
+		case S_Save_Fail:			return 3000;
+		default:							return 0;
+	}
+}
+
+static int Test_Key_Is(const uint8_t *seq, uint8_t len){
+	return key->len == len && memcmp(key->seq, seq, len) == 0;
+}
+
+/**
+  * @brief  follow the screen: check each change against gl_trans, the
+	*					time spent on timed screens and what opened the lock
+  * @retval None
+  */
+static void Test_Observe(void){
+	uint8_t st = Test_Screen();
+	uint32_t i, dwell;
+
+	if(st == S_Unlock || st == S_Record){
+		if(Test_Row(2, "Last Ges:") && shown_len < SeqLength){
+			uint8_t g = atoi(&screen[2][10]), n = atoi(&screen[4][10]);
+			if(n == shown_len + 1) shown[shown_len++] = g;
+		}
+	}
+	dwell = host_tick - state_time;
+	if(Test_Timer(state) && dwell > Test_Timer(state) + TestSlack) overstay++;
+	if(st == state) return;
+
+	for(i=0;i<EdgeNum;i++){
+		if(edges[i][0] == state && edges[i][1] == st) break;
+	}
+	if(i < EdgeNum) edge_cnt[i]++;
+	else{
+		if(bad_edges++ < 5) printf("      %s -> %s at %u ms\n", state_names[state], state_names[st], (unsigned)host_tick);
+	}
+	if(st == S_Match){
+		opened++;
+		if(!Test_Key_Is(shown, shown_len)) wrong_opened++;
+	}
+	if(st == S_Fail){
+		refused++;
+		if(Test_Key_Is(shown, shown_len)) right_refused++;
+	}
+	if(st == S_Unlock || st == S_Record) shown_len = 0;
+	state = st;
+	state_time = host_tick;
+}
+
+/**
+  * @brief  1 ms of the board: SysTick with the key, a DMP sample every
+	*					TestSampleMs, the main loop
+	*	@param	acc		accel of this ms, x y z in g
+  * @retval None
+  */
+static void Test_Ms(const float *acc){
+	host_tick++;
+	Key_Tick();
+	if(host_tick % TestSampleMs == 0){
+		mpu_data.Ax = acc ? acc[0] : 0;
+		mpu_data.Ay = acc ? acc[1] : 0;
+		mpu_data.Az = acc ? acc[2] : 0;
+		mpu_data.pitch = 0;
+		mpu_data.UpdateFlag = 1;
+	}
+	State_Update_Main();
+	Test_Observe();
+}
+
+static void Test_Idle(uint32_t ms){
+	while(ms--) Test_Ms(0);
+}
+
+static void Test_Key(uint8_t pressed){
+	KEY_GPIO_Port->IDR = pressed ? 0 : KEY_Pin;
+	HAL_GPIO_EXTI_Callback(KEY_Pin);
+}
+
+static void Test_Press(uint32_t ms){
+	Test_Key(1);
+	Test_Idle(ms);
+	Test_Key(0);
+}
+
+static void Test_Click(void){
+	Test_Press(80);
+}
+
+static void Test_Double(void){
+	Test_Press(80);
+	Test_Idle(100);
+	Test_Press(80);
+}
+
+static void Test_Long(void){
+	Test_Press(ShortPressMax + 200);
+}
+
+/**
+  * @brief  play one gesture: three peaks on one axis, each 60 ms at 1 g,
+	*					then rest for the holdoff
+	*	@param	g		gesture number 7..12 (palm left, pitch 0): 7/8 x,
+	*							9/10 y, 11/12 z, even numbers start positive
+  * @retval None
+  */
+static void Test_Gesture(uint8_t g){
+	static const int8_t sign[3] = {1, -1, 1};
+	float acc[3] = {0, 0, 0};
+	uint8_t axis = (g - 7) / 2, i;
+	float s = (g & 1) ? -1.0f : 1.0f;
+	uint32_t t;
+
+	for(i=0;i<3;i++){
+		acc[axis] = s * sign[i];
+		for(t=0;t<60;t++) Test_Ms(acc);
+		acc[axis] = 0;
+		for(t=0;t<60;t++) Test_Ms(acc);
+	}
+	Test_Idle(TestGestureMs - 360);
+}
+
+static void Test_Gestures(const uint8_t *seq, uint8_t len){
+	uint8_t i;
+	for(i=0;i<len;i++) Test_Gesture(seq[i]);
+}
+
+/**
+  * @brief  run until the screen shows a state, then check when it came:
+	*					from the start of the last action or the last state
+	*					expected, which becomes the next reference
+	*	@param	st		Test_State_t
+	*	@param	min		ms after the reference
+	*	@param	max		ms after the reference
+  * @retval None
+  */
+static void Test_Expect(const char *step, uint8_t st, uint32_t min, uint32_t max){
+	char what[96];
+	uint32_t t;
+
+	while(state != st && host_tick - ref <= max + TestTimedMax) Test_Ms(0);
+	if(state != st){
+		printf("  %-34s %-13s never\n", step, state_names[st]);
+		snprintf(what, sizeof(what), "%s: no %s, on %s", step, state_names[st], state_names[state]);
+		Test_Check(0, what);
+		ref = host_tick;
+		return;
+	}
+	t = state_time - ref;
+	printf("  %-34s %-13s %5u ms\n", step, state_names[st], (unsigned)t);
+	snprintf(what, sizeof(what), "%s: %s after %u ms, expected %u to %u", step, state_names[st],
+					 (unsigned)t, (unsigned)min, (unsigned)max);
+	Test_Check(t >= min && t <= max, what);
+	ref = state_time;
+}
+
+static void Test_Defaults(void){
+	param.motion_gap_time = 5000;
+	param.motion_dur_time = 1000;
+	param.acc_peak_gap_time = 300;
+	param.motion_peak_th = 0.5f;
+	param.peak_samp_num = 3;
+	param.peak_max_pre = 0.8f;
+	param.min_seq_len = 3;
+	param.mpu_hz = 100;
+}
+
+/**
+  * @brief  the paths of the table, when each screen comes
+  * @retval None
+  */
+static void Test_Scripted(void){
+	static const uint8_t right[4] = {12, 11, 10, 9};
+	static const uint8_t wrong[4] = {12, 11, 10, 10};
+	static const uint8_t record[3] = {8, 7, 8};
+	uint32_t gap = param.motion_gap_time;
+	uint32_t click = 80 + DoubleClickGap;							//release, then no second click
+	uint32_t hold = ShortPressMax + KeyDebounceTime;	//Key_Long while held
+	uint8_t seq[SeqLength+6], i;
+	uint32_t erases;
+
+	printf("scripted                            state        after\n");
+	Test_Check(state == S_Standby && Test_Row(0, "Locked!"), "boot: not on the locked screen");
+	Test_Check(Test_Key_Is(right, 4), "boot: default key not in flash");
+
+	ref = host_tick;
+	Test_Click();
+	Test_Expect("click", S_Unlock, click, click + KeyDebounceTime + TestSlack);
+	Test_Gestures(wrong, 4);
+	ref = host_tick;
+	Test_Expect("wrong key, sequence gap", S_Checking, gap - TestGestureMs, gap);
+	Test_Expect("check", S_Fail, 300, 300 + TestSlack);
+	Test_Expect("fail screen", S_Standby, 3000, 3000 + TestSlack);
+	Test_Check(Test_Row(0, "Locked!"), "fail: lock opened");
+
+	ref = host_tick;
+	Test_Long();
+	Test_Expect("long press while locked", S_Unlock_First, hold, hold + TestSlack);
+	Test_Expect("unlock first screen", S_Standby, 1000, 1000 + TestSlack);
+
+	ref = host_tick;
+	Test_Double();
+	Test_Expect("double click", S_Unlock, 260, 260 + KeyDebounceTime + TestSlack);
+	Test_Gestures(right, 4);
+	ref = host_tick;
+	Test_Expect("right key, sequence gap", S_Checking, gap - TestGestureMs, gap);
+	Test_Expect("check", S_Match, 300, 300 + TestSlack);
+	Test_Expect("match screen", S_Unlocked, 300, 300 + TestSlack);
+	Test_Expect("unlocked screen", S_Standby, 3000, 3000 + TestSlack);
+	Test_Check(Test_Row(0, "Unlocked!"), "match: lock not open");
+
+	ref = host_tick;
+	Test_Long();
+	Test_Expect("long press while unlocked", S_Record, hold, hold + TestSlack);
+	Test_Gestures(record, 1);
+	ref = host_tick;
+	Test_Expect("one gesture, sequence gap", S_Too_Short, gap - TestGestureMs, gap);
+	Test_Expect("too short screen", S_Standby, 2000, 2000 + TestSlack);
+
+	ref = host_tick;
+	Test_Long();
+	Test_Expect("long press while unlocked", S_Record, hold, hold + TestSlack);
+	Test_Gestures(record, 3);
+	erases = host_flash_erases;
+	ref = host_tick;
+	Test_Expect("three gestures, sequence gap", S_Saving, gap - TestGestureMs, gap);
+	Test_Expect("saving screen", S_Saved, 300, 300 + TestSlack);
+	Test_Expect("saved screen", S_Standby, 6000, 6000 + TestSlack);
+	Test_Check(Test_Key_Is(record, 3), "record: new key not in flash");
+	Test_Check(host_flash_erases == erases, "record: the save erased flash");
+	Test_Check(Test_Row(0, "Locked!"), "record: lock still open");
+
+	ref = host_tick;
+	Test_Click();
+	Test_Expect("click", S_Unlock, click, click + KeyDebounceTime + TestSlack);
+	Test_Gestures(record, 3);
+	ref = host_tick;
+	Test_Expect("new key, sequence gap", S_Checking, gap - TestGestureMs, gap);
+	Test_Expect("check", S_Match, 300, 300 + TestSlack);
+	Test_Expect("unlocked screen", S_Standby, 3300, 3300 + 2 * TestSlack);
+
+	/* flash fails under the save: shown, the lock stays open for another try
+		 and the last key is kept */
+	ref = host_tick;
+	Test_Long();
+	Test_Expect("long press while unlocked", S_Record, hold, hold + TestSlack);
+	Test_Gestures(record, 3);
+	host_flash_fail = 1;
+	ref = host_tick;
+	Test_Expect("three gestures, flash fails", S_Saving, gap - TestGestureMs, gap);
+	Test_Expect("saving screen", S_Save_Fail, 300, 300 + TestSlack);
+	host_flash_fail = 0;
+	Test_Expect("save failed screen", S_Standby, 3000, 3000 + TestSlack);
+	Test_Check(Test_Row(0, "Unlocked!"), "save failed: lock closed");
+	Test_Check(Test_Key_Is(record, 3), "save failed: last key lost");
+
+	/* longer than the screen line and than a key can be: input stops at
+		 SeqLength-1, the ignored gestures do not restart the gap */
+	for(i=0;i<SeqLength+6;i++) seq[i] = 7 + i % 6;
+	ref = host_tick;
+	Test_Long();
+	Test_Expect("long press while unlocked", S_Record, hold, hold + TestSlack);
+	Test_Gestures(seq, SeqLength+6);
+	ref = host_tick;
+	Test_Expect("70 gestures, gap after the 63rd", S_Saving, gap - 8 * TestGestureMs, gap);
+	Test_Expect("saving screen", S_Saved, 300, 300 + TestSlack);
+	Test_Check(Test_Key_Is(seq, SeqLength-1), "long record: key is not the first SeqLength-1 gestures");
+	Test_Check(Test_Row(2, "New: 7, 8, 9,10,"), "long record: new key not shown");
+	Test_Expect("saved screen", S_Standby, 6000, 6000 + TestSlack);
+}
+
+/**
+  * @brief  fill the key log: a save erases a full sector, the boot erases
+	*					one nearly full, the key is kept both times
+  * @retval None
+  */
+static void Test_Key_Log(void){
+	Gesture_Seq_t k, last;
+	uint32_t erases = host_flash_erases, saves = 0;
+
+	memcpy(&last, key, sizeof(last));
+	k.len = 4;
+	k.seq[0] = 7;
+	k.seq[1] = 8;
+	k.seq[2] = 9;
+	do{
+		k.seq[3] = 7 + saves % 6;
+		Test_Check(Flash_Save_Seq(&k) == 0, "key log: save failed");
+		saves++;
+	} while(flash_next != 1);
+	printf("\nkey log   %u saves to the first erase, %u erase\n", (unsigned)saves, (unsigned)(host_flash_erases - erases));
+	Test_Check(host_flash_erases - erases == 1, "key log: not one erase per full sector");
+	Test_Check(Test_Key_Is(k.seq, 4), "key log: key lost by the erase");
+	Flash_Scan();
+	Test_Check(Test_Key_Is(k.seq, 4) && flash_next == 1, "key log: scan does not find the key");
+
+	while(flash_next < TestKeySlots - TestBootFree){
+		Test_Check(Flash_Save_Seq(&last) == 0, "key log: save failed");
+	}
+	erases = host_flash_erases;
+	State_Machine_Init();
+	Test_Check(host_flash_erases == erases, "key log: boot erased with FlashBootFree records free");
+	Flash_Save_Seq(&last);
+	State_Machine_Init();
+	printf("key log   boot with %u free records, %u erase\n", (unsigned)(TestBootFree - 1),
+				 (unsigned)(host_flash_erases - erases));
+	Test_Check(host_flash_erases - erases == 1 && flash_next == 1, "key log: boot does not erase a nearly full sector");
+	Test_Check(Test_Key_Is(last.seq, last.len), "key log: key lost at the boot");
+}
+
+/**
+  * @brief  random presses, gestures and pauses
+  * @retval None
+  */
+static void Test_Random(uint32_t actions){
+	uint8_t seq[6], len, i;
+	uint32_t a;
+
+	for(a=0;a<actions;a++){
+		switch(rand() % 8){
+			case 0: Test_Click(); break;
+			case 1: Test_Double(); break;
+			case 2: Test_Long(); break;
+			case 3://the stored key, sometimes
+			case 4:
+				if(rand() % 2 && key->len < 8){
+					Test_Gestures(key->seq, key->len);
+					break;
+				}
+				len = 1 + rand() % 5;
+				for(i=0;i<len;i++) seq[i] = 7 + rand() % 6;
+				Test_Gestures(seq, len);
+				break;
+			case 5: Test_Idle(rand() % 1000); break;
+			default: Test_Idle(rand() % 7000); break;
+		}
+	}
+}
+
+int main(int argc, char **argv){
+	unsigned seed = argc > 1 ? atoi(argv[1]) : 1;
+	uint32_t actions = argc > 2 ? atoi(argv[2]) : 3000;
+	uint32_t i, missing = 0;
+	char what[96];
+
+	srand(seed);
+	Test_Defaults();
+	KEY_GPIO_Port->IDR = KEY_Pin;	//released
+	OLED_Clear();
+	State_Machine_Init();
+	state = Test_Screen();
+	state_time = host_tick;
+
+	Test_Scripted();
+	Test_Check(bad_edges == 0, "scripted: screen change not in gl_trans");
+
+	Test_Random(actions);
+	printf("\nrandom, %u actions, %u s                 taken\n", (unsigned)actions, (unsigned)(host_tick / 1000));
+	for(i=0;i<EdgeNum;i++){
+		printf("  %-14s -> %-14s %6u\n", state_names[edges[i][0]], state_names[edges[i][1]], (unsigned)edge_cnt[i]);
+		if(edge_cnt[i] == 0) missing++;
+	}
+	printf("opened %u (%u on a wrong key), refused %u (%u on the right key)\n",
+				 (unsigned)opened, (unsigned)wrong_opened, (unsigned)refused, (unsigned)right_refused);
+	printf("screen changes not in gl_trans %u, timed screens past their timer %u\n",
+				 (unsigned)bad_edges, (unsigned)overstay);
+
+	snprintf(what, sizeof(what), "%u rows of gl_trans never taken", (unsigned)missing);
+	Test_Check(missing == 0, what);
+	Test_Check(bad_edges == 0, "screen change not in gl_trans");
+	Test_Check(overstay == 0, "timed screen past its timer");
+	Test_Check(wrong_opened == 0, "lock opened on a wrong key");
+	Test_Check(right_refused == 0, "right key refused");
+	Test_Check(key_dropped == 0, "key events dropped");
+
+	Test_Key_Log();
+
+	printf("\n%s\n", fails ? "FAILED" : "state machine checks passed");
+	return fails != 0;
+}
@@ -0,0 +1,366 @@
+/**
+  ******************************************************************************
+  * File Name          : fusion_bench.c
+  * Description        : Host check and benchmark of the software attitude
+	*											 fusion (fusion.c) against a reference orientation.
+	*											 On a CmdSample capture (imu_capture.py) the
+	*											 reference is the DMP quaternion of each sample and
+	*											 the raw accel and gyro of the same sample feed
+	*											 Fusion_Update() at the capture rate. Without a
+	*											 capture, synthetic motion with a known orientation
+	*											 is generated at 100 to 1000 Hz with gyro bias and
+	*											 noise at the +-2000 dps scale of the raw FIFO.
+	*											 Printed per run: tilt error (angle between the
+	*											 gravity vectors the gesture code sees), attitude
+	*											 error with the yaw offset removed at the end of the
+	*											 boot gain, final yaw drift and the cost per sample
+	*											 from the Probe_Fusion probe. Synthetic runs fail past
+	*											 the limits below. Device cycles: Probe_Fusion over
+	*											 CmdProbe.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fusion.h"
+#include "probe.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define BenchSeconds		60			//synthetic motion per rate
+#define BenchSubSteps		16			//integration steps of the reference per sample
+#define BenchMax				200000	//samples read from a capture
+#define BenchSampleSize	28			//CmdSample payload (serial_debug.c)
+#define BenchRounds			20			//passes over the samples for the timing
+#define BenchTolTiltRms	2.0			//deg, synthetic runs
+#define BenchTolTiltMax	6.0			//deg, synthetic runs
+#define BenchDeg				(180.0 / 3.14159265358979)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct{
+	int16_t	acc[3];
+	int16_t	gyro[3];
+	float		q[4];			//reference: DMP or synthetic
+} Bench_Sample_t;
+
+typedef struct{
+	double	tilt_max;
+	double	tilt_sq;
+	double	att_max;
+	double	att_sq;
+	double	yaw_end;
+	uint32_t	n;
+} Bench_Err_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Bench_Sample_t	*sample;
+static uint32_t				samples;
+
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  uniform random number
+  * @retval lo..hi
+  */
+static double Rand_Range(double lo, double hi){
+	return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+/**
+  * @brief  gaussian random number, Box-Muller
+  * @retval N(0, sd)
+  */
+static double Rand_Gauss(double sd){
+	double u = Rand_Range(1e-12, 1);
+	return sd * sqrt(-2 * log(u)) * cos(6.2832 * Rand_Range(0, 1));
+}
+
+/**
+  * @brief  round and clamp to int16
+  * @retval value
+  */
+static int16_t Sat16(double v){
+	v = floor(v + 0.5);
+	if(v > 32767) return 32767;
+	if(v < -32768) return -32768;
+	return (int16_t)v;
+}
+
+/**
+  * @brief  Read a capture: CmdSample payloads back to back, accel and gyro
+	*					int16 then the quaternion int32 q30, big endian
+	*	@param	path	file
+  * @retval 0: ok
+  */
+static int Load_Capture(const char *path){
+	uint8_t b[BenchSampleSize];
+	FILE *f = fopen(path, "rb");
+	uint8_t i;
+
+	if(f == NULL){
+		perror(path);
+		return 1;
+	}
+	sample = malloc(BenchMax * sizeof(*sample));
+	while(samples < BenchMax && fread(b, 1, sizeof(b), f) == sizeof(b)){
+		Bench_Sample_t *s = &sample[samples++];
+		for(i=0;i<3;i++){
+			s->acc[i] = (int16_t)(b[2*i]<<8 | b[2*i+1]);
+			s->gyro[i] = (int16_t)(b[6+2*i]<<8 | b[6+2*i+1]);
+		}
+		for(i=0;i<4;i++){
+			const uint8_t *p = &b[12+4*i];
+			s->q[i] = (int32_t)((uint32_t)p[0]<<24 | p[1]<<16 | p[2]<<8 | p[3]) / 1073741824.0f;
+		}
+	}
+	fclose(f);
+	printf("%s: %u samples\n", path, (unsigned)samples);
+	return samples == 0;
+}
+
+/**
+  * @brief  q += q * (0, w) / 2 * dt, normalized
+	*	@param	q			quaternion
+	*	@param	w			body rates, rad/s
+	*	@param	dt		s
+  * @retval None
+  */
+static void Quat_Step(double q[4], const double w[3], double dt){
+	double dq[4], norm = 0;
+	uint8_t i;
+
+	dq[0] = -q[1]*w[0] - q[2]*w[1] - q[3]*w[2];
+	dq[1] =  q[0]*w[0] + q[2]*w[2] - q[3]*w[1];
+	dq[2] =  q[0]*w[1] - q[1]*w[2] + q[3]*w[0];
+	dq[3] =  q[0]*w[2] + q[1]*w[1] - q[2]*w[0];
+	for(i=0;i<4;i++){
+		q[i] += dq[i] * dt / 2;
+		norm += q[i]*q[i];
+	}
+	norm = sqrt(norm);
+	for(i=0;i<4;i++) q[i] /= norm;
+}
+
+/**
+  * @brief  Synthetic motion at hz: body rates up to a few hundred deg/s and
+	*					linear acceleration as sums of sines, with still periods;
+	*					the reference quaternion integrated from the rates. Raw
+	*					samples at the scales of the raw FIFO with noise and a
+	*					constant gyro bias.
+	*	@param	hz		sample rate
+  * @retval None
+  */
+static void Make_Synth(uint16_t hz){
+	double f[6][3], a[6][3], ph[6][3], bias[3];
+	double q[4] = {1, 0, 0, 0};
+	double w[3], lin[3], g[3], t, env;
+	uint32_t k;
+	uint8_t c, i, j;
+
+	samples = (uint32_t)hz * BenchSeconds;
+	sample = realloc(sample, samples * sizeof(*sample));
+	for(c=0;c<6;c++){
+		for(i=0;i<3;i++){
+			f[c][i] = Rand_Range(0.1, 2.0);
+			a[c][i] = c < 3 ? Rand_Range(0, 0.15) : Rand_Range(0, 60);
+			ph[c][i] = Rand_Range(0, 6.2832);
+		}
+	}
+	for(c=0;c<3;c++) bias[c] = Rand_Range(-0.5, 0.5);//deg/s, left after the self test
+	for(k=0;k<samples;k++){
+		Bench_Sample_t *s = &sample[k];
+		t = (double)k / hz;
+		//gestures of 4 s, 2 s still in between, still for the first second
+		env = t < 1 || fmod(t, 6) > 4 ? 0 : sin(3.14159265 * fmod(t, 6) / 4);
+		g[0] = 2*(q[1]*q[3] - q[0]*q[2]);
+		g[1] = 2*(q[0]*q[1] + q[2]*q[3]);
+		g[2] = q[0]*q[0] - q[1]*q[1] - q[2]*q[2] + q[3]*q[3];
+		for(c=0;c<3;c++){
+			lin[c] = w[c] = 0;
+			for(i=0;i<3;i++){
+				lin[c] += a[c][i] * sin(6.2832 * f[c][i] * t + ph[c][i]);
+				w[c] += a[3+c][i] * sin(6.2832 * f[3+c][i] * t + ph[3+c][i]);
+			}
+			w[c] *= env;
+			s->acc[c] = Sat16((g[c] + lin[c] * env) * FusionAccOne + Rand_Gauss(0.004 * FusionAccOne));
+			s->gyro[c] = Sat16((w[c] + bias[c]) * FusionGyroLsb + Rand_Gauss(0.05 * FusionGyroLsb));
+		}
+		for(i=0;i<4;i++) s->q[i] = (float)q[i];
+		//reference to the next sample, rates held over the interval as the gyro samples them
+		for(c=0;c<3;c++) w[c] /= BenchDeg;
+		for(j=0;j<BenchSubSteps;j++) Quat_Step(q, w, 1.0 / hz / BenchSubSteps);
+	}
+}
+
+/**
+  * @brief  gravity in the body frame, the terms of the DMP path
+  * @retval None
+  */
+static void Gravity(const double q[4], double g[3]){
+	g[0] = 2*(q[1]*q[3] - q[0]*q[2]);
+	g[1] = 2*(q[0]*q[1] + q[2]*q[3]);
+	g[2] = q[0]*q[0] - q[1]*q[1] - q[2]*q[2] + q[3]*q[3];
+}
+
+/**
+  * @brief  r = a * b
+  * @retval None
+  */
+static void Quat_Mult(const double a[4], const double b[4], double r[4]){
+	r[0] = a[0]*b[0] - a[1]*b[1] - a[2]*b[2] - a[3]*b[3];
+	r[1] = a[0]*b[1] + a[1]*b[0] + a[2]*b[3] - a[3]*b[2];
+	r[2] = a[0]*b[2] - a[1]*b[3] + a[2]*b[0] + a[3]*b[1];
+	r[3] = a[0]*b[3] + a[1]*b[2] - a[2]*b[1] + a[3]*b[0];
+}
+
+/**
+  * @brief  Yaw offset between the two frames: the rotation about the world
+	*					vertical that takes the fusion frame to the reference one
+	*	@param	ref		reference quaternion
+	*	@param	q			fusion quaternion
+	*	@param	off		offset out
+  * @retval None
+  */
+static void Yaw_Offset(const double ref[4], const double q[4], double off[4]){
+	double qc[4] = {q[0], -q[1], -q[2], -q[3]};
+	double n;
+
+	Quat_Mult(ref, qc, off);
+	off[1] = off[2] = 0;
+	n = sqrt(off[0]*off[0] + off[3]*off[3]);
+	if(n < 1e-9){
+		off[0] = 1;
+		off[3] = 0;
+		return;
+	}
+	off[0] /= n;
+	off[3] /= n;
+}
+
+/**
+  * @brief  angle of a rotation about z
+  * @retval deg
+  */
+static double Yaw_Angle(const double off[4]){
+	return 2 * atan2(off[3], off[0]) * BenchDeg;
+}
+
+/**
+  * @brief  Run every sample through Fusion_Update() at hz and compare with
+	*					the reference. Errors count from the end of the boot gain.
+	*	@param	hz		sample rate
+	*	@param	e			errors out
+  * @retval None
+  */
+static void Check(uint16_t hz, Bench_Err_t *e){
+	double ref[4], q[4], gr[3], gq[3], off[4] = {1, 0, 0, 0}, end[4], d, dot;
+	uint32_t k, skip;
+	uint8_t i;
+
+	memset(e, 0, sizeof(*e));
+	Fusion_Init(hz);
+	skip = fusion.boot + 1;
+	for(k=0;k<samples;k++){
+		Fusion_Update(sample[k].acc, sample[k].gyro);
+		for(i=0;i<4;i++){
+			ref[i] = sample[k].q[i];
+			q[i] = fusion.q[i];
+		}
+		if(k + 1 == skip) Yaw_Offset(ref, q, off);
+		if(k + 1 <= skip) continue;
+		Gravity(ref, gr);
+		Gravity(q, gq);
+		dot = (gr[0]*gq[0] + gr[1]*gq[1] + gr[2]*gq[2]) /
+					sqrt((gr[0]*gr[0] + gr[1]*gr[1] + gr[2]*gr[2]) * (gq[0]*gq[0] + gq[1]*gq[1] + gq[2]*gq[2]));
+		d = acos(dot > 1 ? 1 : dot < -1 ? -1 : dot) * BenchDeg;
+		if(d > e->tilt_max) e->tilt_max = d;
+		e->tilt_sq += d * d;
+		//attitude with the yaw offset of the end of the boot removed
+		Quat_Mult(off, q, end);
+		dot = fabs(ref[0]*end[0] + ref[1]*end[1] + ref[2]*end[2] + ref[3]*end[3]);
+		d = 2 * acos(dot > 1 ? 1 : dot) * BenchDeg;
+		if(d > e->att_max) e->att_max = d;
+		e->att_sq += d * d;
+		e->n++;
+	}
+	if(e->n){
+		Yaw_Offset(ref, q, end);
+		e->yaw_end = Yaw_Angle(end) - Yaw_Angle(off);
+		if(e->yaw_end > 180) e->yaw_end -= 360;
+		if(e->yaw_end < -180) e->yaw_end += 360;
+	}
+}
+
+/**
+  * @brief  Time Fusion_Update() per sample with Probe_Fusion
+	*	@param	hz		sample rate
+  * @retval None
+  */
+static void Timing(uint16_t hz){
+	const Probe_Stats_t *s = &probe_stats[Probe_Fusion];
+	uint32_t k, round;
+
+	Probe_Reset();
+	for(round=0;round<BenchRounds;round++){
+		Fusion_Init(hz);
+		for(k=0;k<samples;k++) Fusion_Update(sample[k].acc, sample[k].gyro);
+	}
+	printf("  %8.1f  %6u", (double)s->sum / s->count, (unsigned)s->min);
+}
+
+/**
+  * @brief  Check and time one rate, print one row
+	*	@param	hz		sample rate
+	*	@param	limits	1: fail past the synthetic limits
+  * @retval failures
+  */
+static int Run(uint16_t hz, uint8_t limits){
+	Bench_Err_t e;
+	double tilt_rms, att_rms;
+
+	Check(hz, &e);
+	if(e.n == 0){
+		printf("%5u  too few samples for the boot of %u ms\n", hz, FusionBootMs);
+		return 1;
+	}
+	tilt_rms = sqrt(e.tilt_sq / e.n);
+	att_rms = sqrt(e.att_sq / e.n);
+	printf("%5u  %8u  %7.3f  %7.3f  %7.3f  %7.3f  %7.2f", hz, (unsigned)samples,
+				tilt_rms, e.tilt_max, att_rms, e.att_max, e.yaw_end);
+	Timing(hz);
+	printf("\n");
+	if(limits && (tilt_rms > BenchTolTiltRms || e.tilt_max > BenchTolTiltMax)){
+		printf("FAIL  tilt over the limits (%.1f rms, %.1f max)\n", BenchTolTiltRms, BenchTolTiltMax);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv){
+	static const uint16_t rate[] = {100, 200, 500, FusionHzMax};
+	uint16_t hz = argc > 2 ? atoi(argv[2]) : 100;
+	uint8_t r;
+	int fail = 0;
+
+	srand(argc > 3 ? atoi(argv[3]) : 1);
+	if(argc > 1 && strcmp(argv[1], "-") != 0 && Load_Capture(argv[1])) return 1;
+	printf("tilt: gravity vectors, attitude: yaw offset at the end of the boot removed, deg\n");
+	printf("   hz   samples  tilt rms     max  att rms     max  yaw end  ns/sample  min\n");
+	if(samples){
+		Run(hz, 0);//the DMP is the reference, not the truth
+	}
+	else{
+		for(r=0;r<sizeof(rate)/sizeof(rate[0]);r++){
+			Make_Synth(rate[r]);
+			fail += Run(rate[r], 1);
+		}
+		printf("\n%s\n", fail ? "FAILED" : "tilt within limits");
+	}
+	return fail != 0;
+}
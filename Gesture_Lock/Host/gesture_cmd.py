@@ -0,0 +1,360 @@
+#!/usr/bin/env python3
+"""Client of the framed command protocol of the device over USB CDC.
+
+  gesture_cmd.py PORT ping [-n COUNT] [-l BYTES]
+  gesture_cmd.py PORT stats [--reset]
+  gesture_cmd.py PORT param [NAME [VALUE]]
+  gesture_cmd.py PORT save | default
+  gesture_cmd.py PORT enroll G G G ... | verify G G G ...
+  gesture_cmd.py PORT trace OUT.csv
+  gesture_cmd.py PORT probe [ID]
+
+Frames are 0x00, COBS(cmd, seq, payload, crc16), 0x00 as in Src/cmd.c;
+the commands are in Inc/cmd.h and Inc/param.h. Set, save, default,
+trace, enroll, verify and starting the stream need the device unlocked
+with the key. "ping" is the round trip benchmark: it prints the min,
+median, 99th percentile and max time of COUNT pings. The Device class
+is the library the other host tools use. Needs pyserial.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+# Inc/param.h
+PARAM_FUNC_GET = 0xB0
+PARAM_FUNC_SET = 0xB1
+PARAM_FUNC_SAVE = 0xB2
+PARAM_FUNC_DEFAULT = 0xB3
+PARAM_ID_ALL = 0xFF
+PARAM_NAMES = ["motion_gap_time", "motion_dur_time", "acc_peak_gap_time",
+               "motion_peak_th", "peak_samp_num", "peak_max_pre",
+               "min_seq_len", "mpu_hz"]
+PARAM_STATUS = ["ok", "unknown id", "out of range", "bad frame", "flash error",
+                "locked"]
+
+# Inc/cmd.h
+CMD_SCHED = 0xB4
+CMD_STREAM = 0xB5
+CMD_TRACE = 0xB6
+CMD_ENROLL = 0xB7
+CMD_VERIFY = 0xB8
+CMD_STATS = 0xB9
+CMD_PING = 0xBA
+CMD_LOG = 0xBB
+CMD_LOG_FMT = 0xBC
+CMD_PROBE = 0xBD
+CMD_SAMPLE = 0xA3
+CMD_PAYLOAD_MAX = 128
+CMD_STATUS = ["ok", "unknown command", "bad length", "locked", "busy"]
+TRACE_SAMPLE = 16
+
+# Cmd_Stats_Pack(), u32 each
+STATS_NAMES = ["frames", "cobs_err", "crc_err", "overflow", "replies", "sent",
+               "dropped", "lat_last_us", "lat_max_us",
+               "cdc_bytes", "cdc_dropped", "cdc_sent", "cdc_rate", "cdc_fill_max",
+               "tlm_frames", "tlm_dropped", "key_dropped",
+               "bus_errors", "bus_faults", "bus_recoveries",
+               "log_records", "log_dropped", "log_cycles", "printf_cycles"]
+
+
+class ProtocolError(Exception):
+    pass
+
+
+# ----------------------------------------------------------------------------
+# Framing, as in Src/cmd.c
+# ----------------------------------------------------------------------------
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_at, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+        else:
+            out.append(b)
+            code += 1
+            if code == 0xFF:
+                out[code_at] = code
+                code_at, code = len(out), 1
+                out.append(0)
+    out[code_at] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    r = 0
+    while r < len(data):
+        code = data[r]
+        r += 1
+        if code == 0 or r + code - 1 > len(data):
+            return None
+        out += data[r:r + code - 1]
+        r += code - 1
+        if code != 0xFF and r < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def frame(cmd, seq, payload=b""):
+    raw = bytes([cmd, seq]) + payload
+    crc = crc16(raw)
+    return b"\x00" + cobs_encode(raw + bytes([crc >> 8, crc & 0xFF])) + b"\x00"
+
+
+class FrameReader:
+    """Splits the byte stream of the device into (cmd, seq, payload).
+
+    Broken frames and text printed between frames are skipped, "bad"
+    counts them.
+    """
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.bad = 0
+
+    def feed(self, data):
+        self.buf += data
+        frames = []
+        while True:
+            i = self.buf.find(0)
+            if i < 0:
+                return frames
+            enc = bytes(self.buf[:i])
+            del self.buf[:i + 1]
+            if not enc:
+                continue
+            raw = cobs_decode(enc)
+            if raw is None or len(raw) < 4 or crc16(raw[:-2]) != (raw[-2] << 8 | raw[-1]):
+                self.bad += 1
+                continue
+            frames.append((raw[0], raw[1], raw[2:-2]))
+
+
+# ----------------------------------------------------------------------------
+# Device
+# ----------------------------------------------------------------------------
+
+class Device:
+    """One request at a time; frames the device sends on its own (samples,
+    log records, trace chunks) go to on_frame(cmd, seq, payload)."""
+
+    def __init__(self, port, timeout=1.0, on_frame=None):
+        import serial
+        self.port = serial.Serial(port, timeout=0.01)
+        self.port.reset_input_buffer()
+        self.reader = FrameReader()
+        self.timeout = timeout
+        self.on_frame = on_frame
+        self.seq = 0
+        self.pending = []       # frames that came with a reply, for frames()
+
+    def close(self):
+        self.port.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def poll(self):
+        """Read what has arrived, returns the frames not taken by on_frame."""
+        rest = []
+        for f in self.reader.feed(self.port.read(self.port.in_waiting or 1)):
+            if self.on_frame is not None and self.on_frame(*f):
+                continue
+            rest.append(f)
+        return rest
+
+    def frames(self):
+        """The frames left over by request(), then the new ones."""
+        rest, self.pending = self.pending, []
+        return rest + self.poll()
+
+    def request(self, cmd, payload=b""):
+        """Send a request and wait for the reply with its cmd and seq."""
+        if len(payload) > CMD_PAYLOAD_MAX:
+            raise ProtocolError("payload of %d bytes" % len(payload))
+        self.seq = (self.seq + 1) & 0xFF
+        self.port.write(frame(cmd, self.seq, bytes(payload)))
+        end = time.monotonic() + self.timeout
+        reply = None
+        while reply is None and time.monotonic() < end:
+            for f in self.poll():
+                if reply is None and f[0] == cmd and f[1] == self.seq:
+                    reply = f[2]
+                else:
+                    self.pending = self.pending[-1023:] + [f]
+        if reply is not None:
+            return reply
+        raise ProtocolError("no reply to 0x%02X" % cmd)
+
+    def _status(self, data, at=0, names=CMD_STATUS):
+        """Raise on a bad status at data[at], returns what follows it."""
+        if len(data) <= at:
+            raise ProtocolError("short reply")
+        if data[at]:
+            raise ProtocolError(names[data[at]] if data[at] < len(names) else str(data[at]))
+        return data[at + 1:]
+
+    def ping(self, payload=b""):
+        if self.request(CMD_PING, payload) != bytes(payload):
+            raise ProtocolError("ping payload changed")
+
+    def stats(self, reset=False):
+        data = self.request(CMD_STATS, bytes([1]) if reset else b"")
+        v = struct.unpack(">%dI" % (len(data) // 4), data)
+        return dict(zip(STATS_NAMES, v))
+
+    def param_get(self, pid=PARAM_ID_ALL):
+        data = self.request(PARAM_FUNC_GET, bytes([pid]))
+        if len(data) == 2:
+            self._status(data, 1, PARAM_STATUS)
+        out = {}
+        for i in range(0, len(data) - 5, 6):
+            pid, ptype, raw = data[i], data[i + 1], struct.unpack(">I", data[i + 2:i + 6])[0]
+            name = PARAM_NAMES[pid] if pid < len(PARAM_NAMES) else str(pid)
+            out[name] = struct.unpack(">f", struct.pack(">I", raw))[0] if ptype == 3 else raw
+        return out
+
+    def param_set(self, name, value):
+        pid = PARAM_NAMES.index(name)
+        if isinstance(value, float):
+            raw = struct.pack(">f", value)
+        else:
+            raw = struct.pack(">I", value)
+        self._status(self.request(PARAM_FUNC_SET, bytes([pid]) + raw), 1, PARAM_STATUS)
+
+    def param_save(self):
+        self._status(self.request(PARAM_FUNC_SAVE), 0, PARAM_STATUS)
+
+    def param_default(self):
+        self._status(self.request(PARAM_FUNC_DEFAULT), 0, PARAM_STATUS)
+
+    def stream(self, on):
+        """Start or stop the CmdSample stream, returns rate, sent, dropped."""
+        data = self._status(self.request(CMD_STREAM, bytes([1 if on else 0])))
+        return struct.unpack(">3I", data[:12])
+
+    def enroll(self, seq):
+        self._status(self.request(CMD_ENROLL, bytes(seq)))
+
+    def verify(self, seq):
+        return self._status(self.request(CMD_VERIFY, bytes(seq)))[0] == 1
+
+    def log_fmt(self, log_id):
+        return self._status(self.request(CMD_LOG_FMT, bytes([log_id]))).decode("latin-1")
+
+    def probe(self, probe_id):
+        return self._status(self.request(CMD_PROBE, bytes([probe_id])))
+
+    def trace(self):
+        """Dump the trace ring, oldest first: (tick, (ax, ay, az), (gx, gy, gz))."""
+        data = self._status(self.request(CMD_TRACE))
+        count = data[0] << 8 | data[1]
+        seq, samples = self.seq, {}
+        end = time.monotonic() + self.timeout + count * 0.01
+        while len(samples) < count and time.monotonic() < end:
+            for c, s, chunk in self.frames():
+                if c != CMD_TRACE or s != seq or len(chunk) < 2:
+                    continue
+                index = chunk[0] << 8 | chunk[1]
+                for k in range(2, len(chunk) - TRACE_SAMPLE + 1, TRACE_SAMPLE):
+                    v = struct.unpack(">I6h", chunk[k:k + TRACE_SAMPLE])
+                    samples[index] = (v[0], v[1:4], v[4:7])
+                    index += 1
+        if len(samples) < count:
+            raise ProtocolError("trace: %d of %d samples" % (len(samples), count))
+        return [samples[i] for i in range(count)]
+
+
+# ----------------------------------------------------------------------------
+# Command line
+# ----------------------------------------------------------------------------
+
+def round_trip(dev, count, size):
+    payload = bytes(i & 0xFF or 1 for i in range(size))
+    t = []
+    for _ in range(count):
+        t0 = time.perf_counter()
+        dev.ping(payload)
+        t.append((time.perf_counter() - t0) * 1000)
+    t.sort()
+    print("%d pings of %d bytes: min %.2f  median %.2f  p99 %.2f  max %.2f ms"
+          % (count, size, t[0], t[len(t) // 2], t[min(len(t) - 1, len(t) * 99 // 100)], t[-1]))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("port")
+    sub = ap.add_subparsers(dest="what", required=True)
+    p = sub.add_parser("ping")
+    p.add_argument("-n", "--count", type=int, default=1000)
+    p.add_argument("-l", "--bytes", type=int, default=0)
+    p = sub.add_parser("stats")
+    p.add_argument("--reset", action="store_true")
+    p = sub.add_parser("param")
+    p.add_argument("name", nargs="?")
+    p.add_argument("value", nargs="?")
+    sub.add_parser("save")
+    sub.add_parser("default")
+    for name in ("enroll", "verify"):
+        p = sub.add_parser(name)
+        p.add_argument("gestures", type=int, nargs="+")
+    p = sub.add_parser("trace")
+    p.add_argument("output")
+    p = sub.add_parser("probe")
+    p.add_argument("id", type=int, nargs="?", default=0)
+    args = ap.parse_args()
+
+    try:
+        with Device(args.port) as dev:
+            if args.what == "ping":
+                round_trip(dev, args.count, args.bytes)
+            elif args.what == "stats":
+                for k, v in dev.stats(args.reset).items():
+                    print("%-16s %u" % (k, v))
+            elif args.what == "param":
+                if args.value is not None:
+                    dev.param_set(args.name, float(args.value) if "." in args.value else int(args.value, 0))
+                pid = PARAM_ID_ALL if args.name is None else PARAM_NAMES.index(args.name)
+                for k, v in dev.param_get(pid).items():
+                    print("%-18s %s" % (k, v))
+            elif args.what == "save":
+                dev.param_save()
+            elif args.what == "default":
+                dev.param_default()
+            elif args.what == "enroll":
+                dev.enroll(args.gestures)
+            elif args.what == "verify":
+                print("match" if dev.verify(args.gestures) else "no match")
+            elif args.what == "trace":
+                with open(args.output, "w") as out:
+                    out.write("tick,ax,ay,az,gx,gy,gz\n")
+                    for tick, acc, gyro in dev.trace():
+                        out.write("%u,%d,%d,%d,%d,%d,%d\n" % ((tick,) + acc + gyro))
+            elif args.what == "probe":
+                print(dev.probe(args.id).hex())
+    except ProtocolError as e:
+        print("%s: %s" % (args.what, e), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Record the raw sample stream of the device for the host benchmarks.
+
+  imu_capture.py PORT samples.bin [-s SECONDS]
+
+Turns the stream on with CmdStream (Inc/cmd.h), writes every
+CmdSample payload (Src/serial_debug.c, Stream_Data: accel and gyro int16,
+then the DMP quaternion int32 q30, big endian, 28 bytes) back to back, and
+turns it off again. The rate is the sampling rate of the device, param
+mpu_hz. The device must be unlocked with the key. Uses gesture_cmd.py,
+needs pyserial.
+"""
+
+import argparse
+import sys
+import time
+
+from gesture_cmd import CMD_SAMPLE, Device, ProtocolError
+
+SAMPLE_SIZE = 28
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("port")
+    ap.add_argument("output")
+    ap.add_argument("-s", "--seconds", type=float, default=60)
+    args = ap.parse_args()
+
+    n = 0
+
+    def on_frame(cmd, seq, data):
+        nonlocal n
+        if cmd != CMD_SAMPLE or len(data) != SAMPLE_SIZE:
+            return False
+        out.write(data)
+        n += 1
+        return True
+
+    with Device(args.port, on_frame=on_frame) as dev, open(args.output, "wb") as out:
+        try:
+            dev.stream(True)
+        except ProtocolError as e:
+            print("stream: %s" % e, file=sys.stderr)
+            return 1
+        end = time.time() + args.seconds
+        while time.time() < end:
+            dev.poll()
+        dev.stream(False)
+        bad = dev.reader.bad
+    print("%s: %d samples in %.0f s, %d bad frames" % (args.output, n, args.seconds, bad))
+    return 0 if n else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
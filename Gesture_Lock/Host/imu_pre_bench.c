@@ -0,0 +1,366 @@
+/**
+  ******************************************************************************
+  * File Name          : imu_pre_bench.c
+  * Description        : Host check and benchmark of the Q15 IMU chain
+	*											 (imu_pre.c). Every sample goes through the chain and
+	*											 through the float path MPU_Update() had before it
+	*											 (double, /8192, /16.4, quaternion gravity terms), with
+	*											 the same calibration and normalization in double.
+	*											 Per channel error of the gravity removed motion, the
+	*											 Q3.12 features and the q7 window is printed, and the
+	*											 error of Imu_Pre_Motion(), the single precision path
+	*											 MPU_Update() gives the detector; the run fails past
+	*											 the limits below. Then Imu_Pre_Run() is timed per
+	*											 block size with the Probe_Imu_Pre probe, next to
+	*											 the double path and to MPU_Update() per sample, and
+	*											 Probe_Print() lists the chain runs of the
+	*											 MPU_Update() loop, worst one included. Samples are a
+	*											 CmdSample capture (imu_capture.py) or synthetic
+	*											 motion. Device cycles: Probe_Imu_Pre over CmdProbe.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "imu_pre.h"
+#include "probe.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define BenchHz					100			//synthetic motion
+#define BenchSynth			6000		//synthetic samples, 60 s
+#define BenchMax				200000	//samples read from a capture
+#define BenchSampleSize	28			//CmdSample payload (serial_debug.c)
+#define BenchRounds			20			//passes over the samples per timed block size
+#define BenchTolMotion	4				//ImuPreAccOne or ImuPreGyroLsb units
+#define BenchTolFeat		8			//Q3.12 LSB
+#define BenchTolQ7			1				//Q3.4 LSB
+#define BenchTolFloat		0.05		//ImuPreAccOne or ImuPreGyroLsb units, Imu_Pre_Motion()
+
+/* Private types -------------------------------------------------------------*/
+typedef struct{
+	int16_t	acc[3];
+	int16_t	gyro[3];
+	float		q[4];
+} Bench_Sample_t;
+
+typedef struct{
+	double	max;
+	double	sq;
+	uint32_t	n;
+} Bench_Err_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Bench_Sample_t	*sample;
+static uint32_t				samples;
+static const char			*ch_name[ImuPreCh] = {"ax", "ay", "az", "gx", "gy", "gz"};
+static volatile double	sink;
+
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  uniform random number
+  * @retval lo..hi
+  */
+static double Rand_Range(double lo, double hi){
+	return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+/**
+  * @brief  round and clamp to int16
+  * @retval value
+  */
+static int16_t Sat16(double v){
+	v = floor(v + 0.5);
+	if(v > 32767) return 32767;
+	if(v < -32768) return -32768;
+	return (int16_t)v;
+}
+
+/**
+  * @brief  Read a capture: CmdSample payloads back to back, accel and gyro
+	*					int16 then the quaternion int32 q30, big endian
+	*	@param	path	file
+  * @retval 0: ok
+  */
+static int Load_Capture(const char *path){
+	uint8_t b[BenchSampleSize];
+	FILE *f = fopen(path, "rb");
+	uint8_t i;
+
+	if(f == NULL){
+		perror(path);
+		return 1;
+	}
+	sample = malloc(BenchMax * sizeof(*sample));
+	while(samples < BenchMax && fread(b, 1, sizeof(b), f) == sizeof(b)){
+		Bench_Sample_t *s = &sample[samples++];
+		for(i=0;i<3;i++){
+			s->acc[i] = (int16_t)(b[2*i]<<8 | b[2*i+1]);
+			s->gyro[i] = (int16_t)(b[6+2*i]<<8 | b[6+2*i+1]);
+		}
+		for(i=0;i<4;i++){
+			const uint8_t *p = &b[12+4*i];
+			s->q[i] = (int32_t)((uint32_t)p[0]<<24 | p[1]<<16 | p[2]<<8 | p[3]) / 1073741824.0f;
+		}
+	}
+	fclose(f);
+	printf("%s: %u samples\n", path, (unsigned)samples);
+	return samples == 0;
+}
+
+/**
+  * @brief  Synthetic motion at BenchHz: body rates and linear acceleration
+	*					as sums of sines, the quaternion integrated from the rates,
+	*					raw samples with noise at the scale of the float path
+  * @retval None
+  */
+static void Make_Synth(void){
+	double f[6][3], a[6][3], ph[6][3];
+	double q[4] = {1, 0, 0, 0};
+	double w[3], lin[3], g[3], dq[4], t, norm;
+	uint32_t k;
+	uint8_t c, i;
+
+	samples = BenchSynth;
+	sample = malloc(samples * sizeof(*sample));
+	for(c=0;c<6;c++){
+		for(i=0;i<3;i++){
+			f[c][i] = Rand_Range(0.1, 3.0);
+			a[c][i] = c < 3 ? Rand_Range(0, 0.5) : Rand_Range(0, 70);
+			ph[c][i] = Rand_Range(0, 6.2832);
+		}
+	}
+	for(k=0;k<samples;k++){
+		Bench_Sample_t *s = &sample[k];
+		t = (double)k / BenchHz;
+		for(c=0;c<3;c++){
+			lin[c] = w[c] = 0;
+			for(i=0;i<3;i++){
+				lin[c] += a[c][i] * sin(6.2832 * f[c][i] * t + ph[c][i]);
+				w[c] += a[3+c][i] * sin(6.2832 * f[3+c][i] * t + ph[3+c][i]);
+			}
+		}
+		g[0] = 2*(q[1]*q[3] - q[0]*q[2]);
+		g[1] = 2*(q[0]*q[1] + q[2]*q[3]);
+		g[2] = q[0]*q[0] - q[1]*q[1] - q[2]*q[2] + q[3]*q[3];
+		for(c=0;c<3;c++){
+			s->acc[c] = Sat16((g[c] + lin[c]) * ImuPreAccOne + Rand_Range(-8, 8));
+			s->gyro[c] = Sat16(w[c] * ImuPreGyroLsb + Rand_Range(-8, 8));
+		}
+		for(i=0;i<4;i++) s->q[i] = (float)q[i];
+		//q += q * (0, w) / 2 * dt, body rates in rad/s
+		for(c=0;c<3;c++) w[c] *= 3.14159265 / 180 / BenchHz / 2;
+		dq[0] = -q[1]*w[0] - q[2]*w[1] - q[3]*w[2];
+		dq[1] =  q[0]*w[0] + q[2]*w[2] - q[3]*w[1];
+		dq[2] =  q[0]*w[1] - q[1]*w[2] + q[3]*w[0];
+		dq[3] =  q[0]*w[2] + q[1]*w[1] - q[2]*w[0];
+		norm = 0;
+		for(i=0;i<4;i++){
+			q[i] += dq[i];
+			norm += q[i]*q[i];
+		}
+		for(i=0;i<4;i++) q[i] /= sqrt(norm);
+	}
+	printf("synthetic motion: %u samples at %d Hz\n", (unsigned)samples, BenchHz);
+}
+
+/**
+  * @brief  The float path of MPU_Update(), with calibration
+	*	@param	s			sample
+	*	@param	cal		calibration
+	*	@param	out		ax ay az in g, gx gy gz in deg/s
+  * @retval None
+  */
+static void Float_Path(const Bench_Sample_t *s, const Imu_Pre_Cal_t *cal, double out[ImuPreCh]){
+	const float *q = s->q;
+	uint8_t c;
+
+	for(c=0;c<3;c++){
+		out[c] = (s->acc[c] - cal->bias[c]) * cal->gain[c] / ImuPreAccOne;
+		out[3+c] = (s->gyro[c] - cal->bias[3+c]) * cal->gain[3+c] / ImuPreGyroLsb;
+	}
+	out[0] += 2*(q[0]*q[2] - q[1]*q[3]);
+	out[1] -= 2*(q[2]*q[3] + q[0]*q[1]);
+	out[2] += -1 + 2*(q[1]*q[1] + q[2]*q[2]);
+}
+
+/**
+  * @brief  clamp to the range of a Q15 value of unit one
+  * @retval value
+  */
+static double Clamp(double v, double one){
+	if(v > 32767 / one) return 32767 / one;
+	if(v < -32768 / one) return -32768 / one;
+	return v;
+}
+
+/**
+  * @brief  add one error
+  * @retval None
+  */
+static void Err_Add(Bench_Err_t *e, double d){
+	d = fabs(d);
+	if(d > e->max) e->max = d;
+	e->sq += d * d;
+	e->n++;
+}
+
+/**
+  * @brief  Run every sample through the chain in blocks of block samples
+	*					and compare with the float path
+	*	@param	name	printed
+	*	@param	cal		calibration
+	*	@param	block	samples per Imu_Pre_Run()
+  * @retval failures
+  */
+static int Check(const char *name, const Imu_Pre_Cal_t *cal, uint16_t block){
+	Bench_Err_t motion[ImuPreCh], feat[ImuPreCh], q7[ImuPreCh];
+	double ref[ImuPreCh], unit, r, x, fmax = 0;
+	float m[ImuPreCh];
+	uint32_t k, base;
+	uint16_t i, n;
+	uint8_t c;
+	int fail = 0;
+
+	memset(motion, 0, sizeof(motion));
+	memset(feat, 0, sizeof(feat));
+	memset(q7, 0, sizeof(q7));
+	Imu_Pre_Init(cal);
+	for(base=0;base<samples;base+=n){
+		n = samples - base < block ? samples - base : block;
+		for(i=0;i<n;i++) Imu_Pre_Push(sample[base+i].acc, sample[base+i].gyro, sample[base+i].q);
+		Imu_Pre_Run();
+		for(i=0;i<n;i++){
+			k = base + i;
+			Float_Path(&sample[k], cal, ref);
+			Imu_Pre_Motion(sample[k].acc, sample[k].gyro, sample[k].q, m);
+			for(c=0;c<ImuPreCh;c++){
+				unit = c < 3 ? ImuPreAccOne : ImuPreGyroLsb;
+				if(fabs(m[c] - ref[c]) * unit > fmax) fmax = fabs(m[c] - ref[c]) * unit;
+				r = Clamp(ref[c], unit);
+				Err_Add(&motion[c], (imu_pre.motion[c][i] / unit - r) * unit);
+				//features from the motion of the chain: one gyro LSB is 1/16.4 dps,
+				//up to 8 Q3.12 LSB of a feature, so the motion error is not carried on
+				r = Clamp((imu_pre.motion[c][i] / unit - cal->mean[c]) / cal->std[c], ImuPreFeatOne);
+				Err_Add(&feat[c], imu_pre.feat[c][i] - r * ImuPreFeatOne);
+				x = floor(r * 16);
+				if(x > 127) x = 127;
+				if(x < -128) x = -128;
+				Err_Add(&q7[c], imu_pre.window[ImuPreWindow - n + i][c] - x);
+			}
+		}
+	}
+	printf("\n%s, blocks of %u\n", name, block);
+	printf("ch   motion max   rms     unit      feat max  rms   (Q3.12)  q7 max\n");
+	for(c=0;c<ImuPreCh;c++){
+		printf("%s  %9.3f %8.3f  %-10s  %6.2f %6.2f           %4.0f\n", ch_name[c],
+					motion[c].max, sqrt(motion[c].sq / motion[c].n), c < 3 ? "1/8192 g" : "1/16.4 dps",
+					feat[c].max, sqrt(feat[c].sq / feat[c].n), q7[c].max);
+		if(motion[c].max > BenchTolMotion || feat[c].max > BenchTolFeat || q7[c].max > BenchTolQ7){
+			printf("FAIL  %s over the limits (%d, %d, %d)\n", ch_name[c], BenchTolMotion, BenchTolFeat, BenchTolQ7);
+			fail++;
+		}
+	}
+	printf("Imu_Pre_Motion max %.4f LSB\n", fmax);
+	if(fmax > BenchTolFloat){
+		printf("FAIL  Imu_Pre_Motion over the limit (%.2f)\n", BenchTolFloat);
+		fail++;
+	}
+	return fail;
+}
+
+/**
+  * @brief  Time Imu_Pre_Run() per block size with Probe_Imu_Pre, and the
+	*					float path per sample
+  * @retval None
+  */
+static void Timing(void){
+	static const uint16_t size[] = {1, 2, 4, 8, 16, 32};
+	const Probe_Stats_t *s = &probe_stats[Probe_Imu_Pre];
+	double ref[ImuPreCh];
+	float m[ImuPreCh];
+	uint32_t k, t0, round;
+	uint16_t i, n;
+	uint8_t b;
+
+	printf("\nblock  runs      ns/block  min     ns/sample\n");
+	Imu_Pre_Init(NULL);
+	for(b=0;b<sizeof(size)/sizeof(size[0]);b++){
+		Probe_Reset();
+		for(round=0;round<BenchRounds;round++){
+			for(k=0;k+size[b]<=samples;k+=size[b]){
+				for(i=0;i<size[b];i++) Imu_Pre_Push(sample[k+i].acc, sample[k+i].gyro, sample[k+i].q);
+				Imu_Pre_Run();
+			}
+		}
+		n = size[b];
+		printf("%5u  %8u  %8.1f  %6u  %9.1f\n", n, (unsigned)s->count, (double)s->sum / s->count,
+					(unsigned)s->min, (double)s->sum / s->count / n);
+	}
+	t0 = Probe_Now();
+	for(round=0;round<BenchRounds;round++){
+		for(k=0;k<samples;k++){
+			Float_Path(&sample[k], &imu_pre_cal_default, ref);
+			sink = ref[0] + ref[5];
+		}
+	}
+	printf("double path per sample          %9.1f\n", (double)(uint32_t)(Probe_Now() - t0) / samples / BenchRounds);
+	//MPU_Update(): Imu_Pre_Motion() for each sample, the chain on full blocks
+	Imu_Pre_Init(NULL);
+	Probe_Reset();
+	t0 = Probe_Now();
+	for(round=0;round<BenchRounds;round++){
+		for(k=0;k<samples;k++){
+			Imu_Pre_Motion(sample[k].acc, sample[k].gyro, sample[k].q, m);
+			sink = m[0] + m[5];
+			Imu_Pre_Push(sample[k].acc, sample[k].gyro, sample[k].q);
+			if(imu_pre.n >= ImuPreBlock) Imu_Pre_Run();
+		}
+	}
+	printf("MPU_Update per sample           %9.1f\n", (double)(uint32_t)(Probe_Now() - t0) / samples / BenchRounds);
+	Imu_Pre_Init(NULL);
+	t0 = Probe_Now();
+	for(round=0;round<BenchRounds;round++){
+		for(k=0;k<samples;k++){
+			Imu_Pre_Motion(sample[k].acc, sample[k].gyro, sample[k].q, m);
+			sink = m[0] + m[5];
+		}
+	}
+	printf("of it Imu_Pre_Motion            %9.1f\n", (double)(uint32_t)(Probe_Now() - t0) / samples / BenchRounds);
+	Probe_Print();//chain runs of the MPU_Update() loop, with the worst one
+}
+
+int main(int argc, char **argv){
+	static const uint16_t block[] = {1, 7, ImuPreBlock};
+	Imu_Pre_Cal_t cal;
+	uint8_t c, b;
+	int fail = 0;
+
+	srand(argc > 2 ? atoi(argv[2]) : 1);
+	if(argc > 1 && strcmp(argv[1], "-") != 0){
+		if(Load_Capture(argv[1])) return 1;
+	}
+	else{
+		Make_Synth();
+	}
+	for(c=0;c<ImuPreCh;c++){
+		cal.bias[c] = c < 3 ? Rand_Range(-300, 300) : Rand_Range(-100, 100);
+		cal.gain[c] = Rand_Range(0.9, 1.1);
+		cal.mean[c] = c < 3 ? Rand_Range(-0.1, 0.1) : Rand_Range(-5, 5);
+		cal.std[c] = c < 3 ? Rand_Range(0.2, 0.6) : Rand_Range(30, 90);
+	}
+	for(b=0;b<sizeof(block)/sizeof(block[0]);b++){
+		fail += Check("default calibration", &imu_pre_cal_default, block[b]);
+	}
+	fail += Check("random calibration", &cal, ImuPreBlock);
+	Timing();
+	printf("\n%s\n", fail ? "FAILED" : "all channels within limits");
+	return fail != 0;
+}
@@ -0,0 +1,288 @@
+/**
+  ******************************************************************************
+  * File Name          : key_test.c
+  * Description        : Host test of the user key (key.c) with bouncing
+	*											 contacts. The key is simulated in 100 us steps: each
+	*											 press and release chatters for up to TestBounceMax,
+	*											 every level change raises the EXTI callback and the
+	*											 1 ms SysTick runs Key_Tick(). Fixed waveforms check
+	*											 each event kind and its time, a key held at boot and
+	*											 a stalled main loop, then random bursts of clicks are
+	*											 compared with the events their clean waveform should
+	*											 give. Usage: key_test [seed [bursts]]
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "key.h"
+#include "main.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestSubSteps		10		//simulation steps per ms
+#define TestBounceMax		8			//ms of contact chatter after an edge
+#define TestMargin			40		//ms, random durations keep off the thresholds
+#define TestEventsMax		64
+
+/* Private types -------------------------------------------------------------*/
+typedef struct{
+	const char	*name;
+	uint16_t		ms[8];			//press, release, press, ... durations, 0 ends
+	uint8_t			bounce;			//chatter on the edges
+	Key_Event_t	expect[8];	//events in order, Key_None ends
+} Test_Wave_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const Test_Wave_t waves[] = {
+	{"clean click",				{100},							0, {Key_Press, Key_Short}},
+	{"bouncing click",		{100},							1, {Key_Press, Key_Short}},
+	{"long press",				{1500},							1, {Key_Press, Key_Long}},
+	{"double click",			{80, 100, 80},			1, {Key_Press, Key_Press, Key_Double}},
+	{"click, then hold",	{80, 100, 1200},		1, {Key_Press, Key_Press, Key_Short, Key_Long}},
+	{"two slow clicks",		{80, 400, 80},			1, {Key_Press, Key_Short, Key_Press, Key_Short}},
+	{"10 ms glitch",			{10},								0, {Key_None}},
+};
+
+static Key_Msg_t	events[TestEventsMax];
+static uint8_t		event_cnt;
+static uint32_t		sub;				//100 us steps within host_tick
+static uint32_t		press_ms;		//time of the last clean press edge
+static uint8_t		drain = 1;	//main loop reads the queue
+static int				fails;
+/* Private user code ---------------------------------------------------------*/
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+/**
+  * @brief  set the pin, active low as on the board, EXTI on a change
+  * @retval None
+  */
+static void Test_Level(uint8_t pressed){
+	uint32_t idr = pressed ? 0 : KEY_Pin;
+	if((KEY_GPIO_Port->IDR & KEY_Pin) == idr) return;
+	KEY_GPIO_Port->IDR = (KEY_GPIO_Port->IDR & ~(uint32_t)KEY_Pin) | idr;
+	HAL_GPIO_EXTI_Callback(KEY_Pin);
+}
+
+/**
+  * @brief  one 100 us step, SysTick and the main loop on each ms
+  * @retval None
+  */
+static void Test_Step(void){
+	Key_Msg_t m;
+
+	if(++sub < TestSubSteps) return;
+	sub = 0;
+	host_tick++;
+	Key_Tick();
+	while(drain && Key_Get(&m)){
+		if(event_cnt < TestEventsMax) events[event_cnt++] = m;
+	}
+}
+
+/**
+  * @brief  hold a level for ms, chattering for the first bounce ms
+	*	@param	pressed		level after the edge
+	*	@param	ms				time until the next edge
+	*	@param	bounce		chatter time, 0: clean edge
+  * @retval None
+  */
+static void Test_Hold(uint8_t pressed, uint32_t ms, uint32_t bounce){
+	uint32_t i, n = ms * TestSubSteps, b = bounce * TestSubSteps;
+
+	if(pressed) press_ms = host_tick;
+	for(i=0;i<n;i++){
+		if(i < b && i + 2 < n) Test_Level((rand() % 3) ? pressed : !pressed);
+		else Test_Level(pressed);
+		Test_Step();
+	}
+}
+
+static void Test_Begin(void){
+	KEY_GPIO_Port->IDR |= KEY_Pin;	//released
+	Key_Init();
+	event_cnt = 0;
+	key_dropped = 0;
+}
+
+/**
+  * @brief  play a waveform and let the key go idle
+  * @retval None
+  */
+static void Test_Play(const uint16_t *ms, uint8_t n, uint32_t bounce){
+	uint8_t i;
+	for(i=0;i<n;i++) Test_Hold(!(i & 1), ms[i], bounce);
+	Test_Hold(0, ShortPressMax + DoubleClickGap, bounce);
+}
+
+static const char *Test_Name(uint8_t ev){
+	static const char *names[] = {"None", "Press", "Short", "Long", "Double"};
+	return ev <= Key_Double ? names[ev] : "?";
+}
+
+/**
+  * @brief  the events of a clean waveform, from the durations
+	*	@param	ms		press, release, ... durations, the key stays
+	*							released after the last one
+  * @retval number of events
+  */
+static uint8_t Test_Expect(const uint16_t *ms, uint8_t n, Key_Event_t *ev){
+	uint8_t i, k = 0, first = 1;
+
+	for(i=0;i<n;i+=2){
+		ev[k++] = Key_Press;
+		if(ms[i] >= ShortPressMax){							//long
+			if(!first) ev[k++] = Key_Short;				//click, then hold
+			ev[k++] = Key_Long;
+			first = 1;
+		}
+		else if(!first){
+			ev[k++] = Key_Double;
+			first = 1;
+		}
+		else if(i + 2 >= n || ms[i+1] >= DoubleClickGap){//last press, key idle after
+			ev[k++] = Key_Short;
+		}
+		else first = 0;
+	}
+	return k;
+}
+
+/**
+  * @brief  random bursts of one to three presses, short or long, with
+	*					short or long gaps and bouncing edges, against Test_Expect()
+  * @retval None
+  */
+static void Test_Random(uint32_t bursts){
+	static const uint16_t lo[4] = {KeyDebounceTime + TestMargin, ShortPressMax + TestMargin,
+																 KeyDebounceTime + TestMargin, DoubleClickGap + TestMargin};
+	static const uint16_t hi[4] = {ShortPressMax - TestMargin, 2 * ShortPressMax,
+																 DoubleClickGap - TestMargin, 3 * DoubleClickGap};
+	uint16_t ms[6];
+	Key_Event_t ev[12];
+	uint32_t c, wrong = 0, late = 0, total = 0, press_at, d;
+	uint8_t i, k, n, presses;
+	char what[64];
+
+	Test_Begin();
+	for(c=0;c<bursts;c++){
+		presses = 1 + rand() % 3;
+		for(i=0;i<2*presses;i++){
+			k = (i & 1) * 2 + (rand() % 4 == 0);	//one in four long
+			ms[i] = lo[k] + rand() % (hi[k] - lo[k]);
+		}
+		n = Test_Expect(ms, 2 * presses, ev);
+		event_cnt = 0;
+		press_at = 0;
+		for(i=0;i<2*presses;i++){
+			Test_Hold(!(i & 1), ms[i], 1 + rand() % TestBounceMax);
+			if(i == 0) press_at = press_ms;
+		}
+		Test_Hold(0, ShortPressMax + DoubleClickGap, 0);
+		total += n;
+		if(event_cnt != n){
+			wrong++;
+			continue;
+		}
+		for(i=0;i<n;i++){
+			if(events[i].event != ev[i]) break;
+		}
+		if(i < n) wrong++;
+		/* press time within the debounce and chatter of the edge */
+		d = events[0].time - press_at;
+		if(d < KeyDebounceTime || d > KeyDebounceTime + TestBounceMax) late++;
+	}
+	printf("%-22s %u bursts, %u events, %u wrong, %u late\n", "random bouncing keys",
+				 (unsigned)bursts, (unsigned)total, (unsigned)wrong, (unsigned)late);
+	snprintf(what, sizeof(what), "%u random bursts misclassified", (unsigned)wrong);
+	Test_Check(wrong == 0, what);
+	snprintf(what, sizeof(what), "%u presses outside the debounce window", (unsigned)late);
+	Test_Check(late == 0, what);
+	Test_Check(key_dropped == 0, "random bursts: events dropped");
+}
+
+int main(int argc, char **argv){
+	unsigned seed = argc > 1 ? atoi(argv[1]) : 1;
+	uint32_t bursts = argc > 2 ? atoi(argv[2]) : 2000;
+	const Test_Wave_t *w;
+	uint8_t i, n, m;
+	uint32_t t;
+	char what[64];
+
+	srand(seed);
+	printf("case                   events\n");
+	for(w=waves;w<waves+sizeof(waves)/sizeof(waves[0]);w++){
+		Test_Begin();
+		for(n=0;n<8 && w->ms[n];n++);
+		t = host_tick;
+		Test_Play(w->ms, n, w->bounce ? TestBounceMax : 0);
+		printf("%-22s", w->name);
+		for(i=0;i<event_cnt;i++) printf(" %s@%u", Test_Name(events[i].event), (unsigned)(events[i].time - t));
+		printf("\n");
+		for(m=0;m<8 && w->expect[m];m++);
+		snprintf(what, sizeof(what), "%s: events", w->name);
+		Test_Check(event_cnt == m, what);
+		for(i=0;i<event_cnt && i<m;i++){
+			snprintf(what, sizeof(what), "%s: event %u is %s", w->name, i, Test_Name(events[i].event));
+			Test_Check(events[i].event == w->expect[i], what);
+		}
+	}
+
+	/* Key_Long is given while held, ShortPressMax after the debounced press */
+	Test_Begin();
+	{
+		uint16_t ms[1] = {1500};
+		Test_Play(ms, 1, 0);
+		Test_Check(event_cnt == 2 && events[1].time - events[0].time == ShortPressMax, "long press: Key_Long time");
+	}
+
+	/* held at boot: nothing until released and pressed again */
+	KEY_GPIO_Port->IDR &= ~(uint32_t)KEY_Pin;
+	Key_Init();
+	event_cnt = 0;
+	Test_Hold(1, 1500, 0);
+	Test_Hold(0, 500, TestBounceMax);
+	Test_Check(event_cnt == 0, "held at boot: events before the release");
+	{
+		uint16_t ms[1] = {100};
+		Test_Play(ms, 1, TestBounceMax);
+		Test_Check(event_cnt == 2 && events[1].event == Key_Short, "held at boot: next click");
+	}
+	printf("%-22s %u events after the release\n", "held at boot", event_cnt);
+
+	/* main loop stalled: the newest events are dropped and counted, the
+		 oldest KeyQueueLen - 1 come out in order */
+	Test_Begin();
+	drain = 0;
+	for(i=0;i<6;i++){
+		Test_Hold(1, 100, TestBounceMax);
+		Test_Hold(0, DoubleClickGap + TestMargin, TestBounceMax);
+	}
+	drain = 1;
+	{
+		Key_Msg_t msg;
+		n = 0;
+		m = 1;
+		while(Key_Get(&msg)){
+			if(msg.event != ((n & 1) ? Key_Short : Key_Press)) m = 0;
+			n++;
+		}
+	}
+	printf("%-22s 12 events, %u read, %u dropped\n", "main loop stalled", (unsigned)n, (unsigned)key_dropped);
+	Test_Check(n == KeyQueueLen - 1 && key_dropped == 12 - n && m, "main loop stalled: queue");
+
+	Test_Random(bursts);
+
+	printf("\n%s\n", fails ? "FAILED" : "key checks passed");
+	return fails != 0;
+}
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Print the deferred binary log of the device as text.
+
+  log_decode.py PORT [-s SECONDS] [--device-table]
+  log_decode.py -f CAPTURE [-n]
+
+Reads the CmdLog frames (Src/logger.c, Log_Poll) from the device or from a
+capture of its CDC byte stream and expands each record with the format
+of its id. The formats are the LOG_TABLE of Inc/logger.h next to this
+script, or with --device-table the table of the running build, read with
+CmdLogFmt. A record is its header (id << 8 | argument count), the DWT
+cycle count and the arguments, big endian words; %f and the like take
+the bits of a float (Log_F). Lines start with the time since the first
+record, from the cycle count at --clock Hz, unless -n. Uses gesture_cmd.py,
+needs pyserial for PORT.
+"""
+
+import argparse
+import codecs
+import os
+import re
+import struct
+import sys
+import time
+
+from gesture_cmd import CMD_LOG, FrameReader
+
+LOGGER_H = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Inc", "logger.h")
+CONV = re.compile(r"%([-+ #0]*)(\d*)(\.\d+)?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGcs%])")
+
+
+def read_table(path=LOGGER_H):
+    """Formats by id, in the order of LOG_TABLE."""
+    with open(path, encoding="latin-1") as f:
+        text = f.read()
+    body = text[text.index("#define LOG_TABLE"):]
+    body = body[:re.search(r"[^\\]\n", body).end()]
+    return [codecs.decode(s, "unicode_escape")
+            for s in re.findall(r'X\(\s*\w+\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', body)]
+
+
+def expand(fmt, args):
+    """printf with 32 bit words as the arguments."""
+    out, pos, k = [], 0, 0
+    for m in CONV.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, _, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        w = args[k] if k < len(args) else 0
+        k += 1
+        spec = "%" + flags + width + (prec or "")
+        if conv in "di":
+            out.append((spec + "d") % (w - (1 << 32) if w & 0x80000000 else w))
+        elif conv in "ouxX":
+            out.append((spec + conv) % w)
+        elif conv in "eEfFgG":
+            out.append((spec + conv) % struct.unpack(">f", struct.pack(">I", w))[0])
+        elif conv == "c":
+            out.append((spec + "c") % chr(w & 0xFF))
+        else:
+            out.append("<%s>" % conv)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+class LogDecoder:
+    """Turns CmdLog payloads into text, with the time at each line start."""
+
+    def __init__(self, table, clock=96e6, stamps=True, out=sys.stdout):
+        self.table = table
+        self.clock = clock
+        self.stamps = stamps
+        self.out = out
+        self.cycles = None      # running cycle count of the last record, unwrapped
+        self.start = None
+        self.line_start = True
+        self.records = 0
+        self.unknown = 0
+
+    def payload(self, data):
+        words = struct.unpack(">%dI" % (len(data) // 4), data[:len(data) // 4 * 4])
+        i = 0
+        while i + 2 <= len(words):
+            log_id, n = words[i] >> 8, words[i] & 0xFF
+            self.record(log_id, words[i + 1], words[i + 2:i + 2 + n])
+            i += 2 + n
+
+    def record(self, log_id, cyc, args):
+        self.records += 1
+        if self.cycles is None:
+            self.cycles = self.start = cyc
+        else:
+            self.cycles += (cyc - self.cycles) & 0xFFFFFFFF
+        if log_id < len(self.table):
+            text = expand(self.table[log_id], args)
+        else:
+            self.unknown += 1
+            text = "<log %d: %s>\r\n" % (log_id, " ".join("%08X" % a for a in args))
+        for part in re.split(r"(?<=\n)", text):
+            if not part:
+                continue
+            if self.line_start and self.stamps:
+                self.out.write("[%10.3f] " % ((self.cycles - self.start) * 1000.0 / self.clock))
+            self.out.write(part.replace("\r\n", "\n"))
+            self.line_start = part.endswith("\n")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("port", nargs="?")
+    ap.add_argument("-f", "--file", help="capture of the CDC byte stream")
+    ap.add_argument("-s", "--seconds", type=float, default=0, help="0: until Ctrl-C")
+    ap.add_argument("-n", "--no-time", action="store_true")
+    ap.add_argument("--clock", type=float, default=96e6, help="DWT clock, SystemCoreClock")
+    ap.add_argument("--table", default=LOGGER_H, help="logger.h to take LOG_TABLE from")
+    ap.add_argument("--device-table", action="store_true", help="read the formats with CmdLogFmt")
+    args = ap.parse_args()
+    if (args.port is None) == (args.file is None):
+        ap.error("give a PORT or a capture file")
+
+    if args.file:
+        dec = LogDecoder(read_table(args.table), args.clock, not args.no_time)
+        reader = FrameReader()
+        with open(args.file, "rb") as f:
+            for cmd, seq, data in reader.feed(f.read()):
+                if cmd == CMD_LOG:
+                    dec.payload(data)
+    else:
+        from gesture_cmd import Device, ProtocolError
+        dec = LogDecoder([], args.clock, not args.no_time)
+
+        def on_frame(cmd, seq, data):
+            if cmd != CMD_LOG:
+                return False
+            dec.payload(data)
+            sys.stdout.flush()
+            return True
+
+        with Device(args.port, on_frame=on_frame) as dev:
+            if args.device_table:
+                try:
+                    i = 0
+                    while True:
+                        dec.table.append(dev.log_fmt(i))
+                        i += 1
+                except ProtocolError:
+                    pass
+            else:
+                dec.table = read_table(args.table)
+            end = time.time() + args.seconds
+            try:
+                while not args.seconds or time.time() < end:
+                    dev.poll()
+            except KeyboardInterrupt:
+                pass
+            reader = dev.reader
+    if not dec.line_start:
+        sys.stdout.write("\n")
+    print("%d records, %d unknown ids, %d bad frames" % (dec.records, dec.unknown, reader.bad),
+          file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,245 @@
+/**
+  ******************************************************************************
+  * File Name          : log_test.c
+  * Description        : Host test of the deferred binary log (logger.c) and
+	*											 its decoder (log_decode.py). Random messages of the
+	*											 format table are logged in bursts that overrun the
+	*											 ring, Log_Poll() sends them as CmdLog frames into a
+	*											 stream that is now and then full and carries text
+	*											 between the frames. Every stored record must come out
+	*											 once and in order. With -w the stream and the text
+	*											 the printf path would have printed are written to
+	*											 PREFIX.bin and PREFIX.txt for "make test" to compare
+	*											 with the decoder. Usage: log_test [-w PREFIX] [seed]
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "logger.h"
+#include "cmd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestRecords			20000
+#define TestStreamMax		(4u << 20)
+#define TestTextMax			(2u << 20)
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t		stream[TestStreamMax];		//the CDC byte stream
+static uint32_t		stream_len;
+static char				text[TestTextMax];				//what printf would have printed
+static uint32_t		text_len;
+static uint32_t		logged[TestRecords][5];		//id, args, a, b, c of each stored record
+static uint32_t		stored, got, wrong;
+static uint8_t		full;											//stream refuses frames
+static int				fails;
+/* Private user code ---------------------------------------------------------*/
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+static uint16_t Test_Crc16(const uint8_t *buf, uint32_t len){
+	uint16_t crc = 0xFFFF;
+	uint8_t b;
+	while(len--){
+		crc ^= (uint16_t)*buf++ << 8;
+		for(b=0;b<8;b++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+/**
+  * @brief  the CDC stream as Log_Poll() sees it: COBS framed, checked
+	*					against the records in the order they were stored
+  * @retval 0: queued, 1: stream full
+  */
+uint8_t Cmd_Write(uint8_t cmd, uint8_t seq, const uint8_t *data, uint8_t len){
+	uint8_t raw[2+CmdPayloadMax+2];
+	uint16_t crc;
+	uint32_t i, k, code_at, n, w[5];
+
+	if(full || stream_len + 2*len + 16 > TestStreamMax) return 1;
+	/* the records in the payload */
+	for(i=0;i+8<=len;){
+		for(k=0;k<5 && i+4*k+4<=len;k++) w[k] = data[i+4*k]<<24 | data[i+4*k+1]<<16 | data[i+4*k+2]<<8 | data[i+4*k+3];
+		n = w[0] & 0xFF;
+		if(got >= stored || logged[got][0] != w[0] >> 8 || logged[got][1] != n ||
+			 memcmp(&logged[got][2], &w[2], 4*n) != 0) wrong++;
+		got++;
+		i += 4 * (2 + n);
+	}
+	raw[0] = cmd;
+	raw[1] = seq;
+	memcpy(&raw[2], data, len);
+	crc = Test_Crc16(raw, len + 2);
+	raw[len+2] = crc >> 8;
+	raw[len+3] = crc;
+	stream[stream_len++] = 0;
+	code_at = stream_len++;
+	for(i=0;i<len+4u;i++){
+		if(raw[i] == 0){
+			stream[code_at] = stream_len - code_at;
+			code_at = stream_len++;
+			continue;
+		}
+		stream[stream_len++] = raw[i];
+		if(stream_len - code_at == 0xFF){
+			stream[code_at] = 0xFF;
+			code_at = stream_len++;
+		}
+	}
+	stream[code_at] = stream_len - code_at;
+	stream[stream_len++] = 0;
+	return 0;
+}
+
+/**
+  * @brief  format one message as printf would: each conversion with its
+	*					argument word as the type it names
+  * @retval None
+  */
+static void Test_Printf(const char *fmt, const uint32_t *arg){
+	char spec[16];
+	const char *p = fmt, *s;
+	uint32_t k = 0, room;
+	union{ uint32_t u; float f; } v;
+
+	while(*p && text_len < TestTextMax - 64){
+		room = TestTextMax - text_len;
+		if(*p != '%'){
+			if(*p != '\r') text[text_len++] = *p;	//the decoder writes \r\n as \n
+			p++;
+			continue;
+		}
+		s = p++;
+		while(*p && strchr("-+ #0123456789.hlLjzt", *p)) p++;
+		if(*p == '%'){
+			text[text_len++] = '%';
+			p++;
+			continue;
+		}
+		memcpy(spec, s, p - s + 1);
+		spec[p - s + 1] = 0;
+		v.u = arg[k++];
+		if(strchr("di", *p)) text_len += snprintf(&text[text_len], room, spec, (int32_t)v.u);
+		else if(strchr("ouxX", *p)) text_len += snprintf(&text[text_len], room, spec, v.u);
+		else if(strchr("eEfFgG", *p)) text_len += snprintf(&text[text_len], room, spec, (double)v.f);
+		else if(*p == 'c') text_len += snprintf(&text[text_len], room, spec, (int)(v.u & 0xFF));
+		p++;
+	}
+}
+
+/**
+  * @brief  count the conversions of a format
+  * @retval arguments
+  */
+static uint32_t Test_Args(const char *fmt){
+	uint32_t n = 0;
+	for(;*fmt;fmt++){
+		if(*fmt != '%') continue;
+		if(fmt[1] == '%') fmt++;
+		else n++;
+	}
+	return n;
+}
+
+/**
+  * @brief  log one random message of the table
+  * @retval None
+  */
+static void Test_Log(void){
+	uint32_t id = rand() % Log_Num, n = Test_Args(log_fmt[id]), a[3], d = log_stats.dropped, i;
+	union{ uint32_t u; float f; } v;
+
+	if(stored >= TestRecords) return;
+	for(i=0;i<3;i++){
+		switch(rand() % 4){
+			case 0:	a[i] = rand() % 10;	break;
+			case 1:	a[i] = (uint32_t)-(rand() % 1000);	break;
+			case 2:	a[i] = 'A' + rand() % 26;	break;
+			default:	v.f = (rand() % 200000 - 100000) / 1000.0f;	a[i] = v.u;	break;
+		}
+	}
+	if(strstr(log_fmt[id], "%5.2f")){									//Log_F() for the float
+		v.f = (rand() % 200000 - 100000) / 1000.0f;
+		a[n-1] = v.u;
+	}
+	if(strstr(log_fmt[id], "%c")) a[0] = "xyz"[rand() % 3];
+	DWT->CYCCNT += 1 + rand() % 100000;
+	if(n == 0) Log0(id);
+	else if(n == 1) Log1(id, a[0]);
+	else if(n == 2) Log2(id, a[0], a[1]);
+	else Log3(id, a[0], a[1], a[2]);
+	if(log_stats.dropped != d) return;
+	logged[stored][0] = id;
+	logged[stored][1] = n;
+	memcpy(&logged[stored][2], a, 12);
+	stored++;
+	Test_Printf(log_fmt[id], a);
+}
+
+static void Test_Write(const char *prefix){
+	char path[256];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s.bin", prefix);
+	f = fopen(path, "wb");
+	Test_Check(f && fwrite(stream, 1, stream_len, f) == stream_len, "cannot write the stream");
+	if(f) fclose(f);
+	snprintf(path, sizeof(path), "%s.txt", prefix);
+	f = fopen(path, "wb");
+	Test_Check(f && fwrite(text, 1, text_len, f) == text_len && (text_len == 0 || text[text_len-1] == '\n' ||
+						 fputc('\n', f) != EOF), "cannot write the text");
+	if(f) fclose(f);
+}
+
+int main(int argc, char **argv){
+	const char *prefix = NULL;
+	unsigned seed = 1;
+	uint32_t burst, i, polls = 0;
+	char what[96];
+
+	if(argc > 2 && strcmp(argv[1], "-w") == 0){
+		prefix = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+	if(argc > 1) seed = atoi(argv[1]);
+	srand(seed);
+
+	Log_Init();
+	while(stored < TestRecords && polls < 100000){
+		burst = rand() % 8 ? 1 + rand() % 20 : 300 + rand() % 300;	//now and then past the ring
+		for(i=0;i<burst;i++) Test_Log();
+		full = rand() % 5 == 0;
+		Log_Poll();
+		polls++;
+		if(rand() % 16 == 0 && stream_len + 32 < TestStreamMax){				//text printed between frames
+			memcpy(&stream[stream_len], "printf text", 11);
+			stream_len += 11;
+		}
+	}
+	full = 0;
+	Log_Poll();
+
+	printf("%u records stored, %u dropped, %u sent in %u bytes, %u wrong, ring high water %u words\n",
+				 (unsigned)stored, (unsigned)log_stats.dropped, (unsigned)got, (unsigned)stream_len,
+				 (unsigned)wrong, (unsigned)log_stats.fill_max);
+	snprintf(what, sizeof(what), "%u stored, %u sent, %u wrong", (unsigned)stored, (unsigned)got, (unsigned)wrong);
+	Test_Check(got == stored && wrong == 0 && log_stats.sent == stored, what);
+	Test_Check(log_stats.dropped > 0 && log_stats.fill_max <= LogRingSize, "ring never full");
+	Test_Check(log_head == log_tail, "records left in the ring");
+	if(prefix) Test_Write(prefix);
+
+	printf("\n%s\n", fails ? "FAILED" : "log checks passed");
+	return fails != 0;
+}
@@ -0,0 +1,268 @@
+/**
+  ******************************************************************************
+  * File Name          : mpu_emu.c
+  * Description        : Register level MPU6050 emulator. HAL_I2C_Mem_Write
+	*											 and HAL_I2C_Mem_Read land here instead of on I2C1:
+	*											 bursts auto increment the register address except on
+	*											 MEM_R_W (DMP memory through BANK_SEL / MEM_START_ADDR)
+	*											 and FIFO_R_W, PWR_MGMT_1 bit 7 resets the registers
+	*											 and clears the DMP memory (the datasheet promises
+	*											 nothing about it, eMPL always reloads), USER_CTRL
+	*											 FIFO_RST empties the FIFO, an overflow drops the
+	*											 oldest bytes and sets INT_STATUS FIFO_OFLOW until it
+	*											 is read. Every transaction is counted in bytes on the
+	*											 wire and advances host_tick by its time at 400 kHz.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mpu_emu.h"
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define EmuDevAddr			0xD0
+#define EmuAccelOffs		0x06
+#define EmuBankSel			0x6D
+#define EmuMemStart			0x6E
+#define EmuMemRW				0x6F
+#define EmuUserCtrl			0x6A
+#define EmuPwrMgmt1			0x6B
+#define EmuIntStatus		0x3A
+#define EmuFifoCntH			0x72
+#define EmuFifoCntL			0x73
+#define EmuFifoRW				0x74
+#define EmuWhoAmI				0x75
+
+#define EmuUserFifoRst	0x04
+#define EmuUserSelfClr	0x0F	//DMP_RST, FIFO_RST, I2C_MST_RST, SIG_COND_RST
+#define EmuPwrReset			0x80
+#define EmuPwrSleep			0x40
+#define EmuIntFifoOflow	0x10
+
+/* Private variables ---------------------------------------------------------*/
+Mpu_Emu_t					mpu_emu;
+I2C_HandleTypeDef	hi2c1;
+/* Private function prototypes -----------------------------------------------*/
+static void Mpu_Emu_Reset_Regs(void);
+static HAL_StatusTypeDef Mpu_Emu_Begin(I2C_HandleTypeDef *h, uint16_t dev, uint32_t wire, uint32_t timeout);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Register values after reset: asleep, WHO_AM_I 0x68 and the
+	*					ACCEL_OFFS bits of a product rev 2 part (full accel scale)
+  * @retval None
+  */
+static void Mpu_Emu_Reset_Regs(void){
+	memset(mpu_emu.regs, 0, sizeof(mpu_emu.regs));
+	mpu_emu.regs[EmuPwrMgmt1] = EmuPwrSleep;
+	mpu_emu.regs[EmuWhoAmI] = 0x68;
+	mpu_emu.regs[EmuAccelOffs + 3] = 0x01;
+	mpu_emu.fifo_head = 0;
+	mpu_emu.fifo_count = 0;
+}
+
+/**
+  * @brief  Power up: registers reset, DMP memory and counters cleared,
+	*					no fault pending
+  * @retval None
+  */
+void Mpu_Emu_Power_On(void){
+	memset(&mpu_emu, 0, sizeof(mpu_emu));
+	Mpu_Emu_Reset_Regs();
+	hi2c1.ErrorCode = HAL_I2C_ERROR_NONE;
+}
+
+/**
+  * @brief  Brown-out of the sensor alone: registers back to reset values
+	*					and the DMP image gone, the counters are kept
+  * @retval None
+  */
+void Mpu_Emu_Lose_Config(void){
+	memset(mpu_emu.mem, 0, sizeof(mpu_emu.mem));
+	Mpu_Emu_Reset_Regs();
+}
+
+void Mpu_Emu_Clear_Counters(void){
+	mpu_emu.wr_trans = 0;
+	mpu_emu.rd_trans = 0;
+	mpu_emu.wire_bytes = 0;
+	mpu_emu.mem_wr_bytes = 0;
+	mpu_emu.mem_rd_bytes = 0;
+	mpu_emu.fifo_rd_bytes = 0;
+	mpu_emu.resets = 0;
+	mpu_emu.bus_clears = 0;
+}
+
+/**
+  * @brief  Append bytes to the FIFO as the sensor or the DMP would, the
+	*					oldest bytes are dropped on overflow
+  * @retval None
+  */
+void Mpu_Emu_Fifo_Push(const uint8_t *data, uint16_t len){
+	while(len--){
+		if(mpu_emu.fifo_count == MpuEmuFifoSize){
+			mpu_emu.fifo_head = (mpu_emu.fifo_head + 1) % MpuEmuFifoSize;
+			mpu_emu.fifo_count--;
+			mpu_emu.fifo_lost++;
+			mpu_emu.regs[EmuIntStatus] |= EmuIntFifoOflow;
+		}
+		mpu_emu.fifo[(mpu_emu.fifo_head + mpu_emu.fifo_count) % MpuEmuFifoSize] = *data++;
+		mpu_emu.fifo_count++;
+	}
+}
+
+/**
+  * @brief  Lose bytes at the head of the FIFO without telling the host,
+	*					the stream is misaligned afterwards
+  * @retval None
+  */
+void Mpu_Emu_Fifo_Drop(uint16_t len){
+	if(len > mpu_emu.fifo_count) len = mpu_emu.fifo_count;
+	mpu_emu.fifo_head = (mpu_emu.fifo_head + len) % MpuEmuFifoSize;
+	mpu_emu.fifo_count -= len;
+	mpu_emu.fifo_lost += len;
+}
+
+/**
+  * @brief  Make the next transactions fail
+	*	@param	count		transactions
+	*	@param	status	HAL status they return
+	*	@param	code		HAL_I2C_GetError() value
+  * @retval None
+  */
+void Mpu_Emu_Fail(uint32_t count, HAL_StatusTypeDef status, uint32_t code){
+	mpu_emu.fail_next = count;
+	mpu_emu.fail_status = status;
+	mpu_emu.fail_code = code;
+}
+
+/**
+  * @brief  Account the bus time and apply the injected faults
+	*	@param	wire		bytes on the wire
+  * @retval HAL_OK if the transfer goes ahead
+  */
+static HAL_StatusTypeDef Mpu_Emu_Begin(I2C_HandleTypeDef *h, uint16_t dev, uint32_t wire, uint32_t timeout){
+	mpu_emu.wire_bytes += wire;
+	mpu_emu.bus_ns += wire * MpuEmuByteNs;
+	host_tick += mpu_emu.bus_ns / 1000000;
+	mpu_emu.bus_ns %= 1000000;
+
+	h->ErrorCode = HAL_I2C_ERROR_NONE;
+	if(mpu_emu.stuck) return HAL_BUSY;
+	if(mpu_emu.fail_next){
+		mpu_emu.fail_next--;
+		h->ErrorCode = mpu_emu.fail_code;
+		if(mpu_emu.fail_status == HAL_TIMEOUT) host_tick += timeout;
+		return mpu_emu.fail_status;
+	}
+	if(dev != EmuDevAddr){
+		h->ErrorCode = HAL_I2C_ERROR_AF;
+		return HAL_ERROR;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *h, uint16_t dev, uint16_t reg, uint16_t reg_size, uint8_t *buf, uint16_t len, uint32_t timeout){
+	HAL_StatusTypeDef status;
+	uint8_t bank, v;
+
+	mpu_emu.wr_trans++;
+	status = Mpu_Emu_Begin(h, dev, 1 + reg_size + len, timeout);
+	if(status != HAL_OK) return status;
+
+	while(len--){
+		v = *buf++;
+		if(reg == EmuMemRW){
+			bank = mpu_emu.regs[EmuBankSel] % MpuEmuBanks;
+			if(mpu_emu.mem_corrupt) v ^= 0x01;
+			mpu_emu.mem[bank][mpu_emu.regs[EmuMemStart]++] = v;
+			mpu_emu.mem_wr_bytes++;
+			continue;
+		}
+		if(reg == EmuFifoRW) continue;
+		if(reg == EmuPwrMgmt1 && (v & EmuPwrReset)){
+			memset(mpu_emu.mem, 0, sizeof(mpu_emu.mem));
+			Mpu_Emu_Reset_Regs();
+			mpu_emu.resets++;
+		}
+		else if(reg == EmuUserCtrl){
+			if(v & EmuUserFifoRst){
+				mpu_emu.fifo_head = 0;
+				mpu_emu.fifo_count = 0;
+				mpu_emu.regs[EmuIntStatus] &= ~EmuIntFifoOflow;
+			}
+			mpu_emu.regs[reg] = v & ~EmuUserSelfClr;
+		}
+		else if(reg != EmuWhoAmI && reg != EmuFifoCntH && reg != EmuFifoCntL){
+			mpu_emu.regs[reg] = v;
+		}
+		reg = (reg + 1) & 0x7F;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *h, uint16_t dev, uint16_t reg, uint16_t reg_size, uint8_t *buf, uint16_t len, uint32_t timeout){
+	HAL_StatusTypeDef status;
+	uint8_t bank;
+	uint16_t cut = 0xFFFF;
+
+	mpu_emu.rd_trans++;
+	status = Mpu_Emu_Begin(h, dev, 2 + reg_size + len, timeout);
+	if(status != HAL_OK) return status;
+	if(reg == EmuFifoRW && mpu_emu.fifo_cut){
+		cut = mpu_emu.fifo_cut;//bytes clocked out before the error
+		mpu_emu.fifo_cut = 0;
+	}
+
+	while(len--){
+		if(cut-- == 0){
+			h->ErrorCode = HAL_I2C_ERROR_AF;
+			return HAL_ERROR;
+		}
+		if(reg == EmuMemRW){
+			bank = mpu_emu.regs[EmuBankSel] % MpuEmuBanks;
+			*buf++ = mpu_emu.mem[bank][mpu_emu.regs[EmuMemStart]++];
+			mpu_emu.mem_rd_bytes++;
+			continue;
+		}
+		if(reg == EmuFifoRW){
+			if(mpu_emu.fifo_count){
+				*buf++ = mpu_emu.fifo[mpu_emu.fifo_head];
+				mpu_emu.fifo_head = (mpu_emu.fifo_head + 1) % MpuEmuFifoSize;
+				mpu_emu.fifo_count--;
+			}
+			else *buf++ = 0xFF;
+			mpu_emu.fifo_rd_bytes++;
+			continue;
+		}
+		if(reg == EmuFifoCntH) *buf++ = mpu_emu.fifo_count >> 8;
+		else if(reg == EmuFifoCntL) *buf++ = mpu_emu.fifo_count & 0xFF;
+		else *buf++ = mpu_emu.regs[reg];
+		if(reg == EmuIntStatus) mpu_emu.regs[reg] = 0;//clear on read
+		reg = (reg + 1) & 0x7F;
+	}
+	return HAL_OK;
+}
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *h){
+	return h->ErrorCode;
+}
+
+/**
+  * @brief  SCL clock-out stand-in, frees a stuck bus unless told to fail
+  * @retval 0: bus free, 1: SDA still low
+  */
+uint8_t I2C1_Bus_Clear(void){
+	mpu_emu.bus_clears++;
+	host_tick += 1;
+	if(mpu_emu.clear_fail){
+		mpu_emu.clear_fail--;
+		return 1;
+	}
+	mpu_emu.stuck = 0;
+	return 0;
+}
@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * File Name          : mpu_emu.h
+  * Description        : Register level MPU6050 emulator behind the HAL I2C
+	*											 calls of the host tests: registers, DMP memory, FIFO,
+	*											 bus counters and fault injection.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __mpu_emu_H
+#define __mpu_emu_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define MpuEmuBanks			16		//DMP memory, 256 byte banks
+#define MpuEmuFifoSize	1024
+#define MpuEmuByteNs		22500	//9 bit times at 400 kHz
+/* Exported types ------------------------------------------------------------*/
+typedef struct{
+	uint8_t		regs[128];
+	uint8_t		mem[MpuEmuBanks][256];
+	uint8_t		fifo[MpuEmuFifoSize];
+	uint16_t	fifo_head;
+	uint16_t	fifo_count;
+
+	/* fault injection, set by the tests */
+	uint32_t					fail_next;		//fail this many transactions
+	HAL_StatusTypeDef	fail_status;	//with this status
+	uint32_t					fail_code;		//and this HAL_I2C_GetError() value
+	uint8_t						stuck;				//HAL_BUSY until I2C1_Bus_Clear()
+	uint32_t					clear_fail;		//I2C1_Bus_Clear() fails this many times
+	uint8_t						mem_corrupt;	//flip a bit of every DMP memory write
+	uint16_t					fifo_cut;			//next FIFO read fails after this many bytes
+
+	/* counters */
+	uint32_t	wr_trans;
+	uint32_t	rd_trans;
+	uint32_t	wire_bytes;		//address, register and data bytes
+	uint32_t	mem_wr_bytes;	//DMP memory written
+	uint32_t	mem_rd_bytes;	//DMP memory read back
+	uint32_t	fifo_rd_bytes;
+	uint32_t	fifo_lost;		//bytes dropped by overflow or Mpu_Emu_Fifo_Drop()
+	uint32_t	resets;				//PWR_MGMT_1 device resets
+	uint32_t	bus_clears;
+	uint32_t	bus_ns;				//rest of the bus time not yet in host_tick
+} Mpu_Emu_t;
+/* Exported constants --------------------------------------------------------*/
+extern Mpu_Emu_t mpu_emu;
+/* Exported functions prototypes ---------------------------------------------*/
+void Mpu_Emu_Power_On(void);
+void Mpu_Emu_Lose_Config(void);
+void Mpu_Emu_Clear_Counters(void);
+void Mpu_Emu_Fifo_Push(const uint8_t *data, uint16_t len);
+void Mpu_Emu_Fifo_Drop(uint16_t len);
+void Mpu_Emu_Fail(uint32_t count, HAL_StatusTypeDef status, uint32_t code);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__mpu_emu_H */
@@ -0,0 +1,146 @@
+/**
+  ******************************************************************************
+  * File Name          : mpu_load_test.c
+  * Description        : Host check of the DMP image loader (mpu_load_firmware
+	*											 in inv_mpu.c) on the MPU6050 emulator (mpu_emu.c).
+	*											 Cold load: the image is written once and read back
+	*											 once for the CRC. A device reset clears DMP memory,
+	*											 so the load after mpu_init() is a cold load again.
+	*											 Corrupted write: -2. The bytes on the wire
+	*											 are compared with the eMPL loader the driver had
+	*											 before, 16 byte write and read back per chunk.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mpu_emu.h"
+#include "inv_mpu.h"
+#include "inv_mpu_dmp_motion_driver.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestImageSize		3062	//DMP_CODE_SIZE of inv_mpu_dmp_motion_driver.c
+#define TestLegacyChunk	16		//LOAD_CHUNK of the eMPL loader
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t	image[TestImageSize];
+static int			fails;
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  CRC-16/CCITT-FALSE, same as mem_crc16() of the driver
+  * @retval crc
+  */
+static uint16_t Test_Crc16(const uint8_t *data, uint16_t len){
+	uint16_t crc = 0xFFFF;
+	uint8_t i;
+
+	while(len--){
+		crc ^= (uint16_t)(*data++) << 8;
+		for(i=0;i<8;i++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	return crc;
+}
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+/**
+  * @brief  Reset the device as mpu_dmp_init() does, up to the image load
+  * @retval None
+  */
+static void Test_Device_Init(void){
+	Test_Check(mpu_init() == 0, "mpu_init");
+	Test_Check(mpu_set_sensors(INV_XYZ_GYRO | INV_XYZ_ACCEL) == 0, "mpu_set_sensors");
+	Mpu_Emu_Clear_Counters();
+}
+
+/**
+  * @brief  The loader before the single CRC pass: each 16 byte chunk
+	*					written and read back through mpu_write_mem/mpu_read_mem
+  * @retval 0, -1 bus error, -2 mismatch
+  */
+static int Test_Legacy_Load(const uint8_t *fw, uint16_t length){
+	uint8_t cur[TestLegacyChunk];
+	uint16_t ii, n;
+
+	for(ii=0;ii<length;ii+=n){
+		n = length - ii < TestLegacyChunk ? length - ii : TestLegacyChunk;
+		if(mpu_write_mem(ii, n, (uint8_t*)&fw[ii])) return -1;
+		if(mpu_read_mem(ii, n, cur)) return -1;
+		if(memcmp(&fw[ii], cur, n)) return -2;
+	}
+	return 0;
+}
+
+static void Test_Print(const char *name, int res){
+	printf("%-22s %4d %6u %7u %6u %6u %7.1f\n", name, res,
+				 (unsigned)(mpu_emu.wr_trans + mpu_emu.rd_trans), (unsigned)mpu_emu.wire_bytes,
+				 (unsigned)mpu_emu.mem_wr_bytes, (unsigned)mpu_emu.mem_rd_bytes,
+				 mpu_emu.wire_bytes * (MpuEmuByteNs / 1e6));
+}
+
+int main(void){
+	uint32_t new_wire, new_trans;
+	uint16_t crc;
+	int res;
+
+	printf("loader                  res  trans    wire  DMP wr  DMP rd  bus ms\n");
+
+	/* cold: write once, one CRC pass */
+	Mpu_Emu_Power_On();
+	Test_Device_Init();
+	res = dmp_load_motion_driver_firmware();
+	Test_Print("cold", res);
+	memcpy(image, mpu_emu.mem, TestImageSize);
+	crc = Test_Crc16(image, TestImageSize);
+	new_wire = mpu_emu.wire_bytes;
+	new_trans = mpu_emu.wr_trans + mpu_emu.rd_trans;
+	Test_Check(res == 0, "cold load");
+	Test_Check(mpu_emu.mem_wr_bytes == TestImageSize, "cold load writes the image once");
+	Test_Check(mpu_emu.mem_rd_bytes == TestImageSize, "cold load reads it back once");
+	Test_Check(mpu_get_firmware_signature() == crc, "signature is the CRC of DMP memory");
+
+	/* device reset: DMP memory cleared, same cost as cold */
+	Test_Device_Init();
+	Test_Check(mpu_get_firmware_signature() == 0, "no signature before the load");
+	Test_Check(memcmp(image, mpu_emu.mem, TestImageSize) != 0, "reset clears DMP memory");
+	res = dmp_load_motion_driver_firmware();
+	Test_Print("after reset", res);
+	Test_Check(res == 0, "reload");
+	Test_Check(mpu_emu.wire_bytes == new_wire, "reload costs a cold load");
+	Test_Check(memcmp(image, mpu_emu.mem, TestImageSize) == 0, "image restored");
+
+	/* writes corrupted: verify fails */
+	Mpu_Emu_Lose_Config();
+	Test_Device_Init();
+	mpu_emu.mem_corrupt = 1;
+	res = dmp_load_motion_driver_firmware();
+	mpu_emu.mem_corrupt = 0;
+	Test_Print("corrupted write", res);
+	Test_Check(res == -2, "corrupted image reported");
+	Test_Check(mpu_get_firmware_signature() == 0, "no signature for a bad image");
+
+	/* eMPL loader, 16 byte write and read back */
+	Mpu_Emu_Power_On();
+	Test_Device_Init();
+	res = Test_Legacy_Load(image, TestImageSize);
+	Test_Print("eMPL 16 byte chunks", res);
+	Test_Check(res == 0, "legacy load");
+	Test_Check(new_wire < mpu_emu.wire_bytes, "fewer bytes on the wire than the eMPL loader");
+	Test_Check(new_trans < mpu_emu.wr_trans + mpu_emu.rd_trans, "fewer transactions than the eMPL loader");
+	printf("cold load: %.0f%% of the eMPL bus bytes, %u vs %u transactions\n",
+				 100.0 * new_wire / mpu_emu.wire_bytes, (unsigned)new_trans,
+				 (unsigned)(mpu_emu.wr_trans + mpu_emu.rd_trans));
+
+	printf("\n%s\n", fails ? "FAILED" : "loader checks passed");
+	return fails != 0;
+}
@@ -0,0 +1,280 @@
+/**
+  ******************************************************************************
+  * File Name          : mpubus_test.c
+  * Description        : Host fault injection test of the MPU6050 bus recovery
+	*											 (mpubus.c) on the register emulator (mpu_emu.c):
+	*											 a NACK burst, a stuck bus that needs several clock-
+	*											 outs, a sensor that lost its configuration and one
+	*											 that stays away. The sampling path runs MPU_Update()
+	*											 every 5 ms of virtual time and the main loop runs
+	*											 MPU_Bus_Poll(). Checked: state and counters, the
+	*											 backoff schedule, the longest single poll step
+	*											 (one clock-out, one FIFO resync or one step of
+	*											 the restart, never the whole restart)
+	*											 and that a restart after boot only writes the
+	*											 cached biases back: no self test, no flash erase,
+	*											 key ignored.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mpu_emu.h"
+#include "mpu6050.h"
+#include "fast_boot.h"
+#include "imu_pre.h"
+#include "logger.h"
+#include "cmd.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestLoopMs			5			//main loop and sampling period
+#define TestStepMax			160		//ms, one restart step: dmp_enable_feature() resets
+															//the FIFO three times inside eMPL (50 ms each), the
+															//reset waits are polled. The whole restart took one
+															//800 ms step, a self test or an erase would add 0.5
+															//to 1 s
+#define TestResyncMax		60		//ms, one FIFO reset (50 ms wait in DMP mode)
+#define TestImageSize		3062	//DMP_CODE_SIZE
+
+/* Private variables ---------------------------------------------------------*/
+static MPU_Data_t	mpu;
+static uint32_t		step_max;
+static int				fails;
+/* Private function prototypes -----------------------------------------------*/
+uint32_t Calib_Checksum(const Calib_Data_t* c);
+int Calib_Save(const Calib_Data_t* c);
+int Calib_Is_Valid(const Calib_Data_t* c);
+extern Calib_Data_t *calib;
+/* Private user code ---------------------------------------------------------*/
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+/**
+  * @brief  CmdLog sink, records stay in log_ring for Test_Logged()
+  * @retval 0
+  */
+uint8_t Cmd_Write(uint8_t cmd, uint8_t seq, const uint8_t *data, uint8_t len){
+	return 0;
+}
+
+/**
+  * @brief  is a record with this id in the log since the last Log_Init()
+  * @retval 1: yes
+  */
+static int Test_Logged(Log_Id_t id){
+	uint32_t t;
+
+	for(t=0;t!=log_head;t+=2+(log_ring[t & LogMask] & 0xFF)){
+		if((log_ring[t & LogMask] >> 8) == id) return 1;
+	}
+	return 0;
+}
+
+/**
+  * @brief  MPU_Configure() of main.c at boot without Param_Apply_Rate()
+  * @retval 0: success
+  */
+static uint8_t Test_Configure(void){
+	if(mpu_dmp_init()) return 1;
+	Fast_Boot_Calibrate(1);
+	return 0;
+}
+
+/**
+  * @brief  MPU_Restart() of main.c without Param_Apply_Rate(): one init
+	*					step per call, boot while boot_ready_ms is 0, cached
+	*					biases only afterwards
+  * @retval 0: success, 1: failed, 2: not done
+  */
+static uint8_t Test_Restart(void){
+	uint8_t res = mpu_init_step(1);
+
+	if(res == MPU_INIT_BUSY) return 2;
+	if(res) return 1;
+	Fast_Boot_Calibrate(boot_ready_ms == 0);
+	return 0;
+}
+
+/**
+  * @brief  Main loop for ms of virtual time: sample, then one recovery
+	*					step, whose duration is tracked in step_max
+  * @retval bus state at the end
+  */
+static MPU_Bus_State_t Test_Run(uint32_t ms){
+	uint32_t end = host_tick + ms;
+	uint32_t t;
+	MPU_Bus_State_t state = MPU_BUS_OK;
+
+	while((int32_t)(end - host_tick) > 0){
+		MPU_Update(&mpu);
+		t = host_tick;
+		state = MPU_Bus_Poll();
+		if(host_tick - t > step_max) step_max = host_tick - t;
+		host_tick += TestLoopMs;
+	}
+	return state;
+}
+
+/**
+  * @brief  gyro offset register X, Y, Z as written by mpu_apply_bias()
+  * @retval None
+  */
+static void Test_Gyro_Offs(int16_t *offs){
+	uint8_t i;
+	for(i=0;i<3;i++) offs[i] = (int16_t)(mpu_emu.regs[0x13 + 2*i] << 8 | mpu_emu.regs[0x14 + 2*i]);
+}
+
+/**
+  * @brief  a valid calibration record in flash
+  * @retval None
+  */
+static void Test_Calib_Store(void){
+	Calib_Data_t c;
+	const uint32_t *p = (const uint32_t*)&c;
+	uint32_t i;
+
+	memset(&c, 0, sizeof(c));
+	c.magic = CalibMagic;
+	c.version = CalibVersion;
+	c.st_result = 0x3;
+	c.gyro_bias[0] = 3 << 16;
+	c.gyro_bias[1] = -2 << 16;
+	c.gyro_bias[2] = 1 << 16;
+	c.accel_bias[0] = 1 << 12;
+	c.dmp_sig = 0;//DMP image not known yet
+	c.checksum = Calib_Checksum(&c);
+	HAL_FLASH_Unlock();
+	FLASH_Erase_Sector(CalibFlashSector, FLASH_VOLTAGE_RANGE_3);
+	for(i=0;i<sizeof(c)/4;i++) HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, CalibFlashAddr + 4*i, p[i]);
+	HAL_FLASH_Lock();
+}
+
+static void Test_Print(const char *name, uint32_t t0, uint32_t erases){
+	printf("%-28s %6u ms %3u %3u %3u %3u %3u %3u %5u ms %u\n", name, (unsigned)(host_tick - t0),
+				 (unsigned)mpu_bus_stats.faults, (unsigned)mpu_bus_stats.recoveries,
+				 (unsigned)mpu_bus_stats.clear_fail, (unsigned)mpu_bus_stats.restarts,
+				 (unsigned)mpu_bus_stats.fifo_resyncs, (unsigned)mpu_emu.bus_clears,
+				 (unsigned)step_max, (unsigned)(host_flash_erases - erases));
+}
+
+static void Test_Begin(void){
+	memset((void*)&mpu_bus_stats, 0, sizeof(mpu_bus_stats));
+	Mpu_Emu_Clear_Counters();
+	Log_Init();
+	step_max = 0;
+}
+
+int main(void){
+	Calib_Data_t c;
+	int16_t offs[3];
+	uint32_t t0, erases;
+
+	host_gpio[0].IDR = KEY_Pin;//key released
+	Mpu_Emu_Power_On();
+	Test_Calib_Store();
+	Imu_Pre_Init(NULL);
+
+	/* boot as main() does: cache applied, new DMP signature stored */
+	Log_Init();
+	MPU_Bus_Init(Test_Restart);
+	erases = host_flash_erases;
+	t0 = host_tick;
+	Test_Check(Test_Configure() == 0, "boot configuration");
+	printf("boot                         %6u ms, %u flash erase\n", (unsigned)(host_tick - t0), (unsigned)(host_flash_erases - erases));
+	Test_Check(Test_Logged(Log_Calib_Applied), "boot applies the cache");
+	Test_Check(host_flash_erases - erases == 1, "boot stores the DMP signature");
+	Test_Gyro_Offs(offs);
+	Test_Check(offs[0] == -98 && offs[1] == 66 && offs[2] == -32, "gyro offsets written");
+	boot_ready_ms = host_tick;
+
+	printf("\n%-28s %9s %3s %3s %3s %3s %3s %3s %8s %s\n", "case", "time", "flt", "rec", "clf",
+				 "rst", "rsy", "clr", "step max", "erases");
+
+	/* NACK burst: fault, clock-out, probe OK, FIFO resync */
+	Test_Begin();
+	erases = host_flash_erases;
+	t0 = host_tick;
+	Mpu_Emu_Fail(MPU_BUS_ERR_LIMIT, HAL_ERROR, HAL_I2C_ERROR_AF);
+	Test_Check(Test_Run(100) == MPU_BUS_OK, "NACK burst recovered");
+	Test_Print("NACK burst", t0, erases);
+	Test_Check(mpu_bus_stats.faults == 1 && mpu_bus_stats.err_nack == MPU_BUS_ERR_LIMIT, "NACK burst counted");
+	Test_Check(mpu_bus_stats.fifo_resyncs == 1 && mpu_bus_stats.restarts == 0, "NACK burst resyncs only");
+	Test_Check(step_max <= TestResyncMax, "resync step is one FIFO reset");
+
+	/* stuck bus, two clock-outs fail: backoff 10 then 20 ms */
+	Test_Begin();
+	t0 = host_tick;
+	mpu_emu.stuck = 1;
+	mpu_emu.clear_fail = 2;
+	Test_Check(Test_Run(200) == MPU_BUS_OK, "stuck bus recovered");
+	Test_Print("stuck bus, 2 clock-outs", t0, erases);
+	Test_Check(mpu_bus_stats.err_busy >= MPU_BUS_ERR_LIMIT, "stuck bus counted as busy");
+	Test_Check(mpu_bus_stats.recoveries == 3 && mpu_bus_stats.clear_fail == 2, "stuck bus attempts");
+	Test_Check(mpu_bus_stats.restarts == 0, "stuck bus keeps the configuration");
+
+	/* sensor reset itself and lost the DMP image: restart at run time */
+	Test_Begin();
+	t0 = host_tick;
+	host_gpio[0].IDR = 0;//key held, must not matter now
+	Mpu_Emu_Lose_Config();
+	Mpu_Emu_Fail(MPU_BUS_ERR_LIMIT, HAL_TIMEOUT, HAL_I2C_ERROR_TIMEOUT);
+	Test_Check(Test_Run(1500) == MPU_BUS_OK, "lost configuration recovered");
+	Test_Print("lost configuration", t0, erases);
+	Test_Check(mpu_bus_stats.restarts == 1, "one restart");
+	Test_Check(mpu_emu.mem_wr_bytes >= TestImageSize, "DMP image reloaded");
+	Test_Check(Test_Logged(Log_Calib_Applied), "restart applies the cache");
+	Test_Check(!Test_Logged(Log_Key_Held) && !Test_Logged(Log_Self_Test_Fail), "restart ignores the key, no self test");
+	Test_Check(host_flash_erases == erases, "restart does not erase flash");
+	Test_Gyro_Offs(offs);
+	Test_Check(offs[0] == -98 && offs[1] == 66 && offs[2] == -32, "gyro offsets written back");
+	Test_Check(step_max <= TestStepMax, "restart within one poll step");
+
+	/* no cache at run time: restart without biases, still no self test */
+	Test_Begin();
+	t0 = host_tick;
+	HAL_FLASH_Unlock();
+	HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, CalibFlashAddr, 0);//invalidate the record
+	HAL_FLASH_Lock();
+	erases = host_flash_erases;
+	Mpu_Emu_Lose_Config();
+	Mpu_Emu_Fail(MPU_BUS_ERR_LIMIT, HAL_ERROR, HAL_I2C_ERROR_BERR);
+	Test_Check(Test_Run(1500) == MPU_BUS_OK, "restart without cache");
+	Test_Print("lost configuration, no cache", t0, erases);
+	Test_Check(mpu_bus_stats.restarts == 1 && mpu_bus_stats.err_bus == MPU_BUS_ERR_LIMIT, "restart without cache counted");
+	Test_Check(!Test_Logged(Log_Calib_Applied) && !Test_Logged(Log_Self_Test_Fail), "no biases, no self test");
+	Test_Check(host_flash_erases == erases, "no flash erase without cache");
+	Test_Check(step_max <= TestStepMax, "restart without cache within one poll step");
+	host_gpio[0].IDR = KEY_Pin;
+
+	/* sensor gone for 5 s: backoff up to MPU_BUS_BACKOFF_MAX, then back */
+	Test_Begin();
+	t0 = host_tick;
+	mpu_emu.stuck = 1;
+	mpu_emu.clear_fail = 1000;
+	Test_Check(Test_Run(5000) == MPU_BUS_BACKOFF, "sensor gone stays in backoff");
+	Test_Check(mpu_bus_stats.recoveries <= 12, "backoff doubles up to the cap");
+	mpu_emu.clear_fail = 0;
+	Test_Check(Test_Run(MPU_BUS_BACKOFF_MAX + 50) == MPU_BUS_OK, "sensor back within one backoff");
+	Test_Print("sensor gone 5 s", t0, erases);
+	Test_Check(step_max <= TestStepMax, "backoff steps");
+
+	/* flash fails under Calib_Save(): reported, flash locked, record invalid */
+	c = *calib;
+	host_flash_fail = 1;
+	Test_Check(Calib_Save(&c) != 0, "failed calibration write reported");
+	Test_Check(host_flash_locked, "flash locked after a failed write");
+	host_flash_fail = 0;
+	Test_Check(!Calib_Is_Valid(calib), "no valid record after a failed write");
+
+	printf("\n%s\n", fails ? "FAILED" : "bus recovery checks passed");
+	return fails != 0;
+}
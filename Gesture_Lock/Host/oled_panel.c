@@ -0,0 +1,163 @@
+/**
+  ******************************************************************************
+  * File Name          : oled_panel.c
+  * Description        : Mock OLED transport of the host tests, see
+	*											 oled_panel.h. Bytes reach the model with the DC and
+	*											 CS levels of the pins: commands set the page and
+	*											 column, data is written at the column, which then
+	*											 moves on. SPI bytes advance the DWT counter at the
+	*											 SPI1 bit rate, so oled_stats holds the time the
+	*											 flush would take on the board; the bit-bang path is
+	*											 not timed.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "oled_panel.h"
+#include <string.h>
+
+/* Private variables ---------------------------------------------------------*/
+Oled_Panel_t			oled_panel;
+SPI_HandleTypeDef	hspi1;
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  one byte on the wire, with the DC and CS levels it is clocked at
+  * @retval None
+  */
+static void Oled_Panel_Byte(u8 b){
+	Oled_Panel_t *p = &oled_panel;
+
+	if(LCD_CS_GPIO_Port->ODR & LCD_CS_Pin){
+		p->no_cs++;
+		return;
+	}
+	if(LCD_DC_GPIO_Port->ODR & LCD_DC_Pin){
+		p->data_bytes++;
+		if(p->col < OledPanelColumns) p->ram[p->page][p->col++] = b;
+		return;
+	}
+	p->cmd_bytes++;
+	if(p->arg){
+		p->arg--;
+		return;
+	}
+	if(b >= 0xB0 && b < 0xB0 + OLED_PAGES) p->page = b - 0xB0;
+	else if(b < 0x10) p->col = (p->col & 0xF0) | b;
+	else if(b < 0x20) p->col = (p->col & 0x0F) | (b & 0x0F) << 4;
+	else{
+		switch(b){
+			case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+			case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+				p->arg = 1;
+				break;
+		}
+	}
+}
+
+/**
+  * @brief  bit-bang decoder, MOSI is sampled on the rising edge of SCK
+  * @retval None
+  */
+static void Oled_Panel_Pin(GPIO_TypeDef *port, uint16_t pin){
+	Oled_Panel_t *p = &oled_panel;
+	u8 sck = (LCD_SCK_GPIO_Port->ODR & LCD_SCK_Pin) != 0;
+
+	if(port == LCD_CS_GPIO_Port && (pin & LCD_CS_Pin) && (port->ODR & LCD_CS_Pin)) p->bits = 0;
+	if(hspi1.State != HAL_SPI_STATE_RESET || sck == p->sck) return;
+	p->sck = sck;
+	if(!sck) return;
+	p->shift = p->shift << 1 | ((LCD_MOSI_GPIO_Port->ODR & LCD_MOSI_Pin) != 0);
+	if(++p->bits < 8) return;
+	p->bits = 0;
+	p->bb_bytes++;
+	Oled_Panel_Byte(p->shift);
+}
+
+/**
+  * @brief  panel RAM unknown, pins idle high, SPI1 ready or left in reset
+	*	@param	spi		1: MX_SPI1_Init() succeeded, 0: OLED_Init() bit-bangs
+  * @retval None
+  */
+void Oled_Panel_Power_On(u8 spi){
+	uint32_t i;
+
+	memset(&oled_panel, 0, sizeof(oled_panel));
+	for(i=0;i<sizeof(oled_panel.ram);i++) ((u8*)oled_panel.ram)[i] = (u8)(i * 37 + 11);
+	LCD_CS_GPIO_Port->ODR |= LCD_CS_Pin | LCD_DC_Pin | LCD_SCK_Pin | LCD_MOSI_Pin | LCD_RES_Pin;
+	oled_panel.sck = 1;
+	hspi1.State = spi ? HAL_SPI_STATE_READY : HAL_SPI_STATE_RESET;
+	host_gpio_write = Oled_Panel_Pin;
+}
+
+/**
+  * @brief  the shown columns of the panel RAM, laid out as OLED_GRAM
+  * @retval None
+  */
+void Oled_Panel_Screen(u8 screen[OLED_PAGES][X_WIDTH]){
+	u8 i;
+	for(i=0;i<OLED_PAGES;i++) memcpy(screen[i], &oled_panel.ram[i][OledPanelColShift], X_WIDTH);
+}
+
+HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef *h){
+	h->State = HAL_SPI_STATE_RESET;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *h, uint8_t *buf, uint16_t len, uint32_t timeout){
+	uint16_t i;
+
+	if(h->State != HAL_SPI_STATE_READY) return h->State == HAL_SPI_STATE_RESET ? HAL_ERROR : HAL_BUSY;
+	if(oled_panel.in_irq) oled_panel.irq_blocking++;
+	for(i=0;i<len;i++) Oled_Panel_Byte(buf[i]);
+	DWT->CYCCNT += (uint32_t)len * 8 * OledPanelBitCycles;
+	return HAL_OK;
+}
+
+/**
+  * @brief  start a transfer; done at once, or by Oled_Panel_Dma_Done()
+	*					with dma_defer
+  * @retval HAL_OK, or HAL_BUSY while one is on the wire or refused
+  */
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *h, uint8_t *buf, uint16_t len){
+	if(h->State != HAL_SPI_STATE_READY) return HAL_BUSY;
+	if(oled_panel.refuse_next){
+		oled_panel.refuse_next--;
+		return HAL_BUSY;
+	}
+	h->State = HAL_SPI_STATE_BUSY_TX;
+	oled_panel.dma_buf = buf;
+	oled_panel.dma_len = len;
+	oled_panel.dma_transfers++;
+	if(!oled_panel.dma_defer) Oled_Panel_Dma_Done();
+	return HAL_OK;
+}
+
+/**
+  * @brief  end the transfer on the wire and run its callback as the DMA
+	*					interrupt does; lose_next ends it in HAL_SPI_ErrorCallback()
+	*					with nothing sent
+  * @retval 1: a transfer ended, 0: none on the wire
+  */
+u8 Oled_Panel_Dma_Done(void){
+	uint16_t i, len = oled_panel.dma_len;
+	u8 lost = oled_panel.lose_next != 0, irq = oled_panel.in_irq;
+
+	if(!len) return 0;
+	oled_panel.dma_len = 0;
+	if(lost) oled_panel.lose_next--;
+	else{
+		for(i=0;i<len;i++) Oled_Panel_Byte(oled_panel.dma_buf[i]);
+	}
+	DWT->CYCCNT += (uint32_t)len * 8 * OledPanelBitCycles;
+	hspi1.State = HAL_SPI_STATE_READY;
+	oled_panel.in_irq = 1;
+	if(lost) HAL_SPI_ErrorCallback(&hspi1);
+	else HAL_SPI_TxCpltCallback(&hspi1);
+	oled_panel.in_irq = irq;
+	return 1;
+}
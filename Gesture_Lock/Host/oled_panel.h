@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * File Name          : oled_panel.h
+  * Description        : Mock OLED transport of the host tests: SPI1 with its
+	*											 DMA and the bit-bang pins decoded into a model of the
+	*											 panel controller, so a test can compare what reached
+	*											 the panel with OLED_GRAM.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __oled_panel_H
+#define __oled_panel_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "oled.h"
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define OledPanelColumns	132		//controller RAM, 128 of them shown
+#define OledPanelColShift	1			//OLED_Set_Pos() sets bit 0 of the low column
+#define OledPanelBitCycles	16		//SPI1 at 96 MHz / 16
+/* Exported types ------------------------------------------------------------*/
+typedef struct{
+	u8				ram[OLED_PAGES][OledPanelColumns];
+	u8				page;
+	u8				col;
+	u8				arg;					//command bytes still to come as arguments
+
+	/* bit-bang decoder */
+	u8				sck;
+	u8				shift;
+	u8				bits;
+
+	/* DMA, set by the tests */
+	u8				dma_defer;		//0: done at once, 1: by Oled_Panel_Dma_Done()
+	uint32_t	refuse_next;	//HAL_SPI_Transmit_DMA() says busy this many times
+	uint32_t	lose_next;		//transfers that end in HAL_SPI_ErrorCallback()
+	const u8	*dma_buf;
+	uint16_t	dma_len;			//transfer on the wire, 0: none
+	u8				in_irq;				//in a DMA callback
+
+	/* counters */
+	uint32_t	cmd_bytes;
+	uint32_t	data_bytes;
+	uint32_t	no_cs;				//bytes clocked with CS high
+	uint32_t	irq_blocking;	//blocking transfers from a DMA callback
+	uint32_t	dma_transfers;
+	uint32_t	bb_bytes;			//bytes from the bit-bang pins
+} Oled_Panel_t;
+/* Exported constants --------------------------------------------------------*/
+extern Oled_Panel_t oled_panel;
+extern SPI_HandleTypeDef hspi1;
+/* Exported functions prototypes ---------------------------------------------*/
+void Oled_Panel_Power_On(u8 spi);
+u8 Oled_Panel_Dma_Done(void);
+void Oled_Panel_Screen(u8 screen[OLED_PAGES][X_WIDTH]);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__oled_panel_H */
@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * File Name          : oled_pbm.c
+  * Description        : Host backend of the OLED framebuffer, see oled_pbm.h.
+	*											 A PBM row is 16 bytes, leftmost pixel in the MSB; an
+	*											 OLED page byte is a column of 8 rows, top row in the
+	*											 LSB.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "oled_pbm.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  write a page buffer as a P4 image
+	*	@param	path	file to write
+	*	@param	gram	[page][column], as OLED_GRAM
+  * @retval 0: written, -1: file error
+  */
+int Oled_Pbm_Write(const char *path, u8 gram[OLED_PAGES][X_WIDTH]){
+	FILE *f = fopen(path, "wb");
+	u8 row[X_WIDTH/8];
+	int x, y;
+
+	if(!f) return -1;
+	fprintf(f, "P4\n%d %d\n", X_WIDTH, Y_WIDTH);
+	for(y=0;y<Y_WIDTH;y++){
+		memset(row, 0, sizeof(row));
+		for(x=0;x<X_WIDTH;x++){
+			if(gram[y/8][x] & (1 << (y%8))) row[x/8] |= 0x80 >> (x%8);
+		}
+		fwrite(row, 1, sizeof(row), f);
+	}
+	return fclose(f) ? -1 : 0;
+}
+
+/**
+  * @brief  read a P4 image of the panel size, as written by Oled_Pbm_Write()
+	*					(no comments in the header)
+	*	@param	path	file to read
+	*	@param	gram	[page][column], as OLED_GRAM
+  * @retval 0: read, -1: no such file or not a 128x64 P4 image
+  */
+int Oled_Pbm_Read(const char *path, u8 gram[OLED_PAGES][X_WIDTH]){
+	FILE *f = fopen(path, "rb");
+	u8 row[X_WIDTH/8];
+	int w, h, x, y, ok;
+
+	if(!f) return -1;
+	ok = fscanf(f, "P4 %d %d", &w, &h) == 2 && fgetc(f) != EOF && w == X_WIDTH && h == Y_WIDTH;
+	memset(gram, 0, OLED_PAGES * X_WIDTH);
+	for(y=0;ok && y<Y_WIDTH;y++){
+		ok = fread(row, 1, sizeof(row), f) == sizeof(row);
+		for(x=0;ok && x<X_WIDTH;x++){
+			if(row[x/8] & (0x80 >> (x%8))) gram[y/8][x] |= 1 << (y%8);
+		}
+	}
+	fclose(f);
+	return ok ? 0 : -1;
+}
+
+/**
+  * @brief  pixels that differ between two page buffers
+  * @retval pixel count
+  */
+uint32_t Oled_Pbm_Diff(u8 a[OLED_PAGES][X_WIDTH], u8 b[OLED_PAGES][X_WIDTH]){
+	uint32_t n = 0;
+	int x, y;
+
+	for(y=0;y<OLED_PAGES;y++){
+		for(x=0;x<X_WIDTH;x++) n += __builtin_popcount(a[y][x] ^ b[y][x]);
+	}
+	return n;
+}
@@ -0,0 +1,33 @@
+/**
+  ******************************************************************************
+  * File Name          : oled_pbm.h
+  * Description        : Host backend of the OLED framebuffer: a 128x64 page
+	*											 buffer laid out as OLED_GRAM to and from a binary
+	*											 PBM (P4) image, lit pixels black, for the golden
+	*											 image tests.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __oled_pbm_H
+#define __oled_pbm_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "oled.h"
+#include <stdint.h>
+/* Exported functions prototypes ---------------------------------------------*/
+int Oled_Pbm_Write(const char *path, u8 gram[OLED_PAGES][X_WIDTH]);
+int Oled_Pbm_Read(const char *path, u8 gram[OLED_PAGES][X_WIDTH]);
+uint32_t Oled_Pbm_Diff(u8 a[OLED_PAGES][X_WIDTH], u8 b[OLED_PAGES][X_WIDTH]);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__oled_pbm_H */
@@ -0,0 +1,328 @@
+/**
+  ******************************************************************************
+  * File Name          : oled_test.c
+  * Description        : Host test of the OLED framebuffer and its transport
+	*											 (oled.c). The screens of the firmware and the drawing
+	*											 primitives are drawn in the order the UI shows them,
+	*											 flushed, and compared with the golden images in
+	*											 golden/ and with what reached the panel (oled_panel.c),
+	*											 once over SPI1 and DMA and once bit-banged. The bytes
+	*											 and time of each flush are printed and a redraw of
+	*											 the same screen must send nothing. Then drawing during
+	*											 a flush and refused or lost DMA transfers. A screen
+	*											 that differs is written next to the program.
+	*											 Usage: oled_test [-u] [golden dir], -u rewrites the
+	*											 golden images after a deliberate change.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "oled.h"
+#include "oled_pbm.h"
+#include "oled_panel.h"
+#include "bmp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Private types -------------------------------------------------------------*/
+typedef struct{
+	const char	*name;
+	void				(*draw)(void);
+	uint16_t		bytes_max;		//flush after the previous screen, 0: not checked
+} Test_Screen_t;
+
+/* Private variables ---------------------------------------------------------*/
+extern u8 OLED_GRAM[OLED_PAGES][X_WIDTH];
+
+static u8		golden[OLED_PAGES][X_WIDTH];
+static u8		screen[OLED_PAGES][X_WIDTH];
+static u8		flush_done;
+static int	fails;
+/* Private user code ---------------------------------------------------------*/
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+/* the screens as state_machine.c and main.c draw them */
+static void Draw_Boot(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,(u8*)"MPU6050 OK");
+	OLED_ShowString(0,2,(u8*)"Wait init...");
+	OLED_ShowString(0,4,(u8*)"Ready");
+}
+
+static void Draw_Locked(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,(u8*)"Locked!");
+	OLED_ShowString(0,2,(u8*)"Press to Unlock.");
+}
+
+static void Draw_Unlock_Mode(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,(u8*)"Unlock Mode");
+}
+
+static void Draw_Gesture(uint8_t ges, uint8_t len){
+	OLED_Clear();
+	OLED_ShowString(0,0,(u8*)"Unlock Mode");
+	OLED_ShowString(0,2,(u8*)"Last Ges:");
+	OLED_ShowNum(80,2,ges,2,16);
+	OLED_ShowString(0,4,(u8*)"Ges Len:");
+	OLED_ShowNum(80,4,len,2,16);
+}
+
+static void Draw_Gesture_3(void){ Draw_Gesture(7, 3); }
+static void Draw_Gesture_4(void){ Draw_Gesture(12, 4); }
+
+static void Draw_Match(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,(u8*)"Checking...");
+	OLED_ShowString(0,2,(u8*)"Match!");
+	OLED_ShowString(0,4,(u8*)"Unlock!!!!");
+}
+
+static void Draw_Unlocked(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,(u8*)"Unlocked!");
+	OLED_ShowString(0,2,(u8*)"Long Press to");
+	OLED_ShowString(0,4,(u8*)"Record");
+}
+
+static void Draw_Fail(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,(u8*)"Checking...");
+	OLED_ShowString(0,2,(u8*)"Fail!!!!");
+}
+
+static void Draw_Saved(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,(u8*)"Saving...");
+	OLED_ShowString(0,2,(u8*)"New: 7, 8, 9,10,11,12,");	//wraps onto page 4
+	OLED_ShowString(0,6,(u8*)"Saved!");
+}
+
+static void Draw_Too_Short(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,(u8*)"Too short!!!");
+}
+
+static void Draw_Shapes(void){
+	u8 x, y;
+	OLED_Clear();
+	for(x=0;x<X_WIDTH;x++){
+		OLED_DrawPoint(x,0,1);
+		OLED_DrawPoint(x,Y_WIDTH-1,1);
+	}
+	for(y=0;y<Y_WIDTH;y++){
+		OLED_DrawPoint(0,y,1);
+		OLED_DrawPoint(X_WIDTH-1,y,1);
+	}
+	OLED_Fill(10,3,40,12,1);					//across a page boundary
+	OLED_Fill(20,6,30,9,0);						//hole in it
+	OLED_Fill(100,40,140,70,1);				//clipped at the edges
+	for(x=0;x<64;x++) OLED_DrawPoint(32+x,16+x/2,1);
+}
+
+static void Draw_Chinese(void){
+	u8 i;
+	OLED_Clear();
+	for(i=0;i<7;i++) OLED_ShowCHinese(i*16,2,i);
+	OLED_ShowNum(0,6,4294967295u,10,16);
+}
+
+static void Draw_Bmp(void){
+	OLED_DrawBMP(0,0,128,8,BMP1);
+}
+
+static const Test_Screen_t screens[] = {
+	{"boot",				Draw_Boot,				0},
+	{"locked",			Draw_Locked,			0},
+	{"unlock_mode",	Draw_Unlock_Mode,	0},
+	{"gesture_3",		Draw_Gesture_3,		0},
+	{"gesture_4",		Draw_Gesture_4,		48},	//three digits, 2 pages each
+	{"match",				Draw_Match,				0},
+	{"unlocked",		Draw_Unlocked,		0},
+	{"fail",				Draw_Fail,				0},
+	{"saved",				Draw_Saved,				0},
+	{"too_short",		Draw_Too_Short,		0},
+	{"shapes",			Draw_Shapes,			0},
+	{"chinese",			Draw_Chinese,			0},
+	{"bmp",					Draw_Bmp,					0},
+};
+
+/**
+  * @brief  pixels the panel shows unlike OLED_GRAM
+  * @retval pixel count
+  */
+static uint32_t Test_Panel_Diff(void){
+	Oled_Panel_Screen(screen);
+	return Oled_Pbm_Diff(screen, OLED_GRAM);
+}
+
+static void Test_Flush_Done(void){
+	flush_done++;
+}
+
+/**
+  * @brief  boot the panel, then every screen against its golden image and
+	*					the panel
+	*	@param	spi			1: SPI1 and DMA, 0: bit-bang
+	*	@param	dir			golden images
+	*	@param	out			prefix of the images that differ
+	*	@param	update	write the golden images instead
+  * @retval None
+  */
+static void Test_Screens(u8 spi, const char *dir, const char *out, int update){
+	const char *mode = spi ? "SPI" : "bit-bang";
+	const Test_Screen_t *s;
+	char path[256], what[320];
+	uint32_t diff, flushes, bytes;
+
+	Oled_Panel_Power_On(spi);
+	memset(&oled_stats, 0, sizeof(oled_stats));
+	OLED_Init();
+	snprintf(what, sizeof(what), "%s: OLED_Init sends the whole panel", mode);
+	Test_Check(oled_stats.flushes == 1 && oled_stats.bytes_last == X_WIDTH * OLED_PAGES && Test_Panel_Diff() == 0, what);
+
+	if(spi) printf("\n%s, full screen %u us at %u MHz\n", mode, (unsigned)oled_stats.us_full,
+								 (unsigned)(SystemCoreClock / OledPanelBitCycles / 1000000));
+	else printf("\n%s, not timed\n", mode);
+	printf("screen        bytes     us  pixels off golden, panel\n");
+	for(s=screens;s<screens+sizeof(screens)/sizeof(screens[0]);s++){
+		flushes = oled_stats.flushes;
+		s->draw();
+		OLED_Refresh();
+		bytes = oled_stats.flushes != flushes ? oled_stats.bytes_last : 0;
+		snprintf(path, sizeof(path), "%s/%s.pbm", dir, s->name);
+		if(update){
+			Test_Check(Oled_Pbm_Write(path, OLED_GRAM) == 0, path);
+			printf("%-12s %5u  written\n", s->name, (unsigned)bytes);
+			continue;
+		}
+		if(Oled_Pbm_Read(path, golden)){
+			printf("%-12s %5u  no golden image\n", s->name, (unsigned)bytes);
+			snprintf(what, sizeof(what), "%s: no golden image, run with -u", path);
+			Test_Check(0, what);
+			continue;
+		}
+		diff = Oled_Pbm_Diff(OLED_GRAM, golden);
+		printf("%-12s %5u  %5u  %u, %u\n", s->name, (unsigned)bytes, (unsigned)oled_stats.us_last,
+					 (unsigned)diff, (unsigned)Test_Panel_Diff());
+		if(diff){
+			snprintf(path, sizeof(path), "%s%s.pbm", out, s->name);
+			Oled_Pbm_Write(path, OLED_GRAM);
+			snprintf(what, sizeof(what), "%s: differs from the golden image, see %s", s->name, path);
+			Test_Check(0, what);
+		}
+		if(Test_Panel_Diff()){
+			snprintf(path, sizeof(path), "%s%s_panel.pbm", out, s->name);
+			Oled_Pbm_Write(path, screen);
+			snprintf(what, sizeof(what), "%s, %s: panel differs from the framebuffer, see %s", mode, s->name, path);
+			Test_Check(0, what);
+		}
+		if(s->bytes_max){
+			snprintf(what, sizeof(what), "%s: %u bytes for the change", s->name, (unsigned)bytes);
+			Test_Check(bytes > 0 && bytes <= s->bytes_max, what);
+		}
+
+		/* cleared and drawn again the same: nothing to send */
+		flushes = oled_stats.flushes;
+		s->draw();
+		OLED_Refresh();
+		snprintf(what, sizeof(what), "%s: redraw sent %u bytes", s->name,
+						 oled_stats.flushes != flushes ? (unsigned)oled_stats.bytes_last : 0);
+		Test_Check(oled_stats.flushes == flushes, what);
+	}
+	snprintf(what, sizeof(what), "%s: %u bytes clocked without CS", mode, (unsigned)oled_panel.no_cs);
+	Test_Check(oled_panel.no_cs == 0, what);
+}
+
+/**
+  * @brief  the UI draws the next screen while the DMA sends the last one:
+	*					the changes go out with the next flush
+  * @retval None
+  */
+static void Test_Async(void){
+	uint32_t steps = 0;
+
+	Oled_Panel_Power_On(1);
+	OLED_Init();
+	oled_panel.dma_defer = 1;
+	flush_done = 0;
+	Draw_Locked();
+	Test_Check(OLED_Refresh_Async(Test_Flush_Done) == 0 && OLED_Busy(), "async: flush started");
+	Test_Check(OLED_Refresh_Async(Test_Flush_Done) == 1, "async: second flush refused while busy");
+	Oled_Panel_Dma_Done();
+	Oled_Panel_Dma_Done();
+	Draw_Unlocked();								//page 0 is out, the rest is not
+	while(Oled_Panel_Dma_Done()) steps++;
+	Test_Check(flush_done == 1 && !OLED_Busy(), "async: done callback");
+	OLED_Refresh_Async(Test_Flush_Done);
+	while(Oled_Panel_Dma_Done()) steps++;
+	printf("\ndrawn during a flush  %u transfers, %u pixels off\n", (unsigned)steps, (unsigned)Test_Panel_Diff());
+	Test_Check(flush_done == 2 && Test_Panel_Diff() == 0, "async: screen drawn during a flush");
+	Test_Check(oled_panel.irq_blocking == 0, "async: blocking transfer in the DMA interrupt");
+	oled_panel.dma_defer = 0;
+}
+
+/**
+  * @brief  random screens with refused and lost DMA transfers: the flush
+	*					always ends, and the pages it could not send go out with the
+	*					next one
+	*	@param	rounds	screens drawn
+  * @retval None
+  */
+static void Test_Faults(uint32_t rounds){
+	uint32_t c, lost = 0, open = 0;
+	const Test_Screen_t *s;
+
+	Oled_Panel_Power_On(1);
+	OLED_Init();
+	for(c=0;c<rounds;c++){
+		s = &screens[rand() % (sizeof(screens)/sizeof(screens[0]))];
+		s->draw();
+		oled_panel.refuse_next = rand() % 4 == 0 ? 1 + rand() % 3 : 0;
+		oled_panel.lose_next = rand() % 4 == 0 ? 1 + rand() % 3 : 0;
+		OLED_Refresh();
+		open += Test_Panel_Diff() != 0;
+		oled_panel.refuse_next = 0;
+		oled_panel.lose_next = 0;
+		OLED_Refresh();
+		if(Test_Panel_Diff()) lost++;
+	}
+	printf("refused and lost DMA  %u screens, %u pages lost, %u screens fixed by the next flush, %u not\n",
+				 (unsigned)rounds, (unsigned)oled_stats.lost, (unsigned)open, (unsigned)lost);
+	Test_Check(oled_stats.lost > 0 && open > 0, "faults: none injected");
+	Test_Check(lost == 0, "faults: lost page not sent by the next flush");
+	Test_Check(oled_panel.irq_blocking == 0, "faults: blocking transfer in the DMA interrupt");
+}
+
+int main(int argc, char **argv){
+	const char *dir = "golden";
+	char out[256];
+	int update = 0, i;
+
+	for(i=1;i<argc;i++){
+		if(!strcmp(argv[i], "-u")) update = 1;
+		else dir = argv[i];
+	}
+	snprintf(out, sizeof(out), "%.*s", strrchr(argv[0], '/') ? (int)(strrchr(argv[0], '/') - argv[0] + 1) : 0, argv[0]);
+
+	Test_Screens(1, dir, out, update);
+	if(!update){
+		Test_Screens(0, dir, out, 0);
+		Test_Async();
+		Test_Faults(500);
+	}
+
+	printf("\n%s\n", fails ? "FAILED" : "OLED framebuffer checks passed");
+	return fails != 0;
+}
@@ -0,0 +1,299 @@
+/**
+  ******************************************************************************
+  * File Name          : sched_test.c
+  * Description        : Host test of the task scheduler (sched.c) in virtual
+	*											 time. The tasks are stubs that take a set time of
+	*											 DWT cycles and HAL ticks, TIM2 releases Task_Sensor
+	*											 at its period while they run. Checked: earliest
+	*											 deadline first, the chain from a sample to Detect and
+	*											 Telemetry, overruns, missed deadlines, periodic tasks
+	*											 after a stall (one release, then on time again), the
+	*											 sensor deadline beside a storage step and beside a
+	*											 sector erase, and the Sched_Stats_Pack() bytes.
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sched.h"
+#include "mpu6050.h"
+#include "mpubus.h"
+#include "oled.h"
+#include "serial_debug.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestCycUs				96				//DWT cycles per us, SystemCoreClock
+#define TestTraceMax		64
+#define TestSensorUs		10000			//TIM2 at 100 Hz
+#define TestStoreStepUs	256				//16 bytes programmed, 16 us each
+#define TestEraseUs			550000		//sector 4 erase
+
+/* Private variables ---------------------------------------------------------*/
+volatile MPU_Data_t	mpu_data;
+uint8_t							cdc_stream_on;
+
+static uint32_t	run_us[Task_Num];				//time each task takes
+static uint32_t	store_once_us;					//next Storage run takes this instead
+static uint8_t	trace[TestTraceMax];		//tasks in the order they ran
+static uint8_t	trace_n;
+static uint64_t	now_us;
+static uint32_t	isr_us;									//TIM2 period, 0: off
+static uint64_t	isr_next;
+static int			fails;
+/* Private user code ---------------------------------------------------------*/
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+/**
+  * @brief  let time pass: DWT cycles, HAL tick and TIM2
+	*	@param	us		microseconds
+  * @retval None
+  */
+static void Test_Spend(uint32_t us){
+	while(us--){
+		now_us++;
+		host_dwt.CYCCNT += TestCycUs;
+		host_tick = now_us / 1000;
+		if(isr_us && now_us >= isr_next){
+			isr_next += isr_us;
+			Sched_Release(Task_Sensor);
+		}
+	}
+}
+
+/**
+  * @brief  body of every task stub
+  * @retval None
+  */
+static void Test_Task(uint8_t id){
+	uint32_t us = run_us[id];
+	if(id == Task_Storage && store_once_us){
+		us = store_once_us;
+		store_once_us = 0;
+	}
+	if(trace_n < TestTraceMax) trace[trace_n++] = id;
+	Test_Spend(us);
+}
+
+/* Task stubs ----------------------------------------------------------------*/
+MPU_Bus_State_t MPU_Bus_Poll(void){ return MPU_BUS_OK; }
+u8 MPU_Update(MPU_Data_t *mpu){ Test_Task(Task_Sensor); return 0; }
+int State_Update_Motion(void){ Test_Task(Task_Detect); return 0; }
+int State_Update_UI(void){ Test_Task(Task_UI); return 0; }
+u8 OLED_Refresh_Async(void (*done)(void)){ return 0; }
+int Plot_Data(void){ Test_Task(Task_Telemetry); return 0; }
+int Stream_Data(void){ return 0; }
+void Cmd_Trace_Put(void){}
+void Tlm_Poll(void){}
+void Cmd_Poll(void){}
+void Cdc_Poll(void){}
+void Log_Poll(void){}
+void Param_Poll(void){}
+int State_Update_Storage(void){ Test_Task(Task_Storage); return 0; }
+
+/**
+  * @brief  start over on a ms boundary: scheduler, task times, trace
+  * @retval None
+  */
+static void Test_Reset(void){
+	isr_us = 0;
+	Test_Spend(1000 - now_us % 1000);
+	memset(run_us, 0, sizeof(run_us));
+	store_once_us = 0;
+	trace_n = 0;
+	Sched_Init();
+}
+
+/**
+  * @brief  the main loop for a while, 1 us per idle pass
+  * @retval None
+  */
+static void Test_Loop(uint32_t ms){
+	uint64_t end = now_us + 1000ull * ms;
+	while(now_us < end){
+		if(!Sched_Run()) Test_Spend(1);
+	}
+}
+
+static uint32_t Test_Runs(uint8_t id){
+	return Sched_Get_Stats(id)->runs;
+}
+
+static uint32_t Test_Get16(const uint8_t *p){
+	return (uint32_t)p[0] << 8 | p[1];
+}
+
+/**
+  * @brief  release order against run order
+  * @retval None
+  */
+static void Test_Order(void){
+	Test_Reset();
+	Sched_Release(Task_Telemetry);
+	Sched_Release(Task_Detect);
+	Sched_Release(Task_Sensor);
+	while(Sched_Run());
+	Test_Check(trace_n == 3 && trace[0] == Task_Sensor && trace[1] == Task_Detect && trace[2] == Task_Telemetry,
+						 "released together: not by deadline");
+
+	Test_Reset();
+	Sched_Release(Task_Telemetry);			//due at 20 ms
+	Test_Spend(15000);
+	Sched_Release(Task_Detect);					//due at 25 ms, UI released at 15 ms due at 35 ms
+	while(Sched_Run());
+	Test_Check(trace_n == 3 && trace[0] == Task_Telemetry && trace[1] == Task_Detect && trace[2] == Task_UI,
+						 "released apart: not by absolute deadline");
+
+	Test_Reset();
+	Sched_Release(Task_Sensor);
+	while(Sched_Run());
+	Test_Check(trace_n == 3 && trace[0] == Task_Sensor && trace[1] == Task_Detect && trace[2] == Task_Telemetry,
+						 "a sample does not run Detect, then Telemetry");
+	printf("order         deadline first, sample -> Sensor, Detect, Telemetry\n");
+}
+
+/**
+  * @brief  overruns and missed deadlines
+  * @retval None
+  */
+static void Test_Overrun(void){
+	const Sched_Stats_t *st = Sched_Get_Stats(Task_Sensor);
+
+	Test_Reset();
+	run_us[Task_Sensor] = 1000;
+	Sched_Release(Task_Sensor);
+	Test_Spend(2000);
+	Sched_Release(Task_Sensor);					//before it ran: counted, first release kept
+	Sched_Run();
+	Test_Check(st->runs == 1 && st->overruns == 1, "second release before the run not an overrun");
+	Test_Check(st->latency_max == 2000 * TestCycUs, "latency not from the first release");
+	Test_Check(st->missed == 0, "missed at 3 of 5 ms");
+
+	run_us[Task_Sensor] = 6000;
+	Sched_Release(Task_Sensor);
+	Sched_Run();
+	Test_Check(st->missed == 1 && st->run_max == 6000 * TestCycUs, "6 ms run not a missed 5 ms deadline");
+	printf("overrun       %u overrun, %u missed, max latency %u us\n", (unsigned)st->overruns,
+				 (unsigned)st->missed, (unsigned)(st->latency_max / TestCycUs));
+}
+
+/**
+  * @brief  periodic tasks on their grid, after a stall once and on time again
+  * @retval None
+  */
+static void Test_Periodic(void){
+	uint32_t ui, store;
+
+	Test_Reset();
+	Test_Loop(100);
+	ui = Test_Runs(Task_UI);
+	store = Test_Runs(Task_Storage);
+	Test_Check(ui == 9 && store == 4, "100 ms: UI not released at 10 to 90 ms, Storage at 20 to 80");
+	Test_Check(Sched_Get_Stats(Task_UI)->latency_max < 2 * TestCycUs, "periodic release late");
+
+	Test_Spend(35000);									//main loop stalled for three UI periods
+	Test_Loop(1);
+	Test_Check(Test_Runs(Task_UI) == ui + 1 && Test_Runs(Task_Storage) == store + 1,
+						 "stall: periodic tasks released more than once");
+	ui = Test_Runs(Task_UI);
+	Test_Loop(100);
+	Test_Check(Test_Runs(Task_UI) == ui + 10, "stall: UI not every 10 ms after it");
+	Test_Check(Sched_Get_Stats(Task_UI)->overruns == 0, "stall: skipped releases counted as overruns");
+	printf("periodic      UI %u runs, Storage %u, one release after a 35 ms stall\n",
+				 (unsigned)Test_Runs(Task_UI), (unsigned)Test_Runs(Task_Storage));
+}
+
+/**
+  * @brief  Task_Sensor at 100 Hz beside the other tasks, the storage task
+	*					once programming a key record step and once erasing a
+	*					sector in one run
+	*	@param	store_us	the one long storage run
+  * @retval missed sensor deadlines
+  */
+static uint32_t Test_Load(uint32_t store_us){
+	const Sched_Stats_t *st = Sched_Get_Stats(Task_Sensor);
+
+	Test_Reset();
+	run_us[Task_Sensor] = 300;
+	run_us[Task_Detect] = 100;
+	run_us[Task_UI] = 500;
+	run_us[Task_Telemetry] = 200;
+	run_us[Task_Storage] = 50;
+	isr_next = now_us + TestSensorUs;
+	isr_us = TestSensorUs;
+	Test_Loop(100);
+	store_once_us = store_us;
+	Test_Loop(1900);
+	isr_us = 0;
+	printf("load          storage run of %6u us: sensor %u runs, %u missed, %u overruns, max latency %u us\n",
+				 (unsigned)store_us, (unsigned)st->runs, (unsigned)st->missed, (unsigned)st->overruns,
+				 (unsigned)(st->latency_max / TestCycUs));
+	return st->missed;
+}
+
+/**
+  * @brief  the stats reply, byte by byte
+  * @retval None
+  */
+static void Test_Pack(void){
+	uint8_t out[Task_Num*SchedStatsBytes], *p;
+	uint32_t start, n, i, zero = 1;
+
+	Test_Reset();
+	start = host_tick;
+	run_us[Task_Sensor] = 1000;
+	Sched_Release(Task_Sensor);
+	Sched_Run();
+	Sched_Release(Task_Sensor);
+	Test_Spend(2000);
+	Sched_Run();
+	run_us[Task_Sensor] = 70000;				//past 0xFFFF us
+	Sched_Release(Task_Sensor);
+	Sched_Run();
+	Test_Spend(1000000 - (now_us - 1000ull * start));
+	Test_Check(host_tick - start == 1000, "pack: not 1 s of stats");
+
+	memset(out, 0xAA, sizeof(out));
+	n = Sched_Stats_Pack(out);
+	Test_Check(n == Task_Num*SchedStatsBytes, "pack: length");
+	p = &out[Task_Sensor*SchedStatsBytes];
+	Test_Check(p[0] == 0 && p[1] == 0 && p[2] == 0 && p[3] == 3, "pack: runs");
+	Test_Check(Test_Get16(&p[4]) == 72, "pack: load, 72 ms of 1 s");
+	Test_Check(Test_Get16(&p[6]) == 0xFFFF, "pack: max run does not saturate");
+	Test_Check(Test_Get16(&p[8]) == 2000, "pack: max latency");
+	Test_Check(Test_Get16(&p[10]) == 1, "pack: missed");
+	for(i=SchedStatsBytes;i<n;i++) zero &= out[i] == 0;	//Sensor is task 0, nothing else ran
+	Test_Check(zero, "pack: tasks that did not run not zero");
+	printf("pack          %u bytes, Sensor: runs %u, load %u permille, max run %u us, latency %u us, missed %u\n",
+				 (unsigned)n, (unsigned)p[3], (unsigned)Test_Get16(&p[4]), (unsigned)Test_Get16(&p[6]),
+				 (unsigned)Test_Get16(&p[8]), (unsigned)Test_Get16(&p[10]));
+}
+
+int main(void){
+	uint32_t missed;
+
+	host_core_debug.DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	host_dwt.CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	Test_Check(Sched_Release(Task_Sensor) == 0, "release before Sched_Init");
+
+	Test_Order();
+	Test_Overrun();
+	Test_Periodic();
+	missed = Test_Load(TestStoreStepUs);
+	Test_Check(missed == 0, "load: sensor deadline missed beside a storage step");
+	missed = Test_Load(TestEraseUs);
+	Test_Check(missed > 0 && Sched_Get_Stats(Task_Sensor)->overruns > 0, "load: an erase in the storage task not seen");
+	Test_Pack();
+
+	printf("\n%s\n", fails ? "FAILED" : "scheduler checks passed");
+	return fails != 0;
+}
@@ -0,0 +1,293 @@
+/**
+  ******************************************************************************
+  * File Name          : tlm_test.c
+  * Description        : Host test and bandwidth benchmark of the UART1
+	*											 telemetry ring (telemetry.c) on a UART DMA mock at
+	*											 256000 baud. The benchmark offers Plot_Data sized
+	*											 frames at 10 to 300% of the link in 1 ms steps and
+	*											 prints what gets through, the drops, the frames per
+	*											 DMA start, the ring high water mark and the latency.
+	*											 The race test writes frames from the main code while
+	*											 a real asynchronous interrupt (Host_Irq_Start) writes
+	*											 its own and ends the DMA transfers, as the TIM2 ISR
+	*											 and the DMA2 Stream7 interrupt do on the board. Every
+	*											 frame carries a source, a sequence number and a sum:
+	*											 all queued frames must come out whole and in order.
+	*											 Usage: tlm_test [seed [race ms]]
+  ******************************************************************************
+  * @attention
+  *	Host build, see Makefile
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "telemetry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Private macro -------------------------------------------------------------*/
+#define TestBaud				256000		//MX_USART1_UART_Init()
+#define TestBenchMs			10000
+#define TestFrameLen		16				//Plot_Data()
+#define TestSync				0xA5
+#define TestRxMax				(4u << 20)
+#define TestIrqUs				20				//race test interrupt period
+#define TestIrqDrain		32				//bytes the UART sends per interrupt
+
+/* Private types -------------------------------------------------------------*/
+typedef struct{
+	uint32_t	queued[2];			//per source
+	uint32_t	tried[2];
+	uint32_t	got[2];					//frames out, whole and in order
+	uint32_t	bad;						//bytes skipped to find a frame
+	uint32_t	order;					//frames out of order
+	uint32_t	lat_sum;				//ms, source 0
+	uint32_t	lat_max;
+} Test_Count_t;
+
+/* Private variables ---------------------------------------------------------*/
+UART_HandleTypeDef	huart1;
+
+static const uint8_t	*uart_buf;
+static uint16_t				uart_len;		//bytes of the transfer on the wire
+static uint16_t				uart_pos;
+static uint32_t				uart_starts;
+static uint8_t				rx[TestRxMax];
+static uint32_t				rx_tick[TestRxMax / TestFrameLen];	//tick of each frame end, bench only
+static uint32_t				rx_len;
+static Test_Count_t		cnt;
+static int						fails;
+/* Private user code ---------------------------------------------------------*/
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *h, uint8_t *buf, uint16_t len){
+	if(h->gState != HAL_UART_STATE_READY) return HAL_BUSY;
+	h->gState = HAL_UART_STATE_BUSY_TX;
+	uart_buf = buf;
+	uart_len = len;
+	uart_pos = 0;
+	uart_starts++;
+	return HAL_OK;
+}
+
+/**
+  * @brief  the UART sends up to n bytes of the transfer, the completion
+	*					interrupt comes after the last
+  * @retval None
+  */
+static void Test_Uart_Run(uint32_t n){
+	while(n-- && uart_pos < uart_len){
+		if(rx_len < TestRxMax) rx[rx_len++] = uart_buf[uart_pos];
+		uart_pos++;
+	}
+	if(uart_len && uart_pos == uart_len){
+		uart_len = 0;
+		huart1.gState = HAL_UART_STATE_READY;
+		HAL_UART_TxCpltCallback(&huart1);
+	}
+}
+
+static void Test_Check(int ok, const char *what){
+	if(ok) return;
+	printf("FAIL  %s\n", what);
+	fails++;
+}
+
+/**
+  * @brief  queue one frame: sync, source, sequence, length, payload, sum.
+	*					The payload starts with the tick it was written at.
+	*	@param	src		0: main code, 1: interrupt
+	*	@param	len		payload bytes, 4 or more
+  * @retval 0: queued, 1: dropped
+  */
+static uint8_t Test_Frame(uint8_t src, uint8_t len){
+	uint8_t f[64], sum = 0, i;
+	uint32_t seq = cnt.queued[src], t = host_tick;
+
+	f[0] = TestSync;
+	f[1] = src;
+	f[2] = seq;
+	f[3] = seq >> 8;
+	f[4] = len;
+	memcpy(&f[5], &t, 4);
+	for(i=4;i<len;i++) f[5+i] = (uint8_t)(seq * 7 + i);
+	for(i=0;i<5+len;i++) sum += f[i];
+	f[5+len] = sum;
+	cnt.tried[src]++;
+	if(Tlm_Write(f, 6 + len)) return 1;
+	cnt.queued[src]++;
+	return 0;
+}
+
+/**
+  * @brief  split what came out of the UART into frames
+	*	@param	ticks		rx_tick holds the tick each frame ended at
+  * @retval None
+  */
+static void Test_Parse(uint8_t ticks){
+	uint32_t p = 0, n, seq, t;
+	uint8_t sum, src, i;
+
+	while(p + 6 <= rx_len){
+		n = 6 + rx[p+4];
+		if(rx[p] != TestSync || rx[p+1] > 1 || p + n > rx_len){
+			p++;
+			cnt.bad++;
+			continue;
+		}
+		for(sum=0,i=0;i<n-1;i++) sum += rx[p+i];
+		if(sum != rx[p+n-1]){
+			p++;
+			cnt.bad++;
+			continue;
+		}
+		src = rx[p+1];
+		seq = rx[p+2] | rx[p+3] << 8;
+		if(seq != (cnt.got[src] & 0xFFFF)) cnt.order++;
+		cnt.got[src]++;
+		if(ticks && src == 0){
+			memcpy(&t, &rx[p+5], 4);
+			t = rx_tick[(p + n - 1) / TestFrameLen] - t;
+			cnt.lat_sum += t;
+			if(t > cnt.lat_max) cnt.lat_max = t;
+		}
+		p += n;
+	}
+	cnt.bad += rx_len - p;
+}
+
+static void Test_Reset(void){
+	Tlm_Init();
+	huart1.gState = HAL_UART_STATE_READY;
+	uart_len = 0;
+	uart_starts = 0;
+	rx_len = 0;
+	memset(&cnt, 0, sizeof(cnt));
+}
+
+/**
+  * @brief  frames offered at a share of the link for TestBenchMs, 1 ms
+	*					steps: producer, UART, Tlm_Poll as the scheduler runs them
+	*	@param	load	percent of the link
+  * @retval None
+  */
+static void Test_Bench(uint32_t load){
+	uint32_t ms, link = TestBaud / 10;		//bytes per s, 8N1
+	uint32_t offer = 0, drain = 0, last, got, out = 0;
+	char what[96];
+
+	Test_Reset();
+	for(ms=0;ms<TestBenchMs+1000;ms++){
+		if(ms < TestBenchMs){
+			offer += link * load / 100;
+			while(offer >= 1000 * TestFrameLen){
+				offer -= 1000 * TestFrameLen;
+				Test_Frame(0, TestFrameLen - 6);
+			}
+		}
+		drain += link;
+		last = rx_len;
+		Test_Uart_Run(drain / 1000);
+		drain %= 1000;
+		while(last < rx_len){							//frames end on TestFrameLen bytes
+			rx_tick[last / TestFrameLen] = host_tick;
+			last++;
+		}
+		Tlm_Poll();
+		host_tick++;
+		if(ms == TestBenchMs - 1) out = rx_len;
+	}
+	Test_Parse(1);
+	got = cnt.got[0];
+	printf("%4u%%  %6u  %6u  %5.1f%%  %5.1f  %5u  %4.1f  %3u\n", (unsigned)load,
+				 (unsigned)(cnt.tried[0] * TestFrameLen * 1000ull / TestBenchMs),
+				 (unsigned)(out * 1000ull / TestBenchMs),
+				 cnt.tried[0] ? 100.0 * tlm_stats.dropped_frames / cnt.tried[0] : 0.0,
+				 uart_starts ? (double)got / uart_starts : 0.0,
+				 (unsigned)tlm_stats.fill_max, got ? (double)cnt.lat_sum / got : 0.0, (unsigned)cnt.lat_max);
+
+	snprintf(what, sizeof(what), "bench %u%%: frames broken or out of order", (unsigned)load);
+	Test_Check(cnt.bad == 0 && cnt.order == 0 && got == cnt.queued[0], what);
+	snprintf(what, sizeof(what), "bench %u%%: drops not counted", (unsigned)load);
+	Test_Check(cnt.tried[0] - cnt.queued[0] == tlm_stats.dropped_frames, what);
+	if(load < 100){
+		snprintf(what, sizeof(what), "bench %u%%: frames dropped or late below the link rate", (unsigned)load);
+		Test_Check(tlm_stats.dropped_frames == 0 && cnt.lat_max <= TlmFlushTime + 10, what);
+	}
+	else{
+		snprintf(what, sizeof(what), "bench %u%%: link idle while frames are dropped", (unsigned)load);
+		Test_Check(out >= (uint64_t)link * TestBenchMs / 1000 * 95 / 100, what);
+	}
+}
+
+/* race test interrupt: a frame every other time, and the UART */
+static volatile uint32_t irq_count;
+
+static void Test_Isr(void){
+	if(irq_count++ & 1) Test_Frame(1, TestFrameLen - 6);
+	Test_Uart_Run(TestIrqDrain);
+	host_tick = irq_count * TestIrqUs / 1000;
+}
+
+/**
+  * @brief  frames from the main code and from an interrupt, the main code
+	*					in turns floods the ring and leaves half of it free
+	*	@param	ms		real time to run
+  * @retval None
+  */
+static void Test_Race(uint32_t ms){
+	struct timespec t0, t;
+	uint32_t masked, loops = 0;
+	char what[128];
+
+	Test_Reset();
+	irq_count = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	Host_Irq_Start(Test_Isr, TestIrqUs);
+	do{
+		if((irq_count & 512) || Tlm_Free() > TlmRingSize / 2) Test_Frame(0, 4 + rand() % 36);	//flood, or leave room
+		Tlm_Poll();
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		loops++;
+	}while((t.tv_sec - t0.tv_sec) * 1000 + (t.tv_nsec - t0.tv_nsec) / 1000000 < (long)ms && rx_len < TestRxMax - 4096);
+	masked = Host_Irq_Stop();
+	while(uart_len || Tlm_Free() < TlmRingSize){	//drain
+		Test_Uart_Run(TestIrqDrain);
+		host_tick += TlmFlushTime;
+		Tlm_Poll();
+	}
+	Test_Parse(0);
+
+	printf("\nrace: %u interrupts, %u while masked, main frames %u/%u out, interrupt frames %u/%u out,\n"
+				 "      %u dropped, %u bytes broken, %u out of order\n",
+				 (unsigned)irq_count, (unsigned)masked, (unsigned)cnt.got[0], (unsigned)cnt.tried[0],
+				 (unsigned)cnt.got[1], (unsigned)cnt.tried[1], (unsigned)tlm_stats.dropped_frames,
+				 (unsigned)cnt.bad, (unsigned)cnt.order);
+	Test_Check(masked > 0 && cnt.tried[1] > 1000, "race: the interrupt never hit a masked section");
+	Test_Check(cnt.bad == 0 && cnt.order == 0, "race: frames broken or out of order");
+	snprintf(what, sizeof(what), "race: queued %u+%u frames, %u+%u out", (unsigned)cnt.queued[0],
+					 (unsigned)cnt.queued[1], (unsigned)cnt.got[0], (unsigned)cnt.got[1]);
+	Test_Check(cnt.got[0] == cnt.queued[0] && cnt.got[1] == cnt.queued[1], what);
+	Test_Check(cnt.tried[0] + cnt.tried[1] - cnt.queued[0] - cnt.queued[1] == tlm_stats.dropped_frames,
+						 "race: drops not counted");
+	Test_Check(tlm_stats.dropped_frames > 0, "race: ring never full");
+}
+
+int main(int argc, char **argv){
+	static const uint32_t loads[] = {10, 50, 90, 100, 150, 300};
+	unsigned seed = argc > 1 ? atoi(argv[1]) : 1;
+	uint32_t race_ms = argc > 2 ? atoi(argv[2]) : 1000, i;
+
+	srand(seed);
+	printf("frames of %u bytes at %u baud, %u s\n", (unsigned)TestFrameLen,
+				 (unsigned)TestBaud, (unsigned)(TestBenchMs / 1000));
+	printf("load  offer   out     drop   fr/DMA  fill  lat   max  (B/s, ms)\n");
+	for(i=0;i<sizeof(loads)/sizeof(loads[0]);i++) Test_Bench(loads[i]);
+
+	Test_Race(race_ms);
+
+	printf("\n%s\n", fails ? "FAILED" : "telemetry checks passed");
+	return fails != 0;
+}
@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * File Name          : bench.h
+  * Description        : This file provides code for the DSP kernel benchmark
+	*											 image (Gesture_Lock_Bench target, JTEST_BENCH): the
+	*											 JTest groups of the CMSIS DSP test suite timed with
+	*											 the DWT cycle counter, results streamed over USB CDC.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __bench_H
+#define __bench_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define BenchTimeout		1000	//ms, a chunk is dropped when the host stops reading
+/* Exported types ------------------------------------------------------------*/
+typedef struct{
+	volatile uint8_t	req;			//run requested by CmdBench
+	uint8_t						lost;			//host stopped reading, rest of the run dropped
+	uint32_t					mask;			//groups of the run
+	uint32_t					chunks;		//dump chunks sent
+	uint32_t					dropped;	//dump chunks not sent
+} Bench_t;
+/* Exported constants --------------------------------------------------------*/
+extern Bench_t bench;
+/* Exported functions prototypes ---------------------------------------------*/
+void Bench_Main(void);
+uint8_t Bench_Command(const uint8_t *data, uint8_t len, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__bench_H */
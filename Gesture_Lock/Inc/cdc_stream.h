@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * File Name          : cdc_stream.h
+  * Description        : This file provides code for the buffered USB CDC
+	*											 transmit stream.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __cdc_stream_H
+#define __cdc_stream_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define CdcRingSize			4096	//bytes, power of 2
+#define CdcPacketSize		64		//full speed bulk packet
+#define CdcBufSize			(8*CdcPacketSize)	//one ping-pong buffer, one transfer
+/* Exported types ------------------------------------------------------------*/
+typedef struct{
+	uint32_t	bytes;					//accepted by Cdc_Write()
+	uint32_t	dropped;				//bytes refused, ring full or link down
+	uint32_t	sent;						//bytes confirmed by the host
+	uint32_t	transfers;			//completed transfers
+	uint32_t	zlps;						//transfers ending on a packet boundary
+	uint32_t	lost;						//bytes in flight when the link was reset
+	uint32_t	rate;						//sent bytes per second, last second
+	uint32_t	fill_max;				//ring high water mark, bytes
+} Cdc_Stats_t;
+/* Exported constants --------------------------------------------------------*/
+extern volatile Cdc_Stats_t cdc_stats;
+extern uint8_t cdc_stream_on;
+/* Exported functions prototypes ---------------------------------------------*/
+void Cdc_Init(void);
+uint8_t Cdc_Write(const uint8_t *buf, uint16_t len);
+void Cdc_Poll(void);
+void Cdc_Tx_Cplt(void);
+void Cdc_Link_Reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__cdc_stream_H */
@@ -0,0 +1,91 @@
+/**
+  ******************************************************************************
+  * File Name          : cmd.h
+  * Description        : This file provides code for the framed command
+	*											 protocol over USB CDC: COBS framing, CRC16 check,
+	*											 queued replies and bulk trace dump.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __cmd_H
+#define __cmd_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+//frame: 0x00, COBS(cmd, seq, payload, crc16 big endian), 0x00
+//crc16: CCITT, poly 0x1021, init 0xFFFF, over cmd, seq and payload
+//a reply has the cmd and seq of its request
+#define CmdPayloadMax		128		//max payload bytes
+#define CmdRxSize				320		//receive buffer, a frame plus one packet
+#define CmdQueueLen			4			//queued replies, power of 2
+#define CmdTraceLen			256		//trace samples, power of 2
+#define CmdTraceChunk		7			//trace samples per dump frame
+
+//0xB0 - 0xB3: parameter functions, see param.h. Set, Save and Default
+//need the lock open, else Param_Err_Locked
+#define CmdSched				0xB4	//data: 1 to reset after reading. reply: task stats (sched.h)
+#define CmdStream				0xB5	//data: 1 start (unlocked only), 0 stop raw samples.
+																//reply: status, rate, sent, dropped (u32)
+#define CmdTrace				0xB6	//unlocked only. reply: status, count(u16), then chunks: index(u16), samples
+#define CmdEnroll				0xB7	//data: key sequence. reply: status
+#define CmdVerify				0xB8	//unlocked only. data: key sequence. reply: status, 1 on match
+#define CmdStats				0xB9	//data: 1 to reset after reading. reply: u32 counters
+#define CmdPing					0xBA	//reply: the data, for round trip timing
+#define CmdLog					0xBB	//from the device only: log records
+#define CmdLogFmt				0xBC	//data: log id. reply: status, format string (logger.h)
+#define CmdProbe				0xBD	//data: probe id. reply: status, counters (probe.h)
+																//0xFF: reset all, 0xFE: all on the UART telemetry
+#define CmdBench				0xBE	//benchmark image only (bench.h). data: group mask.
+																//reply: status, clock. then from the device: dump text
+#define CmdBenchEnd			0xBF	//from the device only: end of a benchmark run (bench.h)
+#define CmdSample				0xA3	//from the device only: raw sample stream
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	Cmd_OK = 0,
+	Cmd_Err_Cmd,			//unknown command
+	Cmd_Err_Len,			//bad length or content
+	Cmd_Err_Locked,		//unlock with the key first
+	Cmd_Err_Busy			//previous request still running
+} Cmd_Status_t;
+
+typedef struct{
+	uint32_t	frames;				//non-empty frames received
+	uint32_t	cobs_err;			//bad COBS encoding or too short
+	uint32_t	crc_err;
+	uint32_t	overflow;			//frame longer than the receive buffer
+	uint32_t	replies;			//replies written to the stream
+	uint32_t	sent;					//unsolicited frames written, samples and trace
+	uint32_t	dropped;			//unsolicited frames dropped, stream full
+	uint32_t	lat_last;			//us, delimiter received to reply queued
+	uint32_t	lat_max;
+} Cmd_Stats_t;
+
+//one trace sample, 16 bytes on the wire
+typedef struct{
+	uint32_t	time;					//HAL tick
+	int16_t		acc[3];				//raw
+	int16_t		gyro[3];			//raw
+} Cmd_Trace_t;
+/* Exported constants --------------------------------------------------------*/
+extern volatile Cmd_Stats_t cmd_stats;
+/* Exported functions prototypes ---------------------------------------------*/
+uint8_t *Cmd_Rx_Reset(void);
+uint8_t *Cmd_Rx(uint8_t *buf, uint32_t len);
+uint8_t Cmd_Write(uint8_t cmd, uint8_t seq, const uint8_t *data, uint8_t len);
+uint8_t Cmd_Send(uint8_t cmd, uint8_t seq, const uint8_t *data, uint8_t len);
+void Cmd_Trace_Put(void);
+void Cmd_Poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__cmd_H */
@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * File Name          : fast_boot.h
+  * Description        : This file provides code for the warm-start calibration
+	*											 cache and the DMP quaternion convergence monitor.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __fast_boot_H
+#define __fast_boot_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "mpu6050.h"
+/* Exported macro ------------------------------------------------------------*/
+#define CalibFlashAddr		0x08020000//sector 5
+#define CalibFlashSector	FLASH_SECTOR_5
+#define CalibMagic				0x43414C42//"CALB"
+#define CalibVersion			2
+/* Exported types ------------------------------------------------------------*/
+typedef struct{
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	st_result;		//mpu_run_self_test() result mask
+	long			gyro_bias[3];	//q16, dps
+	long			accel_bias[3];//q16, g
+	uint16_t	dmp_sig;			//CRC of the DMP image last loaded
+	uint16_t	reserved;
+	uint32_t	checksum;			//must be the last member
+}	Calib_Data_t;
+/* Exported constants --------------------------------------------------------*/
+extern uint32_t boot_ready_ms;
+/* Exported functions prototypes ---------------------------------------------*/
+int Fast_Boot_Calibrate(uint8_t boot);
+int Fast_Boot_Invalidate(void);
+void Fast_Boot_Monitor_Init(void);
+int Fast_Boot_Monitor_Update(const float *q);
+uint32_t Fast_Boot_Wait_Ready(volatile MPU_Data_t *mpu);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__fast_boot_H */
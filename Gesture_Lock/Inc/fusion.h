@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * File Name          : fusion.h
+  * Description        : This file provides code for the software attitude
+	*											 fusion (Madgwick, accel + gyro) that can replace the
+	*											 DMP quaternion: raw samples from the MPU6050 FIFO,
+	*											 same q[4] and gravity convention as the DMP output.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __fusion_H
+#define __fusion_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "arm_math.h"
+/* Exported macro ------------------------------------------------------------*/
+#ifndef FusionEnable
+#define FusionEnable		0			//1: no DMP image, MPU_Update() runs Fusion_Update() on raw FIFO samples
+#endif
+#define FusionHzMax			1000	//mpu_hz limit with FusionEnable, the DMP stops at 200
+#define FusionGyroLsb		16.4f	//LSB per deg/s, +-2000 dps as set by mpu_init()
+#define FusionBeta			0.04f	//correction gain, sqrt(3/4) * gyro error in rad/s
+#define FusionBetaBoot	2.5f	//correction gain of the first FusionBootMs
+#define FusionBootMs		500
+#define FusionAccOne		8192.0f	//raw accel per g, +-4 g as set by mpu_init()
+#define FusionAccBand		0.3f	//|a| - 1 g where the accel correction reaches 0
+/* Exported types ------------------------------------------------------------*/
+typedef struct{
+	float			q[4];					//w x y z, the order and frame of the DMP quaternion
+	float			dt;						//s, one sample
+	float			beta;
+	uint32_t	boot;					//samples left at FusionBetaBoot
+	uint32_t	samples;
+} Fusion_t;
+/* Exported constants --------------------------------------------------------*/
+extern Fusion_t fusion;
+/* Exported functions prototypes ---------------------------------------------*/
+void Fusion_Init(uint16_t hz);
+void Fusion_Set_Rate(uint16_t hz);
+void Fusion_Update(const int16_t acc[3], const int16_t gyro[3]);
+void Fusion_Euler(const float q[4], float *pitch, float *roll, float *yaw);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__fusion_H */
@@ -39,7 +39,7 @@ extern I2C_HandleTypeDef hi2c1;
 void MX_I2C1_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-
+uint8_t I2C1_Bus_Clear(void);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * File Name          : imu_pre.h
+  * Description        : This file provides code for the fixed point IMU
+	*											 preprocessing chain: calibration, gravity removal and
+	*											 normalization of raw MPU6050 samples in Q15 with the
+	*											 CMSIS DSP library, producing q7 feature windows for
+	*											 CMSIS-NN models.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __imu_pre_H
+#define __imu_pre_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "arm_math.h"
+/* Exported macro ------------------------------------------------------------*/
+#define ImuPreBlock			32		//max samples per Imu_Pre_Run(), at most ImuPreWindow
+#define ImuPreWindow		64		//samples in the feature window, the input of gesture_imu_graph.json
+#define ImuPreCh				6			//channels: ax ay az gx gy gz
+#define ImuPreAccOne		8192	//accel channels, 1 g (Q2.13), +-4 g as set by mpu_init()
+#define ImuPreGyroLsb		16.4f	//gyro channels, LSB per deg/s, +-2000 dps as set by mpu_init()
+#define ImuPreFeatOne		4096	//features, 1 standard deviation (Q3.12, q7 Q3.4 in the window)
+/* Exported types ------------------------------------------------------------*/
+typedef struct{
+	float	bias[ImuPreCh];				//raw LSB, removed before the gain
+	float	gain[ImuPreCh];				//0..2
+	float	mean[ImuPreCh];				//feature mean, g and deg/s after gravity removal
+	float	std[ImuPreCh];				//feature standard deviation, g and deg/s
+} Imu_Pre_Cal_t;
+
+typedef struct{
+	q15_t			raw[ImuPreCh][ImuPreBlock];	//raw samples in, one row per channel
+	float			q[4][ImuPreBlock];					//DMP quaternion of each sample
+	q15_t			motion[ImuPreCh][ImuPreBlock];//calibrated, gravity removed: accel Q2.13 g, gyro 16.4 LSB per deg/s
+	q15_t			feat[ImuPreCh][ImuPreBlock];//normalized Q3.12
+	q7_t			window[ImuPreWindow][ImuPreCh];//q7 features, oldest sample first
+	uint16_t	n;													//samples staged by Imu_Pre_Push(), after the rows to keep them word aligned
+	uint32_t	samples;										//samples processed
+} Imu_Pre_t;
+/* Exported constants --------------------------------------------------------*/
+extern Imu_Pre_t imu_pre;
+extern const Imu_Pre_Cal_t imu_pre_cal_default;
+/* Exported functions prototypes ---------------------------------------------*/
+void Imu_Pre_Init(const Imu_Pre_Cal_t *cal);
+void Imu_Pre_Motion(const int16_t acc[3], const int16_t gyro[3], const float q[4], float out[ImuPreCh]);
+uint8_t Imu_Pre_Push(const int16_t acc[3], const int16_t gyro[3], const float q[4]);
+uint16_t Imu_Pre_Run(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__imu_pre_H */
@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * File Name          : key.h
+  * Description        : This file provides code for the interrupt driven
+	*											 user key and its event queue.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __key_H
+#define __key_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define KeyDebounceTime		20		//ms, level must be stable this long
+#define ShortPressMax			1000	//ms, held longer is a long press
+#define DoubleClickGap		250		//ms, max release to second press
+#define KeyQueueLen				8			//power of 2
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	Key_None = 0,
+	Key_Press,		//debounced press, before it is classified
+	Key_Short,		//released before ShortPressMax, no second click
+	Key_Long,			//held for ShortPressMax, given while still held
+	Key_Double		//two short clicks within DoubleClickGap
+} Key_Event_t;
+
+typedef struct{
+	uint8_t		event;	//Key_Event_t
+	uint32_t	time;		//HAL tick of the debounced edge or timeout
+} Key_Msg_t;
+/* Exported constants --------------------------------------------------------*/
+extern volatile uint32_t key_dropped;
+/* Exported functions prototypes ---------------------------------------------*/
+void Key_Init(void);
+void Key_Tick(void);
+uint8_t Key_Get(Key_Msg_t *m);
+Key_Event_t Key_Get_Event(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__key_H */
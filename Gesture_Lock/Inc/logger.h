@@ -0,0 +1,132 @@
+/**
+  ******************************************************************************
+  * File Name          : logger.h
+  * Description        : This file provides code for the deferred binary log.
+	*											 A call site stores a message id and raw arguments,
+	*											 the text is put together by the upper machine from
+	*											 the format table.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __logger_H
+#define __logger_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define LogEnable			1			//0: log calls compile to nothing
+#define LogRingSize		1024	//words, power of 2
+#define LogMask				(LogRingSize-1)
+
+//message table: id, printf format. Each argument is one 32 bit word,
+//%f takes the bits of a float (Log_F). Only add at the end, the upper
+//machine keeps the ids.
+#define LOG_TABLE(X) \
+	X(Log_Key_Held,				"Key held, recalibrate\r\n") \
+	X(Log_Calib_Applied,	"Calibration cache applied\r\n") \
+	X(Log_Self_Test_Fail,	"MPU6050 self test failed\r\n") \
+	X(Log_Calib_Cached,		"Calibration cached\r\n") \
+	X(Log_Boot_Time,			"Boot to ready: %u ms\r\n") \
+	X(Log_Mpu_Error,			"MPU6050 Error!!!\r\n") \
+	X(Log_Mpu_Ok,					"MPU6050 OK\r\n") \
+	X(Log_Key_Is,					"Key is: ") \
+	X(Log_Key_New,				"New key is: ") \
+	X(Log_Seq_Item,				"%d ") \
+	X(Log_Line_End,				"\r\n") \
+	X(Log_Gesture,				"Gesture Num: %d, seq len: %d, pitch: %5.2f\r\n") \
+	X(Log_Motion_Timeout,	"motion time out!\r\n") \
+	X(Log_Motion_Start,		"motion start!\r\n") \
+	X(Log_Motion_At,			"\tmotion at %c %d!\r\n") \
+	X(Log_Peak_Rej,				"\tpeak rej %c!\r\n") \
+	X(Log_Calib_Save_Fail,"Calibration not saved, flash error\r\n") \
+	X(Log_Key_Save_Fail,	"Key not saved, flash error\r\n")
+
+#define LOG_ID(id, fmt)		id,
+
+#if LogEnable
+#define Log0(id)							Log_Put(id, 0, 0, 0, 0)
+#define Log1(id, a)						Log_Put(id, 1, a, 0, 0)
+#define Log2(id, a, b)				Log_Put(id, 2, a, b, 0)
+#define Log3(id, a, b, c)			Log_Put(id, 3, a, b, c)
+#else
+#define Log0(id)							((void)0)
+#define Log1(id, a)						((void)0)
+#define Log2(id, a, b)				((void)0)
+#define Log3(id, a, b, c)			((void)0)
+#endif
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	LOG_TABLE(LOG_ID)
+	Log_Num
+} Log_Id_t;
+
+typedef struct{
+	uint32_t	records;		//stored
+	uint32_t	dropped;		//ring full
+	uint32_t	sent;				//records written to the CDC stream
+	uint32_t	fill_max;		//ring high water mark, words
+	uint32_t	cyc_log;		//cycles of one Log3() call, measured at init
+	uint32_t	cyc_printf;	//cycles to format the same message with snprintf
+} Log_Stats_t;
+/* Exported constants --------------------------------------------------------*/
+extern uint32_t					log_ring[LogRingSize];
+extern uint32_t					log_head;		//free running, words
+extern uint32_t					log_tail;
+extern Log_Stats_t			log_stats;
+extern const char *const	log_fmt[Log_Num];
+/* Exported functions prototypes ---------------------------------------------*/
+void Log_Init(void);
+void Log_Poll(void);
+
+/**
+  * @brief  Store one record: header (id<<8 | args), DWT cycles, args.
+	*					Any context, never waits, dropped when the ring is full.
+  * @retval None
+  */
+__STATIC_INLINE void Log_Put(uint32_t id, uint32_t n, uint32_t a, uint32_t b, uint32_t c){
+	uint32_t primask = __get_PRIMASK();
+	uint32_t h, used;
+	__disable_irq();
+	h = log_head;
+	used = h - log_tail;
+	if(used + 2 + n > LogRingSize){
+		log_stats.dropped++;
+	}
+	else{
+		log_ring[h & LogMask] = (id<<8) | n;
+		log_ring[(h+1) & LogMask] = DWT->CYCCNT;
+		if(n > 0) log_ring[(h+2) & LogMask] = a;
+		if(n > 1) log_ring[(h+3) & LogMask] = b;
+		if(n > 2) log_ring[(h+4) & LogMask] = c;
+		log_head = h + 2 + n;
+		log_stats.records++;
+		if(used + 2 + n > log_stats.fill_max) log_stats.fill_max = used + 2 + n;
+	}
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  bits of a float argument
+  * @retval raw value
+  */
+__STATIC_INLINE uint32_t Log_F(float f){
+	union{
+		float			f;
+		uint32_t	u;
+	} v;
+	v.f = f;
+	return v.u;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__logger_H */
@@ -35,10 +35,10 @@
 //OLEDģʽ
 //0:4ߴģʽ
 //1:8080ģʽ
-#define u8 unsigned char
-#define u32 unsigned int
+#include "sys.h"			//u8, u32
 
 #define OLED_MODE 0
+#define OLED_SPI 1	//4ߴ: 1,SPI1+DMA; 0,GPIO bit-bang
 #define SIZE 16
 #define XLevelL		0x00
 #define XLevelH		0x10
@@ -79,6 +79,21 @@
 #define OLED_CMD  0	//д
 #define OLED_DATA 1	//д
 
+#define OLED_PAGES 8
+
+//redraw cost of OLED_Refresh()
+typedef struct{
+	u32 flushes;
+	u32 bytes;				//data bytes sent, total
+	u32 bytes_last;
+	u32 us_last;			//start to last byte on the wire
+	u32 us_max;
+	u32 us_full;			//last full screen (1024 bytes)
+	u32 lost;					//pages the DMA refused or lost, sent by the next flush
+} OLED_Stats_t;
+
+extern OLED_Stats_t oled_stats;
+
 
 //OLEDú
 void OLED_WR_Byte(u8 dat,u8 cmd);	    
@@ -94,6 +109,9 @@ void OLED_ShowString(u8 x,u8 y, u8 *p);
 void OLED_Set_Pos(unsigned char x, unsigned char y);
 void OLED_ShowCHinese(u8 x,u8 y,u8 no);
 void OLED_DrawBMP(unsigned char x0, unsigned char y0,unsigned char x1, unsigned char y1,unsigned char BMP[]);
+void OLED_Refresh(void);
+u8 OLED_Refresh_Async(void (*done)(void));
+u8 OLED_Busy(void);
 #endif  
 	 
 
@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * File Name          : param.h
+  * Description        : This file provides code for the persistent parameter
+	*											 table of the gesture detector and sampling timing.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __param_H
+#define __param_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define ParamFlashAddr		0x08040000//sector 6
+#define ParamFlashSector	FLASH_SECTOR_6
+#define ParamMagic				0x5041524D//"PARM"
+#define ParamVersion			1
+#define ParamMaxStore			32		//max entries accepted from flash
+
+//functions, carried as commands of the framed protocol (cmd.h)
+#define ParamFrameMax			64		//max reply bytes
+#define ParamFuncGet			0xB0	//data: id, 0xFF for all. reply: {id,type,value}... or id,status
+#define ParamFuncSet			0xB1	//data: id, value. reply: id, status
+#define ParamFuncSave			0xB2	//reply: status
+#define ParamFuncDefault	0xB3	//reply: status
+#define ParamIdAll				0xFF
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	Param_Motion_Gap_Time = 0,
+	Param_Motion_Dur_Time,
+	Param_Acc_Peak_Gap_Time,
+	Param_Motion_Peak_TH,
+	Param_Peak_Samp_Num,
+	Param_Peak_Max_Pre,
+	Param_Min_Seq_Len,
+	Param_Mpu_Hz,
+	Param_Num
+} Param_Id_t;
+
+typedef enum{
+	Param_U8 = 0,
+	Param_U16,
+	Param_U32,
+	Param_F32
+} Param_Type_t;
+
+typedef enum{
+	Param_OK = 0,
+	Param_Err_Id,				//unknown parameter
+	Param_Err_Range,		//value out of range
+	Param_Err_Frame,		//bad length or function
+	Param_Err_Flash,
+	Param_Err_Locked		//unlock with the key first
+} Param_Status_t;
+
+//live values, read directly by the detector
+typedef struct{
+	uint32_t	motion_gap_time;		//ms, no gesture for this long ends a sequence
+	uint32_t	motion_dur_time;		//ms, max duration of one gesture
+	uint32_t	acc_peak_gap_time;	//ms, max gap between two peaks
+	float			motion_peak_th;			//g, peak detect threshold
+	float			peak_max_pre;				//other axes must stay under max*peak_max_pre
+	uint16_t	mpu_hz;							//DMP output rate
+	uint8_t		peak_samp_num;			//samples over threshold to confirm a peak
+	uint8_t		min_seq_len;				//shortest key that can be recorded
+} Param_t;
+
+//flash record: header, then count entries
+typedef struct{
+	uint8_t		id;
+	uint8_t		type;
+	uint16_t	reserved;
+	uint32_t	value;		//raw bits of the typed value
+} Param_Entry_t;
+
+typedef struct{
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	count;
+	uint32_t	checksum;	//over the entries
+} Param_Header_t;
+/* Exported constants --------------------------------------------------------*/
+extern Param_t param;
+/* Exported functions prototypes ---------------------------------------------*/
+int Param_Init(void);
+int Param_Default(void);
+int Param_Save(void);
+int Param_Set(uint8_t id, uint32_t raw);
+int Param_Get(uint8_t id, uint8_t *type, uint32_t *raw);
+int Param_Apply_Rate(void);
+uint8_t Param_Command(uint8_t func, const uint8_t *data, uint8_t len, uint8_t *out);
+void Param_Poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__param_H */
@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * File Name          : probe.h
+  * Description        : This file provides code for the cycle probes: named
+	*											 begin/end points with min/max/mean and a log2
+	*											 histogram. Build with PROBE_HOST to use the same
+	*											 probes on a PC, counting nanoseconds instead of
+	*											 DWT cycles.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __probe_H
+#define __probe_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#ifdef PROBE_HOST
+#include <stdint.h>
+#include <time.h>
+#else
+#include "stm32f4xx_hal.h"
+#endif
+/* Exported macro ------------------------------------------------------------*/
+#ifndef ProbeEnable
+#define ProbeEnable		1			//0: probe calls compile to nothing
+#endif
+#define ProbeBins			16		//histogram bins
+#define ProbeBinShift	6			//bin 0: under 2^(ProbeBinShift+1) cycles, each bin doubles
+
+//probe table: id, name. Only add at the end, the upper machine keeps the ids.
+#define PROBE_TABLE(X) \
+	X(Probe_Mpu_Update,			"MPU_Update") \
+	X(Probe_Motion_Check,		"Motion_Input_Check") \
+	X(Probe_Oled_String,		"OLED_ShowString") \
+	X(Probe_Sample_Latency,	"TIM2 ISR to decision") \
+	X(Probe_Imu_Pre,				"Imu_Pre_Run")	\
+	X(Probe_Fusion,					"Fusion_Update")
+
+#define PROBE_ID(id, name)	id,
+
+#ifdef PROBE_HOST
+#define Probe_Inline				static inline
+#define Probe_Clz(x)				__builtin_clz(x)
+#else
+#define Probe_Inline				__STATIC_INLINE
+#define Probe_Clz(x)				__CLZ(x)
+#endif
+
+#if ProbeEnable
+#define Probe_Begin(id)			(probe_start[id] = Probe_Now())
+#define Probe_End(id)				Probe_Add(id, Probe_Now() - probe_start[id])
+#else
+#define Probe_Begin(id)			((void)0)
+#define Probe_End(id)				((void)0)
+#endif
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	PROBE_TABLE(PROBE_ID)
+	Probe_Num
+} Probe_Id_t;
+
+typedef struct{
+	uint32_t	count;
+	uint32_t	min;				//cycles
+	uint32_t	max;
+	uint64_t	sum;
+	uint32_t	hist[ProbeBins];
+} Probe_Stats_t;
+/* Exported constants --------------------------------------------------------*/
+extern volatile uint32_t	probe_start[Probe_Num];
+extern Probe_Stats_t			probe_stats[Probe_Num];
+extern const char *const	probe_name[Probe_Num];
+/* Exported functions prototypes ---------------------------------------------*/
+void Probe_Reset(void);
+uint8_t Probe_Pack(uint8_t id, uint8_t *out);
+#ifdef PROBE_HOST
+void Probe_Print(void);
+#else
+void Probe_Dump_Uart(void);
+#endif
+
+/**
+  * @brief  time stamp, DWT cycles or host nanoseconds
+  * @retval time
+  */
+Probe_Inline uint32_t Probe_Now(void){
+#ifdef PROBE_HOST
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint32_t)(t.tv_sec*1000000000ull + t.tv_nsec);
+#else
+	return DWT->CYCCNT;
+#endif
+}
+
+/**
+  * @brief  Add one measurement. Main loop only, Probe_Begin() may be in
+	*					an interrupt.
+	*	@param	id		Probe_Id_t
+	*	@param	cyc		elapsed time
+  * @retval None
+  */
+Probe_Inline void Probe_Add(uint32_t id, uint32_t cyc){
+	Probe_Stats_t *p = &probe_stats[id];
+	int32_t bin = 31 - Probe_Clz(cyc | 1) - ProbeBinShift;
+	if(bin < 0) bin = 0;
+	if(bin >= ProbeBins) bin = ProbeBins - 1;
+	p->hist[bin]++;
+	p->count++;
+	p->sum += cyc;
+	if(cyc < p->min) p->min = cyc;
+	if(cyc > p->max) p->max = cyc;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__probe_H */
@@ -0,0 +1,55 @@
+/**
+  ******************************************************************************
+  * File Name          : sched.h
+  * Description        : This file provides code for the cooperative task
+	*											 scheduler of the main loop.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __sched_H
+#define __sched_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define SchedStatsBytes		12		//per task in the stats reply
+/* Exported types ------------------------------------------------------------*/
+typedef enum{
+	Task_Sensor = 0,	//decode DMP packet, released by TIM2
+	Task_Detect,			//gesture detection, released by a new sample
+	Task_UI,					//key, UI timer, screen
+	Task_Telemetry,		//sample stream to the upper machine
+	Task_Storage,			//flash writes, parameter service
+	Task_Num
+} Sched_Task_Id_t;
+
+typedef struct{
+	uint32_t	runs;
+	uint32_t	missed;				//finished after release + deadline
+	uint32_t	overruns;			//released again before it ran
+	uint32_t	run_max;			//cycles
+	uint32_t	latency_max;	//cycles from release to start
+	uint64_t	run_total;		//cycles
+} Sched_Stats_t;
+/* Exported constants --------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+void Sched_Init(void);
+uint8_t Sched_Started(void);
+uint8_t Sched_Release(uint8_t id);
+uint8_t Sched_Run(void);
+void Sched_Reset_Stats(void);
+const Sched_Stats_t *Sched_Get_Stats(uint8_t id);
+uint8_t Sched_Stats_Pack(uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__sched_H */
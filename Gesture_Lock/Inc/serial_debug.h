@@ -36,6 +36,7 @@ int fputc(int ch, FILE *f);
 int fgetc(FILE *f);
 
 int Plot_Data(void);
+int Stream_Data(void);
 #ifdef __cplusplus
 }
 #endif
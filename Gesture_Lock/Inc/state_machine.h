@@ -28,3 +28,9 @@ extern Gesture_Seq_t		g_seq;
 int Motion_Input_Check(void);
 int State_Machine_Init(void);
 int State_Update_Main(void);
+int State_Update_UI(void);
+int State_Update_Motion(void);
+int State_Update_Storage(void);
+int Motion_Key_Enroll(const uint8_t *seq, uint8_t len);
+int Motion_Key_Verify(const uint8_t *seq, uint8_t len);
+int Is_Unlocked(void);
@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * File Name          : telemetry.h
+  * Description        : This file provides code for the buffered UART1
+	*											 telemetry channel.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __telemetry_H
+#define __telemetry_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+/* Exported macro ------------------------------------------------------------*/
+#define TlmRingSize			1024	//bytes, power of 2
+#define TlmBatchBytes		64		//start DMA once this much is queued
+#define TlmFlushTime		20		//ms, or once the oldest byte waited this long
+/* Exported types ------------------------------------------------------------*/
+typedef struct{
+	uint32_t	frames;					//accepted
+	uint32_t	bytes;					//accepted
+	uint32_t	dropped_frames;	//ring full, never waits
+	uint32_t	dropped_bytes;
+	uint32_t	dma_starts;			//transmissions, frames per start = packing
+	uint32_t	dma_errors;
+	uint32_t	fill_max;				//ring high water mark, bytes
+} Tlm_Stats_t;
+/* Exported constants --------------------------------------------------------*/
+extern volatile Tlm_Stats_t tlm_stats;
+/* Exported functions prototypes ---------------------------------------------*/
+void Tlm_Init(void);
+uint8_t Tlm_Write(const uint8_t *buf, uint16_t len);
+void Tlm_Poll(void);
+uint32_t Tlm_Free(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__telemetry_H */
@@ -106,6 +106,8 @@ extern USBD_CDC_ItfTypeDef USBD_Interface_fops_FS;
 uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
+uint8_t CDC_Tx_Idle(void);
+void CDC_Rx_Resume(uint8_t *Buf);
 #ifdef USB_DEBUG
 int fputc(int ch, FILE *f);
 void usb_printf(const char *format, ...);
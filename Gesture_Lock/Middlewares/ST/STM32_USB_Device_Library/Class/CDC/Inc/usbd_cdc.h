@@ -104,6 +104,8 @@ typedef struct _USBD_CDC_Itf
   int8_t (* DeInit)        (void);
   int8_t (* Control)       (uint8_t cmd, uint8_t* pbuf, uint16_t length);
   int8_t (* Receive)       (uint8_t* Buf, uint32_t *Len);
+  /* Local patch, not in the ST library: called from USBD_CDC_DataIn(), see usbd_cdc.c */
+  int8_t (* TransmitCplt)  (uint8_t *Buf, uint32_t *Len, uint8_t epnum);
 
 }USBD_CDC_ItfTypeDef;
 
@@ -692,6 +692,15 @@ static uint8_t  USBD_CDC_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum)
     else
     {
       hcdc->TxState = 0U;
+
+      /* Local patch, not in the ST library: tell the application that the
+         transfer (and its ZLP) is done, Cdc_Tx_Cplt() in cdc_stream.c starts
+         the next buffer from here. Apply again after a CubeMX regeneration
+         or a library update, with the TransmitCplt member in usbd_cdc.h. */
+      if (((USBD_CDC_ItfTypeDef *)pdev->pUserData)->TransmitCplt != NULL)
+      {
+        ((USBD_CDC_ItfTypeDef *)pdev->pUserData)->TransmitCplt(hcdc->TxBuffer, &hcdc->TxLength, epnum);
+      }
     }
     return USBD_OK;
   }
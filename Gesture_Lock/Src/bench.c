@@ -0,0 +1,166 @@
+/**
+  ******************************************************************************
+  * File Name          : bench.c
+  * Description        : This file provides code for the DSP kernel benchmark
+	*											 image. main() hands over to Bench_Main() right after
+	*											 the clock, USB and DWT are up, so every kernel runs
+	*											 at 96MHz with FLASH_LATENCY_3 and the ART cache as in
+	*											 the application. A CmdBench request starts a run of
+	*											 the chosen groups; the JTest dump text is sent as
+	*											 CmdBench frames and a CmdBenchEnd frame closes the
+	*											 run. jtest_bench.py turns a run into a JSON report
+	*											 and diffs two reports.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "bench.h"
+#include "cmd.h"
+#include "cdc_stream.h"
+#include "jtest_f411.h"
+#include "jtest_cycle.h"
+#include "jtest_fw.h"
+
+/* Private variables ---------------------------------------------------------*/
+Bench_t bench;
+/* Private function prototypes -----------------------------------------------*/
+uint8_t *Bench_Put32(uint8_t *p, uint32_t v);
+uint8_t Bench_Send(uint8_t cmd, const uint8_t *data, uint8_t len);
+void Bench_Run(void);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  put a big endian word
+  * @retval next byte
+  */
+uint8_t *Bench_Put32(uint8_t *p, uint32_t v){
+	*p++ = v>>24;
+	*p++ = v>>16;
+	*p++ = v>>8;
+	*p++ = v;
+	return p;
+}
+
+/**
+  * @brief  Send a frame, waiting for room in the CDC stream up to
+	*					BenchTimeout. After a timeout the rest of the run is
+	*					dropped at once.
+	*	@param	cmd		command
+	*	@param	data	payload
+	*	@param	len		payload bytes
+  * @retval uint8_t
+	*					0: queued
+	*					1: dropped
+  */
+uint8_t Bench_Send(uint8_t cmd, const uint8_t *data, uint8_t len){
+	uint32_t start = HAL_GetTick();
+
+	if(bench.lost){
+		bench.dropped++;
+		return 1;
+	}
+	while(Cmd_Write(cmd, 0, data, len)){
+		Cdc_Poll();
+		if(HAL_GetTick() - start > BenchTimeout){
+			bench.lost = 1;
+			bench.dropped++;
+			return 1;
+		}
+	}
+	bench.chunks++;
+	return 0;
+}
+
+/**
+  * @brief  Dump stream of the test suite, up to 128 characters at a time
+	*					(jtest_f411.h)
+	*	@param	str		text
+	*	@param	len		characters
+  * @retval None
+  */
+void jtest_bench_write(const char *str, uint32_t len){
+	Bench_Send(CmdBench, (const uint8_t*)str, len);
+}
+
+/**
+  * @brief  Run the requested groups, then send CmdBenchEnd: passed,
+	*					failed, chunks sent, chunks dropped, run time in ms,
+	*					big endian u32
+  * @retval None
+  */
+void Bench_Run(void){
+	uint8_t out[5*4];
+	uint8_t *p = out;
+	uint32_t start;
+
+	bench.lost = 0;
+	bench.chunks = 0;
+	bench.dropped = 0;
+	start = HAL_GetTick();
+	jtest_bench_run(bench.mask);
+	p = Bench_Put32(p, JTEST_FW.passed);
+	p = Bench_Put32(p, JTEST_FW.failed);
+	p = Bench_Put32(p, bench.chunks);
+	p = Bench_Put32(p, bench.dropped);
+	p = Bench_Put32(p, HAL_GetTick() - start);
+	bench.lost = 0;
+	Bench_Send(CmdBenchEnd, out, p - out);
+	bench.req = 0;
+}
+
+/**
+  * @brief  Handle CmdBench. Called by the command protocol.
+	*	@param	data	payload: group mask, big endian u32, bit n is entry n of
+	*								JTEST_BENCH_GROUP_TABLE. Empty: all groups.
+	*	@param	len		payload bytes
+	*	@param	out		reply payload: status, number of groups, SystemCoreClock,
+	*								FLASH->ACR, DWT read overhead in cycles
+  * @retval reply bytes
+  */
+uint8_t Bench_Command(const uint8_t *data, uint8_t len, uint8_t *out){
+	uint8_t *p = out;
+
+	if(len != 0 && len != 4){
+		*p++ = Cmd_Err_Len;
+		return p - out;
+	}
+	if(bench.req){
+		*p++ = Cmd_Err_Busy;
+		return p - out;
+	}
+	if(len){
+		bench.mask = ((uint32_t)data[0]<<24)|((uint32_t)data[1]<<16)|((uint32_t)data[2]<<8)|data[3];
+	}
+	else{
+		bench.mask = (1UL<<JTEST_BENCH_GROUP_NUM) - 1;
+	}
+	bench.req = 1;
+	*p++ = Cmd_OK;
+	*p++ = JTEST_BENCH_GROUP_NUM;
+	p = Bench_Put32(p, SystemCoreClock);
+	p = Bench_Put32(p, FLASH->ACR);
+	p = Bench_Put32(p, jtest_dwt_overhead);
+	return p - out;
+}
+
+/**
+  * @brief  Benchmark main loop, never returns. Serves the command
+	*					protocol and runs a requested benchmark once its reply
+	*					has been written.
+  * @retval None
+  */
+void Bench_Main(void){
+	jtest_dwt_init();
+	while(1){
+		Cmd_Poll();
+		Cdc_Poll();
+		if(bench.req){
+			Cmd_Poll();//writes the CmdBench reply first
+			Bench_Run();
+		}
+	}
+}
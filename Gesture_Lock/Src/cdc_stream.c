@@ -0,0 +1,168 @@
+/**
+  ******************************************************************************
+  * File Name          : cdc_stream.c
+  * Description        : This file provides code for the buffered USB CDC
+	*											 transmit stream. Producers copy data into a byte
+	*											 ring and never wait. Cdc_Poll() moves the ring into
+	*											 two 64 byte aligned ping-pong buffers; while one is
+	*											 on the bus the other is filled, and the transmit
+	*											 complete callback starts the filled one at once.
+	*											 Buffers are only written in the main loop, the USB
+	*											 interrupt only sends and frees them.
+	*											 The CmdSample stream at FusionHzMax (1 kHz) is 35 KB/s,
+	*											 one packet per sample; Host/cdc_test.c measures it on
+	*											 a loopback USB mock.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cdc_stream.h"
+#include "usbd_cdc_if.h"
+#include "string.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define CdcMask		(CdcRingSize-1)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct{
+	uint8_t						ring[CdcRingSize];
+	uint32_t					head;				//free running, written by Cdc_Write()
+	uint32_t					tail;				//free running, written by Cdc_Poll()
+	uint8_t						fill;				//next buffer to fill
+	volatile uint8_t	send;				//next buffer to send
+	volatile uint8_t	busy;				//a buffer is on the bus
+	volatile uint16_t	len[2];			//bytes in each buffer, 0: free
+	uint32_t					rate_start;	//tick
+	uint32_t					rate_sent;
+} Cdc_Stream_t;
+
+/* Private variables ---------------------------------------------------------*/
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+uint8_t								cdc_buf[2][CdcBufSize] __attribute__((aligned(64)));
+Cdc_Stream_t					cdc;
+volatile Cdc_Stats_t	cdc_stats;
+uint8_t								cdc_stream_on;	//raw sample stream enabled
+/* Private function prototypes -----------------------------------------------*/
+void Cdc_Send(void);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Stream initialize
+  * @retval None
+  */
+void Cdc_Init(void){
+	memset(&cdc, 0, sizeof(cdc));
+	memset((void*)&cdc_stats, 0, sizeof(cdc_stats));
+	cdc.rate_start = HAL_GetTick();
+	cdc_stream_on = 0;
+}
+
+/**
+  * @brief  Queue bytes, all or nothing. Never waits. Main loop only.
+	*	@param	buf		data
+	*	@param	len		bytes
+  * @retval uint8_t
+	*					0: queued
+	*					1: dropped
+  */
+uint8_t Cdc_Write(const uint8_t *buf, uint16_t len){
+	uint32_t used = cdc.head - cdc.tail;
+	uint32_t off, n;
+
+	if(hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED || len > CdcRingSize - used){
+		cdc_stats.dropped += len;
+		return 1;
+	}
+	off = cdc.head & CdcMask;
+	n = CdcRingSize - off;
+	if(n > len) n = len;
+	memcpy(&cdc.ring[off], buf, n);
+	memcpy(&cdc.ring[0], buf + n, len - n);
+	cdc.head += len;
+	used += len;
+	if(used > cdc_stats.fill_max) cdc_stats.fill_max = used;
+	cdc_stats.bytes += len;
+	return 0;
+}
+
+/**
+  * @brief  start the next filled buffer, called with nothing on the bus
+  * @retval None
+  */
+void Cdc_Send(void){
+	uint8_t i = cdc.send;
+	if(cdc.len[i] == 0){
+		cdc.busy = 0;
+		return;
+	}
+	cdc.busy = 1;
+	if(CDC_Transmit_FS(cdc_buf[i], cdc.len[i]) != USBD_OK){
+		cdc.busy = 0;			//endpoint not ready, Cdc_Poll() retries
+	}
+}
+
+/**
+  * @brief  Transmit complete, from CDC_TransmitCplt_FS() after the ZLP
+	*					if one was needed
+  * @retval None
+  */
+void Cdc_Tx_Cplt(void){
+	uint8_t i = cdc.send;
+	if(!cdc.busy) return;
+	cdc_stats.sent += cdc.len[i];
+	cdc_stats.transfers++;
+	if(cdc.len[i] % CdcPacketSize == 0) cdc_stats.zlps++;
+	cdc.len[i] = 0;
+	cdc.send = i ^ 1;
+	Cdc_Send();
+}
+
+/**
+  * @brief  USB (re)configured, anything in flight is gone
+  * @retval None
+  */
+void Cdc_Link_Reset(void){
+	if(!cdc.busy) return;
+	cdc_stats.lost += cdc.len[cdc.send];
+	cdc.len[cdc.send] = 0;
+	cdc.send ^= 1;
+	cdc.busy = 0;
+}
+
+/**
+  * @brief  Fill free buffers from the ring and start one if the bus is
+	*					idle. Call from the main loop as often as possible.
+  * @retval None
+  */
+void Cdc_Poll(void){
+	uint32_t used, off, n, now;
+	uint8_t i, k;
+
+	for(k=0;k<2;k++){
+		i = cdc.fill;
+		used = cdc.head - cdc.tail;
+		if(used == 0 || cdc.len[i] != 0) break;
+		if(used > CdcBufSize) used = CdcBufSize;
+		off = cdc.tail & CdcMask;
+		n = CdcRingSize - off;
+		if(n > used) n = used;
+		memcpy(cdc_buf[i], &cdc.ring[off], n);
+		memcpy(cdc_buf[i] + n, &cdc.ring[0], used - n);
+		cdc.tail += used;
+		cdc.len[i] = used;		//publish to the interrupt
+		cdc.fill = i ^ 1;
+	}
+	if(!cdc.busy && hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED) Cdc_Send();
+
+	now = HAL_GetTick();
+	if(now - cdc.rate_start >= 1000){
+		cdc_stats.rate = (cdc_stats.sent - cdc.rate_sent)*1000/(now - cdc.rate_start);
+		cdc.rate_sent = cdc_stats.sent;
+		cdc.rate_start = now;
+	}
+}
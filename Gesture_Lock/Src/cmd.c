@@ -0,0 +1,590 @@
+/**
+  ******************************************************************************
+  * File Name          : cmd.c
+  * Description        : This file provides code for the framed command
+	*											 protocol over USB CDC. OUT packets are received
+	*											 straight into the frame buffer; when a packet holds
+	*											 the 0x00 delimiter the endpoint is left NAKing and
+	*											 Cmd_Poll() decodes the frame in place, so nothing is
+	*											 copied on receive. Replies wait in a small queue and
+	*											 are COBS encoded into the CDC stream when it has
+	*											 room; the next request is taken only when a reply
+	*											 slot is free.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cmd.h"
+#include "usbd_cdc_if.h"
+#include "cdc_stream.h"
+#include "sched.h"
+#include "telemetry.h"
+#include "param.h"
+#include "key.h"
+#include "mpu6050.h"
+#include "mpubus.h"
+#include "state_machine.h"
+#include "logger.h"
+#include "probe.h"
+#ifdef JTEST_BENCH
+#include "bench.h"
+#endif
+#include "string.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define CmdFrameMax		(4+CmdPayloadMax+2+2)	//encoded, with both delimiters
+#define CmdQueueMask	(CmdQueueLen-1)
+#define CmdTraceMask	(CmdTraceLen-1)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct{
+	uint8_t						buf[CmdRxSize];
+	volatile uint16_t	len;			//bytes received
+	volatile uint16_t	end;			//delimiter of the ready frame
+	volatile uint8_t	ready;		//frame complete, endpoint NAKing
+	volatile uint32_t	time;			//DWT cycles at the delimiter
+} Cmd_Rx_t;
+
+typedef struct{
+	uint8_t		cmd;
+	uint8_t		seq;
+	uint8_t		len;
+	uint8_t		data[CmdPayloadMax];
+} Cmd_Reply_t;
+
+typedef struct{
+	Cmd_Trace_t	buf[CmdTraceLen];
+	uint32_t		head;			//free running
+	uint8_t			dump;			//dump running, recording stopped
+	uint8_t			seq;			//of the dump request
+	uint16_t		count;		//samples in the dump
+	uint16_t		index;		//next sample to send
+} Cmd_Trace_Buf_t;
+
+/* Private variables ---------------------------------------------------------*/
+extern MPU_Data_t mpu_data;
+
+//CRC16 CCITT, one nibble at a time
+const uint16_t cmd_crc_table[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+Cmd_Rx_t							cmd_rx;
+Cmd_Reply_t						cmd_queue[CmdQueueLen];
+uint8_t								cmd_q_head;
+uint8_t								cmd_q_tail;
+Cmd_Trace_Buf_t				cmd_trace;
+volatile Cmd_Stats_t	cmd_stats;
+/* Private function prototypes -----------------------------------------------*/
+uint16_t Cmd_Crc16(const uint8_t *buf, uint16_t len);
+uint16_t Cobs_Encode(const uint8_t *src, uint16_t len, uint8_t *dst);
+uint16_t Cobs_Decode(uint8_t *buf, uint16_t len);
+Cmd_Reply_t *Cmd_Queue_Slot(void);
+void Cmd_Frame(uint8_t *buf, uint16_t len);
+uint8_t Cmd_Handle(uint8_t cmd, const uint8_t *data, uint8_t len, uint8_t *out);
+uint8_t Cmd_Locked(uint8_t cmd, const uint8_t *data, uint8_t len);
+uint8_t Cmd_Stats_Pack(uint8_t *out);
+uint8_t Cmd_Stream(uint8_t on, uint8_t *out);
+void Cmd_Trace_Next(void);
+void Cmd_Rx_Next(void);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  CRC16 CCITT
+	*	@param	buf		data
+	*	@param	len		bytes
+  * @retval crc
+  */
+uint16_t Cmd_Crc16(const uint8_t *buf, uint16_t len){
+	uint16_t crc = 0xFFFF;
+	while(len--){
+		crc = (crc<<4) ^ cmd_crc_table[(crc>>12) ^ (*buf>>4)];
+		crc = (crc<<4) ^ cmd_crc_table[(crc>>12) ^ (*buf&0x0F)];
+		buf++;
+	}
+	return crc;
+}
+
+/**
+  * @brief  COBS encode, no delimiter
+	*	@param	src		data
+	*	@param	len		bytes
+	*	@param	dst		at least len+len/254+1 bytes
+  * @retval encoded bytes
+  */
+uint16_t Cobs_Encode(const uint8_t *src, uint16_t len, uint8_t *dst){
+	uint16_t w = 1, c = 0;
+	uint8_t code = 1;
+	while(len--){
+		if(*src == 0){
+			dst[c] = code;
+			c = w++;
+			code = 1;
+		}
+		else{
+			dst[w++] = *src;
+			if(++code == 0xFF){
+				dst[c] = code;
+				c = w++;
+				code = 1;
+			}
+		}
+		src++;
+	}
+	dst[c] = code;
+	return w;
+}
+
+/**
+  * @brief  COBS decode in place, the output never passes the input
+	*	@param	buf		encoded data, no delimiter
+	*	@param	len		bytes
+  * @retval decoded bytes, 0: bad encoding
+  */
+uint16_t Cobs_Decode(uint8_t *buf, uint16_t len){
+	uint16_t r = 0, w = 0;
+	uint8_t code, i;
+	while(r < len){
+		code = buf[r++];
+		if(code == 0) return 0;
+		for(i=1;i<code;i++){
+			if(r >= len) return 0;
+			buf[w++] = buf[r++];
+		}
+		if(code != 0xFF && r < len) buf[w++] = 0;
+	}
+	return w;
+}
+
+/**
+  * @brief  Encode a frame into the CDC stream, all or nothing.
+	*					Main loop only.
+	*	@param	cmd		command
+	*	@param	seq		sequence number of the request
+	*	@param	data	payload
+	*	@param	len		payload bytes
+  * @retval uint8_t
+	*					0: queued
+	*					1: stream full or link down
+  */
+uint8_t Cmd_Write(uint8_t cmd, uint8_t seq, const uint8_t *data, uint8_t len){
+	uint8_t raw[2+CmdPayloadMax+2];
+	uint8_t enc[CmdFrameMax];
+	uint16_t crc, n;
+
+	raw[0] = cmd;
+	raw[1] = seq;
+	memcpy(&raw[2], data, len);
+	crc = Cmd_Crc16(raw, len+2);
+	raw[len+2] = crc>>8;
+	raw[len+3] = crc;
+	enc[0] = 0;//ends any text printed before the frame
+	n = Cobs_Encode(raw, len+4, &enc[1]) + 1;
+	enc[n++] = 0;
+	return Cdc_Write(enc, n);
+}
+
+/**
+  * @brief  Send an unsolicited frame now, dropped if the stream is full.
+	*					Main loop only.
+	*	@param	cmd		command
+	*	@param	seq		sequence number, 0 if none
+	*	@param	data	payload
+	*	@param	len		payload bytes, up to CmdPayloadMax
+  * @retval uint8_t
+	*					0: queued
+	*					1: dropped
+  */
+uint8_t Cmd_Send(uint8_t cmd, uint8_t seq, const uint8_t *data, uint8_t len){
+	if(Cmd_Write(cmd, seq, data, len)){
+		cmd_stats.dropped++;
+		return 1;
+	}
+	cmd_stats.sent++;
+	return 0;
+}
+
+/**
+  * @brief  free reply slot
+  * @retval slot, NULL if the queue is full
+  */
+Cmd_Reply_t *Cmd_Queue_Slot(void){
+	if(((cmd_q_head + 1) & CmdQueueMask) == cmd_q_tail) return NULL;
+	return &cmd_queue[cmd_q_head];
+}
+
+/**
+  * @brief  Receiver restart, from CDC_Init_FS() on every (re)configure
+  * @retval buffer for the first OUT packet
+  */
+uint8_t *Cmd_Rx_Reset(void){
+	cmd_rx.len = 0;
+	cmd_rx.ready = 0;
+	return cmd_rx.buf;
+}
+
+/**
+  * @brief  OUT packet received, from CDC_Receive_FS(). buf is where the
+	*					packet was put, right after the bytes already received.
+	*	@param	buf		packet
+	*	@param	len		bytes
+  * @retval buffer for the next packet, NULL: hold the endpoint until
+	*					Cmd_Poll() has taken the frame
+  */
+uint8_t *Cmd_Rx(uint8_t *buf, uint32_t len){
+	uint32_t i;
+	if(cmd_rx.len == 0){//leading delimiters end empty frames, not worth a hold
+		for(i=0;i<len && buf[i]==0;i++);
+		len -= i;
+		memmove(buf, buf + i, len);
+	}
+	for(i=0;i<len;i++){
+		if(buf[i] == 0) break;
+	}
+	cmd_rx.len += len;
+	if(i < len){
+		cmd_rx.end = buf - cmd_rx.buf + i;
+		cmd_rx.time = DWT->CYCCNT;
+		cmd_rx.ready = 1;
+		return NULL;
+	}
+	if(cmd_rx.len + CdcPacketSize > CmdRxSize){//too long, the CRC rejects the rest
+		cmd_stats.overflow++;
+		cmd_rx.len = 0;
+	}
+	return &cmd_rx.buf[cmd_rx.len];
+}
+
+/**
+  * @brief  frame taken, move what followed the delimiter to the front.
+	*					If it holds another frame keep the endpoint held, else
+	*					receive again after it.
+  * @retval None
+  */
+void Cmd_Rx_Next(void){
+	uint16_t rest = cmd_rx.len - cmd_rx.end - 1;
+	uint16_t i;
+
+	memmove(cmd_rx.buf, &cmd_rx.buf[cmd_rx.end + 1], rest);
+	cmd_rx.len = rest;
+	for(i=0;i<rest;i++){
+		if(cmd_rx.buf[i] == 0){
+			cmd_rx.end = i;
+			cmd_rx.time = DWT->CYCCNT;
+			return;
+		}
+	}
+	cmd_rx.ready = 0;
+	CDC_Rx_Resume(&cmd_rx.buf[rest]);
+}
+
+/**
+  * @brief  Record one sample in the trace, call after each sample.
+	*					Paused while a dump runs.
+  * @retval None
+  */
+void Cmd_Trace_Put(void){
+	Cmd_Trace_t *t;
+	if(cmd_trace.dump) return;
+	t = &cmd_trace.buf[cmd_trace.head & CmdTraceMask];
+	t->time = HAL_GetTick();
+	t->acc[0] = mpu_data.Accel_X_RAW;
+	t->acc[1] = mpu_data.Accel_Y_RAW;
+	t->acc[2] = mpu_data.Accel_Z_RAW;
+	t->gyro[0] = mpu_data.Gyro_X_RAW;
+	t->gyro[1] = mpu_data.Gyro_Y_RAW;
+	t->gyro[2] = mpu_data.Gyro_Z_RAW;
+	cmd_trace.head++;
+}
+
+/**
+  * @brief  queue the next chunk of a running dump, oldest sample first
+  * @retval None
+  */
+void Cmd_Trace_Next(void){
+	Cmd_Reply_t *r = Cmd_Queue_Slot();
+	const Cmd_Trace_t *t;
+	uint8_t *p;
+	uint16_t i;
+	uint8_t k;
+
+	if(r == NULL) return;
+	r->cmd = CmdTrace;
+	r->seq = cmd_trace.seq;
+	p = r->data;
+	*p++ = cmd_trace.index>>8;
+	*p++ = cmd_trace.index;
+	for(i=0;i<CmdTraceChunk && cmd_trace.index<cmd_trace.count;i++,cmd_trace.index++){
+		t = &cmd_trace.buf[(cmd_trace.head - cmd_trace.count + cmd_trace.index) & CmdTraceMask];
+		*p++ = t->time>>24;
+		*p++ = t->time>>16;
+		*p++ = t->time>>8;
+		*p++ = t->time;
+		for(k=0;k<3;k++){
+			*p++ = (uint16_t)t->acc[k]>>8;
+			*p++ = t->acc[k];
+		}
+		for(k=0;k<3;k++){
+			*p++ = (uint16_t)t->gyro[k]>>8;
+			*p++ = t->gyro[k];
+		}
+	}
+	r->len = p - r->data;
+	cmd_q_head = (cmd_q_head + 1) & CmdQueueMask;
+	if(cmd_trace.index >= cmd_trace.count) cmd_trace.dump = 0;
+}
+
+/**
+  * @brief  counters, big endian u32: cmd_stats, then CDC, telemetry,
+	*					key queue, MPU bus and log
+	*	@param	out		96 bytes
+  * @retval bytes
+  */
+uint8_t Cmd_Stats_Pack(uint8_t *out){
+	uint32_t v[24];
+	uint8_t i, n = 0;
+
+	memcpy(v, (const void*)&cmd_stats, sizeof(cmd_stats));
+	i = sizeof(cmd_stats)/sizeof(uint32_t);
+	v[i++] = cdc_stats.bytes;
+	v[i++] = cdc_stats.dropped;
+	v[i++] = cdc_stats.sent;
+	v[i++] = cdc_stats.rate;
+	v[i++] = cdc_stats.fill_max;
+	v[i++] = tlm_stats.frames;
+	v[i++] = tlm_stats.dropped_frames;
+	v[i++] = key_dropped;
+	v[i++] = mpu_bus_stats.wr_err + mpu_bus_stats.rd_err;
+	v[i++] = mpu_bus_stats.faults;
+	v[i++] = mpu_bus_stats.recoveries;
+	v[i++] = log_stats.records;
+	v[i++] = log_stats.dropped;
+	v[i++] = log_stats.cyc_log;
+	v[i++] = log_stats.cyc_printf;
+	while(n < i*4){
+		out[n] = v[n/4]>>(24-8*(n%4));
+		n++;
+	}
+	return n;
+}
+
+/**
+  * @brief  start or stop the CmdSample stream
+	*	@param	on		1: start, 0: stop
+	*	@param	out		13 bytes
+  * @retval bytes: status, then rate, sent and dropped, big endian u32
+  */
+uint8_t Cmd_Stream(uint8_t on, uint8_t *out){
+	uint32_t v[3];
+	uint8_t n = 0;
+
+	cdc_stream_on = on;
+	v[0] = cdc_stats.rate;
+	v[1] = cdc_stats.sent;
+	v[2] = cdc_stats.dropped;
+	out[n++] = Cmd_OK;
+	while(n < 1+sizeof(v)){
+		out[n] = v[(n-1)/4]>>(24-8*((n-1)%4));
+		n++;
+	}
+	return n;
+}
+
+/**
+  * @brief  Requests that change the key or the settings, or read the
+	*					motion while a key could be entered, need the lock open.
+	*					Enroll is checked by Motion_Key_Enroll().
+	*	@param	cmd		command
+	*	@param	data	payload
+	*	@param	len		payload bytes
+  * @retval uint8_t
+	*					0: allowed
+	*					1: refused while locked
+  */
+uint8_t Cmd_Locked(uint8_t cmd, const uint8_t *data, uint8_t len){
+	if(Is_Unlocked()) return 0;
+	switch(cmd){
+		case ParamFuncSet:
+		case ParamFuncSave:
+		case ParamFuncDefault:
+		case CmdTrace:
+		case CmdVerify:
+			return 1;
+		case CmdStream:
+			return len == 1 && data[0] != 0;	//stopping is always allowed
+		default:
+			return 0;
+	}
+}
+
+/**
+  * @brief  handle one request
+	*	@param	cmd		command
+	*	@param	data	payload
+	*	@param	len		payload bytes
+	*	@param	out		reply payload, CmdPayloadMax bytes
+  * @retval reply bytes
+  */
+uint8_t Cmd_Handle(uint8_t cmd, const uint8_t *data, uint8_t len, uint8_t *out){
+	const uint8_t enroll_status[] = {Cmd_OK, Cmd_Err_Len, Cmd_Err_Locked, Cmd_Err_Busy};
+	uint8_t n = 0;
+
+	if(Cmd_Locked(cmd, data, len)){
+		if(cmd == ParamFuncSet && len) out[n++] = data[0];	//reply: id, status
+		out[n++] = cmd <= ParamFuncDefault ? Param_Err_Locked : Cmd_Err_Locked;
+		return n;
+	}
+	if(cmd >= ParamFuncGet && cmd <= ParamFuncDefault){
+		return Param_Command(cmd, data, len, out);
+	}
+	switch(cmd){
+		case CmdSched:
+			if(len != 1){
+				out[n++] = Cmd_Err_Len;
+				break;
+			}
+			n = Sched_Stats_Pack(out);
+			if(data[0]) Sched_Reset_Stats();
+			break;
+		case CmdStream:
+			if(len != 1){
+				out[n++] = Cmd_Err_Len;
+				break;
+			}
+			n = Cmd_Stream(data[0] != 0, out);
+			break;
+		case CmdTrace:
+			if(len != 0){
+				out[n++] = Cmd_Err_Len;
+				break;
+			}
+			if(cmd_trace.dump){
+				out[n++] = Cmd_Err_Busy;
+				break;
+			}
+			cmd_trace.count = cmd_trace.head < CmdTraceLen ? cmd_trace.head : CmdTraceLen;
+			cmd_trace.index = 0;
+			cmd_trace.dump = cmd_trace.count != 0;
+			out[n++] = Cmd_OK;
+			out[n++] = cmd_trace.count>>8;
+			out[n++] = cmd_trace.count;
+			break;
+		case CmdEnroll:
+			out[n++] = enroll_status[Motion_Key_Enroll(data, len)];
+			break;
+		case CmdVerify:
+			out[n++] = Cmd_OK;
+			out[n++] = Motion_Key_Verify(data, len);
+			break;
+		case CmdStats:
+			if(len > 1){
+				out[n++] = Cmd_Err_Len;
+				break;
+			}
+			n = Cmd_Stats_Pack(out);
+			if(len && data[0]) memset((void*)&cmd_stats, 0, sizeof(cmd_stats));
+			break;
+		case CmdPing:
+			memcpy(out, data, len);
+			n = len;
+			break;
+		case CmdLogFmt:
+			if(len != 1 || data[0] >= Log_Num){
+				out[n++] = Cmd_Err_Len;
+				break;
+			}
+			out[n++] = Cmd_OK;
+			len = strlen(log_fmt[data[0]]);
+			if(len > CmdPayloadMax-1) len = CmdPayloadMax-1;
+			memcpy(&out[n], log_fmt[data[0]], len);
+			n += len;
+			break;
+		case CmdProbe:
+			if(len != 1){
+				out[n++] = Cmd_Err_Len;
+				break;
+			}
+			if(data[0] == 0xFF) Probe_Reset();
+#ifndef PROBE_HOST
+			else if(data[0] == 0xFE) Probe_Dump_Uart();
+#endif
+			else if(data[0] >= Probe_Num){
+				out[n++] = Cmd_Err_Len;
+				break;
+			}
+			out[n++] = Cmd_OK;
+			if(data[0] < Probe_Num) n += Probe_Pack(data[0], &out[n]);
+			break;
+#ifdef JTEST_BENCH
+		case CmdBench:
+			n = Bench_Command(data, len, out);
+			break;
+#endif
+		default:
+			out[n++] = Cmd_Err_Cmd;
+			break;
+	}
+	return n;
+}
+
+/**
+  * @brief  check a received frame and queue its reply, a slot is free
+	*	@param	buf		encoded frame, decoded in place
+	*	@param	len		bytes, without the delimiter
+  * @retval None
+  */
+void Cmd_Frame(uint8_t *buf, uint16_t len){
+	Cmd_Reply_t *r;
+	uint32_t us;
+
+	if(len == 0) return;//leading delimiter
+	cmd_stats.frames++;
+	len = Cobs_Decode(buf, len);
+	if(len < 4 || len > CmdPayloadMax+4){
+		cmd_stats.cobs_err++;
+		return;
+	}
+	if(Cmd_Crc16(buf, len-2) != (((uint16_t)buf[len-2]<<8) | buf[len-1])){
+		cmd_stats.crc_err++;
+		return;
+	}
+	r = &cmd_queue[cmd_q_head];
+	r->cmd = buf[0];
+	r->seq = buf[1];
+	r->len = Cmd_Handle(buf[0], &buf[2], len-4, r->data);
+	if(r->cmd == CmdTrace && cmd_trace.dump){
+		cmd_trace.seq = r->seq;
+	}
+	cmd_q_head = (cmd_q_head + 1) & CmdQueueMask;
+	us = (DWT->CYCCNT - cmd_rx.time)/(SystemCoreClock/1000000);
+	cmd_stats.lat_last = us;
+	if(us > cmd_stats.lat_max) cmd_stats.lat_max = us;
+}
+
+/**
+  * @brief  Protocol service, call from the main loop. Takes one request,
+	*					queues the next dump chunk, then writes the queued replies,
+	*					so a reply leaves in the same run as its request.
+  * @retval None
+  */
+void Cmd_Poll(void){
+	Cmd_Reply_t *r;
+
+	while(cmd_rx.ready && cmd_rx.end == 0) Cmd_Rx_Next();//leading delimiters
+	if(cmd_rx.ready && Cmd_Queue_Slot() != NULL){
+		Cmd_Frame(cmd_rx.buf, cmd_rx.end);
+		Cmd_Rx_Next();
+	}
+	if(cmd_trace.dump) Cmd_Trace_Next();
+	while(cmd_q_tail != cmd_q_head){
+		r = &cmd_queue[cmd_q_tail];
+		if(Cmd_Write(r->cmd, r->seq, r->data, r->len)) break;//stream full, retry
+		cmd_stats.replies++;
+		cmd_q_tail = (cmd_q_tail + 1) & CmdQueueMask;
+	}
+}
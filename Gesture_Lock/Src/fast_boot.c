@@ -0,0 +1,236 @@
+/**
+  ******************************************************************************
+  * File Name          : fast_boot.c
+  * Description        : This file provides code for fast boot of the gesture
+	*											 lock. Self-test biases are cached in flash and re-applied
+	*											 on the next boot, and the system is declared ready as
+	*											 soon as the DMP quaternion stops moving instead of
+	*											 after a fixed delay.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fast_boot.h"
+#include "main.h"
+#include "inv_mpu.h"
+#include "math.h"
+#include "logger.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define Key_Pressed			HAL_GPIO_ReadPin(KEY_GPIO_Port,KEY_Pin)==0
+
+#define ConvergeTH			1e-5f	//1-|q.q_last| per sample, about 0.5 deg
+#define ConvergeNormTH	0.01f	//allowed | |q|-1 |
+#define ConvergeSamples	50		//consecutive still samples to declare ready
+#define FastBootTimeout	5000	//ms, same as the old fixed wait
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct{
+	float			q_last[4];
+	uint8_t		has_last;
+	uint16_t	still_cnt;
+} Converge_State_t;
+
+/* Private variables ---------------------------------------------------------*/
+uint32_t					boot_ready_ms;
+Converge_State_t	converge;
+Calib_Data_t			*calib = (Calib_Data_t*)CalibFlashAddr;
+/* Private function prototypes -----------------------------------------------*/
+uint32_t Calib_Checksum(const Calib_Data_t* c);
+int Calib_Is_Valid(const Calib_Data_t* c);
+int Calib_Save(const Calib_Data_t* c);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  checksum of a calibration record, covers all members
+	*					before checksum
+	*	@param	c		calibration record
+  * @retval checksum
+  */
+uint32_t Calib_Checksum(const Calib_Data_t* c){
+	const uint32_t *p = (const uint32_t*)c;
+	uint32_t sum = 0;
+	uint32_t i;
+	for(i=0;i<(sizeof(Calib_Data_t)-sizeof(uint32_t))/sizeof(uint32_t);i++){
+		sum += p[i];
+	}
+	return ~sum;
+}
+
+/**
+  * @brief  check if the record in flash can be trusted
+	*	@param	c		calibration record
+  * @retval int
+	*					0: invalid
+	*					1: valid
+  */
+int Calib_Is_Valid(const Calib_Data_t* c){
+	if(c->magic != CalibMagic) return 0;
+	if(c->version != CalibVersion) return 0;
+	if(c->st_result != 0x3) return 0;
+	if(c->checksum != Calib_Checksum(c)) return 0;
+	return 1;
+}
+
+/**
+  * @brief  write calibration record to flash
+	*	@param	c		calibration record
+  * @retval int
+	*					0: saved
+	*					1: erase or program failed, flash locked again
+  */
+int Calib_Save(const Calib_Data_t* c){
+	uint32_t i;
+	const uint32_t *p = (const uint32_t*)c;
+	HAL_StatusTypeDef status;
+
+	HAL_FLASH_Unlock();
+	FLASH_Erase_Sector(CalibFlashSector, FLASH_VOLTAGE_RANGE_3);
+	status = FLASH_WaitForLastOperation(1000);
+	for(i=0;status==HAL_OK && i<sizeof(Calib_Data_t)/sizeof(uint32_t);i++){
+		status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, CalibFlashAddr+i*4, p[i]);
+	}
+	HAL_FLASH_Lock();
+	return status==HAL_OK?0:1;
+}
+
+/**
+  * @brief  Apply cached biases if any, otherwise run the self test and
+	*					cache the result. Must be called after mpu_dmp_init().
+	*					Holding the key during boot forces a new self test.
+	*					The self test and the sector erase of Calib_Save() block
+	*					for seconds, so they only run with boot set. A restart
+	*					at run time passes boot = 0 and only writes the cached
+	*					biases back, whatever the key does.
+	*	@param	boot	1: boot, 0: restart by the bus recovery
+  * @retval int
+	*					0: warm start, cached biases applied
+	*					1: cold start, self test passed and cached
+	*				 -1: self test failed or, at run time, no cache; no bias
+	*							applied
+  */
+int Fast_Boot_Calibrate(uint8_t boot){
+	Calib_Data_t c;
+
+	if(!boot){
+		if(!Calib_Is_Valid(calib)) return -1;
+		if(mpu_apply_bias(calib->gyro_bias, calib->accel_bias)) return -1;
+		Log0(Log_Calib_Applied);
+		return 0;
+	}
+	if(Key_Pressed){
+		Log0(Log_Key_Held);
+	}
+	else if(Calib_Is_Valid(calib)){
+		if(mpu_apply_bias(calib->gyro_bias, calib->accel_bias) == 0){
+			Log0(Log_Calib_Applied);
+			if(calib->dmp_sig != mpu_get_firmware_signature()){//new DMP image
+				c = *calib;
+				c.dmp_sig = mpu_get_firmware_signature();
+				c.checksum = Calib_Checksum(&c);
+				if(Calib_Save(&c)) Log0(Log_Calib_Save_Fail);
+			}
+			return 0;
+		}
+	}
+	if(run_self_test(c.gyro_bias, c.accel_bias) != 0){
+		Log0(Log_Self_Test_Fail);
+		return -1;
+	}
+	c.magic = CalibMagic;
+	c.version = CalibVersion;
+	c.st_result = 0x3;
+	c.dmp_sig = mpu_get_firmware_signature();
+	c.reserved = 0;
+	c.checksum = Calib_Checksum(&c);
+	if(Calib_Save(&c)) Log0(Log_Calib_Save_Fail);
+	else Log0(Log_Calib_Cached);
+	return 1;
+}
+
+/**
+  * @brief  Drop the cached calibration, next boot runs the self test
+  * @retval int
+	*					0: dropped
+	*					1: erase failed
+  */
+int Fast_Boot_Invalidate(void){
+	HAL_StatusTypeDef status;
+
+	HAL_FLASH_Unlock();
+	FLASH_Erase_Sector(CalibFlashSector, FLASH_VOLTAGE_RANGE_3);
+	status = FLASH_WaitForLastOperation(1000);
+	HAL_FLASH_Lock();
+	return status==HAL_OK?0:1;
+}
+
+/**
+  * @brief  Convergence monitor initialize
+  * @retval None
+  */
+void Fast_Boot_Monitor_Init(void){
+	converge.has_last = 0;
+	converge.still_cnt = 0;
+}
+
+/**
+  * @brief  Feed one DMP quaternion to the convergence monitor. The
+	*					quaternion is converged when it is normalized and has
+	*					moved less than ConvergeTH for ConvergeSamples samples.
+	*	@param	q		quaternion, q[0] is w
+  * @retval int
+	*					0: not converged
+	*					1: converged
+  */
+int Fast_Boot_Monitor_Update(const float *q){
+	float dot, norm;
+	uint8_t i;
+
+	norm = q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3];
+	if(fabsf(norm - 1.0f) > ConvergeNormTH){
+		converge.still_cnt = 0;
+	}
+	else if(converge.has_last){
+		dot = q[0]*converge.q_last[0] + q[1]*converge.q_last[1]
+				+ q[2]*converge.q_last[2] + q[3]*converge.q_last[3];
+		if(1.0f - fabsf(dot) < ConvergeTH){
+			converge.still_cnt++;
+		}
+		else{
+			converge.still_cnt = 0;
+		}
+	}
+	for(i=0;i<4;i++) converge.q_last[i] = q[i];
+	converge.has_last = 1;
+	return converge.still_cnt >= ConvergeSamples;
+}
+
+/**
+  * @brief  Wait until the DMP quaternion converges or FastBootTimeout
+	*					passes. Sampling timer must be running. Bus recovery keeps
+	*					running while waiting.
+	*	@param	mpu		data updated by the sampling timer
+  * @retval boot to ready time, ms
+  */
+uint32_t Fast_Boot_Wait_Ready(volatile MPU_Data_t *mpu){
+	uint32_t start = HAL_GetTick();
+	float q[4];
+	uint8_t i;
+
+	Fast_Boot_Monitor_Init();
+	while(HAL_GetTick() - start < FastBootTimeout){
+		MPU_Bus_Poll();
+		if(mpu->UpdateFlag){
+			for(i=0;i<4;i++) q[i] = mpu->q[i];
+			mpu->UpdateFlag = 0;
+			if(Fast_Boot_Monitor_Update(q)) break;
+		}
+	}
+	boot_ready_ms = HAL_GetTick();
+	Log1(Log_Boot_Time, boot_ready_ms);
+	return boot_ready_ms;
+}
@@ -0,0 +1,187 @@
+/**
+  ******************************************************************************
+  * File Name          : fusion.c
+  * Description        : This file provides code for the software attitude
+	*											 fusion. Madgwick's gradient descent filter for accel
+	*											 and gyro in float32 on the M4 FPU: the gyro rate is
+	*											 integrated and one normalized gradient step per
+	*											 sample pulls the predicted gravity towards the
+	*											 measured one, less so as |a| leaves 1 g under linear
+	*											 acceleration. Every sample runs the same code, three
+	*											 square roots and no loops, so the cost per sample is
+	*											 fixed and the rate can go up to the 1kHz of the
+	*											 MPU6050 FIFO. The first sample sets the tilt from
+	*											 gravity and a high gain for FusionBootMs settles it;
+	*											 yaw starts at 0 as with the DMP. Host/fusion_bench.c
+	*											 compares it with the DMP on replayed samples.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fusion.h"
+#include "probe.h"
+#include "math.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define FusionGyroRad		(PI / 180.0f / FusionGyroLsb)	//rad/s per LSB
+
+/* Private variables ---------------------------------------------------------*/
+Fusion_t fusion;
+/* Private function prototypes -----------------------------------------------*/
+void Fusion_Align(const int16_t acc[3]);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Start over: no orientation yet, boot gain
+	*	@param	hz		sample rate
+  * @retval None
+  */
+void Fusion_Init(uint16_t hz){
+	fusion.q[0] = 1.0f;
+	fusion.q[1] = 0;
+	fusion.q[2] = 0;
+	fusion.q[3] = 0;
+	fusion.beta = FusionBetaBoot;
+	fusion.samples = 0;
+	Fusion_Set_Rate(hz);
+	fusion.boot = (uint32_t)hz * FusionBootMs / 1000;
+}
+
+/**
+  * @brief  Change the sample rate, keeps the orientation
+	*	@param	hz		sample rate
+  * @retval None
+  */
+void Fusion_Set_Rate(uint16_t hz){
+	fusion.dt = 1.0f / hz;
+}
+
+/**
+  * @brief  Orientation whose gravity is the measured one, zero yaw.
+	*					(1+az, ay, -ax, 0) normalized gives exactly (ax, ay, az)
+	*					for unit a with the gravity terms of the DMP path.
+	*	@param	acc		raw accel
+  * @retval None
+  */
+void Fusion_Align(const int16_t acc[3]){
+	float ax = acc[0], ay = acc[1], az = acc[2];
+	float n = ax*ax + ay*ay + az*az;
+
+	if(n == 0) return;
+	arm_sqrt_f32(n, &n);
+	n = 1.0f / n;
+	ax *= n;
+	ay *= n;
+	az *= n;
+	if(az < -0.9999f){//upside down, the formula degenerates
+		fusion.q[0] = 0;
+		fusion.q[1] = 1.0f;
+		fusion.q[2] = 0;
+		fusion.q[3] = 0;
+		return;
+	}
+	arm_sqrt_f32(2.0f * (1.0f + az), &n);
+	n = 1.0f / n;
+	fusion.q[0] = (1.0f + az) * n;
+	fusion.q[1] = ay * n;
+	fusion.q[2] = -ax * n;
+	fusion.q[3] = 0;
+}
+
+/**
+  * @brief  One sample
+	*	@param	acc		raw accel X, Y, Z, FusionAccOne per g
+	*	@param	gyro	raw gyro X, Y, Z, FusionGyroLsb per deg/s
+  * @retval None
+  */
+void Fusion_Update(const int16_t acc[3], const int16_t gyro[3]){
+	float q0 = fusion.q[0], q1 = fusion.q[1], q2 = fusion.q[2], q3 = fusion.q[3];
+	float ax = acc[0], ay = acc[1], az = acc[2];
+	float gx = gyro[0] * FusionGyroRad, gy = gyro[1] * FusionGyroRad, gz = gyro[2] * FusionGyroRad;
+	float qd0, qd1, qd2, qd3, s0, s1, s2, s3, n, w;
+	float _2q0, _2q1, _2q2, _2q3, _4q0, _4q1, _4q2, _8q1, _8q2, q0q0, q1q1, q2q2, q3q3;
+
+	Probe_Begin(Probe_Fusion);
+	if(fusion.samples++ == 0){
+		Fusion_Align(acc);
+		Probe_End(Probe_Fusion);
+		return;
+	}
+	//rate of change from the gyro, q' = q * (0, w) / 2
+	qd0 = 0.5f * (-q1*gx - q2*gy - q3*gz);
+	qd1 = 0.5f * ( q0*gx + q2*gz - q3*gy);
+	qd2 = 0.5f * ( q0*gy - q1*gz + q3*gx);
+	qd3 = 0.5f * ( q0*gz + q1*gy - q2*gx);
+
+	n = ax*ax + ay*ay + az*az;
+	if(n > 0){//no accel: free fall or a bad read, gyro only
+		arm_sqrt_f32(n, &n);
+		//trust in the accel falls off linearly as |a| leaves 1 g
+		w = 1.0f - fabsf(n * (1.0f / FusionAccOne) - 1.0f) * (1.0f / FusionAccBand);
+		if(w < 0) w = 0;
+		n = 1.0f / n;
+		ax *= n;
+		ay *= n;
+		az *= n;
+		//gradient of |g(q) - a|^2, g(q) the gravity terms of the DMP path
+		_2q0 = 2.0f * q0;
+		_2q1 = 2.0f * q1;
+		_2q2 = 2.0f * q2;
+		_2q3 = 2.0f * q3;
+		_4q0 = 4.0f * q0;
+		_4q1 = 4.0f * q1;
+		_4q2 = 4.0f * q2;
+		_8q1 = 8.0f * q1;
+		_8q2 = 8.0f * q2;
+		q0q0 = q0 * q0;
+		q1q1 = q1 * q1;
+		q2q2 = q2 * q2;
+		q3q3 = q3 * q3;
+		s0 = _4q0*q2q2 + _2q2*ax + _4q0*q1q1 - _2q1*ay;
+		s1 = _4q1*q3q3 - _2q3*ax + 4.0f*q0q0*q1 - _2q0*ay - _4q1 + _8q1*q1q1 + _8q1*q2q2 + _4q1*az;
+		s2 = 4.0f*q0q0*q2 + _2q0*ax + _4q2*q3q3 - _2q3*ay - _4q2 + _8q2*q1q1 + _8q2*q2q2 + _4q2*az;
+		s3 = 4.0f*q1q1*q3 - _2q1*ax + 4.0f*q2q2*q3 - _2q2*ay;
+		//unit step, the small term keeps an exact fit from dividing by 0
+		arm_sqrt_f32(s0*s0 + s1*s1 + s2*s2 + s3*s3 + 1e-20f, &n);
+		n = fusion.beta * w / n;
+		qd0 -= n * s0;
+		qd1 -= n * s1;
+		qd2 -= n * s2;
+		qd3 -= n * s3;
+	}
+	q0 += qd0 * fusion.dt;
+	q1 += qd1 * fusion.dt;
+	q2 += qd2 * fusion.dt;
+	q3 += qd3 * fusion.dt;
+	arm_sqrt_f32(q0*q0 + q1*q1 + q2*q2 + q3*q3, &n);
+	n = 1.0f / n;
+	fusion.q[0] = q0 * n;
+	fusion.q[1] = q1 * n;
+	fusion.q[2] = q2 * n;
+	fusion.q[3] = q3 * n;
+	if(fusion.boot && --fusion.boot == 0) fusion.beta = FusionBeta;
+	Probe_End(Probe_Fusion);
+}
+
+/**
+  * @brief  Euler angles of a quaternion, the formulas of mpu_dmp_get_data()
+	*					in single precision
+	*	@param	q			quaternion
+	*	@param	pitch	deg
+	*	@param	roll	deg
+	*	@param	yaw		deg
+  * @retval None
+  */
+void Fusion_Euler(const float q[4], float *pitch, float *roll, float *yaw){
+	float sp = -2.0f*q[1]*q[3] + 2.0f*q[0]*q[2];
+
+	if(sp > 1.0f) sp = 1.0f;//rounding of a unit quaternion
+	if(sp < -1.0f) sp = -1.0f;
+	*pitch = asinf(sp) * 57.3f;
+	*roll = atan2f(2.0f*q[2]*q[3] + 2.0f*q[0]*q[1], -2.0f*q[1]*q[1] - 2.0f*q[2]*q[2] + 1.0f) * 57.3f;
+	*yaw = atan2f(2.0f*(q[1]*q[2] + q[0]*q[3]), q[0]*q[0] + q[1]*q[1] - q[2]*q[2] - q[3]*q[3]) * 57.3f;
+}
@@ -100,7 +100,66 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef* i2cHandle)
 } 
 
 /* USER CODE BEGIN 1 */
+#define I2C1_SCL_Pin			GPIO_PIN_6
+#define I2C1_SDA_Pin			GPIO_PIN_7
+#define I2C1_Clear_Pulses	9		//enough for the slave to finish any byte
 
+/**
+  * @brief  ~5us at 96MHz, gives a <100kHz bit-banged SCL
+  * @retval None
+  */
+static void I2C1_Bus_Delay(void)
+{
+	volatile uint32_t n = 120;
+	while(n--);
+}
+
+/**
+  * @brief  Release a slave that holds SDA low after an interrupted
+	*					transfer. The pins are taken from the I2C peripheral, SCL
+	*					is clocked until SDA goes high (at most 9 pulses), a STOP
+	*					is generated and I2C1 is initialized again.
+  * @retval 0: SDA released
+	*					1: SDA still held low
+  */
+uint8_t I2C1_Bus_Clear(void)
+{
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	uint8_t i, stuck;
+
+	HAL_I2C_DeInit(&hi2c1);
+
+	HAL_GPIO_WritePin(GPIOB, I2C1_SCL_Pin|I2C1_SDA_Pin, GPIO_PIN_SET);
+	GPIO_InitStruct.Pin = I2C1_SCL_Pin|I2C1_SDA_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
+	GPIO_InitStruct.Pull = GPIO_PULLUP;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+	HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+	I2C1_Bus_Delay();
+
+	for(i=0;i<I2C1_Clear_Pulses;i++){
+		if(HAL_GPIO_ReadPin(GPIOB, I2C1_SDA_Pin) == GPIO_PIN_SET) break;
+		HAL_GPIO_WritePin(GPIOB, I2C1_SCL_Pin, GPIO_PIN_RESET);
+		I2C1_Bus_Delay();
+		HAL_GPIO_WritePin(GPIOB, I2C1_SCL_Pin, GPIO_PIN_SET);
+		I2C1_Bus_Delay();
+	}
+
+	/* STOP: SDA low to high while SCL is high */
+	HAL_GPIO_WritePin(GPIOB, I2C1_SCL_Pin, GPIO_PIN_RESET);
+	I2C1_Bus_Delay();
+	HAL_GPIO_WritePin(GPIOB, I2C1_SDA_Pin, GPIO_PIN_RESET);
+	I2C1_Bus_Delay();
+	HAL_GPIO_WritePin(GPIOB, I2C1_SCL_Pin, GPIO_PIN_SET);
+	I2C1_Bus_Delay();
+	HAL_GPIO_WritePin(GPIOB, I2C1_SDA_Pin, GPIO_PIN_SET);
+	I2C1_Bus_Delay();
+	stuck = HAL_GPIO_ReadPin(GPIOB, I2C1_SDA_Pin) == GPIO_PIN_RESET;
+
+	HAL_GPIO_DeInit(GPIOB, I2C1_SCL_Pin|I2C1_SDA_Pin);
+	MX_I2C1_Init();//pins back to AF, peripheral software reset
+	return stuck;
+}
 /* USER CODE END 1 */
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,214 @@
+/**
+  ******************************************************************************
+  * File Name          : imu_pre.c
+  * Description        : This file provides code for the fixed point IMU
+	*											 preprocessing chain. Samples are staged one row per
+	*											 channel so that every stage is one CMSIS DSP call per
+	*											 channel over the whole block:
+	*											 calibration		(raw - bias) * gain
+	*											 gravity removal	accel - g(q), the DMP quaternion in Q15
+	*											 normalization		(x - mean) / std, Q3.12
+	*											 The block is then appended to a q7 window laid out
+	*											 as the [time][channel] input of the 1-D conv models.
+	*											 The chain pays off on blocks: MPU_Update() stages
+	*											 every sample and runs it on ImuPreBlock at a time,
+	*											 and gives the threshold detector each sample from
+	*											 Imu_Pre_Motion(), the same calibration and gravity
+	*											 removal in single precision float. Host/imu_pre_bench.c
+	*											 checks both against the double path.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "imu_pre.h"
+#include "probe.h"
+#include "string.h"
+#include "math.h"
+
+/* Private variables ---------------------------------------------------------*/
+Imu_Pre_t imu_pre;
+static const Imu_Pre_Cal_t *imu_pre_cal = &imu_pre_cal_default;
+
+//no calibration beyond the biases the DMP already removes. The feature
+//statistics stand in until the gesture model is trained: +-8 std covers
+//+-4 g and +-2000 deg/s, the whole range mpu_init() sets.
+const Imu_Pre_Cal_t imu_pre_cal_default = {
+	{0, 0, 0, 0, 0, 0},
+	{1, 1, 1, 1, 1, 1},
+	{0, 0, 0, 0, 0, 0},
+	{0.5f, 0.5f, 0.5f, 250.0f, 250.0f, 250.0f}
+};
+
+//calibration in 0..ImuPreCh-1, normalization in ImuPreCh..2*ImuPreCh-1
+static q15_t	imu_pre_off[2*ImuPreCh];
+static q15_t	imu_pre_fract[2*ImuPreCh];
+static int8_t	imu_pre_shift[2*ImuPreCh];
+
+static q15_t	imu_pre_q[4][ImuPreBlock];				//quaternion, Q15
+static q15_t	imu_pre_t[2][ImuPreBlock];				//gravity terms
+static q15_t	imu_pre_row[ImuPreBlock*ImuPreCh];//features of the block, [time][channel]
+/* Private function prototypes -----------------------------------------------*/
+float Imu_Pre_Split(float k, int8_t *shift);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Split a factor for arm_scale_q15: k = fract * 2^shift, fract in
+	*					[0.5, 1), shift in -15..15
+	*	@param	k			factor, > 0
+	*	@param	shift	exponent out
+  * @retval fract
+  */
+float Imu_Pre_Split(float k, int8_t *shift){
+	int e;
+	float m = frexpf(k, &e);
+	if(e > 15){
+		m = 1.0f;//saturates to 0x7FFF
+		e = 15;
+	}
+	else if(e < -15){
+		m = 0;
+		e = 0;
+	}
+	*shift = e;
+	return m;
+}
+
+/**
+  * @brief  Convert the calibration to the Q15 factors of the chain and
+	*					empty the block and the window. The only float work of the
+	*					chain, done once.
+	*	@param	cal		calibration and feature statistics, NULL for
+	*								imu_pre_cal_default. std must be > 0.
+  * @retval None
+  */
+void Imu_Pre_Init(const Imu_Pre_Cal_t *cal){
+	float off[2*ImuPreCh];
+	float fract[2*ImuPreCh];
+	float unit;
+	uint8_t c;
+
+	if(cal == NULL) cal = &imu_pre_cal_default;
+	imu_pre_cal = cal;
+	for(c=0;c<ImuPreCh;c++){
+		unit = c < 3 ? ImuPreAccOne : ImuPreGyroLsb;
+		off[c] = -cal->bias[c] / 32768.0f;
+		fract[c] = Imu_Pre_Split(cal->gain[c], &imu_pre_shift[c]);
+		off[ImuPreCh+c] = -cal->mean[c] * unit / 32768.0f;
+		fract[ImuPreCh+c] = Imu_Pre_Split(ImuPreFeatOne / (cal->std[c] * unit), &imu_pre_shift[ImuPreCh+c]);
+	}
+	arm_float_to_q15(off, imu_pre_off, 2*ImuPreCh);
+	arm_float_to_q15(fract, imu_pre_fract, 2*ImuPreCh);
+	memset(&imu_pre, 0, sizeof(imu_pre));
+}
+
+/**
+  * @brief  Calibrate one sample and remove gravity in float, for callers
+	*					that need each sample at once. The calibration of
+	*					Imu_Pre_Init().
+	*	@param	acc		raw accel X, Y, Z
+	*	@param	gyro	raw gyro X, Y, Z
+	*	@param	q			DMP quaternion
+	*	@param	out		ax ay az in g, gx gy gz in deg/s
+  * @retval None
+  */
+void Imu_Pre_Motion(const int16_t acc[3], const int16_t gyro[3], const float q[4], float out[ImuPreCh]){
+	const Imu_Pre_Cal_t *cal = imu_pre_cal;
+	uint8_t c;
+
+	for(c=0;c<3;c++){
+		out[c] = (acc[c] - cal->bias[c]) * cal->gain[c] * (1.0f/ImuPreAccOne);
+		out[3+c] = (gyro[c] - cal->bias[3+c]) * cal->gain[3+c] * (1.0f/ImuPreGyroLsb);
+	}
+	out[0] += 2*(q[0]*q[2] - q[1]*q[3]);
+	out[1] -= 2*(q[2]*q[3] + q[0]*q[1]);
+	out[2] += -1 + 2*(q[1]*q[1] + q[2]*q[2]);
+}
+
+/**
+  * @brief  Stage one sample
+	*	@param	acc		raw accel X, Y, Z
+	*	@param	gyro	raw gyro X, Y, Z
+	*	@param	q			DMP quaternion
+  * @retval uint8_t
+	*					0: staged
+	*					1: ImuPreBlock samples already staged, sample dropped
+  */
+uint8_t Imu_Pre_Push(const int16_t acc[3], const int16_t gyro[3], const float q[4]){
+	uint16_t i = imu_pre.n;
+	uint8_t c;
+
+	if(i >= ImuPreBlock) return 1;
+	for(c=0;c<3;c++){
+		imu_pre.raw[c][i] = acc[c];
+		imu_pre.raw[3+c][i] = gyro[c];
+	}
+	for(c=0;c<4;c++) imu_pre.q[c][i] = q[c];
+	imu_pre.n = i + 1;
+	return 0;
+}
+
+/**
+  * @brief  Run the chain over the staged samples. Results in imu_pre.motion,
+	*					imu_pre.feat and the last samples of imu_pre.window.
+  * @retval samples processed
+  */
+uint16_t Imu_Pre_Run(void){
+	uint16_t n = imu_pre.n;
+	q15_t *ax = imu_pre.motion[0];
+	q15_t *ay = imu_pre.motion[1];
+	q15_t *az = imu_pre.motion[2];
+	q15_t *t0 = imu_pre_t[0];
+	q15_t *t1 = imu_pre_t[1];
+	uint16_t i;
+	uint8_t c;
+
+	if(n == 0) return 0;
+	Probe_Begin(Probe_Imu_Pre);
+	//calibration
+	for(c=0;c<ImuPreCh;c++){
+		arm_offset_q15(imu_pre.raw[c], imu_pre_off[c], imu_pre.motion[c], n);
+		arm_scale_q15(imu_pre.motion[c], imu_pre_fract[c], imu_pre_shift[c], imu_pre.motion[c], n);
+	}
+	//gravity in the body frame, as in the float path:
+	//(2(q1q3-q0q2), 2(q0q1+q2q3), 1-2(q1q1+q2q2)). A Q15 product p is 2p g,
+	//that is p/2 in Q2.13, hence the scale by 0.5.
+	for(c=0;c<4;c++) arm_float_to_q15(imu_pre.q[c], imu_pre_q[c], n);
+	arm_mult_q15(imu_pre_q[1], imu_pre_q[3], t0, n);
+	arm_mult_q15(imu_pre_q[0], imu_pre_q[2], t1, n);
+	arm_sub_q15(t0, t1, t0, n);
+	arm_scale_q15(t0, 0x4000, 0, t0, n);
+	arm_sub_q15(ax, t0, ax, n);
+
+	arm_mult_q15(imu_pre_q[0], imu_pre_q[1], t0, n);
+	arm_mult_q15(imu_pre_q[2], imu_pre_q[3], t1, n);
+	arm_add_q15(t0, t1, t0, n);
+	arm_scale_q15(t0, 0x4000, 0, t0, n);
+	arm_sub_q15(ay, t0, ay, n);
+
+	arm_mult_q15(imu_pre_q[1], imu_pre_q[1], t0, n);
+	arm_mult_q15(imu_pre_q[2], imu_pre_q[2], t1, n);
+	arm_add_q15(t0, t1, t0, n);
+	arm_scale_q15(t0, -0x4000, 0, t0, n);
+	arm_offset_q15(t0, ImuPreAccOne, t0, n);//g z, the only saturation is on the result
+	arm_sub_q15(az, t0, az, n);
+	//normalization
+	for(c=0;c<ImuPreCh;c++){
+		arm_offset_q15(imu_pre.motion[c], imu_pre_off[ImuPreCh+c], imu_pre.feat[c], n);
+		arm_scale_q15(imu_pre.feat[c], imu_pre_fract[ImuPreCh+c], imu_pre_shift[ImuPreCh+c], imu_pre.feat[c], n);
+	}
+	//q7 window: drop the n oldest samples, append the block. The tail is
+	//not word aligned for odd n, unaligned word stores are fine on the M4.
+	for(i=0;i<n;i++){
+		for(c=0;c<ImuPreCh;c++) imu_pre_row[i*ImuPreCh+c] = imu_pre.feat[c][i];
+	}
+	memmove(imu_pre.window[0], imu_pre.window[n], (ImuPreWindow - n) * ImuPreCh);
+	arm_q15_to_q7(imu_pre_row, imu_pre.window[ImuPreWindow - n], n * ImuPreCh);
+	imu_pre.samples += n;
+	imu_pre.n = 0;
+	Probe_End(Probe_Imu_Pre);
+	return n;
+}
@@ -0,0 +1,193 @@
+/**
+  ******************************************************************************
+  * File Name          : key.c
+  * Description        : This file provides code for the interrupt driven
+	*											 user key on PA0. An edge on EXTI0 starts debouncing,
+	*											 the 1 ms SysTick samples the level once it has been
+	*											 quiet for KeyDebounceTime and runs the click state
+	*											 machine. Events go to a small queue with their time
+	*											 and are read by the main loop. Nothing here waits.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "key.h"
+#include "main.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define Key_Level			(HAL_GPIO_ReadPin(KEY_GPIO_Port,KEY_Pin)==0)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum{
+	Key_Idle = 0,
+	Key_Down,					//first press, not yet long
+	Key_Wait_Second,	//short click released, waiting for a second one
+	Key_Second_Down,	//second press
+	Key_Held					//classified, no event on release
+} Key_Phase_t;
+
+typedef struct{
+	volatile uint8_t	settling;		//edge seen, waiting for the level to settle
+	volatile uint32_t	edge_time;	//last edge
+	uint8_t						stable;			//debounced level, 1: pressed
+	uint8_t						phase;			//Key_Phase_t
+	uint32_t					phase_time;	//press or release time of the phase
+} Key_State_t;
+
+/* Private variables ---------------------------------------------------------*/
+Key_State_t				key_state;
+Key_Msg_t					key_queue[KeyQueueLen];
+volatile uint8_t	key_head;		//written in interrupt
+volatile uint8_t	key_tail;		//written in main loop
+volatile uint32_t	key_dropped;	//queue full
+/* Private function prototypes -----------------------------------------------*/
+void Key_Put(uint8_t event, uint32_t time);
+void Key_Edge(uint8_t pressed, uint32_t now);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Key initialize, a key held at boot gives no event until
+	*					it is released and pressed again
+  * @retval None
+  */
+void Key_Init(void){
+	HAL_NVIC_DisableIRQ(EXTI0_IRQn);
+	key_state.settling = 0;
+	key_state.stable = Key_Level;
+	key_state.phase = key_state.stable ? Key_Held : Key_Idle;
+	key_state.phase_time = HAL_GetTick();
+	key_head = 0;
+	key_tail = 0;
+	key_dropped = 0;
+	__HAL_GPIO_EXTI_CLEAR_IT(KEY_Pin);
+	HAL_NVIC_EnableIRQ(EXTI0_IRQn);
+}
+
+/**
+  * @brief  EXTI callback, any edge restarts the debounce window
+	*	@param	GPIO_Pin	pin of the interrupt
+  * @retval None
+  */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
+	if(GPIO_Pin != KEY_Pin) return;
+	key_state.edge_time = HAL_GetTick();
+	key_state.settling = 1;
+}
+
+/**
+  * @brief  queue an event, dropped if the queue is full
+	*	@param	event	Key_Event_t
+	*	@param	time	HAL tick
+  * @retval None
+  */
+void Key_Put(uint8_t event, uint32_t time){
+	uint8_t next = (key_head + 1) & (KeyQueueLen - 1);
+	if(next == key_tail){
+		key_dropped++;
+		return;
+	}
+	key_queue[key_head].event = event;
+	key_queue[key_head].time = time;
+	key_head = next;
+}
+
+/**
+  * @brief  click state machine, debounced edges
+	*	@param	pressed		new level
+	*	@param	now				HAL tick
+  * @retval None
+  */
+void Key_Edge(uint8_t pressed, uint32_t now){
+	if(pressed){
+		Key_Put(Key_Press, now);
+		if(key_state.phase == Key_Wait_Second) key_state.phase = Key_Second_Down;
+		else key_state.phase = Key_Down;
+		key_state.phase_time = now;
+		return;
+	}
+	switch(key_state.phase){
+		case Key_Down:
+			key_state.phase = Key_Wait_Second;
+			key_state.phase_time = now;
+			return;
+		case Key_Second_Down:
+			Key_Put(Key_Double, now);
+			break;
+		default:
+			break;
+	}
+	key_state.phase = Key_Idle;
+}
+
+/**
+  * @brief  Debounce and click timing, call every 1 ms (SysTick).
+	*					Returns at once while the key is idle.
+  * @retval None
+  */
+void Key_Tick(void){
+	uint32_t now;
+	uint8_t level;
+
+	if(!key_state.settling && key_state.phase == Key_Idle) return;
+	now = HAL_GetTick();
+	if(key_state.settling && now - key_state.edge_time >= KeyDebounceTime){
+		key_state.settling = 0;
+		level = Key_Level;
+		if(level != key_state.stable){
+			key_state.stable = level;
+			Key_Edge(level, now);
+		}
+	}
+	switch(key_state.phase){
+		case Key_Down:
+			if(now - key_state.phase_time >= ShortPressMax){
+				Key_Put(Key_Long, now);
+				key_state.phase = Key_Held;
+			}
+			break;
+		case Key_Second_Down:
+			if(now - key_state.phase_time >= ShortPressMax){//click, then hold
+				Key_Put(Key_Short, now);
+				Key_Put(Key_Long, now);
+				key_state.phase = Key_Held;
+			}
+			break;
+		case Key_Wait_Second:
+			if(now - key_state.phase_time >= DoubleClickGap){
+				Key_Put(Key_Short, key_state.phase_time);
+				key_state.phase = Key_Idle;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+  * @brief  Take the next event from the queue
+	*	@param	m		event and its time
+  * @retval uint8_t
+	*					0: queue empty
+	*					1: event taken
+  */
+uint8_t Key_Get(Key_Msg_t *m){
+	uint8_t tail = key_tail;
+	if(tail == key_head) return 0;
+	*m = key_queue[tail];
+	key_tail = (tail + 1) & (KeyQueueLen - 1);
+	return 1;
+}
+
+/**
+  * @brief  Take the next event, without its time
+  * @retval Key_Event_t
+  */
+Key_Event_t Key_Get_Event(void){
+	Key_Msg_t m;
+	if(!Key_Get(&m)) return Key_None;
+	return (Key_Event_t)m.event;
+}
@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * File Name          : logger.c
+  * Description        : This file provides code for the deferred binary log.
+	*											 Log_Put() (logger.h) only copies a few words into a
+	*											 ring. Log_Poll() sends whole records to the upper
+	*											 machine as CmdLog frames once USB is up, so boot
+	*											 messages wait in the ring instead of being lost,
+	*											 and the format strings are read with CmdLogFmt.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "logger.h"
+#include "cmd.h"
+#include "stdio.h"
+#include "string.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define LOG_FMT(id, fmt)	fmt,
+
+/* Private variables ---------------------------------------------------------*/
+uint32_t				log_ring[LogRingSize];
+uint32_t				log_head;
+uint32_t				log_tail;
+Log_Stats_t			log_stats;
+
+//indexed by Log_Id_t
+const char *const	log_fmt[Log_Num] = {
+	LOG_TABLE(LOG_FMT)
+};
+/* Private function prototypes -----------------------------------------------*/
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Log initialize, the DWT cycle counter must be running.
+	*					Measures one log call against formatting the same message.
+  * @retval None
+  */
+void Log_Init(void){
+	char buf[64];
+	uint32_t t;
+
+	memset(&log_stats, 0, sizeof(log_stats));
+	log_head = 0;
+	log_tail = 0;
+	t = DWT->CYCCNT;
+	Log_Put(Log_Gesture, 3, 12, 3, Log_F(-12.5f));
+	log_stats.cyc_log = DWT->CYCCNT - t;
+	t = DWT->CYCCNT;
+	snprintf(buf, sizeof(buf), log_fmt[Log_Gesture], 12, 3, -12.5f);
+	log_stats.cyc_printf = DWT->CYCCNT - t;
+	log_head = 0;
+	log_stats.records = 0;
+	log_stats.fill_max = 0;
+}
+
+/**
+  * @brief  Send stored records, big endian words, as many whole records
+	*					as fit in a frame. Records stay in the ring while the stream
+	*					is full or USB is down. Main loop only.
+  * @retval None
+  */
+void Log_Poll(void){
+	uint8_t out[CmdPayloadMax];
+	uint32_t head = log_head;
+	uint32_t tail = log_tail;
+	uint32_t w, k, len;
+	uint8_t n, cnt;
+
+	while(tail != head){
+		n = 0;
+		cnt = 0;
+		while(tail != head){
+			len = 2 + (log_ring[tail & LogMask] & 0xFF);
+			if(n + len*4 > CmdPayloadMax) break;
+			for(k=0;k<len;k++){
+				w = log_ring[(tail+k) & LogMask];
+				out[n++] = w>>24;
+				out[n++] = w>>16;
+				out[n++] = w>>8;
+				out[n++] = w;
+			}
+			tail += len;
+			cnt++;
+		}
+		if(Cmd_Write(CmdLog, 0, out, n)) return;//stream full, retry
+		log_tail = tail;
+		log_stats.sent += cnt;
+	}
+}
@@ -25,6 +25,8 @@
 #include "usart.h"
 #include "usb_device.h"
 #include "gpio.h"
+#include "dma.h"
+#include "spi.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
@@ -35,6 +37,18 @@
 #include "inv_mpu_dmp_motion_driver.h"
 #include "serial_debug.h"
 #include "state_machine.h"
+#include "fast_boot.h"
+#include "param.h"
+#include "sched.h"
+#include "telemetry.h"
+#include "cdc_stream.h"
+#include "logger.h"
+#include "probe.h"
+#include "imu_pre.h"
+#include "fusion.h"
+#ifdef JTEST_BENCH
+#include "bench.h"
+#endif
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -61,7 +75,9 @@ volatile MPU_Data_t mpu_data;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
-
+uint8_t MPU_Configure(uint8_t boot);
+uint8_t MPU_Configured(uint8_t res, uint8_t boot);
+uint8_t MPU_Restart(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -93,38 +109,46 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-
+	Cdc_Init();//before USB enumerates
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_USB_DEVICE_Init();
   MX_I2C1_Init();
   MX_TIM2_Init();
+  MX_SPI1_Init();
   /* USER CODE BEGIN 2 */
 	HAL_TIM_Base_Stop(&htim2);
-	HAL_Delay(500);//for usb set up
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;//DWT cycle counter for timing stats
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#ifdef JTEST_BENCH
+	Bench_Main();//DSP kernel benchmark image, never returns
+#endif
+	Log_Init();
+	Probe_Reset();
+	Tlm_Init();
 	OLED_Init();
-	while(mpu_dmp_init())//MPU DMPʼ
+	Param_Init();//tunables from flash, defaults if none
+	Imu_Pre_Init(NULL);//Q15 chain of MPU_Update()
+	MPU_Bus_Init(MPU_Restart);
+	if(MPU_Configure(1))//MPU DMPʼ
 	{
-	  printf("MPU6050 Error!!!\r\n");
-		HAL_I2C_DeInit(&hi2c1);
-		MX_I2C1_Init();
-		HAL_Delay(500);
-		HAL_GPIO_TogglePin(B_LED_GPIO_Port, B_LED_Pin);
-		
+		MPU_Bus_Fault();//retried with backoff by MPU_Bus_Poll()
 	}
-  printf("MPU6050 OK\r\n");
 	//usb_printf("MPU6050 OK\r\n");
 	OLED_Clear();
-	OLED_ShowString(0,0,"MPU6050 OK");
+	OLED_ShowString(0,0,MPU_Bus_Ready()?"MPU6050 OK":"MPU6050 Error");
 	OLED_ShowString(0,2,"Wait init...");
-	HAL_Delay(5000);//for MPU data stable
+	OLED_Refresh();
+	HAL_TIM_Base_Start_IT(&htim2);//timer start
+	Fast_Boot_Wait_Ready(&mpu_data);//until quaternion converges
 	OLED_ShowString(0,4,"Ready");
-	HAL_Delay(1000);
+	OLED_Refresh();
 	State_Machine_Init();
-	HAL_TIM_Base_Start_IT(&htim2);//timer start
+	Sched_Init();//TIM2 only releases the sensor task from now on
   /* USER CODE END 2 */
  
  
@@ -138,7 +162,7 @@ int main(void)
     /* USER CODE BEGIN 3 */
 		
 		/*main program*/
-		State_Update_Main();
+		Sched_Run();
   }
   /* USER CODE END 3 */
 }
@@ -186,7 +210,65 @@ void SystemClock_Config(void)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief  Configure MPU6050 and DMP (raw FIFO with FusionEnable) and apply
+	*					the calibration.
+	*	@param	boot	1: boot, the self test and the flash cache of
+	*									Fast_Boot_Calibrate() may run (seconds)
+	*								0: restart at run time, only the cached biases are
+	*									written back
+  * @retval 0: success
+  */
+uint8_t MPU_Configure(uint8_t boot)
+{
+#if FusionEnable
+	return MPU_Configured(mpu_raw_init(), boot);
+#else
+	return MPU_Configured(mpu_dmp_init(), boot);
+#endif
+}
 
+/**
+  * @brief  Log the result of mpu_raw_init()/mpu_dmp_init() and, on
+	*					success, apply the calibration and the sample rate
+	*	@param	res		result of the init, 0: success
+	*	@param	boot	as MPU_Configure()
+  * @retval 0: success
+  */
+uint8_t MPU_Configured(uint8_t res, uint8_t boot)
+{
+	if(res)
+	{
+		Log0(Log_Mpu_Error);
+		HAL_GPIO_TogglePin(B_LED_GPIO_Port, B_LED_Pin);
+		return 1;
+	}
+	Log0(Log_Mpu_Ok);
+	Fast_Boot_Calibrate(boot);//cached biases, self test only at boot
+	Param_Apply_Rate();//mpu_dmp_init() set DEFAULT_MPU_HZ
+#if FusionEnable
+	Fusion_Init(param.mpu_hz);//new tilt from the first sample after a restart
+#endif
+	return 0;
+}
+
+/**
+  * @brief  Restart callback of the bus recovery (MPU_Bus_Poll) when the
+	*					device lost its configuration. Until Fast_Boot_Wait_Ready()
+	*					is done the boot is still running and may calibrate, after
+	*					that the restart must stay within the step promised by
+	*					MPU_Bus_Poll(): no self test, no flash erase, no key.
+	*					The init runs one mpu_init_step() per call, the reset
+	*					waits and each DMP bank are separate steps.
+  * @retval 0: success, 1: failed, 2: not done, call again
+  */
+uint8_t MPU_Restart(void)
+{
+	uint8_t res = mpu_init_step(!FusionEnable);
+
+	if(res == MPU_INIT_BUSY) return 2;
+	return MPU_Configured(res, boot_ready_ms == 0);
+}
 /* USER CODE END 4 */
 
 /**
@@ -30,7 +30,10 @@
 
 #include "oled.h"
 #include "stdlib.h"
+#include "string.h"
 #include "oledfont.h" 
+#include "spi.h"
+#include "probe.h"
 
 
 //OLEDԴ
@@ -43,6 +46,45 @@
 //[5]0 1 2 3 ... 127	
 //[6]0 1 2 3 ... 127	
 //[7]0 1 2 3 ... 127 			   
+u8 OLED_GRAM[OLED_PAGES][X_WIDTH];
+//changed columns of each page since the last refresh, x0>x1: clean
+u8 oled_dirty_x0[OLED_PAGES];
+u8 oled_dirty_x1[OLED_PAGES];
+//panel contents as of the last flush: a screen cleared and drawn again
+//the same is dirty in OLED_GRAM but has nothing to send
+u8 oled_sent[OLED_PAGES][X_WIDTH];
+OLED_Stats_t oled_stats;
+
+//: SPI1 with DMA per page, or GPIO bit-bang
+u8 oled_spi;								//SPI1 in use
+volatile u8 oled_busy;			//flush in progress
+u8 oled_flush_page;					//page on the wire
+u8 oled_flush_x0[OLED_PAGES];	//dirty ranges taken by the flush
+u8 oled_flush_x1[OLED_PAGES];
+u8 oled_flush_pos[3];				//page address of the page on the wire, sent by DMA
+u8 oled_flush_data;					//position on the wire, the page data next
+u8 oled_lost;								//pages of the last flush not sent, one bit each
+u32 oled_flush_bytes;
+u32 oled_flush_start;				//DWT cycles
+void (*oled_flush_done)(void);
+
+void OLED_SPI_Write(const u8 *buf,unsigned short len,u8 cmd);
+u8 OLED_DMA_Write(const u8 *buf,unsigned short len,u8 cmd);
+void OLED_Flush_Lost(u8 i);
+void OLED_Flush_Next(void);
+
+//дһֽڵԴ, only changed bytes are marked dirty
+//x:0~127
+//y:page 0~7
+void OLED_Put(u8 x,u8 y,u8 dat)
+{
+	if(x>=X_WIDTH||y>=OLED_PAGES)return;
+	if(OLED_GRAM[y][x]==dat)return;
+	OLED_GRAM[y][x]=dat;
+	if(oled_dirty_x0[y]>oled_dirty_x1[y]){oled_dirty_x0[y]=x;oled_dirty_x1[y]=x;}
+	else if(x<oled_dirty_x0[y])oled_dirty_x0[y]=x;
+	else if(x>oled_dirty_x1[y])oled_dirty_x1[y]=x;
+}
 
 #if OLED_MODE==1
 //SSD1106дһֽڡ
@@ -68,6 +110,12 @@ void OLED_WR_Byte(u8 dat,u8 cmd)
 void OLED_WR_Byte(u8 dat,u8 cmd)
 {		  
 	u8 i;
+	if(oled_spi)
+	{
+		while(oled_busy);//DMAˢ
+		OLED_SPI_Write(&dat,1,cmd);
+		return;
+	}
 	if(cmd)
 	  OLED_DC_Set();
 	else 
@@ -111,16 +159,205 @@ void OLED_Display_Off(void)
 	OLED_WR_Byte(0XAE,OLED_CMD);  //DISPLAY OFF
 }		   			 
 //,,ĻǺɫ!ûһ!!!	  
+//clears the framebuffer, shown by OLED_Refresh()
 void OLED_Clear(void)  
 {  
 	u8 i,n;		    
 	for(i=0;i<8;i++)  
 	{  
-		OLED_WR_Byte (0xb0+i,OLED_CMD);    //ҳַ0~7
-		OLED_WR_Byte (0x00,OLED_CMD);      //ʾλáе͵ַ
-		OLED_WR_Byte (0x10,OLED_CMD);      //ʾλáиߵַ   
-		for(n=0;n<128;n++)OLED_WR_Byte(0,OLED_DATA); 
-	} //ʾ
+		for(n=0;n<128;n++)OLED_Put(n,i,0); 
+	}
+}
+
+//SPI, blocking, CS held low for the whole buffer. Main loop only,
+//the flush goes by OLED_DMA_Write()
+void OLED_SPI_Write(const u8 *buf,unsigned short len,u8 cmd)
+{
+	if(cmd)
+	  OLED_DC_Set();
+	else 
+	  OLED_DC_Clr();
+	OLED_CS_Clr();
+	HAL_SPI_Transmit(&hspi1,(u8*)buf,len,10);
+	OLED_CS_Set();
+	OLED_DC_Set();
+}
+
+//start a DMA transfer, CS stays low until HAL_SPI_TxCpltCallback()
+//ֵ: 0,started; 1,refused
+u8 OLED_DMA_Write(const u8 *buf,unsigned short len,u8 cmd)
+{
+	if(cmd)
+	  OLED_DC_Set();
+	else 
+	  OLED_DC_Clr();
+	OLED_CS_Clr();
+	if(HAL_SPI_Transmit_DMA(&hspi1,(u8*)buf,len)==HAL_OK)return 0;
+	OLED_CS_Set();
+	OLED_DC_Set();
+	return 1;
+}
+
+//page i of the flush not sent, the next flush takes it again
+void OLED_Flush_Lost(u8 i)
+{
+	oled_lost|=1<<i;
+	oled_flush_bytes-=oled_flush_x1[i]-oled_flush_x0[i]+1;
+	oled_stats.lost++;
+}
+
+//send the next taken page. On SPI the position and the page data both go
+//by DMA and HAL_SPI_TxCpltCallback() comes back here, nothing waits in
+//the interrupt. A page the DMA refuses is left to the next flush.
+void OLED_Flush_Next(void)
+{
+	u8 i,x,x0,x1;
+	u32 us;
+	if(oled_flush_data)
+	{//position is out, now the page data
+		oled_flush_data=0;
+		i=oled_flush_page-1;
+		x0=oled_flush_x0[i];
+		if(OLED_DMA_Write(&OLED_GRAM[i][x0],oled_flush_x1[i]-x0+1,OLED_DATA)==0)return;
+		OLED_Flush_Lost(i);
+	}
+	while(oled_flush_page<OLED_PAGES)
+	{
+		i=oled_flush_page++;
+		x0=oled_flush_x0[i];
+		x1=oled_flush_x1[i];
+		if(x0>x1)continue;
+		oled_flush_bytes+=x1-x0+1;
+		if(!oled_spi)
+		{
+			OLED_Set_Pos(x0,i);
+			for(x=x0;x<=x1;x++)OLED_WR_Byte(OLED_GRAM[i][x],OLED_DATA);
+			continue;
+		}
+		oled_flush_pos[0]=0xb0+i;//same as OLED_Set_Pos()
+		oled_flush_pos[1]=((x0&0xf0)>>4)|0x10;
+		oled_flush_pos[2]=(x0&0x0f)|0x01;
+		oled_flush_data=1;
+		if(OLED_DMA_Write(oled_flush_pos,3,OLED_CMD)==0)return;
+		oled_flush_data=0;
+		OLED_Flush_Lost(i);
+	}
+	us=(DWT->CYCCNT-oled_flush_start)/(SystemCoreClock/1000000);
+	oled_stats.flushes++;
+	oled_stats.bytes+=oled_flush_bytes;
+	oled_stats.bytes_last=oled_flush_bytes;
+	oled_stats.us_last=us;
+	if(us>oled_stats.us_max)oled_stats.us_max=us;
+	if(oled_flush_bytes==X_WIDTH*OLED_PAGES)oled_stats.us_full=us;
+	oled_busy=0;
+	if(oled_flush_done)oled_flush_done();
+}
+
+//DMA transfer done
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+	if(hspi!=&hspi1||!oled_busy)return;
+	OLED_CS_Set();
+	OLED_Flush_Next();
+}
+
+//transfer lost, the page goes to the next flush so this one never hangs
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+	if(hspi!=&hspi1||!oled_busy)return;
+	OLED_CS_Set();
+	oled_flush_data=0;
+	OLED_Flush_Lost(oled_flush_page-1);
+	OLED_Flush_Next();
+}
+
+//start sending the dirty column range of each page. Drawing may go on
+//while it runs, bytes changed meanwhile are sent by the next flush.
+//done: called when the last byte is out, from the DMA interrupt on SPI
+//ֵ: 0,started or nothing to send; 1,a flush is still running
+u8 OLED_Refresh_Async(void (*done)(void))
+{
+	u8 i,n=0,x0,x1;
+	if(oled_busy)return 1;
+	for(i=0;i<OLED_PAGES;i++)
+	{
+		x0=oled_dirty_x0[i];
+		x1=oled_dirty_x1[i];
+		oled_dirty_x0[i]=0xFF;
+		oled_dirty_x1[i]=0;
+		if(oled_lost&(1<<i))
+		{//not sent by the last flush, oled_sent is ahead of the panel
+			if(oled_flush_x0[i]<x0)x0=oled_flush_x0[i];
+			if(oled_flush_x1[i]>x1)x1=oled_flush_x1[i];
+		}
+		else
+		{
+			while(x0<=x1&&OLED_GRAM[i][x0]==oled_sent[i][x0])x0++;//trim to the bytes unlike the panel
+			while(x1>x0&&OLED_GRAM[i][x1]==oled_sent[i][x1])x1--;
+		}
+		if(x0>x1)
+		{
+			oled_flush_x0[i]=0xFF;
+			oled_flush_x1[i]=0;
+			continue;
+		}
+		x0&=~1;//OLED_Set_Pos() only places even columns exactly
+		memcpy(&oled_sent[i][x0],&OLED_GRAM[i][x0],x1-x0+1);
+		oled_flush_x0[i]=x0;
+		oled_flush_x1[i]=x1;
+		n++;
+	}
+	oled_lost=0;
+	if(n==0)
+	{
+		if(done)done();
+		return 0;
+	}
+	oled_flush_page=0;
+	oled_flush_bytes=0;
+	oled_flush_start=DWT->CYCCNT;
+	oled_flush_done=done;
+	oled_busy=1;
+	OLED_Flush_Next();
+	return 0;
+}
+
+//flush in progress
+u8 OLED_Busy(void)
+{
+	return oled_busy;
+}
+
+//send the dirty column range of each page and wait for it
+void OLED_Refresh(void)
+{
+	while(OLED_Refresh_Async(0));
+	while(oled_busy);
+}
+
+//
+//x:0~127
+//y:0~63
+//t:1  0,
+void OLED_DrawPoint(u8 x,u8 y,u8 t)
+{
+	u8 dat;
+	if(x>=X_WIDTH||y>=Y_WIDTH)return;
+	dat=OLED_GRAM[y/8][x];
+	if(t)dat|=1<<(y%8);
+	else dat&=~(1<<(y%8));
+	OLED_Put(x,y/8,dat);
+}
+
+//, x1,y1,x2,y2 inclusive
+//dot:0,;1,
+void OLED_Fill(u8 x1,u8 y1,u8 x2,u8 y2,u8 dot)
+{
+	u8 x,y;
+	for(x=x1;x<=x2&&x<X_WIDTH;x++)
+	{
+		for(y=y1;y<=y2&&y<Y_WIDTH;y++)OLED_DrawPoint(x,y,dot);
+	}
 }
 
 
@@ -136,17 +373,14 @@ void OLED_ShowChar(u8 x,u8 y,u8 chr)
 		if(x>Max_Column-1){x=0;y=y+2;}
 		if(SIZE ==16)
 			{
-			OLED_Set_Pos(x,y);	
 			for(i=0;i<8;i++)
-			OLED_WR_Byte(F8X16[c*16+i],OLED_DATA);
-			OLED_Set_Pos(x,y+1);
+			OLED_Put(x+i,y,F8X16[c*16+i]);
 			for(i=0;i<8;i++)
-			OLED_WR_Byte(F8X16[c*16+i+8],OLED_DATA);
+			OLED_Put(x+i,y+1,F8X16[c*16+i+8]);
 			}
 			else {	
-				OLED_Set_Pos(x,y+1);
 				for(i=0;i<6;i++)
-				OLED_WR_Byte(F6x8[c][i],OLED_DATA);
+				OLED_Put(x+i,y+1,F6x8[c][i]);
 				
 			}
 }
@@ -186,27 +420,27 @@ void OLED_ShowNum(u8 x,u8 y,u32 num,u8 len,u8 size)
 void OLED_ShowString(u8 x,u8 y,u8 *chr)
 {
 	unsigned char j=0;
+	Probe_Begin(Probe_Oled_String);
 	while (chr[j]!='\0')
 	{		OLED_ShowChar(x,y,chr[j]);
 			x+=8;
 		if(x>120){x=0;y+=2;}
 			j++;
 	}
+	Probe_End(Probe_Oled_String);
 }
 //ʾ
 void OLED_ShowCHinese(u8 x,u8 y,u8 no)
 {      			    
 	u8 t,adder=0;
-	OLED_Set_Pos(x,y);	
     for(t=0;t<16;t++)
 		{
-				OLED_WR_Byte(Hzk[2*no][t],OLED_DATA);
+				OLED_Put(x+t,y,Hzk[2*no][t]);
 				adder+=1;
      }	
-		OLED_Set_Pos(x,y+1);	
     for(t=0;t<16;t++)
 			{	
-				OLED_WR_Byte(Hzk[2*no+1][t],OLED_DATA);
+				OLED_Put(x+t,y+1,Hzk[2*no+1][t]);
 				adder+=1;
       }					
 }
@@ -220,10 +454,9 @@ void OLED_DrawBMP(unsigned char x0, unsigned char y0,unsigned char x1, unsigned
   else y=y1/8+1;
 	for(y=y0;y<y1;y++)
 	{
-		OLED_Set_Pos(x0,y);
     for(x=x0;x<x1;x++)
 	    {      
-	    	OLED_WR_Byte(BMP[j++],OLED_DATA);	    	
+	    	OLED_Put(x,y,BMP[j++]);	    	
 	    }
 	}
 } 
@@ -232,6 +465,21 @@ void OLED_DrawBMP(unsigned char x0, unsigned char y0,unsigned char x1, unsigned
 //ʼSSD1306					    
 void OLED_Init(void)
 { 	
+	u8 i;
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	
+	oled_spi=OLED_SPI&&hspi1.State==HAL_SPI_STATE_READY;
+	if(!oled_spi&&hspi1.State!=HAL_SPI_STATE_RESET)
+	{//fall back to bit-bang, SCK and MOSI back to GPIO
+		HAL_SPI_DeInit(&hspi1);
+		OLED_SCLK_Set();
+		OLED_SDIN_Set();
+		GPIO_InitStruct.Pin = LCD_SCK_Pin|LCD_MOSI_Pin;
+		GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+		GPIO_InitStruct.Pull = GPIO_NOPULL;
+		GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+		HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+	}
  
 /********* Unecessary for HAL
  	GPIO_InitTypeDef  GPIO_InitStructure;
@@ -305,7 +553,14 @@ void OLED_Init(void)
 	OLED_WR_Byte(0xAF,OLED_CMD);//--turn on oled panel
 	
 	OLED_WR_Byte(0xAF,OLED_CMD); /*display ON*/ 
+	for(i=0;i<OLED_PAGES;i++)//panel RAM is unknown, send the whole framebuffer
+	{
+		oled_dirty_x0[i]=0;
+		oled_dirty_x1[i]=X_WIDTH-1;
+	}
+	memset(oled_sent,0xFF,sizeof(oled_sent));
 	OLED_Clear();
+	OLED_Refresh();
 	OLED_Set_Pos(0,0); 	
 }  
 
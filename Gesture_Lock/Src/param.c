@@ -0,0 +1,343 @@
+/**
+  ******************************************************************************
+  * File Name          : param.c
+  * Description        : This file provides code for the persistent parameter
+	*											 table. Detector and timing tunables live in one RAM
+	*											 struct read directly by the detector, described by a
+	*											 typed table with defaults and limits, stored in flash
+	*											 as id/type/value entries and changed at run time by
+	*											 commands over USB CDC (cmd.c).
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "param.h"
+#include "main.h"
+#include "tim.h"
+#include "mpu6050.h"
+#include "inv_mpu_dmp_motion_driver.h"
+#include "fusion.h"
+#include "state_machine.h"
+#include "stddef.h"
+#include "string.h"
+#include "math.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define ParamTimerClk		980000	//TIM2 reload = ParamTimerClk/rate, 9800 at 100Hz,
+																//polls a bit faster than the DMP so the FIFO stays empty
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct{
+	uint8_t		type;
+	uint16_t	offset;		//in Param_t
+	float			min;
+	float			max;
+	float			def;
+} Param_Desc_t;
+
+
+/* Private variables ---------------------------------------------------------*/
+Param_t param;
+
+//indexed by Param_Id_t
+const Param_Desc_t param_desc[Param_Num] = {
+	{Param_U32, offsetof(Param_t, motion_gap_time),		500,		60000,	5000},
+	{Param_U32, offsetof(Param_t, motion_dur_time),		100,		10000,	1000},
+	{Param_U32, offsetof(Param_t, acc_peak_gap_time),	20,			5000,		300},
+	{Param_F32, offsetof(Param_t, motion_peak_th),		0.05f,	4.0f,		0.50f},
+	{Param_U8,	offsetof(Param_t, peak_samp_num),			1,			50,			3},
+	{Param_F32, offsetof(Param_t, peak_max_pre),			0.1f,		1.0f,		0.8f},
+	{Param_U8,	offsetof(Param_t, min_seq_len),				1,			SeqLength,3},
+#if FusionEnable
+	{Param_U16, offsetof(Param_t, mpu_hz),						10,			FusionHzMax,DEFAULT_MPU_HZ},
+#else
+	{Param_U16, offsetof(Param_t, mpu_hz),						10,			200,		DEFAULT_MPU_HZ},
+#endif
+};
+
+Param_Header_t	*param_flash = (Param_Header_t*)ParamFlashAddr;
+uint8_t					param_rate_dirty;
+/* Private function prototypes -----------------------------------------------*/
+uint32_t Param_Checksum(const Param_Entry_t *e, uint16_t count);
+int Param_Check(uint8_t id, uint32_t raw);
+void Param_Write(uint8_t id, uint32_t raw);
+uint32_t Param_Read(uint8_t id);
+uint32_t Param_Float_Raw(float f);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  checksum of stored entries
+	*	@param	e			first entry
+	*	@param	count	number of entries
+  * @retval checksum
+  */
+uint32_t Param_Checksum(const Param_Entry_t *e, uint16_t count){
+	const uint32_t *p = (const uint32_t*)e;
+	uint32_t sum = 0;
+	uint32_t i;
+	for(i=0;i<count*sizeof(Param_Entry_t)/sizeof(uint32_t);i++){
+		sum += p[i];
+	}
+	return ~sum;
+}
+
+/**
+  * @brief  raw bits of a float
+  * @retval raw value
+  */
+uint32_t Param_Float_Raw(float f){
+	uint32_t raw;
+	memcpy(&raw, &f, sizeof(raw));
+	return raw;
+}
+
+/**
+  * @brief  check a raw value against the table limits
+	*	@param	id		parameter id
+	*	@param	raw		raw bits of the typed value
+  * @retval Param_Status_t
+  */
+int Param_Check(uint8_t id, uint32_t raw){
+	const Param_Desc_t *d;
+	float v;
+
+	if(id >= Param_Num) return Param_Err_Id;
+	d = &param_desc[id];
+	if(d->type == Param_F32){
+		memcpy(&v, &raw, sizeof(v));
+		if(isnan(v)) return Param_Err_Range;
+	}
+	else{
+		v = (float)raw;
+	}
+	if(v < d->min || v > d->max) return Param_Err_Range;
+	return Param_OK;
+}
+
+/**
+  * @brief  store a checked raw value in the RAM table
+	*	@param	id		parameter id
+	*	@param	raw		raw bits of the typed value
+  * @retval None
+  */
+void Param_Write(uint8_t id, uint32_t raw){
+	uint8_t *p = (uint8_t*)&param + param_desc[id].offset;
+	switch(param_desc[id].type){
+		case Param_U8:	*(uint8_t*)p = (uint8_t)raw;		break;
+		case Param_U16:	*(uint16_t*)p = (uint16_t)raw;	break;
+		default:				memcpy(p, &raw, sizeof(raw));		break;
+	}
+}
+
+/**
+  * @brief  raw value of a parameter in the RAM table
+	*	@param	id		parameter id
+  * @retval raw bits of the typed value
+  */
+uint32_t Param_Read(uint8_t id){
+	const uint8_t *p = (const uint8_t*)&param + param_desc[id].offset;
+	uint32_t raw;
+	switch(param_desc[id].type){
+		case Param_U8:	raw = *(const uint8_t*)p;		break;
+		case Param_U16:	raw = *(const uint16_t*)p;	break;
+		default:				memcpy(&raw, p, sizeof(raw));	break;
+	}
+	return raw;
+}
+
+/**
+  * @brief  Load defaults into the RAM table
+  * @retval int
+  */
+int Param_Default(void){
+	uint8_t id;
+	for(id=0;id<Param_Num;id++){
+		if(param_desc[id].type == Param_F32){
+			Param_Write(id, Param_Float_Raw(param_desc[id].def));
+		}
+		else{
+			Param_Write(id, (uint32_t)param_desc[id].def);
+		}
+	}
+	param_rate_dirty = 1;
+	return 0;
+}
+
+/**
+  * @brief  Load the table: defaults first, then every stored entry whose
+	*					id and type are known and whose value is in range. Records
+	*					from older or newer table versions load what they share.
+  * @retval int
+	*					0: stored values loaded
+	*					1: no valid record, defaults only
+  */
+int Param_Init(void){
+	const Param_Entry_t *e = (const Param_Entry_t*)(param_flash + 1);
+	uint16_t i;
+
+	Param_Default();
+	if(param_flash->magic != ParamMagic) return 1;
+	if(param_flash->count > ParamMaxStore) return 1;
+	if(param_flash->checksum != Param_Checksum(e, param_flash->count)) return 1;
+	for(i=0;i<param_flash->count;i++){
+		if(e[i].id >= Param_Num) continue;
+		if(e[i].type != param_desc[e[i].id].type) continue;
+		if(Param_Check(e[i].id, e[i].value) != Param_OK) continue;
+		Param_Write(e[i].id, e[i].value);
+	}
+	return 0;
+}
+
+/**
+  * @brief  Write the RAM table to flash
+  * @retval Param_Status_t
+  */
+int Param_Save(void){
+	Param_Entry_t e[Param_Num];
+	Param_Header_t h;
+	const uint32_t *p;
+	uint32_t addr = ParamFlashAddr;
+	uint32_t i, err = 0;
+
+	for(i=0;i<Param_Num;i++){
+		e[i].id = i;
+		e[i].type = param_desc[i].type;
+		e[i].reserved = 0;
+		e[i].value = Param_Read(i);
+	}
+	h.magic = ParamMagic;
+	h.version = ParamVersion;
+	h.count = Param_Num;
+	h.checksum = Param_Checksum(e, Param_Num);
+
+	HAL_FLASH_Unlock();
+	FLASH_Erase_Sector(ParamFlashSector, FLASH_VOLTAGE_RANGE_3);
+	FLASH_WaitForLastOperation(1000);
+	p = (const uint32_t*)&h;
+	for(i=0;i<sizeof(h)/sizeof(uint32_t);i++,addr+=4){
+		err |= HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, p[i]) != HAL_OK;
+	}
+	p = (const uint32_t*)e;
+	for(i=0;i<Param_Num*sizeof(Param_Entry_t)/sizeof(uint32_t);i++,addr+=4){
+		err |= HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, p[i]) != HAL_OK;
+	}
+	HAL_FLASH_Lock();
+	return err ? Param_Err_Flash : Param_OK;
+}
+
+/**
+  * @brief  Change a parameter at run time. Takes effect on the next
+	*					sample; the sampling rate is applied by Param_Poll().
+	*	@param	id		parameter id
+	*	@param	raw		raw bits of the typed value
+  * @retval Param_Status_t
+  */
+int Param_Set(uint8_t id, uint32_t raw){
+	int res = Param_Check(id, raw);
+	if(res != Param_OK) return res;
+	Param_Write(id, raw);
+	if(id == Param_Mpu_Hz) param_rate_dirty = 1;
+	return Param_OK;
+}
+
+/**
+  * @brief  Read a parameter
+	*	@param	id		parameter id
+	*	@param	type	Param_Type_t of the value
+	*	@param	raw		raw bits of the typed value
+  * @retval Param_Status_t
+  */
+int Param_Get(uint8_t id, uint8_t *type, uint32_t *raw){
+	if(id >= Param_Num) return Param_Err_Id;
+	*type = param_desc[id].type;
+	*raw = Param_Read(id);
+	return Param_OK;
+}
+
+/**
+  * @brief  Apply param.mpu_hz to the DMP output rate (the sample rate and
+	*					fusion step with FusionEnable) and the TIM2 poll period.
+	*					TIM2 is masked while the DMP is written since its ISR uses
+	*					the same bus. Call from the main loop only.
+  * @retval int
+  */
+int Param_Apply_Rate(void){
+	int res;
+	HAL_NVIC_DisableIRQ(TIM2_IRQn);
+#if FusionEnable
+	res = mpu_set_sample_rate(param.mpu_hz);
+	Fusion_Set_Rate(param.mpu_hz);
+#else
+	res = dmp_set_fifo_rate(param.mpu_hz);
+#endif
+	__HAL_TIM_SET_AUTORELOAD(&htim2, ParamTimerClk/param.mpu_hz);
+	HAL_NVIC_EnableIRQ(TIM2_IRQn);
+	param_rate_dirty = 0;
+	return res;
+}
+
+/**
+  * @brief  Handle one parameter function, values are big endian.
+	*					Called by the command protocol.
+	*	@param	func	function code
+	*	@param	data	payload
+	*	@param	len		payload bytes
+	*	@param	out		reply payload, ParamFrameMax bytes
+  * @retval reply bytes
+  */
+uint8_t Param_Command(uint8_t func, const uint8_t *data, uint8_t len, uint8_t *out){
+	uint8_t n = 0, id, type;
+	uint32_t raw;
+
+	switch(func){
+		case ParamFuncGet:
+			if(len != 1) break;
+			for(id=0;id<Param_Num;id++){
+				if(data[0] != ParamIdAll && data[0] != id) continue;
+				Param_Get(id, &type, &raw);
+				out[n++] = id;
+				out[n++] = type;
+				out[n++] = raw>>24;
+				out[n++] = raw>>16;
+				out[n++] = raw>>8;
+				out[n++] = raw;
+			}
+			if(n == 0){//2 byte reply: id, status
+				out[n++] = data[0];
+				out[n++] = Param_Err_Id;
+			}
+			return n;
+		case ParamFuncSet:
+			if(len != 5) break;
+			raw = ((uint32_t)data[1]<<24)|((uint32_t)data[2]<<16)|((uint32_t)data[3]<<8)|data[4];
+			out[n++] = data[0];
+			out[n++] = Param_Set(data[0], raw);
+			return n;
+		case ParamFuncSave:
+			out[n++] = Param_Save();
+			return n;
+		case ParamFuncDefault:
+			Param_Default();
+			out[n++] = Param_OK;
+			return n;
+		default:
+			break;
+	}
+	out[n++] = Param_Err_Frame;
+	return n;
+}
+
+/**
+  * @brief  Parameter service, call from the main loop. Applies a new
+	*					sampling rate once the MPU bus is usable.
+  * @retval None
+  */
+void Param_Poll(void){
+	if(param_rate_dirty && MPU_Bus_Ready()){
+		Param_Apply_Rate();
+	}
+}
@@ -0,0 +1,121 @@
+/**
+  ******************************************************************************
+  * File Name          : probe.c
+  * Description        : This file provides code for the cycle probes. The
+	*											 counters are read by the upper machine with CmdProbe
+	*											 over USB CDC, or sent on the UART telemetry with
+	*											 Probe_Dump_Uart(). On the host Probe_Print() lists
+	*											 them.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "probe.h"
+#include "string.h"
+#ifdef PROBE_HOST
+#include "stdio.h"
+#else
+#include "telemetry.h"
+#endif
+
+/* Private macro -------------------------------------------------------------*/
+#define PROBE_NAME(id, name)	name,
+#define ProbePackSize		(1+4*4+4*ProbeBins)
+
+/* Private variables ---------------------------------------------------------*/
+volatile uint32_t	probe_start[Probe_Num];
+Probe_Stats_t			probe_stats[Probe_Num];
+
+//indexed by Probe_Id_t
+const char *const	probe_name[Probe_Num] = {
+	PROBE_TABLE(PROBE_NAME)
+};
+/* Private function prototypes -----------------------------------------------*/
+uint8_t *Probe_Put32(uint8_t *p, uint32_t v);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Clear all counters
+  * @retval None
+  */
+void Probe_Reset(void){
+	uint8_t i;
+	memset(probe_stats, 0, sizeof(probe_stats));
+	for(i=0;i<Probe_Num;i++) probe_stats[i].min = 0xFFFFFFFF;
+}
+
+/**
+  * @brief  put a big endian word
+  * @retval next byte
+  */
+uint8_t *Probe_Put32(uint8_t *p, uint32_t v){
+	*p++ = v>>24;
+	*p++ = v>>16;
+	*p++ = v>>8;
+	*p++ = v;
+	return p;
+}
+
+/**
+  * @brief  Counters of one probe, big endian: id, count, min, max, mean,
+	*					then the histogram bins
+	*	@param	id		Probe_Id_t
+	*	@param	out		ProbePackSize bytes
+  * @retval bytes, 0: unknown id
+  */
+uint8_t Probe_Pack(uint8_t id, uint8_t *out){
+	const Probe_Stats_t *s;
+	uint8_t *p = out;
+	uint8_t i;
+
+	if(id >= Probe_Num) return 0;
+	s = &probe_stats[id];
+	*p++ = id;
+	p = Probe_Put32(p, s->count);
+	p = Probe_Put32(p, s->count ? s->min : 0);
+	p = Probe_Put32(p, s->max);
+	p = Probe_Put32(p, s->count ? (uint32_t)(s->sum / s->count) : 0);
+	for(i=0;i<ProbeBins;i++) p = Probe_Put32(p, s->hist[i]);
+	return p - out;
+}
+
+#ifdef PROBE_HOST
+/**
+  * @brief  List all probes on stdout, times in ns
+  * @retval None
+  */
+void Probe_Print(void){
+	const Probe_Stats_t *s;
+	uint8_t i;
+	for(i=0;i<Probe_Num;i++){
+		s = &probe_stats[i];
+		if(s->count == 0) continue;
+		printf("%-24s n=%u min=%u max=%u mean=%u\n", probe_name[i], (unsigned)s->count,
+					(unsigned)s->min, (unsigned)s->max, (unsigned)(s->sum / s->count));
+	}
+}
+#else
+/**
+  * @brief  Send every probe on the UART telemetry, one frame each:
+	*					0x88, 0xA4, len, Probe_Pack(), sum. Dropped if the ring
+	*					is full.
+  * @retval None
+  */
+void Probe_Dump_Uart(void){
+	uint8_t buf[3+ProbePackSize+1];
+	uint8_t i, k, n;
+	for(i=0;i<Probe_Num;i++){
+		buf[0] = 0x88;//start of frame
+		buf[1] = 0xA4;//function
+		n = Probe_Pack(i, &buf[3]);
+		buf[2] = n;
+		buf[n+3] = 0;//check sum
+		for(k=0;k<n+3;k++) buf[n+3] += buf[k];
+		Tlm_Write(buf, n+4);
+	}
+}
+#endif
@@ -0,0 +1,282 @@
+/**
+  ******************************************************************************
+  * File Name          : sched.c
+  * Description        : This file provides code for the cooperative task
+	*											 scheduler of the main loop. Tasks run to completion,
+	*											 released either by a period or by Sched_Release()
+	*											 (also from an ISR). The ready task with the earliest
+	*											 deadline runs first. Run time, release latency and
+	*											 missed deadlines are measured with the DWT cycle
+	*											 counter.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sched.h"
+#include "mpu6050.h"
+#include "mpubus.h"
+#include "param.h"
+#include "serial_debug.h"
+#include "state_machine.h"
+#include "oled.h"
+#include "telemetry.h"
+#include "cdc_stream.h"
+#include "cmd.h"
+#include "logger.h"
+#include "probe.h"
+#include "string.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define Sched_Cycles()		(DWT->CYCCNT)
+#define Sched_Before(a,b)	((int32_t)((a)-(b)) < 0)	//wrap safe
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct{
+	void			(*run)(void);
+	uint16_t	period;			//ms, 0: released by Sched_Release() only
+	uint16_t	deadline;		//ms after release
+} Sched_Task_t;
+
+typedef struct{
+	volatile uint8_t	ready;
+	uint32_t					release;		//cycles
+	uint32_t					due;				//cycles, absolute deadline
+	uint32_t					next_tick;	//next periodic release, HAL tick
+} Sched_Slot_t;
+
+/* Private variables ---------------------------------------------------------*/
+extern volatile MPU_Data_t mpu_data;
+
+Sched_Slot_t		sched_slot[Task_Num];
+Sched_Stats_t		sched_stats[Task_Num];
+uint32_t				sched_cyc_ms;			//cycles per ms
+uint32_t				sched_stats_start;	//HAL tick of the last stats reset
+uint8_t					sched_started;
+/* Private function prototypes -----------------------------------------------*/
+void Sched_Account(uint8_t id, uint32_t start, uint32_t end);
+void Task_Sensor_Run(void);
+void Task_Detect_Run(void);
+void Task_UI_Run(void);
+void Task_Telemetry_Run(void);
+void Task_Storage_Run(void);
+
+/* Task table ----------------------------------------------------------------*/
+//indexed by Sched_Task_Id_t
+const Sched_Task_t sched_task[Task_Num] = {
+	//run								period	deadline
+	{Task_Sensor_Run,			0,			5},
+	{Task_Detect_Run,			0,			10},
+	{Task_UI_Run,					10,			20},
+	{Task_Telemetry_Run,	0,			20},
+	{Task_Storage_Run,		20,			200},
+};
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Tasks
+  * @retval None
+  */
+void Task_Sensor_Run(void){
+	uint8_t res;
+	MPU_Bus_Poll();
+	Probe_Begin(Probe_Mpu_Update);
+	res = MPU_Update((MPU_Data_t*)&mpu_data);
+	Probe_End(Probe_Mpu_Update);
+	if(res == 0){
+		Sched_Release(Task_Detect);
+		Sched_Release(Task_Telemetry);
+	}
+}
+
+void Task_Detect_Run(void){
+	State_Update_Motion();
+	Probe_End(Probe_Sample_Latency);
+}
+
+void Task_UI_Run(void){
+	State_Update_UI();
+	OLED_Refresh_Async(0);		//screens drawn by any task since the last run
+}
+
+void Task_Telemetry_Run(void){
+	Plot_Data();
+	Cmd_Trace_Put();
+	if(cdc_stream_on) Stream_Data();
+	Tlm_Poll();
+	Cmd_Poll();
+	Cdc_Poll();
+}
+
+void Task_Storage_Run(void){
+	Tlm_Poll();			//partial batch when samples stop
+	Cmd_Poll();			//requests while no samples come
+	Log_Poll();
+	Cdc_Poll();
+	Param_Poll();
+	State_Update_Storage();
+}
+
+/**
+  * @brief  Start the scheduler, the DWT cycle counter must be running.
+	*					From now on the TIM2 ISR only releases Task_Sensor.
+  * @retval None
+  */
+void Sched_Init(void){
+	uint8_t i;
+	uint32_t now = HAL_GetTick();
+
+	sched_cyc_ms = SystemCoreClock/1000;
+
+	for(i=0;i<Task_Num;i++){
+		sched_slot[i].ready = 0;
+		sched_slot[i].next_tick = now + sched_task[i].period;
+	}
+	Sched_Reset_Stats();
+	sched_started = 1;
+}
+
+/**
+  * @brief  check if the scheduler runs the tasks
+  * @retval uint8_t
+  */
+uint8_t Sched_Started(void){
+	return sched_started;
+}
+
+/**
+  * @brief  Make a task ready, safe from an ISR. A task released again
+	*					before it ran keeps its first release time.
+	*	@param	id		Sched_Task_Id_t
+  * @retval uint8_t
+	*					0: not started or bad id
+	*					1: released
+  */
+uint8_t Sched_Release(uint8_t id){
+	uint32_t primask, now;
+
+	if(!sched_started || id >= Task_Num) return 0;
+	now = Sched_Cycles();
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(sched_slot[id].ready){
+		sched_stats[id].overruns++;
+	}
+	else{
+		sched_slot[id].release = now;
+		sched_slot[id].due = now + sched_task[id].deadline*sched_cyc_ms;
+		sched_slot[id].ready = 1;
+	}
+	__set_PRIMASK(primask);
+	return 1;
+}
+
+/**
+  * @brief  record one run of a task
+	*	@param	id		task
+	*	@param	start	cycles
+	*	@param	end		cycles
+  * @retval None
+  */
+void Sched_Account(uint8_t id, uint32_t start, uint32_t end){
+	Sched_Stats_t *st = &sched_stats[id];
+	uint32_t run = end - start;
+	uint32_t lat = start - sched_slot[id].release;
+
+	st->runs++;
+	st->run_total += run;
+	if(run > st->run_max) st->run_max = run;
+	if(lat > st->latency_max) st->latency_max = lat;
+	if(Sched_Before(sched_slot[id].due, end)) st->missed++;
+}
+
+/**
+  * @brief  Release due periodic tasks and run the ready task with the
+	*					earliest deadline. Call from the main loop.
+  * @retval uint8_t
+	*					0: idle
+	*					1: a task ran
+  */
+uint8_t Sched_Run(void){
+	uint32_t now = HAL_GetTick();
+	uint32_t start, end;
+	uint8_t i, id = Task_Num;
+
+	for(i=0;i<Task_Num;i++){
+		if(sched_task[i].period && (int32_t)(now - sched_slot[i].next_tick) >= 0){
+			sched_slot[i].next_tick += sched_task[i].period;
+			if((int32_t)(now - sched_slot[i].next_tick) >= 0){//fell behind, skip
+				sched_slot[i].next_tick = now + sched_task[i].period;
+			}
+			Sched_Release(i);
+		}
+	}
+	for(i=0;i<Task_Num;i++){
+		if(!sched_slot[i].ready) continue;
+		if(id == Task_Num || Sched_Before(sched_slot[i].due, sched_slot[id].due)) id = i;
+	}
+	if(id == Task_Num) return 0;
+
+	start = Sched_Cycles();
+	sched_slot[id].ready = 0;		//a release while running counts again
+	sched_task[id].run();
+	end = Sched_Cycles();
+	Sched_Account(id, start, end);
+	return 1;
+}
+
+/**
+  * @brief  Clear the statistics of all tasks
+  * @retval None
+  */
+void Sched_Reset_Stats(void){
+	memset(sched_stats, 0, sizeof(sched_stats));
+	sched_stats_start = HAL_GetTick();
+}
+
+/**
+  * @brief  Statistics of a task
+	*	@param	id		Sched_Task_Id_t
+  * @retval stats, NULL for a bad id
+  */
+const Sched_Stats_t *Sched_Get_Stats(uint8_t id){
+	if(id >= Task_Num) return 0;
+	return &sched_stats[id];
+}
+
+/**
+  * @brief  Pack the statistics for the upper machine, SchedStatsBytes
+	*					per task, big endian: runs(4), load permille(2), max run
+	*					us(2), max latency us(2), missed(2). us values saturate.
+	*	@param	out		Task_Num*SchedStatsBytes bytes
+  * @retval bytes written
+  */
+uint8_t Sched_Stats_Pack(uint8_t *out){
+	const Sched_Stats_t *st;
+	uint32_t elapsed = HAL_GetTick() - sched_stats_start;
+	uint32_t cyc_us = sched_cyc_ms/1000;
+	uint32_t v[4];
+	uint8_t i, j, n = 0;
+
+	if(elapsed == 0) elapsed = 1;
+	for(i=0;i<Task_Num;i++){
+		st = &sched_stats[i];
+		out[n++] = st->runs>>24;
+		out[n++] = st->runs>>16;
+		out[n++] = st->runs>>8;
+		out[n++] = st->runs;
+		v[0] = (uint32_t)(st->run_total/sched_cyc_ms*1000/elapsed);
+		v[1] = st->run_max/cyc_us;
+		v[2] = st->latency_max/cyc_us;
+		v[3] = st->missed;
+		for(j=0;j<4;j++){
+			if(v[j] > 0xFFFF) v[j] = 0xFFFF;
+			out[n++] = v[j]>>8;
+			out[n++] = v[j];
+		}
+	}
+	return n;
+}
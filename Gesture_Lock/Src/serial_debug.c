@@ -14,18 +14,22 @@
 #include <stdio.h>
 #include "serial_debug.h"
 #include "mpu6050.h"
+#include "telemetry.h"
+#include "cmd.h"
 
 
 
 #ifdef SERIAL_DEBUG
 
 /**
-  * @brief  For redirecting printf to UART1
+  * @brief  For redirecting printf to UART1, queued on the telemetry
+	*					ring, dropped if it is full
   * @retval int
   */
 int fputc(int ch, FILE *f)
 {
-  HAL_UART_Transmit(&huart1, (uint8_t *)&ch, 1, 0xffff);
+  uint8_t c = ch;
+  Tlm_Write(&c, 1);
   return ch;
 }
 
@@ -43,8 +47,11 @@ int fgetc(FILE *f)
 #endif
 
 /**
-  * @brief  send data to Upper machine via UART1
+  * @brief  send data to Upper machine via UART1, queued on the
+	*					telemetry ring, never waits
   * @retval int
+	*					0: queued
+	*					1: dropped, link saturated
   */
 extern MPU_Data_t mpu_data;
 int Plot_Data(void){
@@ -101,8 +108,40 @@ int Plot_Data(void){
 	for(i=0;i<15;i++) buf[15]+=buf[i];
 	buf[16] = 0;//end of string
 
-	HAL_UART_Transmit(&huart1, (uint8_t *)&buf, 16, 0xffff);
+	return Tlm_Write(buf, 16);
+}
+
+/**
+  * @brief  put a big endian value in a frame
+	*	@param	p			destination
+	*	@param	v			value
+	*	@param	n			bytes, 2 or 4
+  * @retval next byte
+  */
+uint8_t *Put_BE(uint8_t *p, uint32_t v, uint8_t n){
+	while(n--) *p++ = (uint8_t)(v>>(8*n));
+	return p;
+}
 
-	return 0;
+/**
+  * @brief  stream one raw sample to the upper machine via USB CDC as a
+	*					CmdSample frame (cmd.h): accel and gyro raw (int16) then
+	*					quaternion (int32, q30), big endian
+  * @retval int
+	*					0: queued
+	*					1: dropped, link saturated or down
+  */
+int Stream_Data(void){
+	uint8_t buf[28];
+	uint8_t *p = &buf[0];
+	uint8_t i;
+	p = Put_BE(p, (uint16_t)mpu_data.Accel_X_RAW, 2);
+	p = Put_BE(p, (uint16_t)mpu_data.Accel_Y_RAW, 2);
+	p = Put_BE(p, (uint16_t)mpu_data.Accel_Z_RAW, 2);
+	p = Put_BE(p, (uint16_t)mpu_data.Gyro_X_RAW, 2);
+	p = Put_BE(p, (uint16_t)mpu_data.Gyro_Y_RAW, 2);
+	p = Put_BE(p, (uint16_t)mpu_data.Gyro_Z_RAW, 2);
+	for(i=0;i<4;i++) p = Put_BE(p, (uint32_t)(int32_t)(mpu_data.q[i]*1073741824.0f), 4);
+	return Cmd_Send(CmdSample, 0, buf, sizeof(buf));
 }
 
@@ -18,41 +18,76 @@
 #include "main.h"
 #include "oled.h"
 #include "mpu6050.h"
+#include "param.h"
+#include "key.h"
 #include "math.h"
 #include "stdio.h"
+#include "logger.h"
+#include "probe.h"
+#include "string.h"
 
 extern MPU_Data_t mpu_data;
 
 /* Private macro -------------------------------------------------------------*/
-#define Key_Pressed			HAL_GPIO_ReadPin(KEY_GPIO_Port,KEY_Pin)==0
-#define ShortPressMax		1000 //ms
+#define GestureHoldoff	200	//ms, motion ignored after a gesture to avoid overlap
+#define GestureMax			18	//gesture numbers are 1 to GestureMax
 
-#define MotionGapTime   5000 //ms 
-#define MotionDurTime		1000//ms
-#define AccPeakGapTime	300//ms
+//detector and timing tunables are in param (param.h)
 
-//peak detect theshold
-#define MotionPeakTH		0.50f//g
-
-#define PeakSampNum			3	//how many samples over theshold to conform a peak
-#define PeakMaxPre			0.8f	// if peaks at other axis smaller than the motion_axis_max*PeakMaxPre, motion is valid
-
-#define MinSeqLen				3
 #define FlashAddr				0x08010000//sector 4
 #define FlashSector			FLASH_SECTOR_4
-
-#define dbg 						1
+#define FlashSize				0x10000		//64 KB
+#define FlashSlots			(FlashSize/sizeof(Gesture_Seq_t))	//key records in the sector, appended
+#define FlashBootFree		64				//free records kept at boot, the sector is erased below
+#define FlashStoreStep	16				//bytes programmed per storage run, 16 us each
 
 /* Private typedef -----------------------------------------------------------*/
 typedef enum{
-	Standby = 0x00U,
-	Unlock  = 0x01U,
-	Record  = 0x02U
+	Root = 0x00U,		//top, handles nothing
+	Standby,
+	Input,					//super state of Unlock and Record, gesture input
+	Unlock,
+	Record,
+	Message,				//super state of timed screens, back to Standby on timeout
+	Unlock_First,
+	Checking,
+	Match,
+	Unlocked,
+	Fail,
+	Saving,
+	Saved,
+	Too_Short,
+	Save_Fail,
+	State_Num
 } GL_Mode;
 
+typedef enum{
+	Ev_Key_Short = 0x00U,
+	Ev_Key_Long,
+	Ev_Gesture,			//new gesture appended to g_seq
+	Ev_Gap,					//no gesture for param.motion_gap_time
+	Ev_Timer				//UI timer expired
+} GL_Event;
+
+typedef struct{
+	GL_Mode		state;
+	GL_Event	event;
+	int				(*guard)(void);		//NULL: always taken
+	void			(*action)(void);	//NULL: none
+	GL_Mode		next;							//Root: internal transition, no entry
+} GL_Trans_t;
+
 typedef struct{
 	GL_Mode 	state;
-	uint32_t	updateTime;
+	uint32_t	updateTime;		//mode entry or last gesture
+	uint32_t	timerStart;
+	uint32_t	timerLen;			//UI timer, 0: stopped
+	uint32_t	holdoffStart;
+	uint8_t		holdoff;			//ignoring motion after a gesture
+	uint8_t		save_pending;	//key sequence waiting for the storage task
+	uint8_t		enroll_pending;	//key from a command waiting for the storage task
+	uint8_t		save_failed;	//last key sequence not written, flash error
+	uint8_t		storing;			//a key record is being programmed
 	uint8_t		is_unlocked;
 } Main_State_t;
 
@@ -80,32 +115,127 @@ typedef struct{
 Main_State_t		main_state;
 Motion_State_t	motion_state;
 Gesture_Seq_t		g_seq;
-Gesture_Seq_t		*key = (Gesture_Seq_t*)FlashAddr;
+Gesture_Seq_t		enroll_seq;
+Gesture_Seq_t		*key = (Gesture_Seq_t*)FlashAddr;	//last key record in flash
+Gesture_Seq_t		flash_store;					//record being programmed
+uint16_t				flash_next;						//first free record
+int16_t					flash_store_pos;			//next byte of flash_store.seq, -1: erase failed
 /* Private function prototypes -----------------------------------------------*/
 void Standby_Print(Main_State_t* s);
+int State_In(GL_Mode super);
+int State_Dispatch(GL_Event ev);
+void State_Enter(GL_Mode st);
+void UI_Timer_Start(uint32_t ms);
+int Is_Unlocked(void);
+int Seq_Long_Enough(void);
+int Save_Failed(void);
+int Save_Busy(void);
+void Gesture_Show(void);
+void Saving_Wait(void);
+void Input_Start(void);
+void Enter_Standby(void);
+void Enter_Unlock(void);
+void Enter_Record(void);
+void Enter_Unlock_First(void);
+void Enter_Checking(void);
+void Enter_Match(void);
+void Enter_Unlocked(void);
+void Enter_Fail(void);
+void Enter_Saving(void);
+void Enter_Saved(void);
+void Enter_Too_Short(void);
+void Enter_Save_Fail(void);
 int Motion_Detect_Buf_Init(Motion_Detect_Buf_t* mdb);
 int Motion_State_Init(Motion_State_t* ms);
 int Main_State_Init(Main_State_t* s);
 int Gesture_Seq_Init(Gesture_Seq_t* g);
+void Flash_Scan(void);
+void Flash_Store_Start(const Gesture_Seq_t *k);
+int Flash_Store_Step(void);
+int Flash_Save_Seq(Gesture_Seq_t* k);
 int Flash_Init(void);
 int Motion_Seq_Print(void);
-int Motion_Seq_Save(void);
+int Motion_Seq_Log(void);
 int Motion_Seq_Check(void);
+
+/* State tables --------------------------------------------------------------*/
+//parent of each state, events not handled by a state go to its parent
+const GL_Mode gl_parent[State_Num] = {
+	Root,			//Root
+	Root,			//Standby
+	Root,			//Input
+	Input,		//Unlock
+	Input,		//Record
+	Root,			//Message
+	Message,	//Unlock_First
+	Message,	//Checking
+	Message,	//Match
+	Message,	//Unlocked
+	Message,	//Fail
+	Message,	//Saving
+	Message,	//Saved
+	Message,	//Too_Short
+	Message		//Save_Fail
+};
+
+//entry action of each state, draws the screen and arms the UI timer
+void (*const gl_entry[State_Num])(void) = {
+	0,										//Root
+	Enter_Standby,				//Standby
+	0,										//Input
+	Enter_Unlock,					//Unlock
+	Enter_Record,					//Record
+	0,										//Message
+	Enter_Unlock_First,		//Unlock_First
+	Enter_Checking,				//Checking
+	Enter_Match,					//Match
+	Enter_Unlocked,				//Unlocked
+	Enter_Fail,						//Fail
+	Enter_Saving,					//Saving
+	Enter_Saved,					//Saved
+	Enter_Too_Short,			//Too_Short
+	Enter_Save_Fail				//Save_Fail
+};
+
+//first matching row wins, children are searched before parents
+const GL_Trans_t gl_trans[] = {
+	//state			event					guard							action				next
+	{Standby,		Ev_Key_Short,	0,								0,						Unlock},
+	{Standby,		Ev_Key_Long,	Is_Unlocked,			0,						Record},
+	{Standby,		Ev_Key_Long,	0,								0,						Unlock_First},
+	{Input,			Ev_Gesture,		0,								Gesture_Show,	Root},
+	{Unlock,		Ev_Gap,				0,								0,						Checking},
+	{Record,		Ev_Gap,				Seq_Long_Enough,	0,						Saving},
+	{Record,		Ev_Gap,				0,								0,						Too_Short},
+	{Checking,	Ev_Timer,			Motion_Seq_Check,	0,						Match},
+	{Checking,	Ev_Timer,			0,								0,						Fail},
+	{Match,			Ev_Timer,			0,								0,						Unlocked},
+	{Saving,		Ev_Timer,			Save_Busy,				Saving_Wait,	Root},
+	{Saving,		Ev_Timer,			Save_Failed,			0,						Save_Fail},
+	{Saving,		Ev_Timer,			0,								0,						Saved},
+	{Message,		Ev_Timer,			0,								0,						Standby},
+};
 /* Private user code ---------------------------------------------------------*/
 
 int State_Machine_Init(void){
 	uint8_t i;
+	Key_Init();
 	Main_State_Init(&main_state);
 	Motion_State_Init(&motion_state);
 	Gesture_Seq_Init(&g_seq);
+	Flash_Scan();
 	if(key->len >= SeqLength){
 		Flash_Init();
 	}
-	printf("Key is: ");
+	else if(flash_next > FlashSlots - FlashBootFree){//erase now, not under a save
+		flash_next = FlashSlots;
+		Flash_Save_Seq(key);
+	}
+	Log0(Log_Key_Is);
 	for(i=0;i<key->len;i++){
-		printf("%d ",key->seq[i]);
+		Log1(Log_Seq_Item, key->seq[i]);
 	}
-	printf("\r\n");
+	Log0(Log_Line_End);
 	return 0;
 }
 
@@ -115,10 +245,13 @@ int State_Machine_Init(void){
   * @retval int
   */
 int Main_State_Init(Main_State_t* s){
-	s->state = Standby;
-	s->updateTime = HAL_GetTick();
 	s->is_unlocked = 0;
-	Standby_Print(s);
+	s->holdoff = 0;
+	s->save_pending = 0;
+	s->enroll_pending = 0;
+	s->save_failed = 0;
+	s->storing = 0;
+	State_Enter(Standby);
 	return 0;
 }
 
@@ -160,20 +293,84 @@ int Gesture_Seq_Init(Gesture_Seq_t* g){
 	return 0;
 }
 
-int Flash_Save_Seq(Gesture_Seq_t* k){
-	int i;
-	uint8_t *p = (uint8_t*)k;
-	
+/**
+  * @brief  find the key, the last complete record of the sector, and the
+	*					first free record after the last one written
+  * @retval None
+  */
+void Flash_Scan(void){
+	const uint8_t *p;
+	uint16_t i, j;
+
+	key = (Gesture_Seq_t*)FlashAddr;
+	flash_next = 0;
+	for(i=0;i<FlashSlots;i++){
+		p = (const uint8_t*)FlashAddr + i*sizeof(Gesture_Seq_t);
+		for(j=0;j<sizeof(Gesture_Seq_t) && p[j]==0xFF;j++);
+		if(j == sizeof(Gesture_Seq_t)) continue;	//erased
+		flash_next = i + 1;
+		if(p[0] < SeqLength) key = (Gesture_Seq_t*)p;
+	}
+}
+
+/**
+  * @brief  start appending a key record, programmed by Flash_Store_Step().
+	*					Only a full sector is erased first, at once: the F411 has
+	*					one flash bank and stalls every code fetch while a sector
+	*					is erased, an erase cannot run beside the other tasks.
+	*	@param	k		key sequence, copied
+  * @retval None
+  */
+void Flash_Store_Start(const Gesture_Seq_t *k){
+	memcpy(&flash_store, k, sizeof(flash_store));
+	flash_store_pos = 0;
 	HAL_FLASH_Unlock();
+	if(flash_next < FlashSlots) return;
 	FLASH_Erase_Sector(FlashSector, FLASH_VOLTAGE_RANGE_3);
-	FLASH_WaitForLastOperation(1000);
-	for(i=0;i<k->len+1;i++){
-		HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, FlashAddr+i, *p);
-		p++;
-		FLASH_WaitForLastOperation(1000);
+	if(FLASH_WaitForLastOperation(1000) != HAL_OK) flash_store_pos = -1;
+	flash_next = 0;
+	key = (Gesture_Seq_t*)FlashAddr;
+}
+
+/**
+  * @brief  program the next FlashStoreStep bytes of the record, the length
+	*					last: a record cut short by a reset is not taken as the key
+  * @retval int
+	*					0: written, it is the key now
+	*					1: erase or program failed, flash locked again
+	*					2: more to program
+  */
+int Flash_Store_Step(void){
+	uint32_t addr = FlashAddr + flash_next*sizeof(Gesture_Seq_t);
+	int16_t end = flash_store_pos + FlashStoreStep;
+	HAL_StatusTypeDef status = flash_store_pos < 0 ? HAL_ERROR : HAL_OK;
+
+	if(end > flash_store.len) end = flash_store.len;
+	while(status==HAL_OK && flash_store_pos<end){
+		status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, addr+1+flash_store_pos, flash_store.seq[flash_store_pos]);
+		flash_store_pos++;
 	}
+	if(status==HAL_OK && flash_store_pos<flash_store.len) return 2;
+	if(status==HAL_OK) status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, addr, flash_store.len);
 	HAL_FLASH_Lock();
-	return 0;
+	if(status==HAL_OK) key = (Gesture_Seq_t*)FlashAddr + flash_next;
+	flash_next++;	//a failed record is not used again
+	return status==HAL_OK?0:1;
+}
+
+/**
+  * @brief  write a key sequence to flash at once, for the boot
+	*	@param	k		key sequence
+  * @retval int
+	*					0: written
+	*					1: erase or program failed, flash locked again
+  */
+int Flash_Save_Seq(Gesture_Seq_t* k){
+	int res;
+
+	Flash_Store_Start(k);
+	do res = Flash_Store_Step(); while(res == 2);
+	return res;
 }
 
 /**
@@ -210,131 +407,326 @@ void Standby_Print(Main_State_t* s){
 }
 
 /**
-  * @brief  main function state update
+  * @brief  check if the current state is super or inside it
+	*	@param	super		state to check
   * @retval int
   */
-int State_Update_Main(void){
-	Main_State_t* s = &main_state;
-	/************Stand by state*********************/
-	if(s->state == Standby){
-		if(Key_Pressed){
-			HAL_Delay(20);//debouncer
-			if(Key_Pressed){
-				HAL_Delay(ShortPressMax);
-				if(Key_Pressed){			//long press
-					while(Key_Pressed); //wait till release
-					if(s->is_unlocked){ //allow to get in record mode
-						OLED_Clear();
-						OLED_ShowString(0,0,"Record Mode");
-						Motion_State_Init(&motion_state);//init motion state variable
-						Gesture_Seq_Init(&g_seq);
-						s->state = Record;
-						s->updateTime = HAL_GetTick();
-						return 0;
-					}
-					else{								//show error message
-						OLED_Clear();
-						OLED_ShowString(0,0,"Unlock first!");
-						HAL_Delay(1000);
-						Standby_Print(s);
-						return 0;
-					}
-				}
-				else{								//short press
-					OLED_Clear();
-					OLED_ShowString(0,0,"Unlock Mode");
-					Motion_State_Init(&motion_state);//init motion state variable
-					Gesture_Seq_Init(&g_seq);
-					s->state = Unlock;
-					s->updateTime = HAL_GetTick();
-					return 0;
-				}
-			}
-		}
+int State_In(GL_Mode super){
+	GL_Mode st = main_state.state;
+	while(st != Root){
+		if(st == super) return 1;
+		st = gl_parent[st];
 	}
-	/************Unlock state*********************/
-	else if(s->state == Unlock){
-		if(HAL_GetTick() - s->updateTime > MotionGapTime){		//end of sequence
-			OLED_Clear();
-			OLED_ShowString(0,0,"Checking...");
-			HAL_Delay(300);																		//delay to make user feels better
-			if(Motion_Seq_Check()){														//match
-				OLED_ShowString(0,2,"Match!");
-				HAL_Delay(300);																		//delay to make user feels better
-				OLED_ShowString(0,4,"Unlock!!!!");
-				HAL_Delay(3000);																		//delay to make user feels better
-				s->is_unlocked = 1;
-				s->state = Standby;
-				s->updateTime = HAL_GetTick();
-				Standby_Print(s);
-				return 0;
-			}
-			else{
-				OLED_ShowString(0,2,"Fail!!!!");
-				HAL_Delay(3000);																		//delay to make user feels better
-				s->is_unlocked = 0;
-				s->state = Standby;
-				s->updateTime = HAL_GetTick();
-				Standby_Print(s);
-				return 0;
-			}
-		}
-		else{																								//wait for new input
-			if(Motion_Input_Check()){
-				if(dbg == 1)printf("Gesture Num: %d, seq len: %d, pitch: %5.2f\r\n",g_seq.seq[g_seq.len-1],g_seq.len,mpu_data.pitch);
-				OLED_Clear();
-				OLED_ShowString(0,0,"Unlock Mode");
-				OLED_ShowString(0,2,"Last Ges:");
-				OLED_ShowNum(80,2,g_seq.seq[g_seq.len-1],2,16);
-				OLED_ShowString(0,4,"Ges Len:");
-				OLED_ShowNum(80,4,g_seq.len,2,16);
-				s->updateTime = HAL_GetTick();
-				HAL_Delay(200); //avoid motion overlap
-			}
-			return 0;
+	return 0;
+}
+
+/**
+  * @brief  enter a state, stops the UI timer and runs the entry action
+	*	@param	st		new state
+  * @retval None
+  */
+void State_Enter(GL_Mode st){
+	main_state.state = st;
+	main_state.timerLen = 0;
+	if(gl_entry[st]) gl_entry[st]();
+}
+
+/**
+  * @brief  run an event through the transition table, from the current
+	*					state up through its parents
+	*	@param	ev		event
+  * @retval int
+	*					0: not handled
+	*					1: handled
+  */
+int State_Dispatch(GL_Event ev){
+	GL_Mode st = main_state.state;
+	const GL_Trans_t *t;
+	uint8_t i;
+	while(st != Root){
+		for(i=0;i<sizeof(gl_trans)/sizeof(gl_trans[0]);i++){
+			t = &gl_trans[i];
+			if(t->state != st || t->event != ev) continue;
+			if(t->guard && !t->guard()) continue;
+			if(t->action) t->action();
+			if(t->next != Root) State_Enter(t->next);
+			return 1;
 		}
-		
+		st = gl_parent[st];
 	}
-	/************Record state*********************/
-	else if(s->state == Record){
-		if(HAL_GetTick()-s->updateTime > MotionGapTime){		//end of sequence
-			if(g_seq.len >= MinSeqLen){
-				OLED_Clear();
-				OLED_ShowString(0,0,"Saving...");
-				HAL_Delay(300);																		//delay to make user feels better
-				Motion_Seq_Save();
-				Motion_Seq_Print();
-				OLED_ShowString(0,6,"Saved!");
-				HAL_Delay(6000);																	//delay to make user feels better
-				s->is_unlocked = 0;
-			}
-			else{
-				OLED_Clear();
-				OLED_ShowString(0,0,"Too short!!!");
-				HAL_Delay(2000);		
-			}
-			s->state = Standby;
-			s->updateTime = HAL_GetTick();
-			Standby_Print(s);
-			return 0;
-		}
-		else{																								//wait for new input
-			if(Motion_Input_Check()){
-				if(dbg == 1)printf("Gesture Num: %d, seq len: %d, pitch: %5.2f\r\n",g_seq.seq[g_seq.len-1],g_seq.len,mpu_data.pitch);
-				OLED_Clear();
-				OLED_ShowString(0,0,"Record Mode");
-				OLED_ShowString(0,2,"Last Ges:");
-				OLED_ShowNum(80,2,g_seq.seq[g_seq.len-1],2,16);
-				OLED_ShowString(0,4,"Ges Len:");
-				OLED_ShowNum(80,4,g_seq.len,2,16);
-				s->updateTime = HAL_GetTick();
-				HAL_Delay(200); //avoid motion overlap
-			}
-			return 0;
-		}
+	return 0;
+}
+
+/**
+  * @brief  arm the UI timer, Ev_Timer is raised after ms
+	*	@param	ms		delay
+  * @retval None
+  */
+void UI_Timer_Start(uint32_t ms){
+	main_state.timerStart = HAL_GetTick();
+	main_state.timerLen = ms;
+}
+
+/**
+  * @brief  guards
+  * @retval int
+  */
+int Is_Unlocked(void){
+	return main_state.is_unlocked;
+}
+
+int Seq_Long_Enough(void){
+	return g_seq.len >= param.min_seq_len;
+}
+
+int Save_Failed(void){
+	return main_state.save_failed;
+}
+
+int Save_Busy(void){
+	return main_state.save_pending;
+}
+
+/**
+  * @brief  the key is still being written, look again after a storage run
+  * @retval None
+  */
+void Saving_Wait(void){
+	UI_Timer_Start(20);
+}
+
+/**
+  * @brief  show the gesture just detected
+  * @retval None
+  */
+void Gesture_Show(void){
+	Main_State_t* s = &main_state;
+	Log3(Log_Gesture, g_seq.seq[g_seq.len-1], g_seq.len, Log_F(mpu_data.pitch));
+	OLED_Clear();
+	OLED_ShowString(0,0,s->state == Unlock ? "Unlock Mode" : "Record Mode");
+	OLED_ShowString(0,2,"Last Ges:");
+	OLED_ShowNum(80,2,g_seq.seq[g_seq.len-1],2,16);
+	OLED_ShowString(0,4,"Ges Len:");
+	OLED_ShowNum(80,4,g_seq.len,2,16);
+	s->updateTime = HAL_GetTick();
+	s->holdoffStart = s->updateTime; //avoid motion overlap
+	s->holdoff = 1;
+}
+
+/**
+  * @brief  entry actions
+  * @retval None
+  */
+void Input_Start(void){
+	Motion_State_Init(&motion_state);//init motion state variable
+	Gesture_Seq_Init(&g_seq);
+	main_state.updateTime = HAL_GetTick();
+	main_state.holdoff = 0;
+}
+
+void Enter_Standby(void){
+	main_state.updateTime = HAL_GetTick();
+	Standby_Print(&main_state);
+}
+
+void Enter_Unlock(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,"Unlock Mode");
+	Input_Start();
+}
+
+void Enter_Record(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,"Record Mode");
+	Input_Start();
+}
+
+void Enter_Unlock_First(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,"Unlock first!");
+	UI_Timer_Start(1000);
+}
+
+void Enter_Checking(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,"Checking...");
+	UI_Timer_Start(300);					//delay to make user feels better
+}
+
+void Enter_Match(void){
+	OLED_ShowString(0,2,"Match!");
+	UI_Timer_Start(300);
+}
+
+void Enter_Unlocked(void){
+	OLED_ShowString(0,4,"Unlock!!!!");
+	main_state.is_unlocked = 1;
+	UI_Timer_Start(3000);
+}
+
+void Enter_Fail(void){
+	OLED_ShowString(0,2,"Fail!!!!");
+	main_state.is_unlocked = 0;
+	UI_Timer_Start(3000);
+}
+
+void Enter_Saving(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,"Saving...");
+	main_state.save_pending = 1;	//written by the storage task
+	UI_Timer_Start(300);
+}
+
+void Enter_Saved(void){
+	OLED_ShowString(0,6,"Saved!");
+	main_state.is_unlocked = 0;
+	UI_Timer_Start(6000);
+}
+
+void Enter_Too_Short(void){
+	OLED_Clear();
+	OLED_ShowString(0,0,"Too short!!!");
+	UI_Timer_Start(2000);
+}
+
+void Enter_Save_Fail(void){
+	OLED_ShowString(0,6,"Save failed!");	//still unlocked, the old key is kept unless the sector was erased
+	UI_Timer_Start(3000);
+}
+
+/**
+  * @brief  UI update, turns key, UI timer and sequence gap into events.
+	*					Never waits.
+  * @retval int
+  */
+int State_Update_UI(void){
+	Main_State_t* s = &main_state;
+	Key_Event_t key;
+	uint32_t now;
+
+	key = Key_Get_Event();
+	//Key_Press comes ahead of the Short, Long or Double it turns into, acting on
+	//it would act twice. No state tells a double click from a click.
+	if(key == Key_Short || key == Key_Double) State_Dispatch(Ev_Key_Short);
+	else if(key == Key_Long) State_Dispatch(Ev_Key_Long);
+
+	now = HAL_GetTick();
+	if(s->timerLen && now - s->timerStart >= s->timerLen){
+		s->timerLen = 0;
+		State_Dispatch(Ev_Timer);
+	}
+
+	if(State_In(Input) && now - s->updateTime > param.motion_gap_time){	//end of sequence
+		State_Dispatch(Ev_Gap);
+	}
+	return 0;
+}
+
+/**
+  * @brief  motion update, turns new samples into gesture events.
+	*					Run after each sample.
+  * @retval int
+  */
+int State_Update_Motion(void){
+	Main_State_t* s = &main_state;
+	int res;
+
+	if(!State_In(Input)) return 0;
+	if(s->holdoff && HAL_GetTick() - s->holdoffStart < GestureHoldoff){
+		mpu_data.UpdateFlag = 0;													//samples keep flowing, motion ignored
+		return 0;
+	}
+	s->holdoff = 0;																			//wait for new input
+	Probe_Begin(Probe_Motion_Check);
+	res = Motion_Input_Check();
+	Probe_End(Probe_Motion_Check);
+	if(res) State_Dispatch(Ev_Gesture);
+	return 0;
+}
+
+/**
+  * @brief  storage update, writes a recorded or enrolled key sequence to
+	*					flash, FlashStoreStep bytes per call
+  * @retval int
+  */
+int State_Update_Storage(void){
+	Main_State_t* s = &main_state;
+	int res;
+
+	if(!s->storing){
+		if(s->enroll_pending) Flash_Store_Start(&enroll_seq);
+		else if(s->save_pending) Flash_Store_Start(&g_seq);
+		else return 0;
+		s->storing = 1;
+	}
+	res = Flash_Store_Step();
+	if(res == 2) return 0;
+	s->storing = 0;
+	if(res) Log0(Log_Key_Save_Fail);
+	if(s->enroll_pending){
+		s->enroll_pending = 0;
+		s->is_unlocked = 0;
+		if(State_In(Standby)) State_Enter(Standby);//show locked
+		return 0;
+	}
+	s->save_failed = res != 0;
+	if(!s->save_failed){
+		Motion_Seq_Log();
+		Motion_Seq_Print();
+	}
+	s->save_pending = 0;
+	return 0;
+}
+
+/**
+  * @brief  Set a new key from a remote command, only while unlocked.
+	*					Written by the storage task, then locked again.
+	*	@param	seq		gesture numbers
+	*	@param	len		sequence length
+  * @retval int
+	*					0: accepted
+	*					1: bad length or gesture number
+	*					2: locked
+	*					3: a key is still being saved
+  */
+int Motion_Key_Enroll(const uint8_t *seq, uint8_t len){
+	uint8_t i;
+	if(len < param.min_seq_len || len >= SeqLength) return 1;
+	for(i=0;i<len;i++){
+		if(seq[i] < 1 || seq[i] > GestureMax) return 1;
 	}
-	else return -1;//error
-	return -1;
+	if(!main_state.is_unlocked) return 2;
+	if(main_state.enroll_pending || main_state.save_pending) return 3;
+	enroll_seq.len = len;
+	memcpy(enroll_seq.seq, seq, len);
+	main_state.enroll_pending = 1;
+	return 0;
+}
+
+/**
+  * @brief  Compare a sequence with the stored key, the state is not changed
+	*	@param	seq		gesture numbers
+	*	@param	len		sequence length
+  * @retval int
+	*					0: wrong
+	*					1: right
+  */
+int Motion_Key_Verify(const uint8_t *seq, uint8_t len){
+	if(key->len != len) return 0;
+	return memcmp(key->seq, seq, len) == 0;
+}
+
+/**
+  * @brief  main function state update, all of the above in one call.
+	*					Never waits, call from the main loop.
+  * @retval int
+  */
+int State_Update_Main(void){
+	State_Update_UI();
+	State_Update_Motion();
+	State_Update_Storage();
+	OLED_Refresh();
+	return 0;
 }
 
 
@@ -350,23 +742,23 @@ int Motion_Peak_Update(Motion_Detect_Buf_t *mdb, float acc){
 		Motion_Detect_Buf_Init(mdb);//reset buffer
 	}
 	if(mdb->peak_cnt == 0){				//wait for first peak
-		if(acc > MotionPeakTH){
+		if(acc > param.motion_peak_th){
 			mdb->max_cnt++;
 		}
-		else if(acc < -MotionPeakTH){
+		else if(acc < -param.motion_peak_th){
 			mdb->min_cnt++;
 		}
 		else{
 			mdb->max_cnt = 0;
 			mdb->min_cnt = 0;
 		}
-		if(mdb->max_cnt==PeakSampNum){ //first pos peak get
+		if(mdb->max_cnt==param.peak_samp_num){ //first pos peak get
 			mdb->max_cnt = 0;
 			mdb->first_peak_dir = 1;
 			mdb->peak_cnt = 1;
 			mdb->peak_time = HAL_GetTick();
 		}
-		else if(mdb->min_cnt==PeakSampNum){ //first pos peak get
+		else if(mdb->min_cnt==param.peak_samp_num){ //first pos peak get
 			mdb->min_cnt = 0;
 			mdb->first_peak_dir = 0;
 			mdb->peak_cnt = 1;
@@ -374,12 +766,12 @@ int Motion_Peak_Update(Motion_Detect_Buf_t *mdb, float acc){
 		}
 	}
 	else if(mdb->peak_cnt == 1){	//wait for second peak
-		if(HAL_GetTick() - mdb->peak_time > AccPeakGapTime){	//time out
+		if(HAL_GetTick() - mdb->peak_time > param.acc_peak_gap_time){	//time out
 			Motion_Detect_Buf_Init(mdb);//reset buffer
 			return 0;
 		}
 		if(mdb->first_peak_dir == 1){	//last peak is pos, wait for neg
-			if(acc < -MotionPeakTH){
+			if(acc < -param.motion_peak_th){
 				mdb->min_cnt++;
 			}
 			else{
@@ -387,7 +779,7 @@ int Motion_Peak_Update(Motion_Detect_Buf_t *mdb, float acc){
 			}
 		}
 		else{													//last peak is neg, wait for pos
-			if(acc > MotionPeakTH){
+			if(acc > param.motion_peak_th){
 				mdb->max_cnt++;
 			}
 			else{
@@ -395,7 +787,7 @@ int Motion_Peak_Update(Motion_Detect_Buf_t *mdb, float acc){
 			}
 		}
 		//check peak update
-		if(mdb->max_cnt == PeakSampNum || mdb->min_cnt == PeakSampNum){
+		if(mdb->max_cnt == param.peak_samp_num || mdb->min_cnt == param.peak_samp_num){
 			mdb->max_cnt = 0;
 			mdb->min_cnt = 0;
 			mdb->peak_cnt = 2;
@@ -403,12 +795,12 @@ int Motion_Peak_Update(Motion_Detect_Buf_t *mdb, float acc){
 		}
 	}
 	else if(mdb->peak_cnt == 2){		//wait for the last peak
-		if(HAL_GetTick() - mdb->peak_time > AccPeakGapTime){	//time out
+		if(HAL_GetTick() - mdb->peak_time > param.acc_peak_gap_time){	//time out
 			Motion_Detect_Buf_Init(mdb);//reset buffer
 			return 0;
 		}
 		if(mdb->first_peak_dir == 1){	//first peak is pos, wait for pos
-			if(acc > MotionPeakTH){
+			if(acc > param.motion_peak_th){
 				mdb->max_cnt++;
 			}
 			else{
@@ -416,7 +808,7 @@ int Motion_Peak_Update(Motion_Detect_Buf_t *mdb, float acc){
 			}
 		}
 		else{													//first peak is neg, wait for neg
-			if(acc < -MotionPeakTH){
+			if(acc < -param.motion_peak_th){
 				mdb->min_cnt++;
 			}
 			else{
@@ -424,7 +816,7 @@ int Motion_Peak_Update(Motion_Detect_Buf_t *mdb, float acc){
 			}
 		}
 		//check peak update
-		if(mdb->max_cnt == PeakSampNum || mdb->min_cnt == PeakSampNum){
+		if(mdb->max_cnt == param.peak_samp_num || mdb->min_cnt == param.peak_samp_num){
 			mdb->max_cnt = 0;
 			mdb->min_cnt = 0;
 			mdb->peak_cnt = 3;
@@ -458,9 +850,10 @@ int Motion_Roll_Check(void){
 	*					1: new gesture done
   */
 int Motion_Input_Check(void){
-	if(motion_state.start_flag == 1 && HAL_GetTick()-motion_state.start_time > MotionDurTime){ //time out
+	if(g_seq.len >= SeqLength-1) return 0;	//full, a longer key reads as erased flash at boot
+	if(motion_state.start_flag == 1 && HAL_GetTick()-motion_state.start_time > param.motion_dur_time){ //time out
 		Motion_State_Init(&motion_state);
-		if(dbg == 1)printf("motion time out!\r\n");
+		Log0(Log_Motion_Timeout);
 		return 0;
 	}
 	
@@ -476,42 +869,42 @@ int Motion_Input_Check(void){
 						motion_state.z.peak_cnt == 1){
 				motion_state.start_flag = 1;
 				motion_state.start_time = HAL_GetTick();
-				if(dbg == 1)printf("motion start!\r\n");
+				Log0(Log_Motion_Start);
 			}
 		}
 		//check if a gesture completed
 		if(motion_state.x.peak_cnt == 3){
-			if(motion_state.x.max_abs_val*PeakMaxPre>motion_state.y.max_abs_val && 
-				motion_state.x.max_abs_val*PeakMaxPre>motion_state.z.max_abs_val){
+			if(motion_state.x.max_abs_val*param.peak_max_pre>motion_state.y.max_abs_val && 
+				motion_state.x.max_abs_val*param.peak_max_pre>motion_state.z.max_abs_val){
 				g_seq.seq[g_seq.len] = (1+motion_state.x.first_peak_dir)+Motion_Roll_Check();
 				g_seq.len++;
 				Motion_State_Init(&motion_state);
-				if(dbg == 1)printf("	motion at x %d!\r\n",motion_state.x.first_peak_dir);
+				Log2(Log_Motion_At, 'x', motion_state.x.first_peak_dir);
 				return 1;
 			}
-			if(dbg == 1)printf("	peak rej x!\r\n");
+			Log1(Log_Peak_Rej, 'x');
 		}
 		else if(motion_state.y.peak_cnt == 3){
-			if(motion_state.y.max_abs_val*PeakMaxPre>motion_state.x.max_abs_val && 
-				motion_state.y.max_abs_val*PeakMaxPre>motion_state.z.max_abs_val){
+			if(motion_state.y.max_abs_val*param.peak_max_pre>motion_state.x.max_abs_val && 
+				motion_state.y.max_abs_val*param.peak_max_pre>motion_state.z.max_abs_val){
 				g_seq.seq[g_seq.len] = (3+motion_state.y.first_peak_dir)+Motion_Roll_Check();
 				g_seq.len++;
 				Motion_State_Init(&motion_state);
-				if(dbg == 1)printf("	motion at y %d!\r\n",motion_state.y.first_peak_dir);
+				Log2(Log_Motion_At, 'y', motion_state.y.first_peak_dir);
 				return 1;
 			}
-			if(dbg == 1)printf("	peak rej y!\r\n");
+			Log1(Log_Peak_Rej, 'y');
 		}
 		else if(motion_state.z.peak_cnt == 3){
-			if(motion_state.z.max_abs_val*PeakMaxPre>motion_state.x.max_abs_val && 
-				motion_state.z.max_abs_val*PeakMaxPre>motion_state.y.max_abs_val){
+			if(motion_state.z.max_abs_val*param.peak_max_pre>motion_state.x.max_abs_val && 
+				motion_state.z.max_abs_val*param.peak_max_pre>motion_state.y.max_abs_val){
 				g_seq.seq[g_seq.len] = (5+motion_state.z.first_peak_dir)+Motion_Roll_Check();
 				g_seq.len++;
 				Motion_State_Init(&motion_state);
-				if(dbg == 1)printf("	motion at z %d!\r\n",motion_state.z.first_peak_dir);
+				Log2(Log_Motion_At, 'z', motion_state.z.first_peak_dir);
 				return 1;
 			}
-			if(dbg == 1)printf("	peak rej z!\r\n");
+			Log1(Log_Peak_Rej, 'z');
 		}
 		return 0;
 	}
@@ -541,15 +934,14 @@ int Motion_Seq_Check(void){
 }
 
 /**
-  * @brief  Save sequence to flash
-	* @retval int 
+  * @brief  Log the key just saved
+	* @retval int
   */
-int Motion_Seq_Save(void){
+int Motion_Seq_Log(void){
 	int i;
-	Flash_Save_Seq(&g_seq);
-	printf("New key is: ");
+	Log0(Log_Key_New);
 	for(i=0;i<key->len;i++){
-		printf("%d ",key->seq[i]);
+		Log1(Log_Seq_Item, key->seq[i]);
 	}
 	return 0;
 }
@@ -560,7 +952,7 @@ int Motion_Seq_Print(void){
 	int i;
 	sprintf(buf,"New:");
 	p += 4;
-	for(i=0;i<key->len;i++){
+	for(i=0;i<key->len && p+3<&buf[sizeof(buf)];i++){//rest is off the screen
 		sprintf(p,"%2d,",key->seq[i]);
 		p +=3;
 	}
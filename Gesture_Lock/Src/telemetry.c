@@ -0,0 +1,159 @@
+/**
+  ******************************************************************************
+  * File Name          : telemetry.c
+  * Description        : This file provides code for the buffered UART1
+	*											 telemetry channel. Producers copy whole frames into
+	*											 a byte ring and return at once; a frame that does not
+	*											 fit is dropped and counted. UART1 TX DMA drains the
+	*											 ring in batches, several frames per transmission, and
+	*											 restarts itself from the completion interrupt.
+	*											 Frames come from the main loop (printf, probes) and
+	*											 from the TIM2 ISR (Plot_Data before the scheduler
+	*											 starts), so reserve, copy, publish and the DMA start
+	*											 run with interrupts masked, as Log_Put() does.
+  ******************************************************************************
+  * @attention
+  *	For STM32F411
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "telemetry.h"
+#include "usart.h"
+#include "string.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define TlmMask		(TlmRingSize-1)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct{
+	uint8_t						buf[TlmRingSize];
+	volatile uint32_t	head;			//free running, written by the producer
+	volatile uint32_t	tail;			//free running, written on DMA completion
+	volatile uint32_t	dma_len;	//bytes on the wire, 0: idle
+	uint32_t					wait_start;	//tick when the ring went non empty
+} Tlm_Ring_t;
+
+/* Private variables ---------------------------------------------------------*/
+Tlm_Ring_t						tlm;
+volatile Tlm_Stats_t	tlm_stats;
+/* Private function prototypes -----------------------------------------------*/
+void Tlm_Start(void);
+/* Private user code ---------------------------------------------------------*/
+
+/**
+  * @brief  Telemetry initialize, UART1 must be initialized
+  * @retval None
+  */
+void Tlm_Init(void){
+	tlm.head = 0;
+	tlm.tail = 0;
+	tlm.dma_len = 0;
+	memset((void*)&tlm_stats, 0, sizeof(tlm_stats));
+}
+
+/**
+  * @brief  free bytes in the ring
+  * @retval bytes
+  */
+uint32_t Tlm_Free(void){
+	return TlmRingSize - (tlm.head - tlm.tail);
+}
+
+/**
+  * @brief  send the queued bytes up to the end of the ring, called with
+	*					the DMA idle and interrupts masked, or from its completion
+  * @retval None
+  */
+void Tlm_Start(void){
+	uint32_t tail = tlm.tail;
+	uint32_t len = tlm.head - tail;
+	uint32_t off = tail & TlmMask;
+
+	if(len == 0) return;
+	if(len > TlmRingSize - off) len = TlmRingSize - off;	//wraps, rest goes next time
+	tlm.dma_len = len;
+	if(HAL_UART_Transmit_DMA(&huart1, &tlm.buf[off], len) != HAL_OK){
+		tlm.dma_len = 0;
+		tlm_stats.dma_errors++;
+		return;
+	}
+	tlm_stats.dma_starts++;
+}
+
+/**
+  * @brief  Queue one frame, all or nothing. Any context, never waits,
+	*					interrupts are masked for the copy of len bytes.
+	*	@param	buf		frame
+	*	@param	len		bytes
+  * @retval uint8_t
+	*					0: queued
+	*					1: dropped, ring full
+  */
+uint8_t Tlm_Write(const uint8_t *buf, uint16_t len){
+	uint32_t primask = __get_PRIMASK();
+	uint32_t head, used, off, n;
+
+	__disable_irq();
+	head = tlm.head;
+	used = head - tlm.tail;
+	if(len > TlmRingSize - used){
+		tlm_stats.dropped_frames++;
+		tlm_stats.dropped_bytes += len;
+		__set_PRIMASK(primask);
+		return 1;
+	}
+	if(used == 0) tlm.wait_start = HAL_GetTick();
+	off = head & TlmMask;
+	n = TlmRingSize - off;
+	if(n > len) n = len;
+	memcpy(&tlm.buf[off], buf, n);
+	memcpy(&tlm.buf[0], buf + n, len - n);
+	tlm.head = head + len;
+
+	used += len;
+	if(used > tlm_stats.fill_max) tlm_stats.fill_max = used;
+	tlm_stats.frames++;
+	tlm_stats.bytes += len;
+	if(tlm.dma_len == 0 && used >= TlmBatchBytes) Tlm_Start();
+	__set_PRIMASK(primask);
+	return 0;
+}
+
+/**
+  * @brief  Send a partial batch that waited TlmFlushTime
+  * @retval None
+  */
+void Tlm_Poll(void){
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if(tlm.dma_len == 0 && tlm.head != tlm.tail && HAL_GetTick() - tlm.wait_start >= TlmFlushTime) Tlm_Start();
+	__set_PRIMASK(primask);
+}
+
+/**
+  * @brief  UART1 DMA done, release the bytes and send the next batch
+	*	@param	huart
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
+	if(huart != &huart1) return;
+	tlm.tail += tlm.dma_len;
+	tlm.dma_len = 0;
+	tlm.wait_start = HAL_GetTick();
+	Tlm_Start();		//whatever queued meanwhile, already a batch
+}
+
+/**
+  * @brief  UART1 error, skip an aborted batch so the channel keeps going
+	*	@param	huart
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart){
+	if(huart != &huart1) return;
+	tlm_stats.dma_errors++;
+	if(huart->gState != HAL_UART_STATE_READY) return;	//TX still running
+	HAL_UART_TxCpltCallback(huart);
+}
@@ -23,7 +23,8 @@
 #include "usbd_cdc_if.h"
 
 /* USER CODE BEGIN INCLUDE */
-
+#include "cmd.h"
+#include "cdc_stream.h"
 /* USER CODE END INCLUDE */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -131,6 +132,7 @@ static int8_t CDC_Init_FS(void);
 static int8_t CDC_DeInit_FS(void);
 static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length);
 static int8_t CDC_Receive_FS(uint8_t* pbuf, uint32_t *Len);
+static int8_t CDC_TransmitCplt_FS(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
 
@@ -145,7 +147,8 @@ USBD_CDC_ItfTypeDef USBD_Interface_fops_FS =
   CDC_Init_FS,
   CDC_DeInit_FS,
   CDC_Control_FS,
-  CDC_Receive_FS
+  CDC_Receive_FS,
+  CDC_TransmitCplt_FS
 };
 
 /* Private functions ---------------------------------------------------------*/
@@ -158,7 +161,8 @@ static int8_t CDC_Init_FS(void)
   /* USER CODE BEGIN 3 */
   /* Set Application Buffers */
   USBD_CDC_SetTxBuffer(&hUsbDeviceFS, UserTxBufferFS, 0);
-  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, UserRxBufferFS);
+  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, Cmd_Rx_Reset());
+  Cdc_Link_Reset();
   return (USBD_OK);
   /* USER CODE END 3 */
 }
@@ -264,8 +268,11 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 6 */
-  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
-  USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  uint8_t *next = Cmd_Rx(Buf, *Len);
+  if (next != NULL){//else held until the frame is taken, see CDC_Rx_Resume
+    USBD_CDC_SetRxBuffer(&hUsbDeviceFS, next);
+    USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  }
   return (USBD_OK);
   /* USER CODE END 6 */
 }
@@ -295,21 +302,64 @@ uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len)
   return result;
 }
 
+/**
+  * @brief  CDC_TransmitCplt_FS
+  *         Data transmited callback
+  *
+  *         @note
+  *         This function is IN transfer complete callback used to inform user that
+  *         the submitted Data is successfully sent over USB.
+  *
+  * @param  Buf: Buffer of data to be received
+  * @param  Len: Number of data received (in bytes)
+  * @retval Result of the operation: USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
+{
+  uint8_t result = USBD_OK;
+  /* USER CODE BEGIN 13 */
+  UNUSED(Buf);
+  UNUSED(Len);
+  UNUSED(epnum);
+  Cdc_Tx_Cplt();
+  /* USER CODE END 13 */
+  return result;
+}
+
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+/**
+  * @brief  Check if the last CDC_Transmit_FS buffer was sent
+  * @retval 1: idle, buffer can be reused
+  */
+uint8_t CDC_Tx_Idle(void)
+{
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
+  if (hcdc == NULL){
+    return 0;
+  }
+  return hcdc->TxState == 0;
+}
+
+/**
+  * @brief  Receive the next OUT packet into Buf, after CDC_Receive_FS
+  *         left the endpoint held. Main loop only.
+  * @param  Buf: where the packet goes, room for one packet
+  */
+void CDC_Rx_Resume(uint8_t *Buf)
+{
+  HAL_NVIC_DisableIRQ(OTG_FS_IRQn);
+  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, Buf);
+  if (hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED){
+    USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  }
+  HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
+}
+
 #ifdef USB_DEBUG
 int fputc(int ch, FILE *f)   
 {
-	int i=0;
-//	USBD_CDC_SetTxBuffer(&hUsbDeviceFS, (uint8_t *)&ch, 1);
-//	while(((USBD_CDC_HandleTypeDef*)(hUsbDeviceFS.pClassData))->TxState==1){};
-//  CDC_Transmit_FS((uint8_t *)&ch, 1); 
-//  return ch;
-	if(hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED){
-		while(CDC_Transmit_FS((uint8_t*)(&ch),1)!=USBD_OK){
-			i++;
-			if(i>1000) break;
-		}
-	}
+	uint8_t c = ch;
+	Cdc_Write(&c, 1);//queued, dropped when the link is down or saturated
   return ch;
 }
 #endif
@@ -323,7 +373,10 @@ void usb_printf(const char *format, ...)
     va_start(args, format);
     length = vsnprintf((char *)UserTxBufferFS, APP_TX_DATA_SIZE, (char *)format, args);
     va_end(args);
-    CDC_Transmit_FS(UserTxBufferFS, length);
+    if (length >= APP_TX_DATA_SIZE){
+      length = APP_TX_DATA_SIZE - 1;
+    }
+    Cdc_Write(UserTxBufferFS, length);//copied, the buffer is free again
 }
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 